@@ -0,0 +1,59 @@
+#ifndef AGGREGATE_FUNCTIONS_H
+#define AGGREGATE_FUNCTIONS_H
+
+#include <stddef.h>
+#include "error_handling.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ─── 数组变量与聚合函数 ──────────────────────────────────────────────────────
+//
+// 数组变量通过 bindArrayVariable() 绑定到名字上（只保存指针，不复制数据，
+// 调用方需保证数据在使用期间有效），表达式中通过聚合函数引用：
+//   sum(v)  mean(v)  min(v)  max(v)  norm(v)  dot(a,b)
+//
+// 求和采用分块成对求和（pairwise），叶子块内使用多路 Kahan 补偿累加；
+// 多路累加器让编译器可以生成 SIMD 代码。数组超过并行阈值时按块拆分到
+// 多个线程计算，再按块顺序合并，保证结果与线程数无关。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define MAX_ARRAY_VARIABLES          16     // 可同时绑定的数组变量数
+#define MAX_VARIABLE_NAME            16     // 变量名最大长度（含结尾 '\0'）
+#define AGGREGATE_BLOCK_SIZE         256    // 成对求和叶子块大小
+#define AGGREGATE_PARALLEL_THRESHOLD 262144 // 超过此元素数时并行分块计算
+#define AGGREGATE_MAX_THREADS        8      // 并行计算最大线程数
+
+// 聚合函数类型
+typedef enum {
+    AGG_NONE,
+    AGG_SUM,    // 求和
+    AGG_MEAN,   // 平均值
+    AGG_MIN,    // 最小值
+    AGG_MAX,    // 最大值
+    AGG_NORM,   // 欧几里得范数
+    AGG_DOT     // 点积（两个参数）
+} AggregateType;
+
+// 数组变量绑定
+CalcError bindArrayVariable(const char* name, const double* data, size_t count);
+void unbindArrayVariable(const char* name);
+void clearArrayVariables(void);
+int lookupArrayVariable(const char* name, size_t nameLen, const double** data, size_t* count);
+
+// 聚合函数解析与计算
+AggregateType getAggregateFunction(const char** expr);
+int getAggregateArity(AggregateType type);
+CalcError calculateAggregate(AggregateType type, const double* a, const double* b,
+                             size_t count, double* result);
+
+// 底层归约（供其他模块复用）
+double sumArray(const double* data, size_t count);
+double dotArrays(const double* a, const double* b, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AGGREGATE_FUNCTIONS_H
@@ -0,0 +1,93 @@
+#ifndef BATCH_FORMAT_H
+#define BATCH_FORMAT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "compiled_expression.h"
+#include "expression_library.h"
+
+// ─── 二进制批量请求/结果格式 ───────────────────────────────────────────────
+//
+// 机器之间传递大量计算请求时，输入不再经过数字解析，输出不再经过格式化：
+//
+// 请求文件：BatchFileHeader（magic 为 BATCH_REQUEST_MAGIC）后接若干条记录，
+// 每条记录 8 字节对齐：
+//   BatchRequestHeader
+//   double 变量值[bindingCount]       按变量在表达式中首次出现的顺序（即变量槽位）
+//   char 表达式[expressionLength]     仅内联表达式，补齐到 8 字节
+// 记录可以引用表达式库（--lib）中的表达式编号，也可以直接内联表达式文本。
+//
+// 处理时按窗口（最多 BATCH_PLAN_RECORDS 条记录、BATCH_PLAN_PROGRAMS 个不同表达式）
+// 制定计划：每个不同的（内联文本, 角度模式）或库编号只编译/取出一次；表达式与
+// 变量值的位模式都相同的记录只求值一次，结果复制给其余记录；其余记录按表达式
+// 分组连续求值。结果仍按请求的原始顺序写出。
+//
+// 结果文件：BatchFileHeader（magic 为 BATCH_RESULT_MAGIC）后接与请求一一对应的
+// 定长 BatchResult，可以直接 mmap 后按下标访问。
+//
+// 两种文件都按本机字节序保存，头部带字节序标记。输入既可以 mmap（普通文件），
+// 也可以从管道流式读取；recordCount 为 0 表示条数未知（流式写入）。流式读取时
+// 输入暂时没有数据就只对已读到的记录执行计划并写出结果（Windows 上仍要等到窗口
+// 已满或输入结束）。管道等输入绕过 stdio 直接读取描述符，一次读入的多条记录
+// 仍在同一个窗口中执行计划。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define BATCH_REQUEST_MAGIC   "CALCREQ"   // 请求文件标识（含结尾 '\0' 共 8 字节）
+#define BATCH_RESULT_MAGIC    "CALCRES"   // 结果文件标识
+#define BATCH_VERSION         1
+#define BATCH_ENDIAN_TAG      0x01020304u
+#define MAX_BATCH_EXPRESSION  4096        // 内联表达式的最大长度
+#define BATCH_PLAN_RECORDS    4096        // 每个计划窗口的最大记录数
+#define BATCH_PLAN_PROGRAMS   256         // 每个计划窗口的最大不同表达式数
+
+// 记录类型
+enum {
+    BATCH_INLINE = 0,   // 内联表达式
+    BATCH_LIBRARY = 1   // 表达式库中的编号（使用库中保存的角度模式）
+};
+
+// 文件头（请求文件与结果文件共用）
+typedef struct {
+    char magic[8];
+    uint32_t version;       // BATCH_VERSION
+    uint32_t endianTag;     // BATCH_ENDIAN_TAG
+    uint64_t recordCount;   // 记录条数（0 表示未知）
+} BatchFileHeader;
+
+// 请求记录头
+typedef struct {
+    uint32_t recordSize;    // 整条记录的字节数（8 的倍数）
+    uint8_t kind;           // BATCH_INLINE / BATCH_LIBRARY
+    uint8_t angleMode;      // AngleMode（仅内联表达式）
+    uint16_t bindingCount;  // 变量值个数
+    uint32_t expression;    // 内联表达式的长度，或表达式库中的编号
+    uint32_t reserved;
+} BatchRequestHeader;
+
+// 结果记录
+typedef struct {
+    double value;           // 计算结果（出错时为 0）
+    int32_t errorCode;      // ErrorCode
+    int32_t errorPosition;  // 错误位置（-1 表示无）
+} BatchResult;
+
+// 处理统计
+typedef struct {
+    uint64_t records;
+    uint64_t errors;
+    uint64_t evaluated;     // 去重后实际求值的记录数
+    uint64_t programs;      // 编译或取出表达式的次数（每个窗口中每个不同表达式一次）
+} BatchStats;
+
+// 写请求
+CalcError writeBatchHeader(FILE* file, const char* magic);
+CalcError appendInlineRequest(FILE* file, const char* expr, size_t len, AngleMode mode,
+                              const double* values, int count);
+CalcError appendLibraryRequest(FILE* file, uint32_t index, const double* values, int count);
+
+// 处理请求
+CalcError processBatchStream(FILE* input, FILE* output, const ExpressionLibrary* lib, BatchStats* stats);
+CalcError processBatchFile(const char* inputPath, const char* outputPath, const ExpressionLibrary* lib,
+                           BatchStats* stats);
+
+#endif // BATCH_FORMAT_H
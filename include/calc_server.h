@@ -0,0 +1,62 @@
+#ifndef CALC_SERVER_H
+#define CALC_SERVER_H
+
+#include <stdint.h>
+#include "error_handling.h"
+
+// ─── 本地套接字服务 ─────────────────────────────────────────────────────────
+//
+// calculator --serve 在 Unix 域套接字或 127.0.0.1 的 TCP 端口上提供计算服务。
+// 主线程运行非阻塞 epoll 事件循环，负责接收连接与读写；请求按行分割后交给
+// 计算线程池处理，同一连接上的多个请求可以连续发送（流水线），响应按请求
+// 顺序返回。仅支持 Linux。
+//
+// 可以为每条请求设置求值预算：编译后按估计的步数与嵌套深度拒绝昂贵的表达式，
+// 在队列中等待超过时限的请求不再计算，均返回 ERR_BUDGET_EXCEEDED。
+//
+// 请求（每行一条）：
+//   EVAL [DEG|RAD] <表达式> [| 变量=值 ...]   计算表达式，默认角度模式
+//   STATS                                      服务统计（含延迟 p50/p99）
+//   PING                                       返回 PONG
+//   QUIT                                       返回 BYE 后关闭连接
+// 响应（每行一条）：
+//   OK <结果>
+//   ERR <错误代码> <错误位置> <错误消息>
+//   STATS requests=N errors=N connections=N p50_us=T p99_us=T max_us=T
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define DEFAULT_SERVER_PORT     7400    // 默认 TCP 端口
+#define MAX_SERVER_THREADS      64      // 计算线程数上限
+#define MAX_REQUEST_LINE        4096    // 单条请求的最大长度
+#define MAX_PIPELINED_REQUESTS  1024    // 单个连接未完成请求数上限（超过时暂停读取）
+
+// 服务配置
+typedef struct {
+    const char* unixPath;   // Unix 域套接字路径（NULL 表示使用 TCP）
+    int port;               // TCP 端口（0 表示由系统分配）
+    int threads;            // 计算线程数（0 表示使用 CPU 核数）
+    uint64_t maxSteps;      // 每条请求的最大估计步数（0 表示不限制）
+    int maxDepth;           // 每条请求的最大嵌套深度（0 表示不限制）
+    uint32_t timeoutMicros; // 从收到请求到开始计算的时限（微秒，0 表示不限制）
+} ServerConfig;
+
+// 服务统计
+typedef struct {
+    uint64_t requests;      // 已完成的请求数
+    uint64_t errors;        // 返回 ERR 的请求数
+    int connections;        // 当前连接数
+    double p50Micros;       // 延迟中位数（微秒，从收到请求到生成响应）
+    double p99Micros;       // 延迟 99 分位数（微秒）
+    double maxMicros;       // 最大延迟（微秒）
+} ServerStats;
+
+typedef struct CalcServer CalcServer;
+
+CalcError createServer(const ServerConfig* config, CalcServer** server);
+int getServerPort(const CalcServer* server);
+CalcError runServer(CalcServer* server);
+void stopServer(CalcServer* server);
+void destroyServer(CalcServer* server);
+void getServerStats(CalcServer* server, ServerStats* stats);
+
+#endif // CALC_SERVER_H
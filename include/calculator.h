@@ -15,12 +15,22 @@
 #include "error_handling.h"
 #include "function_types.h"
 #include "number_utils.h"
+#include "aggregate_functions.h"
+#include "decimal.h"
+#include "compiled_expression.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 // 常量定义
 #define MAX_EXPR 100
+#define EXPRESSION_BUFFER_SIZE 256  // evaluateExpressionN 栈上缓冲区大小
 
 // 主要接口函数声明 - 核心计算功能
 CalcError evaluateExpression(const char* expr, AngleMode mode, double* result);
+// 同上，expr 不要求以 '\0' 结尾
+CalcError evaluateExpressionN(const char* expr, size_t len, AngleMode mode, double* result);
 
 // 括号处理函数
 CalcError checkBracketMatch(const char* expr);
@@ -28,8 +38,17 @@ CalcError checkBracketMatch(const char* expr);
 // 运算符处理函数
 CalcError processOperators(double* numbers, int* numTop, char* operators, int* opTop, char stopAt, int processEqual);
 CalcError performOperation(char op, double a, double b, double* result);
+ErrorCode performOperationCode(char op, double a, double b, double* result);
+ErrorCode performFloatOperation(char op, double a, double b, double* result);
+int compareOperands(char op, double a, double b);
+const char* describeOperationError(double a, double b, ErrorCode code);
+int performIntegerOperation(char op, int64_t a, int64_t b, int64_t* result);
 
 // 安全检查函数
 CalcError checkStackOverflow(int stackSize, const char* stackName);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // CALCULATOR_H 
\ No newline at end of file
@@ -0,0 +1,813 @@
+#ifndef CALCULATOR_HPP
+#define CALCULATOR_HPP
+
+// ─── C++ 接口 ───────────────────────────────────────────────────────────────
+//
+// 只有头文件，包装 C 接口（需要 C++17，std::span 重载需要 C++20）：
+//
+//   calc::literal("2^10 - 1")        常量表达式在编译期求值，结果就是立即数
+//   "2pi(1 + 1/3)"_calc              同上（C++20 下为 consteval，不能在运行期调用）
+//   calc::evaluate(view, MODE_RAD)   std::string_view 入口，不要求以 '\0' 结尾
+//   calc::Expression                 编译表达式的句柄（只能移动），析构时释放指令
+//   calc::VectorExpression           向量模式编译的句柄，自带 arena 存放中间结果
+//
+// 错误以 calc::Error 异常抛出（code/what/position 与 CalcError 相同）。编译期求值
+// 出错时抛出异常的表达式不是常量表达式，因此直接成为编译错误。
+//
+// 编译期求值按 evaluateExpression 的算法逐步重现：同样的运算符栈、隐式乘法、
+// 负号、整数快速路径、接近整数修正和错误消息，结果与运行期逐位一致。
+// 只支持 + - * / ^、括号、数字字面量与 pi/e；函数与变量报 ERR_INVALID_FUNCTION，
+// ^ 的指数必须是整数（其余情况需要 libm 的 pow，报 ERR_INVALID_ARGUMENT）。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <string_view>
+#include <utility>
+#if __cplusplus >= 202002L && __has_include(<span>)
+  #include <span>
+#endif
+
+#include "calculator.h"
+#include "vector_value.h"
+
+#if defined(__cpp_lib_span) && __cpp_lib_span >= 202002L
+  #define CALC_HAS_SPAN 1
+#else
+  #define CALC_HAS_SPAN 0
+#endif
+
+#if defined(__cpp_consteval) && __cpp_consteval >= 201811L
+  #define CALC_CONSTEVAL consteval
+#else
+  #define CALC_CONSTEVAL constexpr
+#endif
+
+namespace calc {
+
+// 计算错误（message 指向库内的静态字符串，与 CalcError 相同）
+class Error : public std::exception {
+public:
+    Error(int code, const char* message, int position) noexcept
+        : code_(code), message_(message), position_(position) {}
+    explicit Error(const CalcError& err) noexcept
+        : Error(err.code, err.message ? err.message : getErrorDescription(err.code), err.position) {}
+
+    const char* what() const noexcept override { return message_; }
+    int code() const noexcept { return code_; }
+    int position() const noexcept { return position_; }
+
+private:
+    int code_;
+    const char* message_;
+    int position_;
+};
+
+inline void check(const CalcError& err) {
+    if (err.code != 0) {
+        throw Error(err);
+    }
+}
+
+namespace detail {
+
+// ─── 编译期数值工具（与 precision_handling.c / operator_handling.c 一致） ───
+
+constexpr double TWO_POW_52 = 4503599627370496.0;
+constexpr double TWO_POW_53 = 9007199254740992.0;
+constexpr double TWO_POW_63 = 9223372036854775808.0;
+
+constexpr double absolute(double x) { return x < 0 ? -x : x; }
+constexpr bool isNan(double x) { return x != x; }
+constexpr bool isFiniteValue(double x) { return x == x && x >= -DBL_MAX && x <= DBL_MAX; }
+
+// isDoubleEqual（参数已是有限值）
+constexpr bool nearlyEqual(double a, double b) {
+    if (isNan(a) || isNan(b)) return false;
+    if (absolute(a) < ABSOLUTE_ZERO_THRESHOLD && absolute(b) < ABSOLUTE_ZERO_THRESHOLD) {
+        return true;
+    }
+    if (absolute(a) < EPSILON || absolute(b) < EPSILON) {
+        return absolute(a - b) < EPSILON;
+    }
+    return absolute(a - b) < EPSILON || absolute((a - b) / ((absolute(a) > absolute(b)) ? a : b)) < RELATIVE_EPSILON;
+}
+
+// round()：四舍五入，远离 0
+constexpr double roundHalfAway(double x) {
+    if (!(absolute(x) < TWO_POW_52)) return x;
+    int64_t truncated = static_cast<int64_t>(x);
+    double fraction = x - static_cast<double>(truncated);
+    if (fraction >= 0.5) truncated++;
+    if (fraction <= -0.5) truncated--;
+    return static_cast<double>(truncated);
+}
+
+// isCloseToInteger
+constexpr bool closeToInteger(double value, int64_t& intValue) {
+    double rounded = roundHalfAway(value);
+    if (rounded >= TWO_POW_63 || rounded < -TWO_POW_63) return false;
+    if (nearlyEqual(value, rounded)) {
+        intValue = static_cast<int64_t>(rounded);
+        return true;
+    }
+    return false;
+}
+
+// doubleToExactInt64
+constexpr bool exactInt64(double value, int64_t& intValue) {
+    if (!(value >= -TWO_POW_63 && value < TWO_POW_63)) return false;
+    int64_t truncated = static_cast<int64_t>(value);
+    if (static_cast<double>(truncated) != value) return false;
+    intValue = truncated;
+    return true;
+}
+
+constexpr bool checkedAdd(int64_t a, int64_t b, int64_t& result) {
+    if ((b > 0 && a > INT64_MAX - b) || (b < 0 && a < INT64_MIN - b)) return false;
+    result = a + b;
+    return true;
+}
+
+constexpr bool checkedSub(int64_t a, int64_t b, int64_t& result) {
+    if ((b < 0 && a > INT64_MAX + b) || (b > 0 && a < INT64_MIN + b)) return false;
+    result = a - b;
+    return true;
+}
+
+constexpr bool checkedMul(int64_t a, int64_t b, int64_t& result) {
+    if (a > 0 ? (b > 0 ? a > INT64_MAX / b : b < INT64_MIN / a)
+              : (b > 0 ? a < INT64_MIN / b : (a != 0 && b < INT64_MAX / a))) {
+        return false;
+    }
+    result = a * b;
+    return true;
+}
+
+// performIntegerOperation
+constexpr bool integerOperation(char op, int64_t a, int64_t b, int64_t& result) {
+    switch (op) {
+        case '+': return checkedAdd(a, b, result);
+        case '-': return checkedSub(a, b, result);
+        case '*': return checkedMul(a, b, result);
+        case '/':
+            if (b == 0 || (a == INT64_MIN && b == -1) || a % b != 0) return false;
+            result = a / b;
+            return true;
+        case '^': {
+            if (b < 0) return false;
+            int64_t acc = 1;
+            while (b > 0) {
+                if ((b & 1) && !checkedMul(acc, a, acc)) return false;
+                b >>= 1;
+                if (b > 0 && !checkedMul(a, a, a)) return false;
+            }
+            result = acc;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// ─── 整数次幂（双双精度平方求幂，尾数与二进制指数分开保存） ────────────────
+
+struct DoubleDouble {
+    double hi;
+    double lo;
+};
+
+constexpr DoubleDouble quickTwoSum(double a, double b) {
+    double s = a + b;
+    return {s, b - (s - a)};
+}
+
+constexpr DoubleDouble twoProduct(double a, double b) {
+    double p = a * b;
+    double ta = 134217729.0 * a;
+    double ah = ta - (ta - a), al = a - ah;
+    double tb = 134217729.0 * b;
+    double bh = tb - (tb - b), bl = b - bh;
+    return {p, ((ah * bh - p) + ah * bl + al * bh) + al * bl};
+}
+
+constexpr DoubleDouble multiply(DoubleDouble x, DoubleDouble y) {
+    DoubleDouble p = twoProduct(x.hi, y.hi);
+    return quickTwoSum(p.hi, p.lo + x.hi * y.lo + x.lo * y.hi);
+}
+
+// 保持 hi 在 [1, 2)，指数记入 exponent（乘除 2 是精确的；指数用 double 保存，不会溢出）
+constexpr void normalize(DoubleDouble& x, double& exponent) {
+    while (x.hi >= 2.0) { x.hi *= 0.5; x.lo *= 0.5; exponent++; }
+    while (x.hi < 1.0)  { x.hi *= 2.0; x.lo *= 2.0; exponent--; }
+}
+
+constexpr DoubleDouble reciprocal(DoubleDouble x) {
+    double q1 = 1.0 / x.hi;
+    DoubleDouble t = multiply(x, {q1, 0.0});
+    double q2 = ((1.0 - t.hi) - t.lo) / x.hi;
+    return quickTwoSum(q1, q2);
+}
+
+// 2^e，e 在 [-1022, 1023]
+constexpr double powerOfTwo(int e) {
+    double value = 1.0;
+    for (; e > 0; e--) value *= 2.0;
+    for (; e < 0; e++) value *= 0.5;
+    return value;
+}
+
+// a^n（n 为整数），误差约 2^-100 后舍入一次，与正确舍入的 pow 一致；溢出时返回 false
+constexpr bool integerPower(double a, double n, double& result) {
+    if (n == 0) {
+        result = 1.0;
+        return true;
+    }
+    if (a == 0) {
+        result = 0.0;
+        return true;
+    }
+    double magnitude = absolute(a);
+    double count = absolute(n);
+    if (count >= TWO_POW_53) {
+        // 这么大的 double 都是偶数
+        if (magnitude == 1.0) { result = 1.0; return true; }
+        if ((magnitude > 1.0) == (n > 0)) return false;
+        result = 0.0;
+        return true;
+    }
+    int64_t k = static_cast<int64_t>(count);
+
+    DoubleDouble base = {magnitude, 0.0};
+    double baseExponent = 0;
+    normalize(base, baseExponent);
+    DoubleDouble acc = {1.0, 0.0};
+    double exponent = 0;
+    for (int64_t bits = k; bits > 0; bits >>= 1) {
+        if (bits & 1) {
+            acc = multiply(acc, base);
+            exponent += baseExponent;
+            normalize(acc, exponent);
+        }
+        if (bits > 1) {
+            base = multiply(base, base);
+            baseExponent *= 2;
+            normalize(base, baseExponent);
+        }
+    }
+    if (n < 0) {
+        acc = reciprocal(acc);
+        exponent = -exponent;
+        normalize(acc, exponent);
+    }
+
+    // quickTwoSum 之后 hi 就是舍入到 double 的值；非规格化数只在最后一次乘法中舍入
+    double value = acc.hi;
+    if (exponent > 1023) return false;
+    if (exponent < -1100) {
+        value = 0.0;
+    } else {
+        if (exponent < -1000) {
+            value *= powerOfTwo(-1000);
+            exponent += 1000;
+        }
+        value *= powerOfTwo(static_cast<int>(exponent));
+    }
+    result = (a < 0 && (k & 1)) ? -value : value;
+    return true;
+}
+
+// ─── 运算（performOperation） ─────────────────────────────────────────────────
+
+constexpr double operate(char op, double a, double b) {
+    // 整数快速路径
+    int64_t intA = 0, intB = 0, intResult = 0;
+    if (exactInt64(a, intA) && exactInt64(b, intB) && integerOperation(op, intA, intB, intResult) &&
+        intResult >= -MAX_EXACT_DOUBLE_INTEGER && intResult <= MAX_EXACT_DOUBLE_INTEGER) {
+        return static_cast<double>(intResult);
+    }
+
+    double result = 0;
+    switch (op) {
+        case '+': result = a + b; break;
+        case '-': result = a - b; break;
+        case '*': result = a * b; break;
+        case '/':
+            if (absolute(b) < ABSOLUTE_ZERO_THRESHOLD) throw Error(ERR_DIV_BY_ZERO, "除数不能为0", -1);
+            result = a / b;
+            break;
+        case '^':
+            if (absolute(a) < ABSOLUTE_ZERO_THRESHOLD && b < 0) {
+                throw Error(ERR_UNDEFINED, "0的负数次幂未定义", -1);
+            }
+            if (a < 0 && absolute(b - static_cast<double>(static_cast<int64_t>(b))) > EPSILON) {
+                throw Error(ERR_UNDEFINED, "负数不能开非整数次方根", -1);
+            }
+            if (absolute(b) < TWO_POW_52 && b != static_cast<double>(static_cast<int64_t>(b))) {
+                throw Error(ERR_INVALID_ARGUMENT, "编译期求值只支持整数次幂", -1);
+            }
+            if (!integerPower(a, b, result)) throw Error(ERR_OVERFLOW, "计算结果太大", -1);
+            break;
+        default:
+            throw Error(ERR_SYNTAX, "无效的运算符", -1);
+    }
+    if (!isFiniteValue(result)) throw Error(ERR_OVERFLOW, "计算结果太大", -1);
+
+    int64_t intValue = 0;
+    if (closeToInteger(result, intValue)) {
+        result = static_cast<double>(intValue);
+    }
+    return result;
+}
+
+// ─── 字面量表达式求值（evaluateExpression 的编译期版本） ─────────────────────
+
+constexpr bool isAlpha(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+constexpr bool isNumberChar(char c) { return isDigit(c) || c == '.'; }
+constexpr char lower(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+constexpr bool isOperator(char c) { return c == '+' || c == '-' || c == '*' || c == '/' || c == '^'; }
+
+constexpr int priority(char op) {
+    switch (op) {
+        case '+': case '-': return PRIORITY_ADD;
+        case '*': case '/': return PRIORITY_MUL;
+        case '^': return PRIORITY_POW;
+        case '(': return PRIORITY_PAR;
+        default: return -1;
+    }
+}
+
+// getNumberWithError：start 指向数字的第一个字符，返回时 pos 指向数字之后
+constexpr double parseNumber(std::string_view expr, std::size_t& pos, int offset) {
+    auto at = [&](std::size_t i) { return i < expr.size() ? expr[i] : '\0'; };
+    const std::size_t start = pos;
+    auto fail = [&](const char* message, std::size_t where) {
+        return Error(ERR_SYNTAX, message, offset + static_cast<int>(where));
+    };
+    double number = 0, decimal = 0.1;
+    bool hasDecimal = false, hasDigit = false, hasExponent = false;
+    int decimalCount = 0, digitCount = 0, exponent = 0, exponentSign = 1;
+
+    while (isDigit(at(pos)) || at(pos) == '.' || lower(at(pos)) == 'e') {
+        if (at(pos) == '.') {
+            if (hasDecimal || hasExponent) throw fail("数字格式不正确，多个小数点", pos);
+            hasDecimal = true;
+            pos++;
+        } else if (lower(at(pos)) == 'e') {
+            if (hasExponent) throw fail("数字格式不正确，多个指数符号", pos);
+            if (!hasDigit) throw fail("无效的数字格式", pos);
+            hasExponent = true;
+            pos++;
+            if (at(pos) == '+' || at(pos) == '-') {
+                exponentSign = (at(pos) == '+') ? 1 : -1;
+                pos++;
+            }
+            if (!isDigit(at(pos))) {
+                if (lower(at(pos)) == 'e') throw fail("数字格式不正确，多个指数符号", pos);
+                throw fail("指数部分必须是整数", pos);
+            }
+            while (isDigit(at(pos))) {
+                if (exponent < 100000) exponent = exponent * 10 + (at(pos) - '0');
+                if (exponentSign > 0 && exponent > 308) throw fail("数字太大", pos);
+                pos++;
+            }
+            if (lower(at(pos)) == 'e') throw fail("数字格式不正确，多个指数符号", pos);
+            if (at(pos) == '.') throw fail("指数部分必须是整数", pos);
+            break;
+        } else {
+            hasDigit = true;
+            if (hasDecimal) {
+                if (decimalCount < PRECISION) {
+                    number = number + (at(pos) - '0') * decimal;
+                    decimal *= 0.1;
+                    decimalCount++;
+                }
+            } else {
+                if (++digitCount > MAX_INTEGER_DIGITS) throw fail("数字太大", pos);
+                if (number > DBL_MAX / 10) throw fail("数字太大", pos);
+                number = number * 10 + (at(pos) - '0');
+            }
+            pos++;
+        }
+    }
+    if (!hasDigit) throw fail("无效的数字格式", start);
+
+    if (hasExponent) {
+        double scale = 0;
+        if (!integerPower(10.0, static_cast<double>(exponentSign * exponent), scale) ||
+            !isFiniteValue(number * scale)) {
+            throw fail("数字太大", pos);
+        }
+        number *= scale;
+    }
+    return number;
+}
+
+class LiteralEvaluator {
+public:
+    // offset 为 expr 在最外层表达式中的位置（用于错误位置）
+    constexpr LiteralEvaluator(std::string_view expr, int offset) : expr_(expr), offset_(offset) {}
+
+    constexpr double run() {
+        if (expr_.empty()) throw Error(ERR_EMPTY_EXPRESSION, "表达式不能为空", -1);
+        checkBrackets();
+
+        std::size_t last = expr_.size() - 1;
+        while (last > 0 && expr_[last] == ' ') last--;
+        if (isOperator(expr_[last])) throw syntaxError("表达式不能以运算符结尾", last);
+
+        bool lastWasNumber = false;
+        std::size_t pos = 0;
+        while (pos < expr_.size()) {
+            char c = expr_[pos];
+            if (c == ' ') {
+                pos++;
+                continue;
+            }
+
+            if (isAlpha(c)) {
+                if (lastWasNumber) implicitMultiply();
+                push(constant(pos));
+                lastWasNumber = true;
+                continue;
+            }
+
+            if (isNumberChar(c)) {
+                if (lastWasNumber) implicitMultiply();
+                push(parseNumber(expr_, pos, offset_));
+                lastWasNumber = true;
+                continue;
+            }
+
+            if (c == '(') {
+                if (lastWasNumber) implicitMultiply();
+                pushOperator('(');
+                pos++;
+                lastWasNumber = false;
+                continue;
+            }
+
+            if (c == ')') {
+                if (opTop_ >= 0 && operators_[opTop_] == '(' &&
+                    (numTop_ < 0 || (expr_[pos - 1] == '(' && !lastWasNumber))) {
+                    throw syntaxError("括号内必须有表达式", pos);
+                }
+                reduce('(', false);
+                if (opTop_ >= 0 && operators_[opTop_] == '(') {
+                    opTop_--;
+                } else {
+                    throw syntaxError("括号不匹配", pos);
+                }
+                pos++;
+                lastWasNumber = true;
+                continue;
+            }
+
+            if (isOperator(c)) {
+                if (!lastWasNumber && c == '-') {
+                    std::size_t next = pos + 1;
+                    while (at(next) == ' ') next++;
+                    char nextChar = at(next);
+                    if (isNumberChar(nextChar) || isAlpha(nextChar) || nextChar == '(') {
+                        pos = next;
+                        if (nextChar == '(') {
+                            push(-subExpression(pos));
+                        } else if (isAlpha(nextChar)) {
+                            push(-constant(pos));
+                        } else {
+                            push(-parseNumber(expr_, pos, offset_));
+                        }
+                        lastWasNumber = true;
+                        continue;
+                    }
+                }
+                if (!lastWasNumber && c != '-') throw syntaxError("运算符使用不正确", pos);
+                reduce(c, false);
+                pushOperator(c);
+                pos++;
+                lastWasNumber = false;
+                continue;
+            }
+
+            if (c == '<' || c == '>' || c == '=' || c == '!' || c == '?' || c == ':') {
+                throw Error(ERR_INVALID_ARGUMENT, "编译期求值不支持比较与条件运算符", offset_ + static_cast<int>(pos));
+            }
+            throw syntaxError("无效的字符", pos);
+        }
+
+        reduce('\0', true);
+        if (numTop_ != 0 || opTop_ != -1) throw Error(ERR_SYNTAX, "表达式不完整", -1);
+        return numbers_[0];
+    }
+
+private:
+    constexpr char at(std::size_t i) const { return i < expr_.size() ? expr_[i] : '\0'; }
+
+    Error syntaxError(const char* message, std::size_t pos) const {
+        return Error(ERR_SYNTAX, message, offset_ + static_cast<int>(pos));
+    }
+
+    // checkBracketMatch
+    constexpr void checkBrackets() const {
+        long depth = 0;
+        for (std::size_t i = 0; i < expr_.size(); i++) {
+            if (expr_[i] == '(') depth++;
+            if (expr_[i] == ')' && --depth < 0) throw syntaxError("括号不匹配：右括号过多", i);
+        }
+        if (depth > 0) throw Error(ERR_MISSING_PARENTHESIS, "括号不匹配：左括号过多", -1);
+    }
+
+    // pi 与 e（大小写不敏感）；其余标识符是函数或变量，不能在编译期求值
+    constexpr double constant(std::size_t& pos) const {
+        if (lower(at(pos)) == 'p' && lower(at(pos + 1)) == 'i' && !isAlpha(at(pos + 2))) {
+            pos += 2;
+            return PI;
+        }
+        if (lower(at(pos)) == 'e' && !isAlpha(at(pos + 1))) {
+            pos += 1;
+            return E;
+        }
+        throw Error(ERR_INVALID_FUNCTION, "编译期求值不支持函数与变量", offset_ + static_cast<int>(pos));
+    }
+
+    // pos 指向左括号，返回时指向匹配的右括号之后（括号已由 checkBrackets 检查过）
+    constexpr double subExpression(std::size_t& pos) const {
+        std::size_t end = pos + 1;
+        for (int depth = 1; depth > 0 && end < expr_.size(); end++) {
+            if (expr_[end] == '(') depth++;
+            if (expr_[end] == ')') depth--;
+        }
+        LiteralEvaluator inner(expr_.substr(pos + 1, end - pos - 2), offset_ + static_cast<int>(pos) + 1);
+        pos = end;
+        return inner.run();
+    }
+
+    constexpr void push(double value) {
+        if (numTop_ + 1 >= MAX_EXPR) throw Error(ERR_STACK_OVERFLOW, "数字栈溢出，表达式过于复杂", -1);
+        numbers_[++numTop_] = value;
+    }
+
+    constexpr void pushOperator(char op) {
+        if (opTop_ + 1 >= MAX_EXPR) throw Error(ERR_STACK_OVERFLOW, "运算符栈溢出，表达式过于复杂", -1);
+        operators_[++opTop_] = op;
+    }
+
+    constexpr void apply() {
+        if (numTop_ < 1) throw Error(ERR_SYNTAX, "运算符使用不正确", -1);
+        double b = numbers_[numTop_--];
+        double a = numbers_[numTop_--];
+        numbers_[++numTop_] = operate(operators_[opTop_--], a, b);
+    }
+
+    // processOperators
+    constexpr void reduce(char stopAt, bool processEqual) {
+        while (opTop_ >= 0 && operators_[opTop_] != '(') {
+            char stackOp = operators_[opTop_];
+            bool shouldProcess = (stackOp == '^') ? priority(stackOp) > priority(stopAt)
+                                                  : priority(stackOp) >= priority(stopAt);
+            if (processEqual && priority(stopAt) < 0) shouldProcess = true;
+            if (!shouldProcess) break;
+            apply();
+        }
+    }
+
+    // handleImplicitMultiply
+    constexpr void implicitMultiply() {
+        while (opTop_ >= 0 && operators_[opTop_] != '(' && priority(operators_[opTop_]) >= priority('*')) {
+            apply();
+        }
+        pushOperator('*');
+    }
+
+    std::string_view expr_;
+    int offset_;
+    double numbers_[MAX_EXPR] = {};
+    char operators_[MAX_EXPR] = {};
+    int numTop_ = -1;
+    int opTop_ = -1;
+};
+
+}  // namespace detail
+
+// ─── 字面量表达式 ───────────────────────────────────────────────────────────
+
+// 在编译期求值（用于 constexpr 变量时出错即编译错误）；也可在运行期调用
+constexpr double literal(std::string_view expr) {
+    return detail::LiteralEvaluator(expr, 0).run();
+}
+
+inline namespace literals {
+CALC_CONSTEVAL double operator""_calc(const char* expr, std::size_t len) {
+    return literal(std::string_view(expr, len));
+}
+}  // namespace literals
+
+// ─── 运行期求值 ─────────────────────────────────────────────────────────────
+
+// evaluateExpressionN：不复制到堆上，不要求以 '\0' 结尾
+inline double evaluate(std::string_view expr, AngleMode mode = MODE_DEG) {
+    double result = 0;
+    check(evaluateExpressionN(expr.data(), expr.size(), mode, &result));
+    return result;
+}
+
+// 向量值的元素（标量视为一个元素）
+#if CALC_HAS_SPAN
+inline std::span<const double> elements(const VectorValue& value) noexcept {
+    return value.isVector ? std::span<const double>(value.data, value.count)
+                          : std::span<const double>(&value.scalar, 1);
+}
+#endif
+
+// 编译表达式的句柄：只能移动，析构时释放指令与多项式计划
+class Expression {
+public:
+    explicit Expression(std::string_view expr) {
+        check(compileExpressionN(expr.data(), expr.size(), &prog_));
+    }
+    Expression(Expression&& other) noexcept : prog_(other.prog_) {
+        std::memset(&other.prog_, 0, sizeof(other.prog_));
+    }
+    Expression& operator=(Expression&& other) noexcept {
+        if (this != &other) {
+            freeCompiledExpression(&prog_);
+            prog_ = other.prog_;
+            std::memset(&other.prog_, 0, sizeof(other.prog_));
+        }
+        return *this;
+    }
+    Expression(const Expression&) = delete;
+    Expression& operator=(const Expression&) = delete;
+    ~Expression() { freeCompiledExpression(&prog_); }
+
+    const CompiledExpr* get() const noexcept { return &prog_; }
+    int variableCount() const noexcept { return prog_.varCount; }
+    std::string_view variableName(int slot) const noexcept { return prog_.varNames[slot]; }
+
+    // 变量的槽位，不存在时返回 -1
+    int findVariable(std::string_view name) const noexcept {
+        for (int i = 0; i < prog_.varCount; i++) {
+            if (name == prog_.varNames[i]) return i;
+        }
+        return -1;
+    }
+
+    // vars 按槽位顺序给出（至少 variableCount() 个）
+    double evaluate(const double* vars, AngleMode mode = MODE_DEG) const {
+        double result = 0;
+        check(evaluateCompiled(&prog_, vars, mode, &result));
+        return result;
+    }
+
+    // columns 按槽位顺序给出各变量的列（每列 rows 行）；出错的行为 NaN，
+    // 并抛出第一个出错行的错误
+    void evaluateBatch(const double* const* columns, std::size_t rows, double* results,
+                       AngleMode mode = MODE_DEG, EvalPrecision precision = EVAL_FP64) const {
+        check(evaluateCompiledBatch(&prog_, columns, rows, mode, precision, results, nullptr));
+    }
+
+#if CALC_HAS_SPAN
+    double evaluate(std::span<const double> vars, AngleMode mode = MODE_DEG) const {
+        requireVariables(vars.size());
+        return evaluate(vars.data(), mode);
+    }
+
+    // 每个变量一列，各列与 results 行数相同
+    void evaluateBatch(std::span<const std::span<const double>> columns, std::span<double> results,
+                       AngleMode mode = MODE_DEG, EvalPrecision precision = EVAL_FP64) const {
+        const double* pointers[MAX_COMPILED_VARIABLES] = {};
+        collectColumns(columns, results.size(), pointers);
+        evaluateBatch(pointers, results.size(), results.data(), mode, precision);
+    }
+
+    // 同上，errors 输出每行的错误代码，出错的行不抛出异常；返回第一个出错行的错误
+    CalcError evaluateBatch(std::span<const std::span<const double>> columns, std::span<double> results,
+                            std::span<ErrorCode> errors, AngleMode mode = MODE_DEG,
+                            EvalPrecision precision = EVAL_FP64) const {
+        if (errors.size() != results.size()) {
+            throw Error(ERR_INVALID_ARGUMENT, "错误代码与结果的行数不同", -1);
+        }
+        const double* pointers[MAX_COMPILED_VARIABLES] = {};
+        collectColumns(columns, results.size(), pointers);
+        return evaluateCompiledBatch(&prog_, pointers, results.size(), mode, precision, results.data(),
+                                     errors.data());
+    }
+
+    // 单变量表达式
+    void evaluateBatch(std::span<const double> x, std::span<double> results, AngleMode mode = MODE_DEG,
+                       EvalPrecision precision = EVAL_FP64) const {
+        std::span<const double> column[1] = {x};
+        evaluateBatch(std::span<const std::span<const double>>(column, prog_.varCount > 0 ? 1 : 0), results,
+                      mode, precision);
+    }
+#endif
+
+private:
+    void requireVariables(std::size_t count) const {
+        if (count < static_cast<std::size_t>(prog_.varCount)) {
+            throw Error(ERR_INVALID_ARGUMENT, "变量个数不足", -1);
+        }
+    }
+
+#if CALC_HAS_SPAN
+    void collectColumns(std::span<const std::span<const double>> columns, std::size_t rows,
+                        const double** pointers) const {
+        requireVariables(columns.size());
+        for (int v = 0; v < prog_.varCount; v++) {
+            if (columns[v].size() != rows) {
+                throw Error(ERR_INVALID_ARGUMENT, "变量列与结果的行数不同", -1);
+            }
+            pointers[v] = columns[v].data();
+        }
+    }
+#endif
+
+    CompiledExpr prog_{};
+};
+
+// VectorArena 的所有者：只能移动，析构时释放全部块
+class Arena {
+public:
+    Arena() noexcept { initVectorArena(&arena_); }
+    Arena(Arena&& other) noexcept : arena_(other.arena_) { initVectorArena(&other.arena_); }
+    Arena& operator=(Arena&& other) noexcept {
+        if (this != &other) {
+            freeVectorArena(&arena_);
+            arena_ = other.arena_;
+            initVectorArena(&other.arena_);
+        }
+        return *this;
+    }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena() { freeVectorArena(&arena_); }
+
+    VectorArena* get() noexcept { return &arena_; }
+    void reset() noexcept { resetVectorArena(&arena_); }
+
+private:
+    VectorArena arena_;
+};
+
+// 向量模式编译的句柄：中间结果与向量结果放在自带的 arena 中，
+// 结果在下一次 evaluate 或句柄析构之前有效；同一个句柄不能被多个线程同时求值
+class VectorExpression {
+public:
+    explicit VectorExpression(std::string_view expr) {
+        check(compileVectorExpressionN(expr.data(), expr.size(), &prog_));
+    }
+    VectorExpression(VectorExpression&& other) noexcept
+        : prog_(other.prog_), arena_(std::move(other.arena_)) {
+        std::memset(&other.prog_, 0, sizeof(other.prog_));
+    }
+    VectorExpression& operator=(VectorExpression&& other) noexcept {
+        if (this != &other) {
+            freeCompiledExpression(&prog_);
+            prog_ = other.prog_;
+            std::memset(&other.prog_, 0, sizeof(other.prog_));
+            arena_ = std::move(other.arena_);
+        }
+        return *this;
+    }
+    VectorExpression(const VectorExpression&) = delete;
+    VectorExpression& operator=(const VectorExpression&) = delete;
+    ~VectorExpression() { freeCompiledExpression(&prog_); }
+
+    const CompiledExpr* get() const noexcept { return &prog_; }
+    int variableCount() const noexcept { return prog_.varCount; }
+
+    int findVariable(std::string_view name) const noexcept {
+        for (int i = 0; i < prog_.varCount; i++) {
+            if (name == prog_.varNames[i]) return i;
+        }
+        return -1;
+    }
+
+    // vars 按槽位顺序给出（至少 variableCount() 个）
+    VectorValue evaluate(const VectorValue* vars, AngleMode mode = MODE_DEG) {
+        arena_.reset();
+        VectorValue result = scalarValue(0);
+        check(evaluateCompiledVector(&prog_, vars, mode, arena_.get(), &result));
+        return result;
+    }
+
+#if CALC_HAS_SPAN
+    VectorValue evaluate(std::span<const VectorValue> vars, AngleMode mode = MODE_DEG) {
+        if (vars.size() < static_cast<std::size_t>(prog_.varCount)) {
+            throw Error(ERR_INVALID_ARGUMENT, "变量个数不足", -1);
+        }
+        return evaluate(vars.data(), mode);
+    }
+#endif
+
+private:
+    CompiledExpr prog_{};
+    Arena arena_;
+};
+
+}  // namespace calc
+
+#endif // CALCULATOR_HPP
@@ -0,0 +1,59 @@
+#ifndef CHAR_SCAN_H
+#define CHAR_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "error_handling.h"
+
+// ─── 字符分类预扫描 ─────────────────────────────────────────────────────────
+//
+// 编译前先对整个表达式做一次分类：每 64 个字节得到一组位图（每类一个 uint64_t），
+// x86 上用 SSE2 一次比较 16 个字节（GCC/Clang 编译时再生成一份 AVX2 实现，
+// 运行时由 __builtin_cpu_supports 检测到 CPU 支持才使用，一次 32 个字节），其他平台
+// 查表。之后括号检查只在位图上累加深度，词法分析用 ctz 直接跳到记号边界，
+// 不再逐字节调用与区域设置相关的 isalpha/isdigit。
+// ─────────────────────────────────────────────────────────────────────────────
+
+// 字符类别（位图下标）
+typedef enum {
+    CHAR_SPACE,         // ' '
+    CHAR_ALPHA,         // A-Z a-z
+    CHAR_DIGIT,         // 0-9
+    CHAR_WORD,          // 字母、数字、'_'（变量名）
+    CHAR_NUMBER,        // 数字、'.'（数字字面量）
+    CHAR_OPEN,          // '('
+    CHAR_CLOSE,         // ')'
+    CHAR_OPERATOR,      // + - * / ^
+    CHAR_CLASS_COUNT
+} CharClass;
+
+#define CHAR_SCAN_INLINE_WORDS 16   // 不超过 1024 字节的表达式不分配内存
+
+// 表达式的分类位图
+typedef struct {
+    size_t length;          // 表达式长度
+    size_t words;           // 每类位图的 uint64_t 个数
+    uint64_t* maps;         // maps[类别 * words + 字节下标 / 64]
+    uint64_t inlineMaps[CHAR_CLASS_COUNT * CHAR_SCAN_INLINE_WORDS];
+} CharScan;
+
+// 单字节分类表（每类一位，与区域设置无关）
+extern const unsigned char charClassTable[256];
+
+static inline int charHasClass(int ch, CharClass cls) {
+    return (charClassTable[(unsigned char)ch] >> cls) & 1;
+}
+
+CalcError scanCharacters(const char* expr, size_t len, CharScan* scan);
+void freeCharScan(CharScan* scan);
+
+// 从 pos 开始跳过属于 cls 的字符，返回第一个不属于 cls 的位置（或 length）
+size_t skipCharClass(const CharScan* scan, CharClass cls, size_t pos);
+// 返回最后一个不是空格的字符之后的位置
+size_t trimTrailingSpaces(const CharScan* scan);
+int scanHasClass(const CharScan* scan, CharClass cls, size_t pos);
+
+// 括号深度检查：右括号过多时返回第一个使深度为负的位置
+CalcError checkBracketDepth(const CharScan* scan);
+
+#endif // CHAR_SCAN_H
@@ -0,0 +1,67 @@
+#ifndef COLUMN_EVALUATOR_H
+#define COLUMN_EVALUATOR_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "compiled_expression.h"
+
+// ─── 按列计算公式 ───────────────────────────────────────────────────────────
+//
+// calculator --csv in.csv --expr 'out=sqrt(a^2+b^2)' 把 CSV 的列名映射为变量，
+// 每个公式只编译一次。数据按块流式读取（每块 COLUMN_BLOCK_ROWS 行），用到的列
+// 用 parseNumberField 解析成列数组，再用 evaluateCompiledBatch 整列求值，结果列
+// 追加在每行末尾。后面的公式可以引用前面公式的结果列。
+//
+// 也支持简单的二进制列式文件（--columnar），文件用 mmap 映射，列数据直接参与
+// 计算，不做任何解析：
+//   ColumnarFileHeader
+//   char 列名[columnCount][MAX_VARIABLE_NAME]
+//   double 数据[columnCount][rowCount]   按列连续存放，本机字节序
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define MAX_FORMULA_COLUMNS  16         // 公式列数上限
+#define MAX_DATA_COLUMNS     256        // 输入文件的列数上限
+#define COLUMN_BLOCK_ROWS    4096       // CSV 每块行数
+#define COLUMNAR_MAGIC       "CALCCOL"  // 列式文件标识（含结尾 '\0' 共 8 字节）
+#define COLUMNAR_VERSION     1
+#define COLUMNAR_ENDIAN_TAG  0x01020304u
+
+// 列式文件头
+typedef struct {
+    char magic[8];          // COLUMNAR_MAGIC
+    uint32_t version;       // COLUMNAR_VERSION
+    uint32_t endianTag;     // COLUMNAR_ENDIAN_TAG
+    uint32_t columnCount;   // 列数
+    uint32_t reserved;
+    uint64_t rowCount;      // 行数
+} ColumnarFileHeader;
+
+// 公式列：name=表达式
+typedef struct {
+    char name[MAX_VARIABLE_NAME];   // 结果列名
+    CompiledExpr prog;
+} FormulaColumn;
+
+typedef struct {
+    FormulaColumn formulas[MAX_FORMULA_COLUMNS];
+    int count;
+    AngleMode mode;
+} FormulaSet;
+
+// 计算统计
+typedef struct {
+    uint64_t rows;              // 数据行数
+    uint64_t errors;            // 出错的结果单元格数（输入不是数值或计算出错）
+    uint64_t firstErrorRow;     // 第一个出错的数据行（从 1 开始，0 表示没有出错）
+} ColumnStats;
+
+CalcError addFormulaColumn(FormulaSet* set, const char* definition);
+void freeFormulaSet(FormulaSet* set);
+
+CalcError evaluateCsvStream(FILE* input, FILE* output, const FormulaSet* set, ColumnStats* stats);
+CalcError evaluateColumnarFile(const char* inputPath, const char* outputPath, const FormulaSet* set,
+                               ColumnStats* stats);
+CalcError writeColumnarFile(const char* path, const char (*names)[MAX_VARIABLE_NAME],
+                            const double* const* columns, int columnCount, uint64_t rows);
+
+#endif // COLUMN_EVALUATOR_H
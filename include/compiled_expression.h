@@ -0,0 +1,176 @@
+#ifndef COMPILED_EXPRESSION_H
+#define COMPILED_EXPRESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "error_handling.h"
+#include "function_types.h"
+#include "aggregate_functions.h"
+#include "decimal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ─── 编译表达式 ─────────────────────────────────────────────────────────────
+//
+// 表达式先编译为后缀形式的字节码，再在栈机上求值；同一个表达式对不同
+// 变量取值反复计算时无需重复解析。表达式中的标识符（非函数、非常量）
+// 视为变量，按首次出现的顺序分配槽位。
+//
+// 批量求值按列进行：每条指令一次处理 BATCH_BLOCK_SIZE 行，
+// EVAL_FP32 模式使用单精度向量化内核，吞吐更高，相对误差约 1e-6。
+// EVAL_ADAPTIVE 模式在双精度下求值并估计误差上界，只有发生严重相消的行
+// 才用双双精度重新计算。
+//
+// 求值只传递错误代码（evaluateCompiledFast），成功时不构造错误消息；出错后
+// evaluateCompiled / diagnoseCompiled 根据出错指令及其操作数生成消息与位置。
+//
+// 单行求值（evaluateCompiled / evaluateCompiledNumber / evaluateCompiledFast）在 int64 上
+// 精确跟踪整数中间结果；evaluateExpression 与双精度批量求值不跟踪。中间结果不超过 2^53 时
+// 三者结果相同，超过时可能不同：x = 2^60 时 x+1-x 单行求值得到 1，其余得到 0。
+//
+// 以十进制模式编译（compileDecimalExpression）时，常量直接保存为定点尾数，
+// 只能用 evaluateCompiledDecimal 求值，不支持函数与 pi/e 常量。
+//
+// 以向量模式编译（compileVectorExpression）时还支持方括号字面量 [1, 2, 3] 与
+// 聚合函数，只能用 evaluateCompiledVector 求值（见 vector_value.h）。
+//
+// 编译时还按字节码估计求值代价（cost），用于在求值之前拒绝或分流昂贵的表达式
+// （见 evaluation_budget.h）。
+//
+// 普通模式与向量模式编译后还会识别单变量的多项式/有理式子树。默认只在结果与原指令
+// 逐位相同时（整数运算且不超过 2^53）一次求出整个子树；setPolynomialMode 可以开启
+// 双精度 Estrin 形式，结果可能与原指令相差若干 ulp（见 polynomial_evaluator.h）。
+//
+// 比较与逻辑运算的结果为 1 或 0，操作数非 0 即为真。条件 c ? a : b（或 if(c, a, b)）
+// 与 and / or 编译为带跳转的指令序列：
+//   c ? a : b   →  [c] BRANCH [a] JUMP [b] SELECT
+//   a and b     →  [a] BRANCH [b] AND          （or 同理）
+// 单行求值沿跳转执行，只计算选中的分支与需要的右操作数；批量求值不跳转，
+// 两个分支都按列计算，再按条件掩码逐行选择结果与错误（无分支的 blend），
+// 未选中分支中的错误不会报告。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define MAX_COMPILED_VARIABLES 16   // 单个表达式最多变量数
+#define BATCH_BLOCK_SIZE       256  // 批量求值每块行数
+#define DEFAULT_ESCALATION_TOLERANCE 1e-12  // 提升到双双精度的相对误差上界
+
+// 字节码操作码
+typedef enum {
+    OP_CONST,   // 压入常量
+    OP_VAR,     // 压入变量
+    OP_NEG,     // 取负
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_POW,
+    OP_CALL,    // 调用函数（FuncType）
+    OP_PACK,    // 弹出 slot 个值拼接为向量（仅向量模式）
+    OP_REDUCE,  // 聚合函数（func 为 AggregateType，slot 为参数个数，仅向量模式）
+    OP_LT,      // 比较：结果为 1 或 0
+    OP_LE,
+    OP_GT,
+    OP_GE,
+    OP_EQ,
+    OP_NE,
+    OP_NOT,
+    OP_AND,     // 右操作数之后，与前面的 OP_BRANCH 配对
+    OP_OR,
+    OP_BRANCH,  // 条件跳转：func 为配对的 OP_AND / OP_OR / OP_SELECT，slot 为跳转目标
+    OP_JUMP,    // 跳过 else 分支：slot 为 OP_SELECT 之后的位置
+    OP_SELECT   // 条件运算的结束
+} OpCode;
+
+// 字节码指令（16字节）
+typedef struct {
+    unsigned char op;       // OpCode
+    unsigned char func;     // OP_CALL 的函数类型；OP_BRANCH 配对的操作码
+    unsigned short slot;    // OP_VAR 的变量槽位；OP_PACK / OP_REDUCE 的操作数个数；跳转目标
+    int position;           // 对应源表达式中的位置（用于错误报告）
+    union {
+        double value;       // OP_CONST 的常量值
+        int64_t decimal;    // 十进制模式下 OP_CONST 的定点尾数
+    };
+} Instruction;
+
+struct PolynomialPlan;
+
+// 静态代价估计（向量模式按每个元素计）
+typedef struct {
+    uint32_t steps;     // 归约步数：二元运算、函数调用、拼接与聚合各 1 步（取负不计）
+    uint32_t weight;    // 加权代价，以一次加法为 1（除法、开方 4，乘方与超越函数 20）
+    uint32_t depth;     // 嵌套深度：顶层为 1，每层括号与函数参数加 1
+} ExpressionCost;
+
+// 编译后的表达式
+typedef struct {
+    const Instruction* code;    // 指令序列
+    int length;                 // 指令数
+    int maxStack;               // 求值所需最大栈深度
+    int varCount;               // 变量个数
+    char varNames[MAX_COMPILED_VARIABLES][MAX_VARIABLE_NAME];
+    Instruction* storage;       // 自有的指令缓冲区（NULL 表示 code 指向外部内存）
+    int isDecimal;              // 是否以十进制模式编译
+    DecimalContext decimal;     // 十进制模式的小数位数与舍入方式
+    int isVector;               // 是否以向量模式编译
+    struct PolynomialPlan* polynomials; // 多项式子树（按起始指令排序，可为 NULL）
+    int polynomialCount;
+    ExpressionCost cost;        // 编译时估计的求值代价
+} CompiledExpr;
+
+// 带整数标记的计算结果
+typedef struct {
+    double value;       // 结果（双精度）
+    int64_t intValue;   // 精确整数结果（isInteger 为真时有效）
+    int isInteger;      // 结果是否为 int64_t 范围内的精确整数
+} CalcNumber;
+
+// 求值精度
+typedef enum {
+    EVAL_FP64,      // 双精度（默认，与 evaluateExpression 结果一致）
+    EVAL_FP32,      // 单精度（仅批量求值）
+    EVAL_ADAPTIVE   // 双精度，误差上界超标时提升到双双精度
+} EvalPrecision;
+
+// 编译
+CalcError compileExpression(const char* expr, CompiledExpr* prog);
+CalcError compileExpressionN(const char* expr, size_t len, CompiledExpr* prog);
+CalcError compileDecimalExpression(const char* expr, DecimalContext context, CompiledExpr* prog);
+CalcError compileVectorExpression(const char* expr, CompiledExpr* prog);
+CalcError compileVectorExpressionN(const char* expr, size_t len, CompiledExpr* prog);
+void freeCompiledExpression(CompiledExpr* prog);
+int findCompiledVariable(const CompiledExpr* prog, const char* name);
+// 由字节码计算 prog->cost，nesting 为括号的最大嵌套层数
+void estimateCompiledCost(CompiledExpr* prog, int nesting);
+
+// 求值
+CalcError evaluateCompiled(const CompiledExpr* prog, const double* vars, AngleMode mode, double* result);
+CalcError evaluateCompiledNumber(const CompiledExpr* prog, const double* vars, AngleMode mode,
+                                 CalcNumber* result);
+ErrorCode evaluateCompiledFast(const CompiledExpr* prog, const double* vars, AngleMode mode, double* result);
+CalcError diagnoseCompiled(const CompiledExpr* prog, const double* vars, AngleMode mode);
+CalcError evaluateCompiledDecimal(const CompiledExpr* prog, const Decimal* vars, Decimal* result);
+CalcError evaluateDecimalExpression(const char* expr, DecimalContext context, Decimal* result);
+CalcError evaluateCompiledAdaptive(const CompiledExpr* prog, const double* vars, AngleMode mode,
+                                   double tolerance, double* result, int* escalated);
+CalcError evaluateCompiledBatch(const CompiledExpr* prog, const double* const* columns, size_t rows,
+                                AngleMode mode, EvalPrecision precision,
+                                double* results, ErrorCode* errors);
+// 批量求值的条件分支在栈之后需要的行错误快照字节数
+size_t branchSnapshotSize(const CompiledExpr* prog);
+
+char opcodeToOperator(int op);
+
+// 单行求值时 OP_BRANCH 是否跳转：and 在条件为假、or 在条件为真时跳过右操作数，
+// 条件运算在条件为假时跳到 else 分支
+static inline int branchTaken(const Instruction* ins, double condition) {
+    return (ins->func == OP_OR) ? (condition != 0) : (condition == 0);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COMPILED_EXPRESSION_H
@@ -0,0 +1,58 @@
+#ifndef DECIMAL_H
+#define DECIMAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "error_handling.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ─── 十进制定点数 ───────────────────────────────────────────────────────────
+//
+// 值 = mantissa / 10^scale，mantissa 为 int64_t（范围 ±INT64_MAX）。
+// 同一表达式的所有中间结果使用相同的小数位数，加减精确，乘除及字面量
+// 超出小数位数的部分按指定的舍入方式处理，因此 0.1+0.2 精确等于 0.3。
+// 乘除的中间结果使用 128 位整数，不经过 double。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define MAX_DECIMAL_SCALE 18   // 最大小数位数（10^18 < 2^63）
+
+// 舍入方式
+typedef enum {
+    DEC_ROUND_HALF_EVEN,    // 四舍六入五成双（默认，银行家舍入）
+    DEC_ROUND_HALF_UP,      // 四舍五入（0.5 远离零）
+    DEC_ROUND_DOWN,         // 向零截断
+    DEC_ROUND_FLOOR,        // 向负无穷
+    DEC_ROUND_CEILING       // 向正无穷
+} DecimalRounding;
+
+// 十进制定点数
+typedef struct {
+    int64_t mantissa;   // 整数尾数
+    int scale;          // 小数位数
+} Decimal;
+
+// 十进制模式参数
+typedef struct {
+    int scale;                  // 小数位数（0 ~ MAX_DECIMAL_SCALE）
+    DecimalRounding rounding;   // 舍入方式
+} DecimalContext;
+
+// 运算
+CalcError performDecimalOperation(char op, Decimal a, Decimal b, DecimalRounding rounding, Decimal* result);
+CalcError rescaleDecimal(Decimal value, int scale, DecimalRounding rounding, Decimal* result);
+CalcError decimalFromDigits(uint64_t digits, int exponent, int tailDigit, int tailSticky,
+                            int scale, DecimalRounding rounding, Decimal* result);
+double decimalToDouble(Decimal value);
+
+// 解析与格式化
+CalcError getDecimalWithError(const char** expr, int scale, DecimalRounding rounding, Decimal* result);
+char* formatDecimal(Decimal value, char* buffer, size_t bufferSize);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DECIMAL_H
@@ -1,6 +1,10 @@
 #ifndef ERROR_HANDLING_H
 #define ERROR_HANDLING_H
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // 错误代码枚举
 typedef enum {
     ERR_SUCCESS = 0,          // 成功
@@ -13,7 +17,8 @@ typedef enum {
     ERR_INVALID_ARGUMENT = 7, // 无效参数
     ERR_STACK_OVERFLOW = 8,   // 栈溢出
     ERR_MISSING_PARENTHESIS = 9, // 括号不匹配
-    ERR_EMPTY_EXPRESSION = 10 // 空表达式
+    ERR_EMPTY_EXPRESSION = 10, // 空表达式
+    ERR_BUDGET_EXCEEDED = 11  // 超出求值预算（步数、嵌套深度或时限）
 } ErrorCode;
 
 // 错误处理结构
@@ -35,4 +40,8 @@ typedef struct {
 // 错误处理函数声明
 const char* getErrorDescription(int errorCode);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // ERROR_HANDLING_H 
\ No newline at end of file
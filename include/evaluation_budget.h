@@ -0,0 +1,77 @@
+#ifndef EVALUATION_BUDGET_H
+#define EVALUATION_BUDGET_H
+
+#include <stdint.h>
+#include "error_handling.h"
+#include "compiled_expression.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ─── 求值预算 ───────────────────────────────────────────────────────────────
+//
+// 限制单次 evaluateExpression 的归约步数、嵌套深度与墙钟时限，防止个别病态
+// 表达式（很深的括号与函数嵌套、很长的 ^ 链、项数巨大的 sum/prod）长时间占用
+// 工作线程。超出任一限制时返回 ERR_BUDGET_EXCEEDED。
+//
+// 步数：每次二元运算归约（processOperators 与隐式乘法）、每次函数调用各计 1 步；
+// sum/prod 在求值前按 项数 × 项表达式的步数 一次计入，solve/integrate 每求一个
+// 点计入一次函数体的步数。嵌套深度：顶层为 1，每层括号、函数参数与 -(...) 加 1。
+// 时限：每 BUDGET_CLOCK_INTERVAL 步读一次单调时钟；sum/prod 的工作线程每块检查一次。
+//
+// 预算保存在线程局部的状态中，evaluateExpressionBudget 返回前恢复调用前的状态
+// （可以嵌套，内层预算在执行期间替换外层预算）。进程内从未使用过预算时，
+// 检查点只读一次 evaluationBudgetsUsed，不访问线程局部状态。
+//
+// 编译表达式的代价（CompiledExpr.cost）在编译时由字节码估计，checkCompiledBudget
+// 在求值之前按估计值拒绝超出预算的表达式，也可以据此把昂贵的表达式分流。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define BUDGET_CLOCK_INTERVAL 64    // 读取时钟的间隔（步）
+
+// 求值预算（各项为 0 表示不限制）
+typedef struct {
+    uint64_t maxSteps;      // 最大归约步数
+    int maxDepth;           // 最大嵌套深度
+    uint64_t deadlineNs;    // 截止时间（budgetClockNs 的绝对值）
+} EvaluationBudget;
+
+// 实际用量
+typedef struct {
+    uint64_t steps;         // 计入的步数
+    int depth;              // 达到的最大嵌套深度
+    uint64_t elapsedNs;     // 耗时
+} BudgetUsage;
+
+extern int evaluationBudgetsUsed;   // 进程内是否使用过预算（首次使用时置 1，只读）
+
+// 单调时钟（纳秒），截止时间按 budgetClockNs() + 时限 计算
+uint64_t budgetClockNs(void);
+
+// 在预算内计算表达式；usage 可为 NULL
+CalcError evaluateExpressionBudget(const char* expr, AngleMode mode, const EvaluationBudget* budget,
+                                   double* result, BudgetUsage* usage);
+// 按编译时估计的代价检查 rows 行求值是否超出预算（截止时间已过也返回错误）
+CalcError checkCompiledBudget(const CompiledExpr* prog, size_t rows, const EvaluationBudget* budget);
+
+// ─── 求值器内部使用的检查点 ─────────────────────────────────────────────────
+
+ErrorCode chargeBudgetSteps(uint64_t steps);
+ErrorCode enterBudgetLevel(void);
+void leaveBudgetLevel(void);
+int currentBudgetDepth(void);
+void restoreBudgetDepth(int depth);
+uint64_t currentBudgetDeadline(void);
+CalcError budgetExceededError(int position);
+
+// 计入 steps 步；当前线程没有预算时返回 ERR_SUCCESS
+static inline ErrorCode chargeEvaluationBudget(uint64_t steps) {
+    return evaluationBudgetsUsed ? chargeBudgetSteps(steps) : ERR_SUCCESS;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVALUATION_BUDGET_H
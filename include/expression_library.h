@@ -0,0 +1,78 @@
+#ifndef EXPRESSION_LIBRARY_H
+#define EXPRESSION_LIBRARY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "compiled_expression.h"
+
+// ─── 编译表达式库文件 ───────────────────────────────────────────────────────
+//
+// 将大量编译后的表达式保存为一个二进制文件，启动时用 mmap 映射，
+// 取用时直接指向文件中的字节码，无需重新解析或分配内存。
+//
+// 文件布局（所有偏移量相对于文件开头，8 字节对齐，与加载地址无关）：
+//   LibraryFileHeader
+//   记录 0, 记录 1, ...      每条记录为 LibraryRecordHeader + 变量名[varCount] + Instruction[length]
+//   uint64_t 索引[count]    每条记录的偏移量
+//
+// 常量直接保存在 OP_CONST 指令中（即每条记录的常量池）。文件按本机字节序
+// 写入，头部记录字节序标记与指令大小，不匹配时拒绝加载。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define LIBRARY_MAGIC          "CALCLIB"    // 文件标识（含结尾 '\0' 共 8 字节）
+#define LIBRARY_VERSION        2            // 文件格式版本（2：记录头增加括号嵌套层数）
+#define LIBRARY_ENDIAN_TAG     0x01020304u  // 字节序标记
+
+// 文件头
+typedef struct {
+    char magic[8];              // LIBRARY_MAGIC
+    uint32_t version;           // LIBRARY_VERSION
+    uint32_t endianTag;         // LIBRARY_ENDIAN_TAG
+    uint32_t instructionSize;   // sizeof(Instruction)
+    uint32_t count;             // 表达式条数
+    uint64_t indexOffset;       // 索引的偏移量
+    uint64_t fileSize;          // 文件总大小
+} LibraryFileHeader;
+
+// 记录头（后接 varCount 个变量名，每个 MAX_VARIABLE_NAME 字节，再接 length 条指令）
+typedef struct {
+    int32_t length;             // 指令数
+    int32_t maxStack;           // 最大栈深度
+    int32_t varCount;           // 变量个数
+    uint8_t angleMode;          // AngleMode
+    uint8_t isDecimal;          // 是否为十进制模式
+    uint8_t decimalScale;       // 十进制模式的小数位数
+    uint8_t decimalRounding;    // 十进制模式的舍入方式
+    uint32_t nesting;           // 括号的最大嵌套层数（用于代价估计）
+    uint32_t reserved;          // 保持 8 字节对齐
+} LibraryRecordHeader;
+
+// 已映射的表达式库
+typedef struct {
+    const unsigned char* base;  // 映射的起始地址
+    size_t size;                // 映射大小
+    uint32_t count;             // 表达式条数
+    const uint64_t* index;      // 记录偏移量表
+    void* mapping;              // 平台相关的映射句柄
+} ExpressionLibrary;
+
+// 表达式库写入器
+typedef struct {
+    FILE* file;
+    uint64_t* offsets;          // 已写入记录的偏移量
+    uint32_t count;
+    uint32_t capacity;
+    uint64_t position;          // 当前写入位置
+} LibraryWriter;
+
+// 写入
+CalcError openLibraryWriter(const char* path, LibraryWriter* writer);
+CalcError appendLibraryExpression(LibraryWriter* writer, const CompiledExpr* prog, AngleMode mode);
+CalcError closeLibraryWriter(LibraryWriter* writer);
+
+// 加载
+CalcError openExpressionLibrary(const char* path, ExpressionLibrary* lib);
+CalcError getLibraryExpression(const ExpressionLibrary* lib, uint32_t index, CompiledExpr* prog, AngleMode* mode);
+void closeExpressionLibrary(ExpressionLibrary* lib);
+
+#endif // EXPRESSION_LIBRARY_H
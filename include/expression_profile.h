@@ -0,0 +1,80 @@
+#ifndef EXPRESSION_PROFILE_H
+#define EXPRESSION_PROFILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include "compiled_expression.h"
+
+// ─── 表达式性能分析（explain） ─────────────────────────────────────────────
+//
+// 编译后的字节码是后缀形式，每条指令对应语法树的一个节点，节点的子树是
+// 紧挨在它前面的一段连续指令。profileCompiled 用插桩的求值循环把表达式
+// 执行 runs 次，逐节点统计自身耗时（x86 上为 TSC 周期，其他平台为纳秒）
+// 以及以下计数：
+//   - 三角函数的查表（lookupDegreeTrig）次数、特殊角检查（checkTrigSpecialAngle）
+//     耗时与命中次数
+//   - 接近整数修正（isCloseToInteger）耗时与实际修正的次数
+//   - int64 快速路径命中次数、^ 调用 pow 的次数
+// 特殊角检查单独再计时一次，是节点自身耗时中这一部分的估计值。
+//
+// 同时静态分析字节码：不含变量的子表达式给出折叠后的常量，x^2、x^0.5、
+// 重复计算的子表达式给出改写建议。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define MAX_PROFILE_HINTS    16
+#define DEFAULT_PROFILE_RUNS 10000   // explain 默认的求值次数
+
+// 单个节点的统计
+typedef struct {
+    int start;              // 子树第一条指令的下标（子树为 code[start..本节点]）
+    int parent;             // 父节点下标（-1 表示根）
+    uint64_t calls;         // 执行次数
+    uint64_t ticks;         // 自身耗时（不含子节点）
+    uint64_t specialTicks;  // 其中特殊角检查的耗时
+    uint64_t snapTicks;     // 其中接近整数修正的耗时
+    uint64_t specialHits;   // 命中特殊角的次数
+    uint64_t tableHits;     // 角度模式查表的次数（整数或半整数度）
+    uint64_t snaps;         // 结果被修正为整数的次数
+    uint64_t integerHits;   // 走 int64 快速路径的次数
+    uint64_t powCalls;      // 调用 pow 的次数
+} ProfileNode;
+
+// 分析结论
+typedef enum {
+    HINT_FOLD,      // 不含变量的子表达式，可折叠为 value
+    HINT_SQUARE,    // x^2、x^3 可改为连乘，避免调用 pow
+    HINT_SQRT,      // x^0.5 可改为 sqrt(x)
+    HINT_REPEATED   // 子表达式重复计算 value 次
+} ProfileHintKind;
+
+typedef struct {
+    ProfileHintKind kind;
+    int node;       // 对应的节点
+    double value;
+} ProfileHint;
+
+// 分析结果
+typedef struct {
+    const CompiledExpr* prog;
+    AngleMode mode;
+    int runs;
+    ProfileNode* nodes;         // 每条指令一个节点
+    uint64_t baselineTicks;     // 不插桩求值 runs 次的总耗时
+    uint64_t clockOverhead;     // 单次计时的固定开销（已从节点耗时中扣除）
+    double result;              // 求值结果
+    CalcError error;            // 求值错误（出错时只统计到出错的节点为止）
+    ProfileHint hints[MAX_PROFILE_HINTS];
+    int hintCount;
+} ExpressionProfile;
+
+CalcError profileCompiled(const CompiledExpr* prog, const double* vars, AngleMode mode, int runs,
+                          ExpressionProfile* profile);
+void freeExpressionProfile(ExpressionProfile* profile);
+
+// 节点对应的子表达式文本，返回写入的长度
+int formatProfileNode(const ExpressionProfile* profile, int node, char* buffer, size_t size);
+// 打印带注释的语法树、折叠的常量和改写建议
+void printExpressionProfile(const ExpressionProfile* profile, FILE* out);
+const char* profileClockUnit(void);
+
+#endif // EXPRESSION_PROFILE_H
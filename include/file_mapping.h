@@ -0,0 +1,19 @@
+#ifndef FILE_MAPPING_H
+#define FILE_MAPPING_H
+
+#include <stddef.h>
+#include "error_handling.h"
+
+// 只读文件映射（POSIX 使用 mmap，Windows 使用 MapViewOfFile）
+typedef struct {
+    const unsigned char* base;  // 映射的起始地址
+    size_t size;                // 文件大小
+    void* handle;               // 平台相关的映射句柄
+} MappedFile;
+
+CalcError mapReadOnlyFile(const char* path, MappedFile* file);
+void unmapFile(MappedFile* file);
+// 两个路径是否指向同一个已存在的文件（比较设备与 inode，识别 ./a、符号链接与硬链接）
+int isSameFile(const char* a, const char* b);
+
+#endif // FILE_MAPPING_H
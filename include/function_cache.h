@@ -0,0 +1,55 @@
+#ifndef FUNCTION_CACHE_H
+#define FUNCTION_CACHE_H
+
+#include <stdint.h>
+#include "function_types.h"
+
+// ─── 函数调用缓存（memo） ──────────────────────────────────────────────────
+//
+// 每个线程一张直接映射的小表，键为 (函数, 参数的位模式, 角度模式)，值为
+// calculateFunctionCode 的结果与错误代码。命中时跳过特殊角检查、libm 调用与
+// 接近整数修正；只缓存三角、反三角与对数函数（sqrt、abs 等比查表还快）。
+//
+// 缓存默认关闭，由 setFunctionCacheEnabled 在整个进程范围内开启（应在启动
+// 工作线程之前设置）。每个线程每 FUNCTION_CACHE_WINDOW 次查询检查一次命中率，
+// 低于 1/8 时自动关闭本线程的缓存，之后跳过 FUNCTION_CACHE_RETRY 次调用再重新尝试。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define FUNCTION_CACHE_BITS      8                              // 256 项
+#define FUNCTION_CACHE_SIZE      (1 << FUNCTION_CACHE_BITS)
+#define FUNCTION_CACHE_WINDOW    4096                           // 统计命中率的窗口
+#define FUNCTION_CACHE_MIN_HITS  (FUNCTION_CACHE_WINDOW / 8)    // 窗口内至少命中的次数
+#define FUNCTION_CACHE_RETRY     65536                          // 自动关闭后跳过的调用次数
+
+// 缓存项（tag 为 0 表示空）
+typedef struct {
+    uint64_t bits;      // 参数的位模式
+    uint32_t tag;       // 函数、角度模式与有效位
+    int32_t code;       // 错误代码
+    double result;
+} FunctionCacheEntry;
+
+// 当前线程的统计
+typedef struct {
+    uint64_t lookups;   // 缓存开启时的查询次数
+    uint64_t hits;      // 命中次数
+    uint64_t bypassed;  // 自动关闭期间直接计算的次数
+    uint32_t disables;  // 自动关闭的次数
+    int active;         // 当前是否开启（未自动关闭）
+} FunctionCacheStats;
+
+extern int functionCacheEnabled;    // 进程范围的开关，只读；用 setFunctionCacheEnabled 修改
+
+void setFunctionCacheEnabled(int enabled);
+// 当前线程的统计；清空当前线程的缓存与统计
+void getFunctionCacheStats(FunctionCacheStats* stats);
+void resetFunctionCache(void);
+
+// 查询缓存：命中时写入 *result、*code 并返回 1；未命中返回 0，*entry 为计算后
+// 应写入的缓存项（函数不缓存或本线程缓存已自动关闭时为 NULL）
+int lookupFunctionCache(FuncType func, double value, AngleMode mode, double* result, ErrorCode* code,
+                        FunctionCacheEntry** entry);
+void storeFunctionCache(FunctionCacheEntry* entry, FuncType func, double value, AngleMode mode,
+                        double result, ErrorCode code);
+
+#endif // FUNCTION_CACHE_H
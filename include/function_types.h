@@ -2,8 +2,13 @@
 #define FUNCTION_TYPES_H
 
 #include <math.h>
+#include <stddef.h>
 #include "error_handling.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // 角度模式
 typedef enum {
     MODE_DEG,  // 角度模式
@@ -31,17 +36,46 @@ typedef enum {
 #define PI 3.14159265358979323846
 #define E 2.71828182845904523536  // 自然对数的底
 
-// 运算符优先级
-#define PRIORITY_ADD 1    // + -
-#define PRIORITY_MUL 2    // * /
-#define PRIORITY_POW 3    // ^
+// 运算符优先级（? : 最低，由求值器按分支单独处理）
+#define PRIORITY_COND 1   // ? 之后尚未遇到 : 的标记
+#define PRIORITY_OR  2    // or
+#define PRIORITY_AND 3    // and
+#define PRIORITY_NOT 4    // not（前缀）
+#define PRIORITY_CMP 5    // < <= > >= == !=
+#define PRIORITY_ADD 6    // + -
+#define PRIORITY_MUL 7    // * /
+#define PRIORITY_POW 8    // ^
 #define PRIORITY_PAR 0    // (
 
+// 比较与逻辑运算符在运算符栈中的字符（两字符运算符与关键字各用一个字符表示）
+#define OPERATOR_LE   'l'   // <=
+#define OPERATOR_GE   'g'   // >=
+#define OPERATOR_EQ   '='   // ==
+#define OPERATOR_NE   '!'   // !=
+#define OPERATOR_AND  '&'   // and
+#define OPERATOR_OR   '|'   // or
+#define OPERATOR_NOT  '~'   // not
+#define OPERATOR_COND '?'   // ? 的标记
+
 // 函数声明
 FuncType getFunction(const char** expr);
+const char* getFunctionName(FuncType func);
 int getPriority(char op);
+const char* getOperatorSymbol(char op);
 CalcError calculateFunctionWithError(FuncType func, double value, AngleMode mode, double* result);
+ErrorCode calculateFunctionCode(FuncType func, double value, AngleMode mode, double* result);
+ErrorCode calculateFunctionRaw(FuncType func, double value, AngleMode mode, double* result);
+double calculateFunctionIEEE(FuncType func, double value, AngleMode mode);
+int checkTrigSpecialAngle(double angle, AngleMode mode, FuncType funcType);
+int lookupDegreeTrig(FuncType func, double degrees, double* result);
+const char* describeFunctionError(FuncType func, ErrorCode code);
+void calculateFunctionBlockF32(FuncType func, const float* input, float* output, size_t count,
+                               AngleMode mode, unsigned char* errors);
 double degreeToRadian(double degree);
 double radianToDegree(double radian);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // FUNCTION_TYPES_H 
\ No newline at end of file
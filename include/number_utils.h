@@ -5,6 +5,10 @@
 #include <stdint.h>  // 添加对int64_t的支持
 #include "error_handling.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // ─── 精度控制常量 ────────────────────────────────────────────────────────────
 //
 // 精度层级（从严到宽）：
@@ -28,6 +32,12 @@
 #define ANGLE_EPSILON_DEG       0.001  // 角度模式特殊角判断容差（单位：度）
 #define ANGLE_EPSILON_RAD       0.0001 // 弧度模式特殊角判断容差（单位：弧度）
 
+// 单精度（EVAL_FP32）对应的阈值：float 的机器精度约为 1.2e-7，
+// 各阈值按与双精度相近的 ulp 倍数放宽
+#define ABSOLUTE_ZERO_THRESHOLD_F32 1e-6f  // 单精度绝对零阈值
+#define RELATIVE_EPSILON_F32        1e-6f  // 单精度相对误差阈值
+#define EPSILON_F32                 1e-6f  // 单精度接近整数判断阈值
+
 #define DISPLAY_FORMAT_THRESHOLD 1e7   // 超过此值切换为科学计数法显示
 #define DISPLAY_FORMAT_MIN       1e-4  // 小于此值切换为科学计数法显示
 #define PRECISION                10    // 结果显示的小数点后最大位数
@@ -36,16 +46,28 @@
 // 整数处理常量
 #define MAX_INTEGER_DIGITS 15        // 整数部分最大位数（防止溢出）
 #define LARGE_INTEGER_THRESHOLD 1e15 // 大整数显示阈值（超过使用科学计数法）
+#define MAX_EXACT_DOUBLE_INTEGER 9007199254740992LL // 2^53，double 可精确表示的最大整数
 
 // 历史记录大小
 #define HISTORY_SIZE 5
 
 // 数值处理函数声明
 CalcError getNumberWithError(const char** expr, double* result);
+int parseNumberField(const char* begin, const char* end, double* result);
 int isInfinite(double value);
 int isUndefined(double value);
 int isDoubleEqual(double a, double b);
 int isCloseToInteger(double value, int64_t* intValue);  // 将long改为int64_t
+int doubleToExactInt64(double value, int64_t* intValue);
 char* formatNumber(double value, char* buffer, size_t bufferSize);
+int formatRoundTrip(double value, char* buffer, size_t bufferSize);
+
+// 单精度数值处理
+int isFloatEqual(float a, float b);
+void snapFloatArray(float* values, size_t count);
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif // NUMBER_UTILS_H
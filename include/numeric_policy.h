@@ -0,0 +1,54 @@
+#ifndef NUMERIC_POLICY_H
+#define NUMERIC_POLICY_H
+
+#include <stddef.h>
+#include "compiled_expression.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ─── 数值策略 ───────────────────────────────────────────────────────────────
+//
+// 计算器对每一步运算施加同一套规则：结果溢出（含 NaN）报 ERR_OVERFLOW，
+// 除零与定义域之外报错，接近整数的结果修正为整数，三角函数识别特殊角。
+// 这些规则作为编译期参数写在 numeric_policy_template.h 中，numeric_policy.c 按参数
+// 组合各生成一份运算、函数、单行求值与批量求值，循环内没有运行时的策略分支：
+//
+//   POLICY_OVERFLOW_CHECKS   结果非有限时报 ERR_OVERFLOW
+//   POLICY_DOMAIN_ERRORS     除数接近 0、0 的负数次幂、负数的小数次幂、函数定义域之外报错
+//   POLICY_SNAP_INTEGERS     整数快速路径，接近整数的结果修正为整数
+//   POLICY_SNAP_ANGLES       角度查表、特殊角返回精确值、sin/cos 接近 0 的结果修正为 0
+//
+// 目前生成两份：
+//   POLICY_CHECKED   全部开启（默认），运算与函数就是 performOperationCode / calculateFunctionCode
+//   POLICY_IEEE      全部关闭：NaN 与 Inf 照常传播，不报错也不修正，批量求值的算术循环可以向量化
+//
+// 只在调用入口按 NumericPolicy 选择一次实例。策略求值不使用多项式改写，
+// POLICY_CHECKED 的结果与 evaluateCompiledBatch（EVAL_FP64）逐行求值的语义一致。
+// ─────────────────────────────────────────────────────────────────────────────
+
+typedef enum {
+    POLICY_CHECKED,     // 默认：溢出与定义域检查、接近整数与特殊角修正
+    POLICY_IEEE         // IEEE 语义：不检查、不修正
+} NumericPolicy;
+
+// 单个运算与函数（POLICY_IEEE 总是返回 ERR_SUCCESS）
+ErrorCode performPolicyOperation(NumericPolicy policy, char op, double a, double b, double* result);
+ErrorCode calculatePolicyFunction(NumericPolicy policy, FuncType func, double value, AngleMode mode,
+                                  double* result);
+
+// 单行求值：只返回错误代码，需要错误消息时调用 diagnoseCompiled
+ErrorCode evaluateCompiledPolicy(const CompiledExpr* prog, const double* vars, AngleMode mode,
+                                 NumericPolicy policy, double* result);
+
+// 批量求值（双精度，每块 BATCH_BLOCK_SIZE 行）：POLICY_CHECKED 出错的行为 NaN，
+// 返回第一个出错行的错误；POLICY_IEEE 不会出错，errors 全部为 ERR_SUCCESS
+CalcError evaluateCompiledBatchPolicy(const CompiledExpr* prog, const double* const* columns, size_t rows,
+                                      AngleMode mode, NumericPolicy policy, double* results, ErrorCode* errors);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NUMERIC_POLICY_H
@@ -0,0 +1,294 @@
+// ─── 数值策略模板 ───────────────────────────────────────────────────────────
+//
+// 只由 numeric_policy.c 包含，每包含一次生成一份实例（没有 include guard）。
+// 包含前定义：
+//   POLICY_NAME              实例名后缀（如 Checked）
+//   POLICY_OVERFLOW_CHECKS   0 或 1，含义见 numeric_policy.h
+//   POLICY_DOMAIN_ERRORS
+//   POLICY_SNAP_INTEGERS
+//   POLICY_SNAP_ANGLES
+// 生成 policyOperation##POLICY_NAME、policyFunction##POLICY_NAME、
+// policyRun##POLICY_NAME、policyBlock##POLICY_NAME，包含结束时取消以上定义。
+// 策略参数只出现在 #if 中，生成的代码里没有策略分支。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define POLICY_CONCAT_(a, b) a##b
+#define POLICY_CONCAT(a, b) POLICY_CONCAT_(a, b)
+#define POLICY_FN(name) POLICY_CONCAT(name, POLICY_NAME)
+#define POLICY_REPORTS_ERRORS (POLICY_OVERFLOW_CHECKS || POLICY_DOMAIN_ERRORS)
+
+/**
+ * 二元运算 + - * / ^
+ */
+static inline ErrorCode POLICY_FN(policyOperation)(char op, double a, double b, double* result) {
+#if POLICY_OVERFLOW_CHECKS && POLICY_DOMAIN_ERRORS && POLICY_SNAP_INTEGERS
+    // 全部开启即默认策略
+    return performOperationCode(op, a, b, result);
+#else
+  #if POLICY_SNAP_INTEGERS
+    int64_t intA, intB, intResult;
+    if (doubleToExactInt64(a, &intA) && doubleToExactInt64(b, &intB) &&
+        performIntegerOperation(op, intA, intB, &intResult) &&
+        intResult >= -MAX_EXACT_DOUBLE_INTEGER && intResult <= MAX_EXACT_DOUBLE_INTEGER) {
+        *result = (double)intResult;
+        return ERR_SUCCESS;
+    }
+  #endif
+    switch (op) {
+        case '+': *result = a + b; break;
+        case '-': *result = a - b; break;
+        case '*': *result = a * b; break;
+        case '/':
+  #if POLICY_DOMAIN_ERRORS
+            if (fabs(b) < ABSOLUTE_ZERO_THRESHOLD) return ERR_DIV_BY_ZERO;
+  #endif
+            *result = a / b;
+            break;
+        case '^':
+  #if POLICY_DOMAIN_ERRORS
+            if ((fabs(a) < ABSOLUTE_ZERO_THRESHOLD && b < 0) || (a < 0 && fabs(b - (int64_t)b) > EPSILON)) {
+                return ERR_UNDEFINED;
+            }
+  #endif
+            *result = pow(a, b);
+            break;
+        default:
+            return ERR_SYNTAX;
+    }
+  #if POLICY_OVERFLOW_CHECKS
+    if (isInfinite(*result)) return ERR_OVERFLOW;
+  #endif
+  #if POLICY_SNAP_INTEGERS
+    int64_t intValue;
+    if (isCloseToInteger(*result, &intValue)) *result = (double)intValue;
+  #endif
+    return ERR_SUCCESS;
+#endif
+}
+
+/**
+ * 数学函数
+ */
+static inline ErrorCode POLICY_FN(policyFunction)(FuncType func, double value, AngleMode mode, double* result) {
+#if POLICY_OVERFLOW_CHECKS && POLICY_DOMAIN_ERRORS && POLICY_SNAP_INTEGERS && POLICY_SNAP_ANGLES
+    // 全部开启即默认策略（含函数缓存）
+    return calculateFunctionCode(func, value, mode, result);
+#else
+    ErrorCode code = ERR_SUCCESS;
+  #if POLICY_SNAP_ANGLES
+    code = calculateFunctionRaw(func, value, mode, result);
+    #if !POLICY_DOMAIN_ERRORS
+    if (code != ERR_SUCCESS) {
+        *result = NAN;
+        code = ERR_SUCCESS;
+    }
+    #endif
+  #else
+    *result = calculateFunctionIEEE(func, value, mode);
+    #if POLICY_DOMAIN_ERRORS
+    code = functionDomainError(func, value);
+    #endif
+  #endif
+  #if POLICY_OVERFLOW_CHECKS
+    if (code == ERR_SUCCESS && isinf(*result)) code = ERR_OVERFLOW;
+  #endif
+  #if POLICY_SNAP_INTEGERS
+    int64_t intValue;
+    if (code == ERR_SUCCESS && !isnan(*result) && isCloseToInteger(*result, &intValue)) *result = (double)intValue;
+  #endif
+    return code;
+#endif
+}
+
+/**
+ * 单行求值：默认策略就是 evaluateCompiledFast，其余策略用双精度栈（不跟踪精确整数）
+ */
+static ErrorCode POLICY_FN(policyRun)(const CompiledExpr* prog, const double* vars, AngleMode mode,
+                                      double* result) {
+#if POLICY_OVERFLOW_CHECKS && POLICY_DOMAIN_ERRORS && POLICY_SNAP_INTEGERS && POLICY_SNAP_ANGLES
+    // 全部开启即默认策略：超过 2^53 的整数中间结果也要在 int64_t 上精确跟踪
+    return evaluateCompiledFast(prog, vars, mode, result);
+#else
+    double stack[MAX_EXPR];
+    int top = -1;
+    ErrorCode code = ERR_SUCCESS;
+
+    for (int i = 0; i < prog->length; i++) {
+        const Instruction* ins = &prog->code[i];
+        switch (ins->op) {
+            case OP_CONST: stack[++top] = ins->value; break;
+            case OP_VAR:   stack[++top] = vars[ins->slot]; break;
+            case OP_NEG:   stack[top] = -stack[top]; break;
+            case OP_CALL:
+                code = POLICY_FN(policyFunction)((FuncType)ins->func, stack[top], mode, &stack[top]);
+                break;
+            case OP_ADD: top--; code = POLICY_FN(policyOperation)('+', stack[top], stack[top + 1], &stack[top]); break;
+            case OP_SUB: top--; code = POLICY_FN(policyOperation)('-', stack[top], stack[top + 1], &stack[top]); break;
+            case OP_MUL: top--; code = POLICY_FN(policyOperation)('*', stack[top], stack[top + 1], &stack[top]); break;
+            case OP_DIV: top--; code = POLICY_FN(policyOperation)('/', stack[top], stack[top + 1], &stack[top]); break;
+            case OP_POW: top--; code = POLICY_FN(policyOperation)('^', stack[top], stack[top + 1], &stack[top]); break;
+            case OP_LT:
+            case OP_LE:
+            case OP_GT:
+            case OP_GE:
+            case OP_EQ:
+            case OP_NE:  top--; stack[top] = compareOperands(opcodeToOperator(ins->op), stack[top], stack[top + 1]); break;
+            case OP_NOT: stack[top] = (stack[top] == 0); break;
+            case OP_AND:
+            case OP_OR:  stack[top] = (stack[top] != 0); break;
+            case OP_BRANCH:
+                if (branchTaken(ins, stack[top])) {
+                    if (ins->func == OP_SELECT) top--;
+                    else stack[top] = (ins->func == OP_OR);
+                    i = ins->slot - 1;
+                } else {
+                    top--;
+                }
+                break;
+            case OP_JUMP:   i = ins->slot - 1; break;
+            case OP_SELECT: break;
+            default: return ERR_SYNTAX;
+        }
+#if POLICY_REPORTS_ERRORS
+        if (code != ERR_SUCCESS) return code;
+#endif
+    }
+    *result = stack[0];
+    return code;
+#endif
+}
+
+// 一种二元运算作用于整列（运算符为常量，内联后只剩对应的算术）
+#if POLICY_REPORTS_ERRORS
+  #define POLICY_COLUMN_OPERATION(op)                                                   \
+    for (size_t r = 0; r < count; r++) {                                                \
+        ErrorCode code_ = POLICY_FN(policyOperation)(op, dst[r], rhs[r], &dst[r]);      \
+        if (code_ != ERR_SUCCESS && rowErrors[r] == 0) rowErrors[r] = (unsigned char)code_; \
+    }
+#else
+  #define POLICY_COLUMN_OPERATION(op)                                                   \
+    for (size_t r = 0; r < count; r++) {                                                \
+        (void)POLICY_FN(policyOperation)(op, dst[r], rhs[r], &dst[r]);                  \
+    }
+#endif
+
+/**
+ * 批量求值一块（count 行，按列逐条指令处理）
+ */
+static void POLICY_FN(policyBlock)(const CompiledExpr* prog, const double* const* columns, size_t offset,
+                                   size_t count, AngleMode mode, double* stack, unsigned char* rowErrors,
+                                   unsigned char* snapshots, double* out) {
+    int top = -1;
+    unsigned char* frame = snapshots;   // 当前条件分支的行错误快照
+
+    for (int i = 0; i < prog->length; i++) {
+        const Instruction* ins = &prog->code[i];
+        double* dst;
+        double* rhs;
+
+        switch (ins->op) {
+            case OP_CONST:
+                dst = stack + (size_t)(++top) * BATCH_BLOCK_SIZE;
+                for (size_t r = 0; r < count; r++) dst[r] = ins->value;
+                break;
+
+            case OP_VAR:
+                dst = stack + (size_t)(++top) * BATCH_BLOCK_SIZE;
+                memcpy(dst, columns[ins->slot] + offset, count * sizeof(double));
+                break;
+
+            case OP_NEG:
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                for (size_t r = 0; r < count; r++) dst[r] = -dst[r];
+                break;
+
+            case OP_CALL:
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                for (size_t r = 0; r < count; r++) {
+                    ErrorCode code = POLICY_FN(policyFunction)((FuncType)ins->func, dst[r], mode, &dst[r]);
+#if POLICY_REPORTS_ERRORS
+                    if (code != ERR_SUCCESS && rowErrors[r] == 0) rowErrors[r] = (unsigned char)code;
+#else
+                    (void)code;
+#endif
+                }
+                break;
+
+            case OP_NOT:
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                for (size_t r = 0; r < count; r++) dst[r] = (dst[r] == 0);
+                break;
+
+            // 条件分支：两侧都计算，按条件掩码选择值与行错误
+            case OP_BRANCH:
+#if POLICY_REPORTS_ERRORS
+                memcpy(frame, rowErrors, count);
+#endif
+                frame += 2 * BATCH_BLOCK_SIZE;
+                break;
+
+            case OP_JUMP:
+#if POLICY_REPORTS_ERRORS
+                memcpy(frame - BATCH_BLOCK_SIZE, rowErrors, count);
+                memcpy(rowErrors, frame - 2 * BATCH_BLOCK_SIZE, count);
+#endif
+                break;
+
+            case OP_SELECT:
+                frame -= 2 * BATCH_BLOCK_SIZE;
+                top -= 2;
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+#if POLICY_REPORTS_ERRORS
+                selectRowErrors(dst, frame + BATCH_BLOCK_SIZE, rowErrors, rowErrors, count);
+#endif
+                vectorSelect(dst, dst + BATCH_BLOCK_SIZE, dst + 2 * BATCH_BLOCK_SIZE, dst, count);
+                break;
+
+            default:
+                top--;
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                rhs = dst + BATCH_BLOCK_SIZE;
+                if (ins->op == OP_AND || ins->op == OP_OR) {
+                    frame -= 2 * BATCH_BLOCK_SIZE;
+#if POLICY_REPORTS_ERRORS
+                    if (ins->op == OP_AND) {
+                        selectRowErrors(dst, rowErrors, frame, rowErrors, count);
+                    } else {
+                        selectRowErrors(dst, frame, rowErrors, rowErrors, count);
+                    }
+#endif
+                }
+                switch (ins->op) {
+                    case OP_ADD: POLICY_COLUMN_OPERATION('+'); break;
+                    case OP_SUB: POLICY_COLUMN_OPERATION('-'); break;
+                    case OP_MUL: POLICY_COLUMN_OPERATION('*'); break;
+                    case OP_DIV: POLICY_COLUMN_OPERATION('/'); break;
+                    case OP_POW: POLICY_COLUMN_OPERATION('^'); break;
+                    default:
+                        vectorCompare(opcodeToOperator(ins->op), dst, 1, rhs, 1, dst, count);
+                        break;
+                }
+                break;
+        }
+    }
+
+#if POLICY_REPORTS_ERRORS
+    for (size_t r = 0; r < count; r++) {
+        out[r] = rowErrors[r] ? NAN : stack[r];
+    }
+#else
+    (void)rowErrors;
+    memcpy(out, stack, count * sizeof(double));
+#endif
+}
+
+#undef POLICY_COLUMN_OPERATION
+#undef POLICY_REPORTS_ERRORS
+#undef POLICY_FN
+#undef POLICY_CONCAT
+#undef POLICY_CONCAT_
+#undef POLICY_NAME
+#undef POLICY_OVERFLOW_CHECKS
+#undef POLICY_DOMAIN_ERRORS
+#undef POLICY_SNAP_INTEGERS
+#undef POLICY_SNAP_ANGLES
@@ -0,0 +1,51 @@
+#ifndef NUMERIC_SOLVER_H
+#define NUMERIC_SOLVER_H
+
+#include <stddef.h>
+#include "vector_value.h"
+
+// ─── 求根与数值积分 ─────────────────────────────────────────────────────────
+//
+//   solve(expr, x, lo, hi)       在 [lo, hi] 内求 expr = 0 的根（Brent 方法，两端函数值必须异号）
+//   integrate(expr, x, a, b)     求 expr 在 [a, b] 上的积分（自适应 Gauss-Kronrod 7-15）
+//
+// expr 只编译一次（compileVectorFunction）。Brent 每步求一个点；积分按轮进行，每一轮
+// 把所有未达到精度的子区间二等分，全部新子区间的 15 个节点拼成一个向量整体求值。
+// 函数值按计算器的规则求值（接近整数的结果会被修正），求根精度因此受 EPSILON 限制。
+// 容差与迭代预算由 SolverOptions 给出，超出预算返回 ERR_UNDEFINED。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define SOLVE_TOLERANCE          1e-12  // 求根：根的绝对误差
+#define SOLVE_MAX_ITERATIONS     100    // 求根：最多求值次数
+#define INTEGRATE_TOLERANCE      1e-10  // 积分：误差估计上限（绝对与相对取大者）
+#define INTEGRATE_MAX_INTERVALS  2000   // 积分：最多求值的子区间数
+
+typedef enum {
+    SOLVER_NONE,
+    SOLVER_SOLVE,       // solve(expr, x, lo, hi)
+    SOLVER_INTEGRATE    // integrate(expr, x, a, b)
+} SolverType;
+
+typedef struct {
+    double tolerance;   // 求根：根的绝对误差（不小于 |x|·DBL_EPSILON）；积分：max(tolerance, tolerance·|I|)
+    int maxIterations;  // 求根：求值次数上限；积分：子区间数上限
+} SolverOptions;
+
+// 默认容差与预算
+SolverOptions defaultSolverOptions(SolverType type);
+
+// 识别 solve/integrate 的四参数形式：名字后是括号且括号内恰好有 4 个参数时前进到名字之后
+SolverType getSolverFunction(const char** expr);
+
+// 对已编译的函数求根/积分；options 为 NULL 时使用默认值
+CalcError solveFunction(const VectorFunction* fn, double lo, double hi, AngleMode mode,
+                        const SolverOptions* options, double* root);
+CalcError integrateFunction(const VectorFunction* fn, double a, double b, AngleMode mode,
+                            const SolverOptions* options, double* result);
+
+// 编译 body（自变量为 name）并求根/积分；body、name 不要求以 '\0' 结尾
+// 出错时 position 为 body 内的位置，变量名与区间的错误 position 为 -1
+CalcError evaluateSolver(SolverType type, const char* body, size_t bodyLen, const char* name, size_t nameLen,
+                         double lo, double hi, AngleMode mode, const SolverOptions* options, double* result);
+
+#endif // NUMERIC_SOLVER_H
@@ -0,0 +1,86 @@
+#ifndef POLYNOMIAL_EVALUATOR_H
+#define POLYNOMIAL_EVALUATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "compiled_expression.h"
+
+// ─── 多项式与有理式子表达式 ─────────────────────────────────────────────────
+//
+// 编译（普通模式与向量模式）之后扫描字节码，找出只含一个变量的最大多项式子树
+// （如 3*x^4 + 2*x^3 - x + 7）与两个多项式之比，把系数记录在 PolynomialPlan 中：
+//   - 允许的运算：常量、同一个变量、+ -、取负、乘以单项式、除以常量、
+//     单项式的非负整数次幂；多项式与多项式相乘或多项式的乘方不展开（展开后
+//     在根附近会发生严重相消）
+//   - 次数不低于 2 的多项式，或分子分母都是多项式的有理式才记录
+//   - 记录前在若干采样点上与原指令的求值结果比较，超出 POLYNOMIAL_TOLERANCE
+//     （相对于各项绝对值之和）的子树不记录
+//
+// 原指令保持不变，库序列化、十进制、误差上界、剖析等求值方式照常使用原指令。
+// 单行、批量与向量求值遇到子树起点时按改写方式一次求出整个子树：
+//   - POLYNOMIAL_EXACT（默认）：只用精确形式。原指令的每一步都是整数运算
+//     （常量、系数与中间结果都是整数），自变量为整数，且识别时推出的中间结果
+//     上界不超过 2^53 时，在 int64_t 上求值；此时原指令也没有舍入，结果逐位相同。
+//     其余情况执行原指令
+//   - POLYNOMIAL_FAST（setPolynomialMode 开启）：精确形式之外的情况用双精度
+//     Estrin 形式（各级之间相互独立，批量求值按 POLYNOMIAL_LANES 行一组展开，
+//     便于向量化与指令级并行）。单行与批量的运算顺序相同，结果逐位一致，
+//     但与原指令可能相差若干 ulp（根附近的相对误差更大）；单精度批量求值也只在
+//     此方式下使用 Estrin 形式
+// 结果非有限、分母接近 0 或整数计算溢出时回到原指令求值，错误与原语义一致。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define MAX_POLYNOMIAL_DEGREE   16      // 可记录的最高次数
+#define POLYNOMIAL_TOLERANCE    1e-8    // 采样验证的相对误差上限
+#define POLYNOMIAL_LANES        8       // Estrin 形式每组行数
+
+// 一个多项式（或有理式）子树：系数按升幂排列
+typedef struct PolynomialPlan {
+    int start;                  // 子树第一条指令
+    int end;                    // 子树最后一条指令之后
+    int slot;                   // 自变量槽位
+    int degree;                 // 分子次数
+    int denominatorDegree;      // 分母次数（isRational 为 0 时为 0）
+    int isRational;             // 是否为两个多项式之比
+    int isExact;                // 能否使用精确形式（原指令每一步都是整数运算）
+    int fast;                   // 是否允许双精度 Estrin 形式（POLYNOMIAL_FAST）
+    int boundDegree;            // 中间结果上界的次数
+    int denominatorBoundDegree;
+    double numerator[MAX_POLYNOMIAL_DEGREE + 1];
+    double denominator[MAX_POLYNOMIAL_DEGREE + 1];
+    int64_t integerNumerator[MAX_POLYNOMIAL_DEGREE + 1];    // 以下在 isExact 时有效
+    int64_t integerDenominator[MAX_POLYNOMIAL_DEGREE + 1];
+    int64_t integerBound[MAX_POLYNOMIAL_DEGREE + 1];        // 原指令中间结果绝对值的上界（在 |x| 处取值）
+    int64_t integerDenominatorBound[MAX_POLYNOMIAL_DEGREE + 1];
+} PolynomialPlan;
+
+// 多项式子树的改写方式
+typedef enum {
+    POLYNOMIAL_EXACT,   // 只使用与原指令逐位相同的精确形式（默认）
+    POLYNOMIAL_FAST     // 另外使用双精度 Estrin 形式，结果可能与原指令相差若干 ulp
+} PolynomialMode;
+
+// 识别并验证 prog 中的多项式子树，结果保存在 prog->polynomials（按 start 排序），
+// 由 freeCompiledExpression 释放；没有可记录的子树或内存不足时不附加
+void attachPolynomialPlans(CompiledExpr* prog);
+
+// 设置 prog 中全部子树的改写方式（编译后为 POLYNOMIAL_EXACT）
+void setPolynomialMode(CompiledExpr* prog, PolynomialMode mode);
+
+// 单行求值：成功返回 1；需要回到原指令求值时返回 0
+int evaluatePolynomialNumber(const PolynomialPlan* plan, double x, CalcNumber* result);
+
+// 对数组求值，每一行与 evaluatePolynomialNumber 逐位相同：x 与 out 可以相同；
+// 返回第一个需要回到原指令求值的下标，全部成功时返回 count
+size_t evaluatePolynomialArray(const PolynomialPlan* plan, const double* x, size_t count, double* out);
+// 单精度 Estrin 形式（结果不做接近整数修正，由调用方按单精度阈值修正）；POLYNOMIAL_EXACT 时返回 0
+size_t evaluatePolynomialArrayF32(const PolynomialPlan* plan, const double* x, size_t count, float* out);
+
+// 单行求值跳转到 target 之后，跳过起点位于被跳过指令中的子树
+static inline const PolynomialPlan* seekPolynomialPlan(const PolynomialPlan* plan, const PolynomialPlan* end,
+                                                       int target) {
+    while (plan < end && plan->start < target) plan++;
+    return plan;
+}
+
+#endif // POLYNOMIAL_EVALUATOR_H
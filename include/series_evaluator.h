@@ -0,0 +1,43 @@
+#ifndef SERIES_EVALUATOR_H
+#define SERIES_EVALUATOR_H
+
+#include <stddef.h>
+#include "compiled_expression.h"
+
+// ─── 求和与连乘 ─────────────────────────────────────────────────────────────
+//
+//   sum(i, a, b, expr)    对整数 i = a..b 求 expr 的和（a > b 时为 0）
+//   prod(i, a, b, expr)   对整数 i = a..b 求 expr 的积（a > b 时为 1）
+//
+// expr 只编译一次（compileVectorFunction），i 以 SERIES_BLOCK_SIZE 个下标为一块
+// 作为向量变量整块求值，逐元素运算走 vector_value.h 的 SIMD 内核；expr 中含聚合
+// 函数或方括号时（整块求值会改变语义）改为逐个下标求值。其他变量取 bindArrayVariable
+// 绑定的数组，但每一项必须是标量。expr 中不能再出现 sum/prod 的四参数形式（不支持嵌套）。
+//
+// 求和：块内用 sumArray（成对 + Kahan），块之间用 Neumaier 补偿累加；
+// 连乘：每一项拆成尾数与指数，尾数用 Dekker 双积补偿，指数单独累加，中间结果
+// 不会提前上溢或下溢。项数超过 SERIES_PARALLEL_THRESHOLD 时按块分给多个线程，
+// 各块的部分结果按块顺序合并，结果与线程数无关。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define SERIES_BLOCK_SIZE          4096         // 每块下标个数
+#define SERIES_PARALLEL_THRESHOLD  65536        // 超过此项数时并行计算
+#define SERIES_MAX_THREADS         8            // 并行计算最大线程数
+#define SERIES_MAX_TERMS           100000000    // 项数上限
+
+typedef enum {
+    SERIES_NONE,
+    SERIES_SUM,     // sum(i, a, b, expr)
+    SERIES_PROD     // prod(i, a, b, expr)
+} SeriesType;
+
+// 识别 sum/prod 的四参数形式：名字后是括号且括号内恰好有 4 个参数时前进到名字之后，
+// 否则不移动 *expr 并返回 SERIES_NONE（sum(v) 仍是聚合函数）
+SeriesType getSeriesFunction(const char** expr);
+
+// 计算级数：index 为下标变量名，body 为项表达式（均不要求以 '\0' 结尾）
+// 出错时 position 为 body 内的位置
+CalcError evaluateSeries(SeriesType type, const char* index, size_t indexLen, double from, double to,
+                         const char* body, size_t bodyLen, AngleMode mode, double* result);
+
+#endif // SERIES_EVALUATOR_H
@@ -0,0 +1,97 @@
+#ifndef SHARED_RING_H
+#define SHARED_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "error_handling.h"
+#include "compiled_expression.h"
+
+// ─── 共享内存环形队列 ───────────────────────────────────────────────────────
+//
+// 同机的生产者进程通过 POSIX 共享内存把表达式交给计算服务，不经过套接字，
+// 每条请求没有系统调用，也不复制字符串。
+//
+// 共享区域为 RingHeader + RingSlot[capacity]。生产者（可以有多个）用 CAS
+// 推进 tail 认领槽位（按序号判断槽位是否空闲），写入表达式与变量绑定后把
+// state 置为 RING_SLOT_REQUEST；服务（单个消费者）按 head 顺序处理，直接
+// 对共享内存中的表达式按长度编译求值，把结果与错误代码/位置写回同一槽位，
+// 置为 RING_SLOT_DONE；生产者取回结果后释放槽位。结果未取回前槽位不能复用，
+// 因此队列满时 submitRingRequest 返回 ERR_STACK_OVERFLOW 而不是一直等待。
+//
+// 等待时先自旋，超过自旋上限后用 futex 休眠；自旋上限按最近的等待结果
+// 自适应调整（自旋内等到则加倍，需要休眠则减半）。仅支持 Linux。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define SHARED_RING_MAGIC       0x52434C43u  // "CLCR"
+#define SHARED_RING_VERSION     1
+#define DEFAULT_RING_CAPACITY   1024    // 默认槽位数（必须是 2 的幂）
+#define MAX_RING_EXPRESSION     200     // 单条表达式的最大长度
+#define MAX_RING_BINDINGS       8       // 单条请求的最大变量绑定数
+
+// 槽位状态
+enum {
+    RING_SLOT_EMPTY = 0,    // 空闲或正在被生产者写入
+    RING_SLOT_REQUEST = 1,  // 请求已发布，等待服务处理
+    RING_SLOT_DONE = 2      // 结果已写回，等待生产者取走
+};
+
+// 变量绑定
+typedef struct {
+    char name[MAX_VARIABLE_NAME];   // 以 '\0' 结尾
+    double value;
+} RingBinding;
+
+// 槽位（对齐到缓存行）
+typedef struct {
+    uint64_t sequence;      // 槽位序号：等于认领位置时空闲
+    uint32_t state;         // 槽位状态（futex 字）
+    uint32_t waiting;       // 生产者是否在 state 上休眠
+    uint16_t length;        // 表达式长度（不含 '\0'，表达式不要求以 '\0' 结尾）
+    uint8_t mode;           // AngleMode
+    uint8_t bindingCount;   // 变量绑定数
+    int32_t errorCode;      // 结果：错误代码（0 表示成功）
+    int32_t errorPosition;  // 结果：错误位置
+    double result;          // 结果：计算值
+    RingBinding bindings[MAX_RING_BINDINGS];
+    char expression[MAX_RING_EXPRESSION];
+} __attribute__((aligned(64))) RingSlot;
+
+// 共享区域头部（生产者与消费者使用的字段分别位于不同缓存行）
+typedef struct {
+    uint32_t magic;                 // SHARED_RING_MAGIC
+    uint32_t version;               // SHARED_RING_VERSION
+    uint32_t capacity;              // 槽位数
+    uint32_t slotSize;              // sizeof(RingSlot)
+    uint32_t requestSignal;         // 每发布一条请求加 1（消费者的 futex 字）
+    uint32_t consumerSleeping;      // 消费者是否在 requestSignal 上休眠
+    uint32_t stopping;              // 服务停止标志
+    __attribute__((aligned(64))) uint64_t tail;     // 下一个认领位置（生产者）
+    __attribute__((aligned(64))) uint64_t head;     // 下一个处理位置（消费者）
+} __attribute__((aligned(64))) RingHeader;
+
+// 已映射的共享队列（进程本地）
+typedef struct {
+    RingHeader* header;
+    RingSlot* slots;
+    size_t size;            // 映射大小
+    char name[64];          // 共享内存名称
+    int owner;              // 是否由本进程创建（关闭时删除共享内存）
+    uint32_t spinLimit;     // 当前自旋上限（自适应）
+} SharedRing;
+
+// 服务端
+CalcError createSharedRing(const char* name, uint32_t capacity, SharedRing* ring);
+CalcError serveSharedRing(SharedRing* ring);
+void stopSharedRing(SharedRing* ring);
+
+// 生产者
+CalcError openSharedRing(const char* name, SharedRing* ring);
+CalcError submitRingRequest(SharedRing* ring, const char* expr, size_t len, AngleMode mode,
+                            const RingBinding* bindings, int bindingCount, uint64_t* ticket);
+CalcError waitRingResult(SharedRing* ring, uint64_t ticket, double* result);
+CalcError evaluateOverRing(SharedRing* ring, const char* expr, size_t len, AngleMode mode,
+                           const RingBinding* bindings, int bindingCount, double* result);
+
+void closeSharedRing(SharedRing* ring);
+
+#endif // SHARED_RING_H
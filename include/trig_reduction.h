@@ -0,0 +1,61 @@
+#ifndef TRIG_REDUCTION_H
+#define TRIG_REDUCTION_H
+
+#include <stdint.h>
+#include "function_types.h"
+
+// ─── 三角函数参数归约 ───────────────────────────────────────────────────────
+//
+// 把参数写成 x = quadrant·(π/2) + r，|r| ≤ π/4，r 以双双精度（hi + lo）给出，
+// 再在 [-π/4, π/4] 上调用 libm。三种归约：
+//   - 角度：fmod(x, 360) 是精确的，之后按 90° 取整也是精确的，余数（度）
+//     再乘以双双精度的 π/180，不再先乘以舍入过的 PI
+//   - 弧度，|x| < CODY_WAITE_LIMIT：Cody-Waite，π/2 拆成三段 33 位常数加尾项，
+//     k·常数都是精确乘积（内联，单精度批量内核在向量化循环中使用）
+//   - 弧度，更大的参数：Payne-Hanek，用 2/π 的 1408 位二进制展开中与 x 的
+//     指数对应的 192 位窗口做整数乘法，得到 x·2/π 的象限与 117 位小数部分
+// 特殊角判断（checkTrigSpecialAngle）也使用归约后的余数，不再对舍入过的 2·PI 取模。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define CODY_WAITE_LIMIT  1647099.0                  // 约 2^20·π/2：k < 2^20 时 k·TRIG_PIO2_1 精确
+#define TRIG_PIO2_1       1.57079632673412561417e+00 // π/2 的前 33 位
+#define TRIG_PIO2_2       6.07710050630396597660e-11 // 接下来 33 位
+#define TRIG_PIO2_3       2.02226624871116645580e-21 // 再接下来 33 位
+#define TRIG_PIO2_3T      8.47842766036889956997e-32 // π/2 - 以上三段
+#define TRIG_ROUND_MAGIC  6755399441055744.0         // 1.5·2^52，加减后得到最接近的整数
+
+// 归约结果：x = quadrant·(π/2) + hi + lo
+typedef struct {
+    double hi;
+    double lo;
+    double remainder;   // 余数：角度模式为度（精确），弧度模式等于 hi
+    int quadrant;       // 象限（0～3）
+} TrigReduction;
+
+// Cody-Waite 归约，要求 |x| < CODY_WAITE_LIMIT
+static inline TrigReduction codyWaiteReduce(double x) {
+    TrigReduction out;
+    double k = (x * 0.63661977236758134308 + TRIG_ROUND_MAGIC) - TRIG_ROUND_MAGIC;
+    double r1 = x - k * TRIG_PIO2_1;
+    double w2 = k * TRIG_PIO2_2;
+    // r1 - w2 的精确和（r1 可能比 w2 小，使用完整的 TwoSum）
+    double s = r1 - w2;
+    double bb = s - r1;
+    double e = (r1 - (s - bb)) - (w2 + bb);
+    double t = e - (k * TRIG_PIO2_3 + k * TRIG_PIO2_3T);
+    out.hi = s + t;
+    out.lo = t - (out.hi - s);
+    out.remainder = out.hi;
+    out.quadrant = (int)((int64_t)k & 3);
+    return out;
+}
+
+void reduceRadians(double x, TrigReduction* out);
+void reduceDegrees(double degrees, TrigReduction* out);
+void reduceAngle(double angle, AngleMode mode, TrigReduction* out);
+// 由归约结果计算 sin/cos/tan（tan 在奇数象限为 -1/tan(r)）
+double trigFromReduction(FuncType func, const TrigReduction* reduction);
+// 特殊角判断：0 非特殊角; 1 应为0; 2 应为1; 3 应为-1; 4 无定义
+int classifySpecialAngle(const TrigReduction* reduction, AngleMode mode, FuncType func);
+
+#endif // TRIG_REDUCTION_H
@@ -0,0 +1,108 @@
+#ifndef VECTOR_VALUE_H
+#define VECTOR_VALUE_H
+
+#include <stddef.h>
+#include "compiled_expression.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ─── 向量值 ─────────────────────────────────────────────────────────────────
+//
+// 以 compileVectorExpression 编译的表达式中，值可以是标量或向量：
+//   [1, 2, 3]          方括号字面量（元素是向量时按顺序拼接）
+//   v                  bindArrayVariable 绑定的数组变量
+//   v * 2 + [1, 0, 1]  + - * / ^ 逐元素计算，标量广播到另一侧向量的长度
+//   sqrt(v)            所有 FuncType 函数逐元素作用
+//   sum(v^2)           聚合函数 sum/mean/min/max/norm/dot 把向量归约为标量
+// 逐元素的结果与错误都和 evaluateCompiledBatch（EVAL_FP64）逐行求值一致。
+//
+// 中间结果分配在 VectorArena 中：按 VECTOR_ALIGNMENT 字节对齐的分块线性分配，
+// 不逐个释放，求值结束后由调用方 reset 或 free。+ - * / 与取负使用 SSE2/AVX 循环
+// （运行时选择），除数接近 0、结果非有限、超过 2^51 或恰好在两整数正中的元素逐个回退到
+// performOperationCode；^ 与函数逐元素调用标量实现。比较、not 与 and / or 逐元素计算；
+// 条件 c ? a : b 与 and / or 的跳转条件必须是标量。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define VECTOR_ALIGNMENT     64         // 向量缓冲区对齐字节数
+#define VECTOR_ARENA_BLOCK   65536      // arena 默认块大小（字节）
+#define VECTOR_FORMAT_ITEMS  16         // formatVector 最多显示的元素数
+
+// 标量或向量
+typedef struct {
+    double scalar;          // 标量值（isVector 为 0 时有效）
+    const double* data;     // 向量元素（指向 arena 或绑定的数组）
+    size_t count;           // 向量元素个数
+    int isVector;
+} VectorValue;
+
+typedef struct VectorArenaBlock VectorArenaBlock;
+
+// 线性分配器
+typedef struct {
+    VectorArenaBlock* blocks;   // 块链表，表头为当前块
+    size_t used;                // 当前块已用字节
+} VectorArena;
+
+static inline VectorValue scalarValue(double value) {
+    VectorValue v = {value, NULL, 0, 0};
+    return v;
+}
+
+static inline VectorValue vectorValue(const double* data, size_t count) {
+    VectorValue v = {0, data, count, 1};
+    return v;
+}
+
+// arena：reset 只保留当前块，之前分配的缓冲区全部失效
+void initVectorArena(VectorArena* arena);
+double* allocateVector(VectorArena* arena, size_t count);
+void resetVectorArena(VectorArena* arena);
+void freeVectorArena(VectorArena* arena);
+
+// 求值：vars 按槽位顺序给出变量值；向量结果指向 arena 或 vars 中的数组
+CalcError evaluateCompiledVector(const CompiledExpr* prog, const VectorValue* vars, AngleMode mode,
+                                 VectorArena* arena, VectorValue* result);
+// 编译并求值，变量取 bindArrayVariable 绑定的数组
+CalcError evaluateVectorExpression(const char* expr, AngleMode mode, VectorArena* arena, VectorValue* result);
+// 以 name 为自变量的单变量函数（sum/prod 的项、solve/integrate 的被积函数等）
+// 其他变量取 bindArrayVariable 绑定的数组，函数值必须是标量
+typedef struct {
+    CompiledExpr prog;
+    VectorValue vars[MAX_COMPILED_VARIABLES];   // 自变量槽位在求值时填入
+    int slot;           // 自变量槽位（表达式不含自变量时为 -1）
+    int vectorized;     // 能否把多个自变量值作为一个向量整体求值（不含聚合函数、方括号与条件分支）
+} VectorFunction;
+
+// body、name 均不要求以 '\0' 结尾；变量名无效时 position 为 -1，其余错误为 body 内的位置
+CalcError compileVectorFunction(const char* body, size_t bodyLen, const char* name, size_t nameLen,
+                                VectorFunction* fn);
+// 求 fn 在 x[0..count) 处的值；多个线程可共用同一个 fn（各自使用自己的 arena）
+CalcError evaluateVectorFunction(const VectorFunction* fn, const double* x, size_t count, AngleMode mode,
+                                 VectorArena* arena, double* out);
+void freeVectorFunction(VectorFunction* fn);
+
+// 格式化为 [1, 2, 3]，超过 VECTOR_FORMAT_ITEMS 个元素时省略末尾
+char* formatVector(const VectorValue* value, char* buffer, size_t bufferSize);
+
+// 逐元素内核：out 必须按 VECTOR_ALIGNMENT 对齐；aStep、bStep 为 0 表示广播 a[0]、b[0]
+// 返回第一个出错元素的下标（全部成功返回 count），错误代码写入 *code
+size_t vectorArithmetic(char op, const double* a, size_t aStep, const double* b, size_t bStep,
+                        double* out, size_t count, ErrorCode* code);
+size_t vectorFunction(FuncType func, const double* input, double* out, size_t count, AngleMode mode,
+                      ErrorCode* code);
+void vectorNegate(const double* input, double* out, size_t count);
+// 比较与 and / or（op 为运算符栈中的字符），结果为 1 或 0；out 不要求对齐
+void vectorCompare(char op, const double* a, size_t aStep, const double* b, size_t bStep,
+                   double* out, size_t count);
+// out[i] = cond[i] != 0 ? a[i] : b[i]，按掩码混合而不逐元素分支；out 不要求对齐
+void vectorSelect(const double* cond, const double* a, const double* b, double* out, size_t count);
+void selectRowErrors(const double* cond, const unsigned char* a, const unsigned char* b, unsigned char* out,
+                     size_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VECTOR_VALUE_H
@@ -0,0 +1,441 @@
+#include "calculator.h"
+#include "compiled_expression.h"
+
+// ─── 按需提升精度的求值 ─────────────────────────────────────────────────────
+//
+// 先做普通的双精度求值，同时对每个中间结果维护一个绝对误差上界（一阶误差
+// 传播，舍入单位 u = 2^-53）。若最终结果的误差上界超过 tolerance * |结果|，
+// 说明发生了严重的相消（如 1e16+1-1e16），再用双双精度（约106位）重新计算。
+// 条件良好的表达式只付出误差估计的少量开销。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define UNIT_ROUNDOFF 1.1102230246251565e-16  // 2^-53
+#define DD_SPLITTER   134217729.0             // 2^27 + 1，Dekker 拆分常数
+#define DD_MAX_INTEGER_EXPONENT 1024          // 双双精度整数幂的最大指数
+
+// 双双精度数：值为 hi + lo，|lo| <= ulp(hi)/2
+typedef struct {
+    double hi;
+    double lo;
+} DoubleDouble;
+
+// 精确求和：a + b = s + e
+static inline DoubleDouble twoSum(double a, double b) {
+    double s = a + b;
+    double bb = s - a;
+    double e = (a - (s - bb)) + (b - bb);
+    return (DoubleDouble){s, e};
+}
+
+// 精确乘积（Dekker 拆分，不依赖 FMA）：a * b = p + e
+static inline DoubleDouble twoProd(double a, double b) {
+    double p = a * b;
+    double t = DD_SPLITTER * a;
+    double aHi = t - (t - a), aLo = a - aHi;
+    t = DD_SPLITTER * b;
+    double bHi = t - (t - b), bLo = b - bHi;
+    double e = ((aHi * bHi - p) + aHi * bLo + aLo * bHi) + aLo * bLo;
+    return (DoubleDouble){p, e};
+}
+
+static inline DoubleDouble ddNormalize(double hi, double lo) {
+    double s = hi + lo;
+    return (DoubleDouble){s, lo - (s - hi)};
+}
+
+static DoubleDouble ddAdd(DoubleDouble a, DoubleDouble b) {
+    DoubleDouble s = twoSum(a.hi, b.hi);
+    DoubleDouble t = twoSum(a.lo, b.lo);
+    s.lo += t.hi;
+    s = ddNormalize(s.hi, s.lo);
+    s.lo += t.lo;
+    return ddNormalize(s.hi, s.lo);
+}
+
+static DoubleDouble ddNeg(DoubleDouble a) {
+    return (DoubleDouble){-a.hi, -a.lo};
+}
+
+static DoubleDouble ddMul(DoubleDouble a, DoubleDouble b) {
+    DoubleDouble p = twoProd(a.hi, b.hi);
+    p.lo += a.hi * b.lo + a.lo * b.hi;
+    return ddNormalize(p.hi, p.lo);
+}
+
+static DoubleDouble ddDiv(DoubleDouble a, DoubleDouble b) {
+    double q1 = a.hi / b.hi;
+    DoubleDouble r = ddAdd(a, ddNeg(ddMul((DoubleDouble){q1, 0}, b)));
+    double q2 = r.hi / b.hi;
+    r = ddAdd(r, ddNeg(ddMul((DoubleDouble){q2, 0}, b)));
+    double q3 = r.hi / b.hi;
+    DoubleDouble q = ddNormalize(q1, q2);
+    return ddAdd(q, (DoubleDouble){q3, 0});
+}
+
+// 平方根：双精度近似后做一次牛顿修正，a > 0
+static DoubleDouble ddSqrt(DoubleDouble a) {
+    double s = sqrt(a.hi);
+    DoubleDouble residual = ddAdd(a, ddNeg(twoProd(s, s)));
+    return twoSum(s, residual.hi / (2.0 * s));
+}
+
+// 整数次幂（平方求幂）
+static DoubleDouble ddPowInt(DoubleDouble base, long exponent) {
+    DoubleDouble result = {1.0, 0.0};
+    int negative = exponent < 0;
+    unsigned long e = negative ? (unsigned long)(-exponent) : (unsigned long)exponent;
+    while (e > 0) {
+        if (e & 1) result = ddMul(result, base);
+        e >>= 1;
+        if (e > 0) base = ddMul(base, base);
+    }
+    return negative ? ddDiv((DoubleDouble){1.0, 0.0}, result) : result;
+}
+
+/**
+ * 函数的误差传播：|f'(x)| * 参数误差 + 结果本身的舍入误差
+ */
+static double functionErrorBound(FuncType func, double x, double fx, double errX, AngleMode mode) {
+    double scale = (mode == MODE_DEG) ? PI / 180.0 : 1.0;
+    double derivative;
+
+    switch (func) {
+        case FUNC_SIN:
+        case FUNC_COS:
+            derivative = scale;
+            break;
+        case FUNC_TAN:
+            derivative = scale * (1.0 + fx * fx);
+            break;
+        case FUNC_ASIN:
+        case FUNC_ACOS:
+            derivative = (fabs(x) < 1.0) ? 1.0 / sqrt(1.0 - x * x) / scale : INFINITY;
+            break;
+        case FUNC_ATAN:
+            derivative = 1.0 / (1.0 + x * x) / scale;
+            break;
+        case FUNC_SQRT:
+            derivative = (fx > 0) ? 0.5 / fx : INFINITY;
+            break;
+        case FUNC_LOG:
+            derivative = 1.0 / (x * log(10.0));
+            break;
+        case FUNC_LN:
+            derivative = 1.0 / x;
+            break;
+        case FUNC_RAD:
+            derivative = PI / 180.0;
+            break;
+        case FUNC_DEG:
+            derivative = 180.0 / PI;
+            break;
+        default:
+            derivative = 1.0;
+            break;
+    }
+    return fabs(derivative) * errX + 2 * UNIT_ROUNDOFF * fabs(fx);
+}
+
+/**
+ * 双精度求值并估计误差上界
+ */
+static CalcError evaluateWithErrorBound(const CompiledExpr* prog, const double* vars, AngleMode mode,
+                                        double* result, double* errorBound) {
+    double stack[MAX_EXPR];
+    double errors[MAX_EXPR];
+    int top = -1;
+    int uncertain = 0;      // 是否有比较的两侧相差不超过误差上界
+    stack[0] = errors[0] = 0;   // 有跳转时编译器无法确认栈底已写入
+
+    for (int i = 0; i < prog->length; i++) {
+        const Instruction* ins = &prog->code[i];
+        CalcError err;
+
+        switch (ins->op) {
+            case OP_CONST: {
+                int64_t intValue;
+                top++;
+                stack[top] = ins->value;
+                // 非整数字面量在解析时已舍入
+                errors[top] = doubleToExactInt64(ins->value, &intValue) ? 0 : UNIT_ROUNDOFF * fabs(ins->value);
+                break;
+            }
+
+            case OP_VAR:
+                top++;
+                stack[top] = vars[ins->slot];
+                errors[top] = 0;
+                break;
+
+            case OP_NEG:
+                stack[top] = -stack[top];
+                break;
+
+            case OP_CALL: {
+                double x = stack[top];
+                err = calculateFunctionWithError((FuncType)ins->func, x, mode, &stack[top]);
+                if (err.code != 0) {
+                    err.position = ins->position;
+                    return err;
+                }
+                errors[top] = functionErrorBound((FuncType)ins->func, x, stack[top], errors[top], mode);
+                break;
+            }
+
+            case OP_LT:
+            case OP_LE:
+            case OP_GT:
+            case OP_GE:
+            case OP_EQ:
+            case OP_NE:
+                top--;
+                if (fabs(stack[top] - stack[top + 1]) < errors[top] + errors[top + 1]) {
+                    uncertain = 1;
+                }
+                stack[top] = compareOperands(opcodeToOperator(ins->op), stack[top], stack[top + 1]);
+                errors[top] = 0;
+                break;
+
+            case OP_NOT:
+            case OP_AND:
+            case OP_OR:
+                stack[top] = (ins->op == OP_NOT) ? (stack[top] == 0) : (stack[top] != 0);
+                errors[top] = 0;
+                break;
+
+            case OP_BRANCH:
+                if (!branchTaken(ins, stack[top])) {
+                    top--;
+                    break;
+                }
+                if (ins->func == OP_SELECT) {
+                    top--;
+                } else {
+                    stack[top] = (ins->func == OP_OR);
+                    errors[top] = 0;
+                }
+                i = ins->slot - 1;
+                break;
+
+            case OP_JUMP:
+                i = ins->slot - 1;
+                break;
+
+            case OP_SELECT:
+                break;
+
+            default: {
+                double a = stack[top - 1], b = stack[top];
+                double ea = errors[top - 1], eb = errors[top];
+                double r;
+                top--;
+                err = performOperation(opcodeToOperator(ins->op), a, b, &r);
+                if (err.code != 0) {
+                    err.position = ins->position;
+                    return err;
+                }
+
+                double bound;
+                switch (ins->op) {
+                    case OP_ADD:
+                    case OP_SUB:
+                        bound = ea + eb;
+                        break;
+                    case OP_MUL:
+                        bound = fabs(a) * eb + fabs(b) * ea + ea * eb;
+                        break;
+                    case OP_DIV:
+                        bound = (ea + fabs(r) * eb) / fabs(b);
+                        break;
+                    default:
+                        // d(a^b) = b*a^(b-1) da + a^b*ln|a| db
+                        bound = (a != 0) ? fabs(r) * (fabs(b) * ea / fabs(a) + fabs(log(fabs(a))) * eb) : 0;
+                        break;
+                }
+                stack[top] = r;
+                errors[top] = bound + UNIT_ROUNDOFF * fabs(r);
+                break;
+            }
+        }
+    }
+
+    // 比较结果可能因舍入而反转时，整个结果都不可靠，交给双双精度重新计算
+    *result = stack[0];
+    *errorBound = uncertain ? INFINITY : errors[0];
+    return CALC_SUCCESS;
+}
+
+/**
+ * 双双精度求值（不做接近整数修正）
+ * 四则运算、整数次幂与 sqrt 在双双精度下计算；其余函数在双精度下计算，
+ * 参数取双双精度结果的舍入值
+ */
+static CalcError evaluateDoubleDouble(const CompiledExpr* prog, const double* vars, AngleMode mode,
+                                      double* result) {
+    DoubleDouble stack[MAX_EXPR];
+    int top = -1;
+
+    for (int i = 0; i < prog->length; i++) {
+        const Instruction* ins = &prog->code[i];
+        CalcError err;
+
+        switch (ins->op) {
+            case OP_CONST:
+                stack[++top] = (DoubleDouble){ins->value, 0};
+                break;
+
+            case OP_VAR:
+                stack[++top] = (DoubleDouble){vars[ins->slot], 0};
+                break;
+
+            case OP_NEG:
+                stack[top] = ddNeg(stack[top]);
+                break;
+
+            case OP_CALL: {
+                double value;
+                err = calculateFunctionWithError((FuncType)ins->func, stack[top].hi + stack[top].lo, mode, &value);
+                if (err.code != 0) {
+                    err.position = ins->position;
+                    return err;
+                }
+                if (ins->func == FUNC_SQRT && stack[top].hi > 0) {
+                    stack[top] = ddSqrt(stack[top]);
+                } else {
+                    stack[top] = (DoubleDouble){value, 0};
+                }
+                break;
+            }
+
+            case OP_NOT:
+            case OP_AND:
+            case OP_OR:
+                stack[top] = (DoubleDouble){(ins->op == OP_NOT) ? (stack[top].hi == 0) : (stack[top].hi != 0), 0};
+                break;
+
+            case OP_BRANCH:
+                if (!branchTaken(ins, stack[top].hi)) {
+                    top--;
+                    break;
+                }
+                if (ins->func == OP_SELECT) {
+                    top--;
+                } else {
+                    stack[top] = (DoubleDouble){(ins->func == OP_OR), 0};
+                }
+                i = ins->slot - 1;
+                break;
+
+            case OP_JUMP:
+                i = ins->slot - 1;
+                break;
+
+            case OP_SELECT:
+                break;
+
+            default: {
+                DoubleDouble a = stack[top - 1], b = stack[top];
+                top--;
+                switch (ins->op) {
+                    case OP_ADD:
+                        stack[top] = ddAdd(a, b);
+                        break;
+                    case OP_SUB:
+                        stack[top] = ddAdd(a, ddNeg(b));
+                        break;
+                    case OP_MUL:
+                        stack[top] = ddMul(a, b);
+                        break;
+                    case OP_DIV:
+                        if (fabs(b.hi) < ABSOLUTE_ZERO_THRESHOLD) {
+                            return CALC_ERROR_CODE_POS(ERR_DIV_BY_ZERO, "除数不能为0", ins->position);
+                        }
+                        stack[top] = ddDiv(a, b);
+                        break;
+                    case OP_POW:
+                        if (b.lo == 0 && b.hi == floor(b.hi) && fabs(b.hi) <= DD_MAX_INTEGER_EXPONENT &&
+                            !(a.hi == 0 && b.hi < 0)) {
+                            stack[top] = ddPowInt(a, (long)b.hi);
+                        } else {
+                            double value;
+                            err = performOperation('^', a.hi + a.lo, b.hi + b.lo, &value);
+                            if (err.code != 0) {
+                                err.position = ins->position;
+                                return err;
+                            }
+                            stack[top] = (DoubleDouble){value, 0};
+                        }
+                        break;
+                    default: {
+                        // 比较：高位相等时比较低位（双双数已规格化）
+                        int sameHigh = (a.hi == b.hi);
+                        double value = compareOperands(opcodeToOperator(ins->op), sameHigh ? a.lo : a.hi,
+                                                       sameHigh ? b.lo : b.hi);
+                        stack[top] = (DoubleDouble){value, 0};
+                        break;
+                    }
+                }
+                if (isInfinite(stack[top].hi)) {
+                    return CALC_ERROR_CODE_POS(ERR_OVERFLOW, "计算结果太大", ins->position);
+                }
+                break;
+            }
+        }
+    }
+
+    *result = stack[0].hi + stack[0].lo;
+    return CALC_SUCCESS;
+}
+
+/**
+ * 按需提升精度的求值
+ * 双精度结果的误差上界超过 tolerance * |结果| 时，改用双双精度重新计算
+ *
+ * @param prog      编译后的表达式
+ * @param vars      变量值
+ * @param mode      角度模式
+ * @param tolerance 允许的相对误差上界（如 DEFAULT_ESCALATION_TOLERANCE）
+ * @param result    输出计算结果
+ * @param escalated 可选，输出是否使用了双双精度
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+CalcError evaluateCompiledAdaptive(const CompiledExpr* prog, const double* vars, AngleMode mode,
+                                   double tolerance, double* result, int* escalated) {
+    if (prog->length == 0 || prog->maxStack > MAX_EXPR) {
+        return CALC_ERROR_CODE(ERR_SYNTAX, "表达式不完整");
+    }
+    if (prog->isDecimal) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "十进制模式的表达式只能按十进制求值");
+    }
+    if (prog->isVector) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "向量表达式只能按向量求值");
+    }
+
+    double value, errorBound;
+    CalcError err = evaluateWithErrorBound(prog, vars, mode, &value, &errorBound);
+    if (escalated) *escalated = 0;
+
+    // 双精度下的数学错误可能由相消引起（如除数相消为0），用双双精度再确认一次
+    if (err.code != 0) {
+        double precise;
+        if (err.code == ERR_SYNTAX || evaluateDoubleDouble(prog, vars, mode, &precise).code != 0) {
+            return err;
+        }
+        if (escalated) *escalated = 1;
+        *result = precise;
+        return CALC_SUCCESS;
+    }
+
+    if (errorBound > 0 && errorBound > tolerance * fabs(value)) {
+        double precise;
+        err = evaluateDoubleDouble(prog, vars, mode, &precise);
+        if (err.code != 0) {
+            return err;
+        }
+        if (escalated) *escalated = 1;
+        value = precise;
+    }
+
+    *result = value;
+    return CALC_SUCCESS;
+}
@@ -0,0 +1,597 @@
+#include "calculator.h"
+#include "batch_format.h"
+#include "file_mapping.h"
+
+#ifndef _WIN32
+    #include <errno.h>
+    #include <poll.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#define BATCH_ALIGNMENT      8      // 记录对齐
+#define BATCH_OUTPUT_CHUNK   1024   // 结果缓冲条数
+#define BATCH_INPUT_BUFFER   65536  // 管道输入的读缓冲字节数
+#define MAX_BATCH_RECORD (sizeof(BatchRequestHeader) + 65535 * sizeof(double) + MAX_BATCH_EXPRESSION)
+#define BATCH_ARENA_SIZE     (2 * MAX_BATCH_RECORD)   // 流式处理时一个窗口的记录缓冲
+#define BATCH_PROGRAM_SLOTS  (2 * BATCH_PLAN_PROGRAMS) // 表达式哈希表大小（2 的幂）
+#define BATCH_JOB_SLOTS      (2 * BATCH_PLAN_RECORDS)  // 记录哈希表大小（2 的幂）
+#define FNV_OFFSET           0xcbf29ce484222325ULL
+#define FNV_PRIME            0x100000001b3ULL
+
+// 窗口内的一个不同表达式（内联文本 + 角度模式，或库编号）
+typedef struct {
+    const BatchRequestHeader* first;    // 第一条使用它的记录（比较内联文本用）
+    uint64_t hash;
+    CompiledExpr prog;                  // 内联表达式自有；库表达式指向映射内存
+    AngleMode mode;
+    CalcError error;                    // 编译或取库失败时的错误（所有引用它的记录共用）
+    int owned;                          // prog 需要释放
+    int jobCount;                       // 去重后引用它的记录数
+} PlannedProgram;
+
+// 批量计划：收集一个窗口的记录，去重、按表达式分组求值，再按原顺序写出
+typedef struct {
+    const ExpressionLibrary* lib;
+    const BatchRequestHeader* records[BATCH_PLAN_RECORDS];
+    int count;
+    PlannedProgram programs[BATCH_PLAN_PROGRAMS];
+    int programCount;
+    int32_t programSlots[BATCH_PROGRAM_SLOTS];  // 哈希表：表达式下标，-1 为空
+    int32_t jobSlots[BATCH_JOB_SLOTS];          // 哈希表：第一次出现的记录下标，-1 为空
+    int32_t programOf[BATCH_PLAN_RECORDS];      // 每条记录的表达式
+    int32_t canonical[BATCH_PLAN_RECORDS];      // 与之相同的第一条记录（自身表示需要求值）
+    int32_t order[BATCH_PLAN_RECORDS];          // 需要求值的记录，按表达式分组
+    BatchResult results[BATCH_PLAN_RECORDS];
+} BatchPlanner;
+
+// 结果缓冲
+typedef struct {
+    FILE* file;
+    BatchResult results[BATCH_OUTPUT_CHUNK];
+    int count;
+    int failed;
+} BatchOutput;
+
+// 流式输入：管道等交互输入绕过 stdio，直接 read 到自有缓冲区，
+// 这样才能准确判断是否还有已读入、未处理的数据
+typedef struct {
+    FILE* file;
+    int fd;                     // 直接读取的描述符（-1 表示通过 stdio 读取）
+    char* buffer;
+    size_t start;               // buffer[start, end) 为尚未取走的数据
+    size_t end;
+    int failed;                 // 读取出错
+} BatchInput;
+
+static size_t alignRecord(size_t size) {
+    return (size + BATCH_ALIGNMENT - 1) & ~(size_t)(BATCH_ALIGNMENT - 1);
+}
+
+static void fillHeader(BatchFileHeader* header, const char* magic, uint64_t count) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, magic, sizeof(BATCH_REQUEST_MAGIC));
+    header->version = BATCH_VERSION;
+    header->endianTag = BATCH_ENDIAN_TAG;
+    header->recordCount = count;
+}
+
+static CalcError checkHeader(const BatchFileHeader* header) {
+    if (memcmp(header->magic, BATCH_REQUEST_MAGIC, sizeof(BATCH_REQUEST_MAGIC)) != 0) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "批量请求文件格式不正确");
+    }
+    if (header->version != BATCH_VERSION || header->endianTag != BATCH_ENDIAN_TAG) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "批量请求文件版本或平台不兼容");
+    }
+    return CALC_SUCCESS;
+}
+
+// ─── 写请求 ─────────────────────────────────────────────────────────────────
+
+/**
+ * 写文件头（magic 为 BATCH_REQUEST_MAGIC 或 BATCH_RESULT_MAGIC），条数记为未知
+ */
+CalcError writeBatchHeader(FILE* file, const char* magic) {
+    BatchFileHeader header;
+    fillHeader(&header, magic, 0);
+    if (fwrite(&header, sizeof(header), 1, file) != 1) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "写入批量文件失败");
+    }
+    return CALC_SUCCESS;
+}
+
+static CalcError appendRequest(FILE* file, const BatchRequestHeader* header, const double* values,
+                               const char* expr, size_t len) {
+    static const char padding[BATCH_ALIGNMENT] = {0};
+    size_t padded = alignRecord(len);
+    int ok = fwrite(header, sizeof(*header), 1, file) == 1 &&
+             (header->bindingCount == 0 ||
+              fwrite(values, sizeof(double), header->bindingCount, file) == header->bindingCount) &&
+             (len == 0 || fwrite(expr, 1, len, file) == len) &&
+             (padded == len || fwrite(padding, 1, padded - len, file) == padded - len);
+    if (!ok) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "写入批量文件失败");
+    }
+    return CALC_SUCCESS;
+}
+
+/**
+ * 追加一条内联表达式请求
+ *
+ * @param values 变量值，按变量在表达式中首次出现的顺序
+ */
+CalcError appendInlineRequest(FILE* file, const char* expr, size_t len, AngleMode mode,
+                              const double* values, int count) {
+    if (len > MAX_BATCH_EXPRESSION) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "表达式过长");
+    }
+    if (count < 0 || count > MAX_COMPILED_VARIABLES) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "变量值过多");
+    }
+    BatchRequestHeader header;
+    memset(&header, 0, sizeof(header));
+    header.recordSize = (uint32_t)(sizeof(header) + (size_t)count * sizeof(double) + alignRecord(len));
+    header.kind = BATCH_INLINE;
+    header.angleMode = (uint8_t)mode;
+    header.bindingCount = (uint16_t)count;
+    header.expression = (uint32_t)len;
+    return appendRequest(file, &header, values, expr, len);
+}
+
+/**
+ * 追加一条引用表达式库的请求
+ */
+CalcError appendLibraryRequest(FILE* file, uint32_t index, const double* values, int count) {
+    if (count < 0 || count > MAX_COMPILED_VARIABLES) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "变量值过多");
+    }
+    BatchRequestHeader header;
+    memset(&header, 0, sizeof(header));
+    header.recordSize = (uint32_t)(sizeof(header) + (size_t)count * sizeof(double));
+    header.kind = BATCH_LIBRARY;
+    header.bindingCount = (uint16_t)count;
+    header.expression = index;
+    return appendRequest(file, &header, values, NULL, 0);
+}
+
+// ─── 处理请求 ───────────────────────────────────────────────────────────────
+
+// 记录头与大小是否一致（不一致时无法定位下一条记录，整个输入作废）
+static int isValidRecord(const BatchRequestHeader* header) {
+    size_t expected = sizeof(*header) + (size_t)header->bindingCount * sizeof(double);
+    if (header->kind == BATCH_INLINE) {
+        if (header->expression > MAX_BATCH_EXPRESSION) return 0;
+        expected += alignRecord(header->expression);
+    } else if (header->kind != BATCH_LIBRARY) {
+        return 0;
+    }
+    return header->recordSize == expected;
+}
+
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static const double* recordValues(const BatchRequestHeader* header) {
+    return (const double*)(header + 1);
+}
+
+static const char* recordExpression(const BatchRequestHeader* header) {
+    return (const char*)(recordValues(header) + header->bindingCount);
+}
+
+// 两条记录是否引用同一个表达式
+static int sameProgram(const BatchRequestHeader* a, const BatchRequestHeader* b) {
+    if (a->kind != b->kind || a->expression != b->expression) {
+        return 0;
+    }
+    return a->kind == BATCH_LIBRARY ||
+           (a->angleMode == b->angleMode && memcmp(recordExpression(a), recordExpression(b), a->expression) == 0);
+}
+
+static uint64_t programHash(const BatchRequestHeader* header) {
+    uint64_t hash = hashBytes(FNV_OFFSET, &header->kind, 1);
+    hash = hashBytes(hash, &header->expression, sizeof(header->expression));
+    if (header->kind == BATCH_INLINE) {
+        hash = hashBytes(hash, &header->angleMode, 1);
+        hash = hashBytes(hash, recordExpression(header), header->expression);
+    }
+    return hash;
+}
+
+// 编译或取出表达式，失败时记录错误
+static void prepareProgram(const ExpressionLibrary* lib, PlannedProgram* program) {
+    const BatchRequestHeader* header = program->first;
+    if (header->kind == BATCH_LIBRARY) {
+        program->error = lib == NULL ? CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "未指定表达式库")
+                                     : getLibraryExpression(lib, header->expression, &program->prog, &program->mode);
+    } else if (header->angleMode > MODE_RAD) {
+        program->error = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无效的角度模式");
+    } else {
+        program->error = compileExpressionN(recordExpression(header), header->expression, &program->prog);
+        program->owned = program->error.code == 0;
+        program->mode = (AngleMode)header->angleMode;
+    }
+}
+
+static void resetPlanner(BatchPlanner* planner) {
+    for (int i = 0; i < planner->programCount; i++) {
+        if (planner->programs[i].owned) {
+            freeCompiledExpression(&planner->programs[i].prog);
+        }
+    }
+    planner->count = 0;
+    planner->programCount = 0;
+    memset(planner->programSlots, -1, sizeof(planner->programSlots));
+    memset(planner->jobSlots, -1, sizeof(planner->jobSlots));
+}
+
+static BatchPlanner* createPlanner(const ExpressionLibrary* lib) {
+    BatchPlanner* planner = (BatchPlanner*)calloc(1, sizeof(BatchPlanner));
+    if (planner != NULL) {
+        planner->lib = lib;
+        resetPlanner(planner);
+    }
+    return planner;
+}
+
+static void destroyPlanner(BatchPlanner* planner) {
+    if (planner != NULL) {
+        resetPlanner(planner);
+        free(planner);
+    }
+}
+
+// 窗口是否还能加入记录（记录数已满，或不同表达式已满而这条可能引入新的表达式）
+static int plannerFull(const BatchPlanner* planner) {
+    return planner->count == BATCH_PLAN_RECORDS || planner->programCount == BATCH_PLAN_PROGRAMS;
+}
+
+/**
+ * 加入一条记录：找到（或新建并编译）它的表达式，再查找窗口中完全相同的记录
+ * （同一表达式、变量值的位模式相同），找到时只记下对应关系，不再求值
+ */
+static void planRecord(BatchPlanner* planner, const BatchRequestHeader* header) {
+    uint64_t hash = programHash(header);
+    uint32_t slot = (uint32_t)hash & (BATCH_PROGRAM_SLOTS - 1);
+    int32_t program;
+    while ((program = planner->programSlots[slot]) >= 0 &&
+           !(planner->programs[program].hash == hash && sameProgram(planner->programs[program].first, header))) {
+        slot = (slot + 1) & (BATCH_PROGRAM_SLOTS - 1);
+    }
+    if (program < 0) {
+        program = planner->programCount++;
+        PlannedProgram* entry = &planner->programs[program];
+        memset(entry, 0, sizeof(*entry));
+        entry->first = header;
+        entry->hash = hash;
+        prepareProgram(planner->lib, entry);
+        planner->programSlots[slot] = program;
+    }
+
+    int index = planner->count++;
+    planner->records[index] = header;
+    planner->programOf[index] = program;
+
+    size_t valueSize = (size_t)header->bindingCount * sizeof(double);
+    uint64_t jobHash = hashBytes(hash, recordValues(header), valueSize);
+    slot = (uint32_t)jobHash & (BATCH_JOB_SLOTS - 1);
+    int32_t other;
+    while ((other = planner->jobSlots[slot]) >= 0) {
+        const BatchRequestHeader* candidate = planner->records[other];
+        if (planner->programOf[other] == program && candidate->bindingCount == header->bindingCount &&
+            memcmp(recordValues(candidate), recordValues(header), valueSize) == 0) {
+            planner->canonical[index] = other;
+            return;
+        }
+        slot = (slot + 1) & (BATCH_JOB_SLOTS - 1);
+    }
+    planner->jobSlots[slot] = index;
+    planner->canonical[index] = index;
+    planner->programs[program].jobCount++;
+}
+
+static void evaluateRecord(const PlannedProgram* program, const BatchRequestHeader* header, BatchResult* result) {
+    const double* values = recordValues(header);
+    CalcError err = program->error;
+    double value = 0.0;
+    if (err.code == 0 && header->bindingCount != program->prog.varCount) {
+        err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "变量值个数与表达式不符");
+    }
+    if (err.code == 0) {
+        // 绝大多数记录成功：只取错误代码，出错时再重新求值得到错误位置
+        ErrorCode code = evaluateCompiledFast(&program->prog, values, program->mode, &value);
+        if (code != ERR_SUCCESS) {
+            err = diagnoseCompiled(&program->prog, values, program->mode);
+        }
+    }
+    result->value = err.code == 0 ? value : 0.0;
+    result->errorCode = err.code;
+    result->errorPosition = err.code == 0 ? -1 : err.position;
+}
+
+static void flushOutput(BatchOutput* output) {
+    if (output->count > 0 && !output->failed &&
+        fwrite(output->results, sizeof(BatchResult), (size_t)output->count, output->file) != (size_t)output->count) {
+        output->failed = 1;
+    }
+    output->count = 0;
+}
+
+static void emitResult(BatchOutput* output, BatchStats* stats, const BatchResult* result) {
+    output->results[output->count++] = *result;
+    if (output->count == BATCH_OUTPUT_CHUNK) {
+        flushOutput(output);
+    }
+    stats->records++;
+    if (result->errorCode != 0) stats->errors++;
+}
+
+/**
+ * 执行窗口中的计划：相同的记录只求值一次，其余记录按表达式分组连续求值
+ * （同一段字节码留在缓存中），结果按记录的原始顺序写出
+ */
+static void runPlan(BatchPlanner* planner, BatchOutput* output, BatchStats* stats) {
+    // 按表达式分组（计数排序，组内保持原顺序）
+    int32_t start[BATCH_PLAN_PROGRAMS];
+    int32_t jobs = 0;
+    for (int p = 0; p < planner->programCount; p++) {
+        start[p] = jobs;
+        jobs += planner->programs[p].jobCount;
+    }
+    for (int i = 0; i < planner->count; i++) {
+        if (planner->canonical[i] == i) {
+            planner->order[start[planner->programOf[i]]++] = i;
+        }
+    }
+
+    for (int32_t k = 0; k < jobs; k++) {
+        int i = planner->order[k];
+        evaluateRecord(&planner->programs[planner->programOf[i]], planner->records[i], &planner->results[i]);
+    }
+    stats->evaluated += (uint64_t)jobs;
+    stats->programs += (uint64_t)planner->programCount;
+
+    for (int i = 0; i < planner->count; i++) {
+        emitResult(output, stats, &planner->results[planner->canonical[i]]);
+    }
+    resetPlanner(planner);
+}
+
+#ifndef _WIN32
+/**
+ * 输入是否可能阻塞（管道、终端、套接字）；普通文件总是可以读到数据或文件结束
+ */
+static int isInteractiveInput(FILE* input) {
+    struct stat info;
+    return fstat(fileno(input), &info) == 0 && !S_ISREG(info.st_mode);
+}
+#endif
+
+/**
+ * 读满 size 字节；输入结束或出错时返回 0
+ */
+static int readInput(BatchInput* input, void* data, size_t size) {
+    if (input->fd < 0) {
+        return fread(data, 1, size, input->file) == size;
+    }
+#ifndef _WIN32
+    char* dest = (char*)data;
+    while (size > 0) {
+        if (input->start == input->end) {
+            ssize_t got = read(input->fd, input->buffer, BATCH_INPUT_BUFFER);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) {
+                input->failed = got < 0;
+                return 0;
+            }
+            input->start = 0;
+            input->end = (size_t)got;
+        }
+        size_t chunk = input->end - input->start;
+        if (chunk > size) chunk = size;
+        memcpy(dest, input->buffer + input->start, chunk);
+        input->start += chunk;
+        dest += chunk;
+        size -= chunk;
+    }
+#endif
+    return 1;
+}
+
+/**
+ * 已读入的数据都已取走，且再读会阻塞
+ */
+static int inputWouldBlock(const BatchInput* input) {
+#ifdef _WIN32
+    (void)input;
+    return 0;
+#else
+    if (input->fd < 0 || input->start < input->end) {
+        return 0;
+    }
+    struct pollfd fd = {.fd = input->fd, .events = POLLIN};
+    return poll(&fd, 1, 0) == 0;
+#endif
+}
+
+static CalcError finishOutput(BatchOutput* output, CalcError err) {
+    flushOutput(output);
+    if (fflush(output->file) != 0) output->failed = 1;
+    if (err.code == 0 && output->failed) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "写入批量结果失败");
+    }
+    return err;
+}
+
+/**
+ * 流式处理请求：记录读入缓冲区，每个窗口（BATCH_PLAN_RECORDS 条，或缓冲区已满）
+ * 执行一次计划，结果按顺序写出（适用于管道）。输入来自管道等且暂时没有数据时，
+ * 只对已经读到的记录执行计划并刷新结果，逐条发送请求、等待结果的客户端不会因此卡住。
+ * 这类输入直接从文件描述符读取，调用前不能已经通过 stdio 读过 input
+ *
+ * @param lib 表达式库（没有引用库表达式时可以为 NULL）
+ * @return 单条记录的计算错误写入结果，不影响返回值；输入格式错误时返回错误
+ *         （已处理记录的结果仍会写出）
+ */
+CalcError processBatchStream(FILE* input, FILE* output, const ExpressionLibrary* lib, BatchStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    BatchInput in = {input, -1, NULL, 0, 0, 0};
+#ifndef _WIN32
+    if (isInteractiveInput(input)) {
+        in.buffer = (char*)malloc(BATCH_INPUT_BUFFER);
+        if (in.buffer == NULL) {
+            return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+        }
+        in.fd = fileno(input);
+    }
+#endif
+    BatchFileHeader fileHeader;
+    if (!readInput(&in, &fileHeader, sizeof(fileHeader))) {
+        free(in.buffer);
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "批量请求文件格式不正确");
+    }
+    CalcError err = checkHeader(&fileHeader);
+    if (err.code != 0) {
+        free(in.buffer);
+        return err;
+    }
+
+    BatchPlanner* planner = createPlanner(lib);
+    BatchOutput* out = (BatchOutput*)calloc(1, sizeof(BatchOutput));
+    double* arena = (double*)malloc(BATCH_ARENA_SIZE);   // 窗口内的记录，按 double 对齐
+    if (planner == NULL || out == NULL || arena == NULL) {
+        destroyPlanner(planner);
+        free(out);
+        free(arena);
+        free(in.buffer);
+        return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+    }
+    out->file = output;
+    err = writeBatchHeader(output, BATCH_RESULT_MAGIC);
+
+    size_t used = 0;
+    BatchRequestHeader header;
+    while (err.code == 0) {
+        // 不等窗口填满：已经读到的记录先执行计划
+        if (inputWouldBlock(&in)) {
+            runPlan(planner, out, stats);
+            used = 0;
+            flushOutput(out);
+            if (fflush(output) != 0) out->failed = 1;
+        }
+        if (!readInput(&in, &header, sizeof(header))) {
+            break;
+        }
+        if (!isValidRecord(&header)) {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "批量请求记录已损坏");
+            break;
+        }
+        if (plannerFull(planner) || used + header.recordSize > BATCH_ARENA_SIZE) {
+            runPlan(planner, out, stats);
+            used = 0;
+        }
+        BatchRequestHeader* record = (BatchRequestHeader*)((char*)arena + used);
+        *record = header;
+        size_t rest = header.recordSize - sizeof(header);
+        if (rest > 0 && !readInput(&in, record + 1, rest)) {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "批量请求记录不完整");
+            break;
+        }
+        planRecord(planner, record);
+        used += header.recordSize;
+    }
+    if (err.code == 0 && (in.failed || ferror(input))) {
+        err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "读取批量请求失败");
+    }
+    runPlan(planner, out, stats);
+
+    err = finishOutput(out, err);
+    destroyPlanner(planner);
+    free(out);
+    free(arena);
+    free(in.buffer);
+    return err;
+}
+
+/**
+ * 处理请求文件：输入用 mmap 映射后直接在映射内存上执行计划，结果文件头记录总条数
+ */
+CalcError processBatchFile(const char* inputPath, const char* outputPath, const ExpressionLibrary* lib,
+                           BatchStats* stats) {
+    memset(stats, 0, sizeof(*stats));
+    if (isSameFile(inputPath, outputPath)) {    // 输入仍在映射中，不能覆盖（./in.req、链接也算同一文件）
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "输出文件不能与输入文件相同");
+    }
+    MappedFile file;
+    CalcError err = mapReadOnlyFile(inputPath, &file);
+    if (err.code != 0) {
+        return err;
+    }
+    if (file.size < sizeof(BatchFileHeader)) {
+        err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "批量请求文件格式不正确");
+    } else {
+        err = checkHeader((const BatchFileHeader*)file.base);
+    }
+    FILE* output = NULL;
+    if (err.code == 0 && (output = fopen(outputPath, "wb")) == NULL) {
+        err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法创建批量结果文件");
+    }
+    BatchPlanner* planner = NULL;
+    BatchOutput* out = NULL;
+    if (err.code == 0) {
+        planner = createPlanner(lib);
+        out = (BatchOutput*)calloc(1, sizeof(BatchOutput));
+        if (planner == NULL || out == NULL) {
+            err = CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+        }
+    }
+    if (err.code != 0) {
+        destroyPlanner(planner);
+        free(out);
+        if (output != NULL) {
+            fclose(output);
+            remove(outputPath);
+        }
+        unmapFile(&file);
+        return err;
+    }
+
+    out->file = output;
+    err = writeBatchHeader(output, BATCH_RESULT_MAGIC);
+    size_t offset = sizeof(BatchFileHeader);
+    while (err.code == 0 && offset < file.size) {
+        const BatchRequestHeader* header = (const BatchRequestHeader*)(file.base + offset);
+        if (file.size - offset < sizeof(*header) || !isValidRecord(header) ||
+            file.size - offset < header->recordSize) {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "批量请求记录已损坏");
+            break;
+        }
+        if (plannerFull(planner)) {
+            runPlan(planner, out, stats);
+        }
+        planRecord(planner, header);
+        offset += header->recordSize;
+    }
+    runPlan(planner, out, stats);
+
+    err = finishOutput(out, err);
+    if (err.code == 0) {   // 回填总条数
+        BatchFileHeader header;
+        fillHeader(&header, BATCH_RESULT_MAGIC, stats->records);
+        if (fseek(output, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, output) != 1) {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "写入批量结果失败");
+        }
+    }
+    if (fclose(output) != 0 && err.code == 0) {
+        err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "写入批量结果失败");
+    }
+    destroyPlanner(planner);
+    free(out);
+    unmapFile(&file);
+    return err;
+}
@@ -0,0 +1,566 @@
+#include "calculator.h"
+#include "column_evaluator.h"
+#include "file_mapping.h"
+
+#define CSV_READ_BUFFER (1 << 20)   // CSV 读缓冲区初始大小
+#define MAX_ROUND_TRIP_NUMBER 32    // formatRoundTrip 输出的最大长度
+
+// 一块数据中每列的值与无效标记（输入列在前，公式结果列在后）
+typedef struct {
+    const double* values[MAX_DATA_COLUMNS + MAX_FORMULA_COLUMNS];
+    unsigned char* failed[MAX_DATA_COLUMNS + MAX_FORMULA_COLUMNS];  // NULL 表示该列都有效
+} ColumnBlock;
+
+// 每个公式变量槽位对应的列
+typedef int FormulaSources[MAX_FORMULA_COLUMNS][MAX_COMPILED_VARIABLES];
+
+// ─── 公式定义 ───────────────────────────────────────────────────────────────
+
+static int isColumnName(const char* name, size_t length) {
+    if (length == 0 || length >= MAX_VARIABLE_NAME || !(isalpha((unsigned char)name[0]) || name[0] == '_')) {
+        return 0;
+    }
+    for (size_t i = 1; i < length; i++) {
+        if (!isalnum((unsigned char)name[i]) && name[i] != '_') return 0;
+    }
+    return 1;
+}
+
+/**
+ * 添加一个公式列
+ *
+ * @param set        公式集合（首次使用前清零，mode 为角度模式）
+ * @param definition 形如 "out=sqrt(a^2+b^2)"
+ * @return 成功返回 CALC_SUCCESS，否则返回错误（编译错误的位置相对于 '=' 之后的表达式）
+ */
+CalcError addFormulaColumn(FormulaSet* set, const char* definition) {
+    if (set->count >= MAX_FORMULA_COLUMNS) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "公式列过多");
+    }
+    const char* equals = strchr(definition, '=');
+    if (equals == NULL) {
+        return CALC_ERROR_CODE(ERR_SYNTAX, "公式格式应为 结果列=表达式");
+    }
+    const char* name = definition;
+    const char* nameEnd = equals;
+    while (*name == ' ') name++;
+    while (nameEnd > name && nameEnd[-1] == ' ') nameEnd--;
+    size_t length = (size_t)(nameEnd - name);
+    if (!isColumnName(name, length)) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "结果列名无效");
+    }
+
+    FormulaColumn* formula = &set->formulas[set->count];
+    memset(formula->name, 0, sizeof(formula->name));
+    memcpy(formula->name, name, length);
+    for (int i = 0; i < set->count; i++) {
+        if (strcmp(set->formulas[i].name, formula->name) == 0) {
+            return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "结果列名重复");
+        }
+    }
+
+    CalcError err = compileExpression(equals + 1, &formula->prog);
+    if (err.code != 0) {
+        return err;
+    }
+    set->count++;
+    return CALC_SUCCESS;
+}
+
+void freeFormulaSet(FormulaSet* set) {
+    for (int i = 0; i < set->count; i++) {
+        freeCompiledExpression(&set->formulas[i].prog);
+    }
+    set->count = 0;
+}
+
+/**
+ * 把公式中的变量对应到列：先找前面公式的结果列，再找输入列
+ */
+static CalcError resolveSources(const FormulaSet* set, const char (*names)[MAX_VARIABLE_NAME], int inputCount,
+                                FormulaSources sources) {
+    for (int f = 0; f < set->count; f++) {
+        for (int c = 0; c < inputCount; c++) {
+            if (strcmp(names[c], set->formulas[f].name) == 0) {
+                return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "结果列与输入列同名");
+            }
+        }
+
+        const CompiledExpr* prog = &set->formulas[f].prog;
+        for (int v = 0; v < prog->varCount; v++) {
+            int source = -1;
+            for (int g = 0; g < f && source < 0; g++) {
+                if (strcmp(set->formulas[g].name, prog->varNames[v]) == 0) source = inputCount + g;
+            }
+            for (int c = 0; c < inputCount && source < 0; c++) {
+                if (strcmp(names[c], prog->varNames[v]) == 0) source = c;
+            }
+            if (source < 0) {
+                return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "未知的列");
+            }
+            sources[f][v] = source;
+        }
+    }
+    return CALC_SUCCESS;
+}
+
+/**
+ * 对一块数据依次整列计算所有公式
+ * 输入无效、计算出错或结果为 NaN 的单元格标记为无效，并使依赖它的后续公式也无效
+ *
+ * @param firstRow 本块第一行的行号（从 1 开始，用于统计）
+ */
+static void evaluateFormulaBlock(const FormulaSet* set, int inputCount, FormulaSources sources,
+                                 ColumnBlock* block, size_t rows, ErrorCode* errors,
+                                 uint64_t firstRow, ColumnStats* stats) {
+    for (int f = 0; f < set->count; f++) {
+        const CompiledExpr* prog = &set->formulas[f].prog;
+        const double* vars[MAX_COMPILED_VARIABLES];
+        for (int v = 0; v < prog->varCount; v++) {
+            vars[v] = block->values[sources[f][v]];
+        }
+
+        double* results = (double*)block->values[inputCount + f];
+        unsigned char* failed = block->failed[inputCount + f];
+        evaluateCompiledBatch(prog, vars, rows, set->mode, EVAL_FP64, results, errors);
+
+        for (size_t r = 0; r < rows; r++) {
+            int bad = errors[r] != ERR_SUCCESS || isnan(results[r]);
+            for (int v = 0; v < prog->varCount && !bad; v++) {
+                const unsigned char* sourceFailed = block->failed[sources[f][v]];
+                bad = sourceFailed != NULL && sourceFailed[r];
+            }
+            failed[r] = (unsigned char)bad;
+            if (bad) {
+                results[r] = NAN;
+                stats->errors++;
+                if (stats->firstErrorRow == 0 || firstRow + r < stats->firstErrorRow) {
+                    stats->firstErrorRow = firstRow + r;
+                }
+            }
+        }
+    }
+}
+
+// ─── CSV ────────────────────────────────────────────────────────────────────
+
+typedef struct {
+    FILE* file;
+    char* data;
+    size_t capacity;
+    size_t length;      // 已读入的字节数
+    size_t position;    // 下一行的起始位置
+    int eof;
+} CsvReader;
+
+typedef struct {
+    const char* start;
+    size_t length;      // 不含行尾的 "\r\n"
+} LineSpan;
+
+/**
+ * 取出缓冲区中的下一行（最后一行可以没有换行符）
+ * @return 缓冲区中没有完整的行时返回 0，调用者处理完已取出的行后再调用 refillReader
+ */
+static int takeLine(CsvReader* reader, LineSpan* line) {
+    char* start = reader->data + reader->position;
+    size_t available = reader->length - reader->position;
+    char* newline = (char*)memchr(start, '\n', available);
+    if (newline == NULL) {
+        if (!reader->eof || available == 0) return 0;
+        newline = start + available;
+        reader->position = reader->length;
+    } else {
+        reader->position = (size_t)(newline - reader->data) + 1;
+    }
+    line->start = start;
+    line->length = (size_t)(newline - start);
+    if (line->length > 0 && start[line->length - 1] == '\r') line->length--;
+    return 1;
+}
+
+/**
+ * 丢弃已取出的行并继续读取（使之前取出的行失效）
+ * @return 还有未处理的数据返回 1，否则返回 0
+ */
+static int refillReader(CsvReader* reader, CalcError* err) {
+    if (reader->eof) {
+        return reader->position < reader->length;
+    }
+    memmove(reader->data, reader->data + reader->position, reader->length - reader->position);
+    reader->length -= reader->position;
+    reader->position = 0;
+
+    if (reader->length == reader->capacity) {  // 单行超过缓冲区
+        char* grown = (char*)realloc(reader->data, reader->capacity * 2);
+        if (grown == NULL) {
+            *err = CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+            return 0;
+        }
+        reader->data = grown;
+        reader->capacity *= 2;
+    }
+    size_t got = fread(reader->data + reader->length, 1, reader->capacity - reader->length, reader->file);
+    reader->length += got;
+    if (got == 0) {
+        if (ferror(reader->file)) {
+            *err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "读取输入失败");
+            return 0;
+        }
+        reader->eof = 1;
+    }
+    return 1;
+}
+
+/**
+ * 取下一个字段（带引号的字段去掉引号，"" 为转义的引号；不支持字段内换行）
+ * @return 字段后面还有分隔符返回 1
+ */
+static int nextField(const char** cursor, const char* end, const char** fieldStart, const char** fieldEnd) {
+    const char* p = *cursor;
+    while (p < end && *p == ' ') p++;
+    if (p < end && *p == '"') {
+        *fieldStart = ++p;
+        while (p < end) {
+            if (*p == '"') {
+                if (p + 1 < end && p[1] == '"') {
+                    p += 2;
+                    continue;
+                }
+                break;
+            }
+            p++;
+        }
+        *fieldEnd = p;
+        const char* comma = (const char*)memchr(p, ',', (size_t)(end - p));
+        p = comma ? comma : end;
+    } else {
+        const char* comma = (const char*)memchr(p, ',', (size_t)(end - p));
+        *fieldStart = p;
+        *fieldEnd = p = comma ? comma : end;
+    }
+    if (p < end) {
+        *cursor = p + 1;
+        return 1;
+    }
+    *cursor = end;
+    return 0;
+}
+
+static int appendOutput(char** buffer, size_t* length, size_t* capacity, const char* data, size_t size) {
+    if (*length + size > *capacity) {
+        size_t newCapacity = *capacity ? *capacity : CSV_READ_BUFFER;
+        while (newCapacity < *length + size) newCapacity *= 2;
+        char* grown = (char*)realloc(*buffer, newCapacity);
+        if (grown == NULL) return 0;
+        *buffer = grown;
+        *capacity = newCapacity;
+    }
+    memcpy(*buffer + *length, data, size);
+    *length += size;
+    return 1;
+}
+
+/**
+ * 流式处理 CSV：第一行为列名，结果列追加在每行末尾（出错的单元格留空）
+ *
+ * @param input  输入
+ * @param output 输出
+ * @param set    公式集合
+ * @param stats  输出统计
+ * @return 成功返回 CALC_SUCCESS；列名或公式有误、读写失败时返回错误
+ */
+CalcError evaluateCsvStream(FILE* input, FILE* output, const FormulaSet* set, ColumnStats* stats) {
+    CsvReader reader = {input, (char*)malloc(CSV_READ_BUFFER), CSV_READ_BUFFER, 0, 0, 0};
+    CalcError err = CALC_SUCCESS;
+    LineSpan header;
+    memset(stats, 0, sizeof(*stats));
+    if (reader.data == NULL) {
+        return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+    }
+
+    // 列名
+    while (!takeLine(&reader, &header)) {
+        if (!refillReader(&reader, &err)) {
+            free(reader.data);
+            return err.code != 0 ? err : CALC_ERROR_CODE(ERR_EMPTY_EXPRESSION, "CSV 文件为空");
+        }
+    }
+    char names[MAX_DATA_COLUMNS][MAX_VARIABLE_NAME];
+    int inputCount = 0;
+    const char* cursor = header.start;
+    const char* end = header.start + header.length;
+    int more = 1;
+    while (more) {
+        const char *fieldStart, *fieldEnd;
+        more = nextField(&cursor, end, &fieldStart, &fieldEnd);
+        if (inputCount == MAX_DATA_COLUMNS) {
+            free(reader.data);
+            return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "CSV 列数过多");
+        }
+        while (fieldEnd > fieldStart && fieldEnd[-1] == ' ') fieldEnd--;
+        size_t length = (size_t)(fieldEnd - fieldStart);
+        memset(names[inputCount], 0, MAX_VARIABLE_NAME);
+        if (length < MAX_VARIABLE_NAME) {   // 过长的列名无法作为变量引用
+            memcpy(names[inputCount], fieldStart, length);
+        }
+        inputCount++;
+    }
+
+    FormulaSources sources;
+    err = resolveSources(set, (const char (*)[MAX_VARIABLE_NAME])names, inputCount, sources);
+    if (err.code != 0) {
+        free(reader.data);
+        return err;
+    }
+
+    // 只为公式用到的输入列分配缓冲区
+    ColumnBlock block;
+    memset(&block, 0, sizeof(block));
+    int allocationFailed = 0;
+    for (int f = 0; f < set->count; f++) {
+        for (int v = 0; v < set->formulas[f].prog.varCount; v++) {
+            int source = sources[f][v];
+            if (source < inputCount && block.values[source] == NULL) {
+                block.values[source] = (double*)malloc(COLUMN_BLOCK_ROWS * sizeof(double));
+                block.failed[source] = (unsigned char*)malloc(COLUMN_BLOCK_ROWS);
+                allocationFailed |= block.values[source] == NULL || block.failed[source] == NULL;
+            }
+        }
+        block.values[inputCount + f] = (double*)malloc(COLUMN_BLOCK_ROWS * sizeof(double));
+        block.failed[inputCount + f] = (unsigned char*)malloc(COLUMN_BLOCK_ROWS);
+        allocationFailed |= block.values[inputCount + f] == NULL || block.failed[inputCount + f] == NULL;
+    }
+    LineSpan* lines = (LineSpan*)malloc(COLUMN_BLOCK_ROWS * sizeof(LineSpan));
+    ErrorCode* errors = (ErrorCode*)malloc(COLUMN_BLOCK_ROWS * sizeof(ErrorCode));
+    char* out = NULL;
+    size_t outLength = 0, outCapacity = 0;
+    if (allocationFailed || lines == NULL || errors == NULL) {
+        err = CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+    }
+
+    // 输出列名
+    if (err.code == 0) {
+        int ok = appendOutput(&out, &outLength, &outCapacity, header.start, header.length);
+        for (int f = 0; f < set->count && ok; f++) {
+            ok = appendOutput(&out, &outLength, &outCapacity, ",", 1) &&
+                 appendOutput(&out, &outLength, &outCapacity, set->formulas[f].name, strlen(set->formulas[f].name));
+        }
+        if (!ok || !appendOutput(&out, &outLength, &outCapacity, "\n", 1)) {
+            err = CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+        }
+    }
+
+    while (err.code == 0) {
+        // 收集一块数据行（跳过空行）
+        size_t rows = 0;
+        while (rows < COLUMN_BLOCK_ROWS) {
+            if (takeLine(&reader, &lines[rows])) {
+                if (lines[rows].length > 0) rows++;
+            } else if (rows > 0 || !refillReader(&reader, &err)) {
+                break;
+            }
+        }
+        if (rows == 0) {
+            break;
+        }
+
+        // 解析用到的列
+        for (size_t r = 0; r < rows; r++) {
+            cursor = lines[r].start;
+            end = lines[r].start + lines[r].length;
+            more = 1;
+            for (int c = 0; c < inputCount; c++) {
+                const char *fieldStart, *fieldEnd;
+                int present = more;
+                if (present) {
+                    more = nextField(&cursor, end, &fieldStart, &fieldEnd);
+                }
+                if (block.values[c] != NULL) {
+                    double value = NAN;
+                    int ok = present && parseNumberField(fieldStart, fieldEnd, &value);
+                    ((double*)block.values[c])[r] = ok ? value : NAN;
+                    block.failed[c][r] = (unsigned char)!ok;
+                }
+            }
+        }
+
+        evaluateFormulaBlock(set, inputCount, sources, &block, rows, errors, stats->rows + 1, stats);
+        stats->rows += rows;
+
+        // 原行后追加结果列
+        for (size_t r = 0; r < rows && err.code == 0; r++) {
+            int ok = appendOutput(&out, &outLength, &outCapacity, lines[r].start, lines[r].length);
+            for (int f = 0; f < set->count && ok; f++) {
+                char number[MAX_ROUND_TRIP_NUMBER + 1];
+                int length = 0;
+                number[length++] = ',';
+                if (!block.failed[inputCount + f][r]) {
+                    length += formatRoundTrip(block.values[inputCount + f][r], number + 1, MAX_ROUND_TRIP_NUMBER);
+                }
+                ok = appendOutput(&out, &outLength, &outCapacity, number, (size_t)length);
+            }
+            if (!ok || !appendOutput(&out, &outLength, &outCapacity, "\n", 1)) {
+                err = CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+            }
+        }
+        if (err.code == 0 && fwrite(out, 1, outLength, output) != outLength) {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "写入输出失败");
+        }
+        outLength = 0;
+    }
+    if (err.code == 0 && outLength > 0 && fwrite(out, 1, outLength, output) != outLength) {
+        err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "写入输出失败");
+    }
+
+    for (int i = 0; i < inputCount + set->count; i++) {
+        free((double*)block.values[i]);
+        free(block.failed[i]);
+    }
+    free(lines);
+    free(errors);
+    free(out);
+    free(reader.data);
+    return err;
+}
+
+// ─── 列式文件 ───────────────────────────────────────────────────────────────
+
+/**
+ * 写入列式文件
+ *
+ * @param names       列名
+ * @param columns     每列的数据（各 rows 个）
+ * @param columnCount 列数
+ * @param rows        行数
+ */
+CalcError writeColumnarFile(const char* path, const char (*names)[MAX_VARIABLE_NAME],
+                            const double* const* columns, int columnCount, uint64_t rows) {
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法创建列式文件");
+    }
+    ColumnarFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+    header.version = COLUMNAR_VERSION;
+    header.endianTag = COLUMNAR_ENDIAN_TAG;
+    header.columnCount = (uint32_t)columnCount;
+    header.rowCount = rows;
+
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int c = 0; c < columnCount && ok; c++) {
+        char name[MAX_VARIABLE_NAME] = {0};
+        strncpy(name, names[c], MAX_VARIABLE_NAME - 1);
+        ok = fwrite(name, MAX_VARIABLE_NAME, 1, file) == 1;
+    }
+    for (int c = 0; c < columnCount && ok; c++) {
+        ok = rows == 0 || fwrite(columns[c], sizeof(double), (size_t)rows, file) == (size_t)rows;
+    }
+    if (fclose(file) != 0 || !ok) {
+        remove(path);
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "写入列式文件失败");
+    }
+    return CALC_SUCCESS;
+}
+
+/**
+ * 计算列式文件：输入用 mmap 映射后直接整列计算，输出包含全部输入列与结果列
+ * （出错的单元格为 NaN）
+ */
+CalcError evaluateColumnarFile(const char* inputPath, const char* outputPath, const FormulaSet* set,
+                               ColumnStats* stats) {
+    MappedFile file;
+    memset(stats, 0, sizeof(*stats));
+    if (isSameFile(inputPath, outputPath)) {    // 输入仍在映射中，不能覆盖（./in.col、链接也算同一文件）
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "输出文件不能与输入文件相同");
+    }
+    CalcError err = mapReadOnlyFile(inputPath, &file);
+    if (err.code != 0) {
+        return err;
+    }
+
+    const ColumnarFileHeader* header = (const ColumnarFileHeader*)file.base;
+    if (file.size < sizeof(*header) || memcmp(header->magic, COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC)) != 0) {
+        err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "列式文件格式不正确");
+    } else if (header->version != COLUMNAR_VERSION || header->endianTag != COLUMNAR_ENDIAN_TAG) {
+        err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "列式文件版本或平台不兼容");
+    } else if (header->columnCount > MAX_DATA_COLUMNS ||
+               (file.size - sizeof(*header)) / MAX_VARIABLE_NAME < header->columnCount ||
+               (header->columnCount > 0 &&
+                (file.size - sizeof(*header) - (size_t)header->columnCount * MAX_VARIABLE_NAME) /
+                    sizeof(double) / header->columnCount != header->rowCount) ||
+               (header->columnCount == 0 && file.size != sizeof(*header))) {
+        err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "列式文件已损坏");
+    }
+    if (err.code != 0) {
+        unmapFile(&file);
+        return err;
+    }
+
+    int inputCount = (int)header->columnCount;
+    size_t rows = (size_t)header->rowCount;
+    char names[MAX_DATA_COLUMNS + MAX_FORMULA_COLUMNS][MAX_VARIABLE_NAME];
+    const char* storedNames = (const char*)(header + 1);
+    const double* data = (const double*)(storedNames + (size_t)inputCount * MAX_VARIABLE_NAME);
+    for (int c = 0; c < inputCount; c++) {
+        memcpy(names[c], storedNames + (size_t)c * MAX_VARIABLE_NAME, MAX_VARIABLE_NAME);
+        names[c][MAX_VARIABLE_NAME - 1] = '\0';
+    }
+    for (int f = 0; f < set->count; f++) {
+        memcpy(names[inputCount + f], set->formulas[f].name, MAX_VARIABLE_NAME);
+    }
+
+    FormulaSources sources;
+    err = resolveSources(set, (const char (*)[MAX_VARIABLE_NAME])names, inputCount, sources);
+
+    // 结果列整列保存，计算按块进行
+    const double* columns[MAX_DATA_COLUMNS + MAX_FORMULA_COLUMNS];
+    double* results[MAX_FORMULA_COLUMNS] = {NULL};
+    unsigned char* failed[MAX_FORMULA_COLUMNS] = {NULL};
+    ErrorCode* errors = (ErrorCode*)malloc(COLUMN_BLOCK_ROWS * sizeof(ErrorCode));
+    for (int f = 0; f < set->count && err.code == 0; f++) {
+        results[f] = (double*)malloc((rows > 0 ? rows : 1) * sizeof(double));
+        failed[f] = (unsigned char*)malloc(COLUMN_BLOCK_ROWS);
+        if (results[f] == NULL || failed[f] == NULL) {
+            err = CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+        }
+    }
+    if (errors == NULL && err.code == 0) {
+        err = CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+    }
+
+    for (size_t offset = 0; err.code == 0 && offset < rows; offset += COLUMN_BLOCK_ROWS) {
+        size_t blockRows = rows - offset < COLUMN_BLOCK_ROWS ? rows - offset : COLUMN_BLOCK_ROWS;
+        ColumnBlock block;
+        for (int c = 0; c < inputCount; c++) {
+            block.values[c] = data + (size_t)c * rows + offset;
+            block.failed[c] = NULL;
+        }
+        for (int f = 0; f < set->count; f++) {
+            block.values[inputCount + f] = results[f] + offset;
+            block.failed[inputCount + f] = failed[f];
+        }
+        evaluateFormulaBlock(set, inputCount, sources, &block, blockRows, errors, offset + 1, stats);
+    }
+    stats->rows = rows;
+
+    if (err.code == 0) {
+        for (int c = 0; c < inputCount; c++) {
+            columns[c] = data + (size_t)c * rows;
+        }
+        for (int f = 0; f < set->count; f++) {
+            columns[inputCount + f] = results[f];
+        }
+        err = writeColumnarFile(outputPath, (const char (*)[MAX_VARIABLE_NAME])names, columns,
+                                inputCount + set->count, rows);
+    }
+
+    for (int f = 0; f < set->count; f++) {
+        free(results[f]);
+        free(failed[f]);
+    }
+    free(errors);
+    unmapFile(&file);
+    return err;
+}
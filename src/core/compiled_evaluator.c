@@ -0,0 +1,671 @@
+#include "calculator.h"
+#include "compiled_expression.h"
+#include "polynomial_evaluator.h"
+#include "vector_value.h"
+
+/**
+ * 双精度运算结果是否可以视为精确整数
+ * 超过 2^53 的 double 都是整数，但已经过舍入，不再视为精确
+ */
+static int resultToExactInt64(double value, int64_t* intValue) {
+    return fabs(value) <= (double)MAX_EXACT_DOUBLE_INTEGER && doubleToExactInt64(value, intValue);
+}
+
+// 字节码操作码对应的运算符
+char opcodeToOperator(int op) {
+    switch (op) {
+        case OP_ADD: return '+';
+        case OP_SUB: return '-';
+        case OP_MUL: return '*';
+        case OP_DIV: return '/';
+        case OP_POW: return '^';
+        case OP_LT:  return '<';
+        case OP_LE:  return OPERATOR_LE;
+        case OP_GT:  return '>';
+        case OP_GE:  return OPERATOR_GE;
+        case OP_EQ:  return OPERATOR_EQ;
+        case OP_NE:  return OPERATOR_NE;
+        case OP_AND: return OPERATOR_AND;
+        case OP_OR:  return OPERATOR_OR;
+        case OP_NOT: return OPERATOR_NOT;
+        default:     return '\0';
+    }
+}
+
+// 出错的指令及其操作数（只在出错时写入，用于事后生成错误消息）
+typedef struct {
+    int index;
+    double lhs;
+    double rhs;
+} CompiledFault;
+
+/**
+ * 求值核心：只返回错误代码，不构造 CalcError，也不处理错误位置
+ * 整数操作数之间的 + - * / ^ 在 int64_t 上计算（performIntegerOperation），
+ * 只有溢出、除不尽或遇到非整数时才转为双精度，因此超过 2^53 的整数结果仍然精确
+ * 多项式子树的起点按改写方式一次求出并跳过整个子树，需要回退时照常执行原指令
+ */
+static inline ErrorCode runCompiled(const CompiledExpr* prog, const double* vars, AngleMode mode,
+                                    CalcNumber* result, CompiledFault* fault) {
+    double stack[MAX_EXPR];
+    int64_t intStack[MAX_EXPR];
+    unsigned char isInt[MAX_EXPR];
+    int top = -1;
+    const PolynomialPlan* poly = prog->polynomials;
+    const PolynomialPlan* polyEnd = poly + prog->polynomialCount;
+
+    for (int i = 0; i < prog->length; i++) {
+        const Instruction* ins = &prog->code[i];
+        ErrorCode code;
+
+        if (poly < polyEnd && i == poly->start) {
+            CalcNumber value;
+            if (evaluatePolynomialNumber(poly, vars[poly->slot], &value)) {
+                top++;
+                stack[top] = value.value;
+                intStack[top] = value.intValue;
+                isInt[top] = (unsigned char)value.isInteger;
+                i = poly->end - 1;
+                poly++;
+                continue;
+            }
+            poly++;
+        }
+
+        switch (ins->op) {
+            case OP_CONST:
+            case OP_VAR:
+                top++;
+                stack[top] = (ins->op == OP_CONST) ? ins->value : vars[ins->slot];
+                isInt[top] = (unsigned char)doubleToExactInt64(stack[top], &intStack[top]);
+                break;
+
+            case OP_NEG:
+                stack[top] = -stack[top];
+                if (isInt[top]) {
+                    isInt[top] = intStack[top] != INT64_MIN;
+                    intStack[top] = isInt[top] ? -intStack[top] : 0;
+                }
+                break;
+
+            case OP_CALL: {
+                double argument = stack[top];
+                code = calculateFunctionCode((FuncType)ins->func, argument, mode, &stack[top]);
+                if (code != ERR_SUCCESS) {
+                    fault->index = i;
+                    fault->lhs = argument;
+                    return code;
+                }
+                isInt[top] = (unsigned char)resultToExactInt64(stack[top], &intStack[top]);
+                break;
+            }
+
+            case OP_NOT:
+            case OP_AND:
+            case OP_OR:
+                // and / or 的左操作数已由 OP_BRANCH 弹出，这里只把右操作数转成 1 或 0
+                stack[top] = (ins->op == OP_NOT) ? (stack[top] == 0) : (stack[top] != 0);
+                intStack[top] = (int64_t)stack[top];
+                isInt[top] = 1;
+                break;
+
+            case OP_BRANCH:
+                if (!branchTaken(ins, stack[top])) {
+                    top--;
+                    break;
+                }
+                if (ins->func == OP_SELECT) {
+                    top--;
+                } else {
+                    stack[top] = (ins->func == OP_OR);
+                    intStack[top] = (int64_t)stack[top];
+                    isInt[top] = 1;
+                }
+                i = ins->slot - 1;
+                poly = seekPolynomialPlan(poly, polyEnd, ins->slot);
+                break;
+
+            case OP_JUMP:
+                i = ins->slot - 1;
+                poly = seekPolynomialPlan(poly, polyEnd, ins->slot);
+                break;
+
+            case OP_SELECT:
+                break;
+
+            default: {
+                char op = opcodeToOperator(ins->op);
+                top--;
+                if (isInt[top] && isInt[top + 1] &&
+                    performIntegerOperation(op, intStack[top], intStack[top + 1], &intStack[top])) {
+                    stack[top] = (double)intStack[top];
+                    break;
+                }
+                double lhs = stack[top];
+                code = performOperationCode(op, lhs, stack[top + 1], &stack[top]);
+                if (code != ERR_SUCCESS) {
+                    fault->index = i;
+                    fault->lhs = lhs;
+                    fault->rhs = stack[top + 1];
+                    return code;
+                }
+                isInt[top] = (unsigned char)resultToExactInt64(stack[top], &intStack[top]);
+                break;
+            }
+        }
+    }
+
+    result->value = stack[0];
+    result->isInteger = isInt[0];
+    result->intValue = isInt[0] ? intStack[0] : 0;
+    return ERR_SUCCESS;
+}
+
+static ErrorCode checkProgram(const CompiledExpr* prog) {
+    if (prog->length == 0 || prog->maxStack > MAX_EXPR) {
+        return ERR_SYNTAX;
+    }
+    return (prog->isDecimal || prog->isVector) ? ERR_INVALID_ARGUMENT : ERR_SUCCESS;
+}
+
+/**
+ * 对单组变量取值求值编译后的表达式，并跟踪结果是否为精确整数
+ * 求值本身只处理错误代码，出错后才根据出错指令与操作数生成错误消息
+ *
+ * @param prog   编译后的表达式
+ * @param vars   变量值，按槽位顺序排列（无变量时可为 NULL）
+ * @param mode   角度模式
+ * @param result 输出计算结果
+ * @return 成功返回 CALC_SUCCESS，否则返回错误（position 为出错运算在表达式中的位置）
+ */
+CalcError evaluateCompiledNumber(const CompiledExpr* prog, const double* vars, AngleMode mode,
+                                 CalcNumber* result) {
+    ErrorCode code = checkProgram(prog);
+    if (code == ERR_SYNTAX) {
+        return CALC_ERROR_CODE(ERR_SYNTAX, "表达式不完整");
+    }
+    if (code != ERR_SUCCESS) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, prog->isVector ? "向量表达式只能按向量求值"
+                                                                    : "十进制模式的表达式只能按十进制求值");
+    }
+
+    CompiledFault fault;
+    code = runCompiled(prog, vars, mode, result, &fault);
+    if (code == ERR_SUCCESS) {
+        return CALC_SUCCESS;
+    }
+    const Instruction* ins = &prog->code[fault.index];
+    const char* message = (ins->op == OP_CALL)
+                              ? describeFunctionError((FuncType)ins->func, code)
+                              : describeOperationError(fault.lhs, fault.rhs, code);
+    return CALC_ERROR_CODE_POS(code, message, ins->position);
+}
+
+/**
+ * 对单组变量取值求值编译后的表达式（双精度）
+ * 逐条指令复用 performOperation / calculateFunctionWithError 的计算逻辑。
+ * 整数中间结果在 int64 上精确计算，因此超过 2^53 时结果可能与 evaluateExpression
+ * 及双精度批量求值不同（x = 2^60 时 x+1-x 在这里得到 1，在后两者得到 0）；
+ * 不超过 2^53 时三者一致
+ */
+CalcError evaluateCompiled(const CompiledExpr* prog, const double* vars, AngleMode mode, double* result) {
+    CalcNumber number;
+    CalcError err = evaluateCompiledNumber(prog, vars, mode, &number);
+    if (err.code == 0) {
+        *result = number.value;
+    }
+    return err;
+}
+
+/**
+ * 快速求值：只返回错误代码，结果与 evaluateCompiled 一致
+ * 出错时（通常很少）再调用 diagnoseCompiled 得到错误消息与位置
+ */
+ErrorCode evaluateCompiledFast(const CompiledExpr* prog, const double* vars, AngleMode mode, double* result) {
+    ErrorCode code = checkProgram(prog);
+    if (code != ERR_SUCCESS) {
+        return code;
+    }
+    CalcNumber number;
+    CompiledFault fault;
+    code = runCompiled(prog, vars, mode, &number, &fault);
+    if (code == ERR_SUCCESS) {
+        *result = number.value;
+    }
+    return code;
+}
+
+/**
+ * 诊断：用同一组变量重新求值，返回带错误消息与位置的错误（没有出错时返回 CALC_SUCCESS）
+ */
+CalcError diagnoseCompiled(const CompiledExpr* prog, const double* vars, AngleMode mode) {
+    CalcNumber ignored;
+    return evaluateCompiledNumber(prog, vars, mode, &ignored);
+}
+
+// ─── 批量求值 ───────────────────────────────────────────────────────────────
+
+// 记录行错误（只保留每行的第一个错误）
+#define SET_ROW_ERROR(errs, row, code) do { if ((errs)[row] == 0) (errs)[row] = (unsigned char)(code); } while (0)
+
+/**
+ * 批量求值条件分支所需的行错误快照字节数：每个 OP_BRANCH 两份（分支之前、then 分支之后）
+ */
+size_t branchSnapshotSize(const CompiledExpr* prog) {
+    size_t branches = 0;
+    for (int i = 0; i < prog->length; i++) {
+        branches += (prog->code[i].op == OP_BRANCH);
+    }
+    return branches * 2 * BATCH_BLOCK_SIZE;
+}
+
+/**
+ * POLYNOMIAL_FAST 的子树有行需要回退时整块执行原指令，子树结束后把能改写的行
+ * 换回改写结果并恢复子树之前的行错误，使每一行都与单行求值逐位一致
+ */
+static void restorePolynomialRows(const PolynomialPlan* plan, const double* x, size_t count, double* values,
+                                  unsigned char* rowErrors, const unsigned char* savedErrors) {
+    for (size_t r = 0; r < count; r++) {
+        CalcNumber number;
+        if (!savedErrors[r] && evaluatePolynomialNumber(plan, x[r], &number)) {
+            values[r] = number.value;
+            rowErrors[r] = 0;
+        }
+    }
+}
+
+/**
+ * 双精度块求值：按列逐条指令处理 count 行
+ * 每个元素调用 performOperationCode / calculateFunctionCode，语义与单行求值一致
+ */
+static void evaluateBlockF64(const CompiledExpr* prog, const double* const* columns, size_t offset,
+                             size_t count, AngleMode mode, double* stack, unsigned char* rowErrors,
+                             unsigned char* snapshots, double* out) {
+    int top = -1;
+    unsigned char* frame = snapshots;   // 当前条件分支的快照
+    const PolynomialPlan* poly = prog->polynomials;
+    const PolynomialPlan* polyEnd = poly + prog->polynomialCount;
+    const PolynomialPlan* pending = NULL;   // 正在按原指令执行、结束后需要换回改写结果的子树
+    unsigned char savedErrors[BATCH_BLOCK_SIZE];
+
+    for (int i = 0; i < prog->length; i++) {
+        const Instruction* ins = &prog->code[i];
+        double* dst;
+        double* rhs;
+
+        // 多项式子树整块一次求出，有任何一行需要回退时整块执行原指令
+        if (poly < polyEnd && i == poly->start) {
+            dst = stack + (size_t)(top + 1) * BATCH_BLOCK_SIZE;
+            if (evaluatePolynomialArray(poly, columns[poly->slot] + offset, count, dst) == count) {
+                top++;
+                i = poly->end - 1;
+                poly++;
+                continue;
+            }
+            if (poly->fast) {
+                pending = poly;
+                memcpy(savedErrors, rowErrors, count);
+            }
+            poly++;
+        }
+
+        switch (ins->op) {
+            case OP_CONST:
+                dst = stack + (size_t)(++top) * BATCH_BLOCK_SIZE;
+                for (size_t r = 0; r < count; r++) dst[r] = ins->value;
+                break;
+
+            case OP_VAR:
+                dst = stack + (size_t)(++top) * BATCH_BLOCK_SIZE;
+                memcpy(dst, columns[ins->slot] + offset, count * sizeof(double));
+                break;
+
+            case OP_NEG:
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                for (size_t r = 0; r < count; r++) dst[r] = -dst[r];
+                break;
+
+            case OP_CALL:
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                for (size_t r = 0; r < count; r++) {
+                    if (rowErrors[r]) continue;
+                    ErrorCode code = calculateFunctionCode((FuncType)ins->func, dst[r], mode, &dst[r]);
+                    if (code != ERR_SUCCESS) SET_ROW_ERROR(rowErrors, r, code);
+                }
+                break;
+
+            case OP_LT:
+            case OP_LE:
+            case OP_GT:
+            case OP_GE:
+            case OP_EQ:
+            case OP_NE:
+                top--;
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                vectorCompare(opcodeToOperator(ins->op), dst, 1, dst + BATCH_BLOCK_SIZE, 1, dst, count);
+                break;
+
+            case OP_NOT:
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                for (size_t r = 0; r < count; r++) dst[r] = (dst[r] == 0);
+                break;
+
+            // 条件分支不跳转：两侧都按列计算，再按条件选择值与行错误
+            case OP_BRANCH:
+                memcpy(frame, rowErrors, count);
+                frame += 2 * BATCH_BLOCK_SIZE;
+                break;
+
+            case OP_JUMP:
+                memcpy(frame - BATCH_BLOCK_SIZE, rowErrors, count);
+                memcpy(rowErrors, frame - 2 * BATCH_BLOCK_SIZE, count);
+                break;
+
+            case OP_SELECT:
+                frame -= 2 * BATCH_BLOCK_SIZE;
+                top -= 2;
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                selectRowErrors(dst, frame + BATCH_BLOCK_SIZE, rowErrors, rowErrors, count);
+                vectorSelect(dst, dst + BATCH_BLOCK_SIZE, dst + 2 * BATCH_BLOCK_SIZE, dst, count);
+                break;
+
+            case OP_AND:
+            case OP_OR:
+                frame -= 2 * BATCH_BLOCK_SIZE;
+                top--;
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                // 左操作数已经决定结果的行不报告右操作数中的错误
+                if (ins->op == OP_AND) {
+                    selectRowErrors(dst, rowErrors, frame, rowErrors, count);
+                } else {
+                    selectRowErrors(dst, frame, rowErrors, rowErrors, count);
+                }
+                vectorCompare(opcodeToOperator(ins->op), dst, 1, dst + BATCH_BLOCK_SIZE, 1, dst, count);
+                break;
+
+            default: {
+                char op = opcodeToOperator(ins->op);
+                top--;
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                rhs = dst + BATCH_BLOCK_SIZE;
+                for (size_t r = 0; r < count; r++) {
+                    if (rowErrors[r]) continue;
+                    ErrorCode code = performOperationCode(op, dst[r], rhs[r], &dst[r]);
+                    if (code != ERR_SUCCESS) SET_ROW_ERROR(rowErrors, r, code);
+                }
+                break;
+            }
+        }
+
+        if (pending && i == pending->end - 1) {
+            restorePolynomialRows(pending, columns[pending->slot] + offset, count,
+                                  stack + (size_t)top * BATCH_BLOCK_SIZE, rowErrors, savedErrors);
+            pending = NULL;
+        }
+    }
+
+    for (size_t r = 0; r < count; r++) {
+        out[r] = rowErrors[r] ? NAN : stack[r];
+    }
+}
+
+/**
+ * 单精度块求值：算术为逐元素向量循环，函数使用 calculateFunctionBlockF32 内核，
+ * 每步之后按单精度阈值修正接近整数的结果
+ */
+static void evaluateBlockF32(const CompiledExpr* prog, const double* const* columns, size_t offset,
+                             size_t count, AngleMode mode, float* stack, unsigned char* rowErrors,
+                             unsigned char* snapshots, double* out) {
+    int top = -1;
+    unsigned char* frame = snapshots;
+    const PolynomialPlan* poly = prog->polynomials;
+    const PolynomialPlan* polyEnd = poly + prog->polynomialCount;
+
+    for (int i = 0; i < prog->length; i++) {
+        const Instruction* ins = &prog->code[i];
+        float* dst;
+        float* rhs;
+
+        if (poly < polyEnd && i == poly->start) {
+            dst = stack + (size_t)(top + 1) * BATCH_BLOCK_SIZE;
+            if (evaluatePolynomialArrayF32(poly, columns[poly->slot] + offset, count, dst) == count) {
+                snapFloatArray(dst, count);
+                top++;
+                i = poly->end - 1;
+                poly++;
+                continue;
+            }
+            poly++;
+        }
+
+        switch (ins->op) {
+            case OP_CONST: {
+                float value = (float)ins->value;
+                dst = stack + (size_t)(++top) * BATCH_BLOCK_SIZE;
+                for (size_t r = 0; r < count; r++) dst[r] = value;
+                break;
+            }
+
+            case OP_VAR: {
+                const double* src = columns[ins->slot] + offset;
+                dst = stack + (size_t)(++top) * BATCH_BLOCK_SIZE;
+                for (size_t r = 0; r < count; r++) dst[r] = (float)src[r];
+                break;
+            }
+
+            case OP_NEG:
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                for (size_t r = 0; r < count; r++) dst[r] = -dst[r];
+                break;
+
+            case OP_CALL:
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                calculateFunctionBlockF32((FuncType)ins->func, dst, dst, count, mode, rowErrors);
+                snapFloatArray(dst, count);
+                break;
+
+            // 比较与选择的结果不需要溢出检查与整数修正；循环没有分支，由编译器向量化
+            case OP_LT:
+            case OP_LE:
+            case OP_GT:
+            case OP_GE:
+            case OP_EQ:
+            case OP_NE:
+            case OP_AND:
+            case OP_OR:
+                top--;
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                rhs = dst + BATCH_BLOCK_SIZE;
+                if (ins->op == OP_AND || ins->op == OP_OR) {
+                    frame -= 2 * BATCH_BLOCK_SIZE;
+                    int decided = (ins->op == OP_OR);   // 左操作数为此真值时不报告右操作数的错误
+                    for (size_t r = 0; r < count; r++) {
+                        rowErrors[r] = ((dst[r] != 0) == decided) ? frame[r] : rowErrors[r];
+                    }
+                }
+                switch (ins->op) {
+                    case OP_LT:  for (size_t r = 0; r < count; r++) dst[r] = dst[r] < rhs[r]; break;
+                    case OP_LE:  for (size_t r = 0; r < count; r++) dst[r] = dst[r] <= rhs[r]; break;
+                    case OP_GT:  for (size_t r = 0; r < count; r++) dst[r] = dst[r] > rhs[r]; break;
+                    case OP_GE:  for (size_t r = 0; r < count; r++) dst[r] = dst[r] >= rhs[r]; break;
+                    case OP_EQ:  for (size_t r = 0; r < count; r++) dst[r] = dst[r] == rhs[r]; break;
+                    case OP_NE:  for (size_t r = 0; r < count; r++) dst[r] = dst[r] != rhs[r]; break;
+                    case OP_AND: for (size_t r = 0; r < count; r++) dst[r] = (dst[r] != 0) & (rhs[r] != 0); break;
+                    default:     for (size_t r = 0; r < count; r++) dst[r] = (dst[r] != 0) | (rhs[r] != 0); break;
+                }
+                break;
+
+            case OP_NOT:
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                for (size_t r = 0; r < count; r++) dst[r] = (dst[r] == 0);
+                break;
+
+            case OP_BRANCH:
+                memcpy(frame, rowErrors, count);
+                frame += 2 * BATCH_BLOCK_SIZE;
+                break;
+
+            case OP_JUMP:
+                memcpy(frame - BATCH_BLOCK_SIZE, rowErrors, count);
+                memcpy(rowErrors, frame - 2 * BATCH_BLOCK_SIZE, count);
+                break;
+
+            case OP_SELECT: {
+                frame -= 2 * BATCH_BLOCK_SIZE;
+                top -= 2;
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                const float* a = dst + BATCH_BLOCK_SIZE;
+                const float* b = dst + 2 * BATCH_BLOCK_SIZE;
+                const unsigned char* thenErrors = frame + BATCH_BLOCK_SIZE;
+                for (size_t r = 0; r < count; r++) {
+                    int taken = (dst[r] != 0);
+                    rowErrors[r] = taken ? thenErrors[r] : rowErrors[r];
+                    dst[r] = taken ? a[r] : b[r];
+                }
+                break;
+            }
+
+            default:
+                top--;
+                dst = stack + (size_t)top * BATCH_BLOCK_SIZE;
+                rhs = dst + BATCH_BLOCK_SIZE;
+                switch (ins->op) {
+                    case OP_ADD:
+                        for (size_t r = 0; r < count; r++) dst[r] = dst[r] + rhs[r];
+                        break;
+                    case OP_SUB:
+                        for (size_t r = 0; r < count; r++) dst[r] = dst[r] - rhs[r];
+                        break;
+                    case OP_MUL:
+                        for (size_t r = 0; r < count; r++) dst[r] = dst[r] * rhs[r];
+                        break;
+                    case OP_DIV:
+                        for (size_t r = 0; r < count; r++) {
+                            if (fabsf(rhs[r]) < ABSOLUTE_ZERO_THRESHOLD_F32) SET_ROW_ERROR(rowErrors, r, ERR_DIV_BY_ZERO);
+                            dst[r] = dst[r] / rhs[r];
+                        }
+                        break;
+                    case OP_POW:
+                        for (size_t r = 0; r < count; r++) {
+                            float a = dst[r], b = rhs[r];
+                            if (fabsf(a) < ABSOLUTE_ZERO_THRESHOLD_F32 && b < 0) {
+                                SET_ROW_ERROR(rowErrors, r, ERR_UNDEFINED);
+                            } else if (a < 0 && fabsf(b - rintf(b)) > EPSILON_F32) {
+                                SET_ROW_ERROR(rowErrors, r, ERR_UNDEFINED);
+                            }
+                            dst[r] = powf(a, b);
+                        }
+                        break;
+                }
+                for (size_t r = 0; r < count; r++) {
+                    if (isinf(dst[r]) || isnan(dst[r])) SET_ROW_ERROR(rowErrors, r, ERR_OVERFLOW);
+                }
+                snapFloatArray(dst, count);
+                break;
+        }
+    }
+
+    // 超出单精度范围的输入在转换时变为无穷大，同样按溢出处理
+    for (size_t r = 0; r < count; r++) {
+        if (!isfinite(stack[r])) SET_ROW_ERROR(rowErrors, r, ERR_OVERFLOW);
+        out[r] = rowErrors[r] ? NAN : (double)stack[r];
+    }
+}
+
+/**
+ * 按需提升精度的块求值：逐行调用 evaluateCompiledAdaptive，
+ * 只有误差上界超标的行才会进行双双精度计算
+ */
+static void evaluateBlockAdaptive(const CompiledExpr* prog, const double* const* columns, size_t offset,
+                                  size_t count, AngleMode mode, unsigned char* rowErrors, double* out) {
+    double vars[MAX_COMPILED_VARIABLES];
+
+    for (size_t r = 0; r < count; r++) {
+        for (int v = 0; v < prog->varCount; v++) {
+            vars[v] = columns[v][offset + r];
+        }
+        CalcError err = evaluateCompiledAdaptive(prog, vars, mode, DEFAULT_ESCALATION_TOLERANCE, &out[r], NULL);
+        if (err.code != 0) {
+            SET_ROW_ERROR(rowErrors, r, err.code);
+            out[r] = NAN;
+        }
+    }
+}
+
+/**
+ * 批量求值：对 rows 组变量取值计算同一个表达式
+ *
+ * @param prog      编译后的表达式
+ * @param columns   按列存放的变量值，columns[slot][row]（无变量时可为 NULL）
+ * @param rows      行数
+ * @param mode      角度模式
+ * @param precision 求值精度（EVAL_FP64、EVAL_FP32 或 EVAL_ADAPTIVE）
+ * @param results   输出结果，出错的行为 NaN
+ * @param errors    可选，输出每行的错误代码（ERR_SUCCESS 表示成功）
+ * @return 全部成功返回 CALC_SUCCESS，否则返回第一个出错行的错误
+ */
+CalcError evaluateCompiledBatch(const CompiledExpr* prog, const double* const* columns, size_t rows,
+                                AngleMode mode, EvalPrecision precision,
+                                double* results, ErrorCode* errors) {
+    if (prog->length == 0 || prog->maxStack > MAX_EXPR) {
+        return CALC_ERROR_CODE(ERR_SYNTAX, "表达式不完整");
+    }
+    if (prog->isDecimal) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "十进制模式的表达式只能按十进制求值");
+    }
+    if (prog->isVector) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "向量表达式只能按向量求值");
+    }
+
+    // 栈之后是条件分支的行错误快照
+    size_t elementSize = (precision == EVAL_FP32) ? sizeof(float) : sizeof(double);
+    size_t stackSize = (size_t)prog->maxStack * BATCH_BLOCK_SIZE * elementSize;
+    void* stack = malloc(stackSize + branchSnapshotSize(prog));
+    if (stack == NULL) {
+        return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+    }
+    unsigned char* snapshots = (unsigned char*)stack + stackSize;
+
+    unsigned char rowErrors[BATCH_BLOCK_SIZE];
+    size_t firstErrorRow = rows;
+    int firstErrorCode = 0;
+
+    for (size_t offset = 0; offset < rows; offset += BATCH_BLOCK_SIZE) {
+        size_t count = (rows - offset < BATCH_BLOCK_SIZE) ? rows - offset : BATCH_BLOCK_SIZE;
+        memset(rowErrors, 0, count);
+
+        if (precision == EVAL_FP32) {
+            evaluateBlockF32(prog, columns, offset, count, mode, (float*)stack, rowErrors, snapshots,
+                             results + offset);
+        } else if (precision == EVAL_ADAPTIVE) {
+            evaluateBlockAdaptive(prog, columns, offset, count, mode, rowErrors, results + offset);
+        } else {
+            evaluateBlockF64(prog, columns, offset, count, mode, (double*)stack, rowErrors, snapshots,
+                             results + offset);
+        }
+
+        for (size_t r = 0; r < count; r++) {
+            if (errors) errors[offset + r] = (ErrorCode)rowErrors[r];
+            if (rowErrors[r] && firstErrorRow == rows) {
+                firstErrorRow = offset + r;
+                firstErrorCode = rowErrors[r];
+            }
+        }
+    }
+    free(stack);
+
+    if (firstErrorRow == rows) {
+        return CALC_SUCCESS;
+    }
+
+    // 出错时按单行重新求值，得到准确的错误消息和位置
+    double vars[MAX_COMPILED_VARIABLES];
+    for (int v = 0; v < prog->varCount; v++) {
+        vars[v] = columns[v][firstErrorRow];
+    }
+    CalcError err = diagnoseCompiled(prog, vars, mode);
+    if (err.code == firstErrorCode) {
+        return err;
+    }
+    return CALC_ERROR_CODE(firstErrorCode, getErrorDescription(firstErrorCode));
+}
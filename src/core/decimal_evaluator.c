@@ -0,0 +1,128 @@
+#include "calculator.h"
+#include "compiled_expression.h"
+
+/**
+ * 十进制定点求值
+ * 所有中间结果使用编译时指定的小数位数，乘除结果按编译时指定的方式舍入
+ *
+ * @param prog   以 compileDecimalExpression 编译的表达式
+ * @param vars   变量值（小数位数不同时按表达式的小数位数舍入），无变量时可为 NULL
+ * @param result 输出计算结果
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+CalcError evaluateCompiledDecimal(const CompiledExpr* prog, const Decimal* vars, Decimal* result) {
+    Decimal stack[MAX_EXPR];
+    int top = -1;
+
+    if (prog->length == 0 || prog->maxStack > MAX_EXPR) {
+        return CALC_ERROR_CODE(ERR_SYNTAX, "表达式不完整");
+    }
+    if (!prog->isDecimal) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "表达式未以十进制模式编译");
+    }
+
+    int scale = prog->decimal.scale;
+    DecimalRounding rounding = prog->decimal.rounding;
+    const Decimal zero = {0, scale};
+
+    for (int i = 0; i < prog->length; i++) {
+        const Instruction* ins = &prog->code[i];
+        CalcError err;
+
+        switch (ins->op) {
+            case OP_CONST:
+                top++;
+                stack[top].mantissa = ins->decimal;
+                stack[top].scale = scale;
+                break;
+
+            case OP_VAR:
+                top++;
+                err = rescaleDecimal(vars[ins->slot], scale, rounding, &stack[top]);
+                if (err.code != 0) {
+                    err.position = ins->position;
+                    return err;
+                }
+                break;
+
+            case OP_NEG:
+                stack[top].mantissa = -stack[top].mantissa;
+                break;
+
+            case OP_CALL:
+                return CALC_ERROR_CODE_POS(ERR_INVALID_FUNCTION, "十进制模式不支持函数", ins->position);
+
+            // 逻辑运算的结果由与 0 的比较得到（1 或 0，小数位数与表达式相同）
+            case OP_NOT:
+            case OP_AND:
+            case OP_OR:
+                performDecimalOperation(ins->op == OP_NOT ? OPERATOR_EQ : OPERATOR_NE, stack[top], zero, rounding,
+                                        &stack[top]);
+                break;
+
+            case OP_BRANCH:
+                if (!branchTaken(ins, (double)stack[top].mantissa)) {
+                    top--;
+                    break;
+                }
+                if (ins->func == OP_SELECT) {
+                    top--;
+                } else {
+                    performDecimalOperation(OPERATOR_NE, stack[top], zero, rounding, &stack[top]);
+                }
+                i = ins->slot - 1;
+                break;
+
+            case OP_JUMP:
+                i = ins->slot - 1;
+                break;
+
+            case OP_SELECT:
+                break;
+
+            default:
+                top--;
+                err = performDecimalOperation(opcodeToOperator(ins->op), stack[top], stack[top + 1],
+                                              rounding, &stack[top]);
+                if (err.code != 0) {
+                    err.position = ins->position;
+                    return err;
+                }
+                break;
+        }
+    }
+
+    *result = stack[0];
+    return CALC_SUCCESS;
+}
+
+/**
+ * 以十进制定点模式计算不含变量的表达式
+ *
+ * @param expr    表达式
+ * @param context 小数位数与舍入方式
+ * @param result  输出计算结果
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+CalcError evaluateDecimalExpression(const char* expr, DecimalContext context, Decimal* result) {
+    CompiledExpr prog;
+    CalcError err = compileDecimalExpression(expr, context, &prog);
+    if (err.code != 0) {
+        return err;
+    }
+
+    if (prog.varCount > 0) {
+        // 与 evaluateExpression 一致，未知的标识符按无效字符报告
+        err = CALC_ERROR_POS("无效的字符", -1);
+        for (int i = 0; i < prog.length; i++) {
+            if (prog.code[i].op == OP_VAR) {
+                err.position = prog.code[i].position;
+                break;
+            }
+        }
+    } else {
+        err = evaluateCompiledDecimal(&prog, NULL, result);
+    }
+    freeCompiledExpression(&prog);
+    return err;
+}
@@ -1,4 +1,5 @@
 #include "calculator.h"
+#include "char_scan.h"
 
 // 获取错误描述
 const char* getErrorDescription(int errorCode) {
@@ -25,6 +26,8 @@ const char* getErrorDescription(int errorCode) {
             return "括号不匹配";
         case ERR_EMPTY_EXPRESSION:
             return "表达式不能为空";
+        case ERR_BUDGET_EXCEEDED:
+            return "超出求值预算";
         default:
             return "未知错误";
     }
@@ -41,28 +44,13 @@ CalcError checkStackOverflow(int stackSize, const char* stackName) {
     return CALC_SUCCESS;
 }
 
-// 检查括号匹配
+// 检查括号匹配（在分类位图上累加括号深度）
 CalcError checkBracketMatch(const char* expr) {
-    int leftCount = 0;
-    int rightCount = 0;
-    int position = 0;
-    
-    while (*expr) {
-        if (*expr == '(') {
-            leftCount++;
-        } else if (*expr == ')') {
-            rightCount++;
-            if (rightCount > leftCount) {
-                return CALC_ERROR_POS("括号不匹配：右括号过多", position);
-            }
-        }
-        expr++;
-        position++;
+    CharScan scan;
+    CalcError err = scanCharacters(expr, strlen(expr), &scan);
+    if (err.code == 0) {
+        err = checkBracketDepth(&scan);
     }
-    
-    if (leftCount > rightCount) {
-        return CALC_ERROR_CODE(ERR_MISSING_PARENTHESIS, "括号不匹配：左括号过多");
-    }
-    
-    return CALC_SUCCESS;
+    freeCharScan(&scan);
+    return err;
 } 
\ No newline at end of file
@@ -0,0 +1,203 @@
+#include "calculator.h"
+#include "evaluation_budget.h"
+#ifndef _WIN32
+    #include <time.h>
+#endif
+
+int evaluationBudgetsUsed = 0;
+
+// 超出的限制（记录第一次超出的原因，之后的检查点直接失败）
+typedef enum {
+    BUDGET_WITHIN,
+    BUDGET_STEPS,
+    BUDGET_DEPTH,
+    BUDGET_DEADLINE
+} BudgetLimit;
+
+// 当前线程的预算（线程局部存储，初始为全零：没有预算）
+typedef struct {
+    int active;
+    BudgetLimit exceeded;
+    uint64_t steps;
+    uint64_t maxSteps;
+    int depth;
+    int peakDepth;
+    int maxDepth;
+    uint64_t deadline;
+    int64_t clockCountdown;     // 距下一次读取时钟的步数
+} BudgetState;
+
+static _Thread_local BudgetState budgetState;
+
+uint64_t budgetClockNs(void) {
+#ifdef _WIN32
+    LARGE_INTEGER counter, frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static const char* budgetMessage(BudgetLimit limit) {
+    switch (limit) {
+        case BUDGET_STEPS:    return "超出运算步数上限";
+        case BUDGET_DEPTH:    return "超出嵌套深度上限";
+        case BUDGET_DEADLINE: return "超出求值时限";
+        default:              return getErrorDescription(ERR_BUDGET_EXCEEDED);
+    }
+}
+
+static ErrorCode exceedBudget(BudgetLimit limit) {
+    budgetState.exceeded = limit;
+    return ERR_BUDGET_EXCEEDED;
+}
+
+// ─── 检查点 ─────────────────────────────────────────────────────────────────
+
+/**
+ * 计入 steps 步，按需读取时钟
+ * @return 超出预算（或之前已经超出）时返回 ERR_BUDGET_EXCEEDED
+ */
+ErrorCode chargeBudgetSteps(uint64_t steps) {
+    BudgetState* s = &budgetState;
+    if (!s->active) {
+        return ERR_SUCCESS;
+    }
+    if (s->exceeded != BUDGET_WITHIN) {
+        return ERR_BUDGET_EXCEEDED;
+    }
+
+    s->steps += steps;
+    if (s->maxSteps && s->steps > s->maxSteps) {
+        return exceedBudget(BUDGET_STEPS);
+    }
+    if (s->deadline) {
+        s->clockCountdown -= steps < BUDGET_CLOCK_INTERVAL ? (int64_t)steps : BUDGET_CLOCK_INTERVAL;
+        if (s->clockCountdown <= 0) {
+            s->clockCountdown = BUDGET_CLOCK_INTERVAL;
+            if (budgetClockNs() >= s->deadline) {
+                return exceedBudget(BUDGET_DEADLINE);
+            }
+        }
+    }
+    return ERR_SUCCESS;
+}
+
+// 进入一层括号或子表达式
+ErrorCode enterBudgetLevel(void) {
+    BudgetState* s = &budgetState;
+    if (!s->active) {
+        return ERR_SUCCESS;
+    }
+    if (s->exceeded != BUDGET_WITHIN) {
+        return ERR_BUDGET_EXCEEDED;
+    }
+    if (++s->depth > s->peakDepth) {
+        s->peakDepth = s->depth;
+    }
+    if (s->maxDepth && s->depth > s->maxDepth) {
+        return exceedBudget(BUDGET_DEPTH);
+    }
+    return ERR_SUCCESS;
+}
+
+// 离开一层括号
+void leaveBudgetLevel(void) {
+    if (budgetState.active) {
+        budgetState.depth--;
+    }
+}
+
+// 出错返回时用于恢复进入时的深度
+int currentBudgetDepth(void) {
+    return budgetState.depth;
+}
+
+void restoreBudgetDepth(int depth) {
+    budgetState.depth = depth;
+}
+
+// 当前线程的截止时间（没有预算或不限时为 0），供 sum/prod 的工作线程检查
+uint64_t currentBudgetDeadline(void) {
+    return budgetState.active ? budgetState.deadline : 0;
+}
+
+CalcError budgetExceededError(int position) {
+    return CALC_ERROR_CODE_POS(ERR_BUDGET_EXCEEDED, budgetMessage(budgetState.exceeded), position);
+}
+
+// ─── 入口 ───────────────────────────────────────────────────────────────────
+
+/**
+ * 在预算内计算表达式
+ *
+ * @param expr   表达式
+ * @param mode   角度模式
+ * @param budget 预算（NULL 或各项为 0 表示不限制）
+ * @param result 输出结果
+ * @param usage  可选，输出实际用量（超出预算时为截至出错的用量）
+ * @return 超出预算时返回 ERR_BUDGET_EXCEEDED，消息说明超出的是哪一项
+ */
+CalcError evaluateExpressionBudget(const char* expr, AngleMode mode, const EvaluationBudget* budget,
+                                   double* result, BudgetUsage* usage) {
+    static const EvaluationBudget unlimited = {0, 0, 0};
+    if (budget == NULL) {
+        budget = &unlimited;
+    }
+    evaluationBudgetsUsed = 1;
+
+    BudgetState saved = budgetState;
+    BudgetState* s = &budgetState;
+    memset(s, 0, sizeof(*s));
+    s->active = 1;
+    s->maxSteps = budget->maxSteps;
+    s->maxDepth = budget->maxDepth;
+    s->deadline = budget->deadlineNs;
+    s->clockCountdown = BUDGET_CLOCK_INTERVAL;
+
+    uint64_t start = budgetClockNs();
+    CalcError err;
+    if (s->deadline && start >= s->deadline) {
+        exceedBudget(BUDGET_DEADLINE);
+        err = budgetExceededError(-1);
+    } else {
+        err = evaluateExpression(expr, mode, result);
+    }
+    // 求值器中途捕获并改写的错误也按超出预算报告
+    if (s->exceeded != BUDGET_WITHIN) {
+        err = budgetExceededError(err.code == ERR_BUDGET_EXCEEDED ? err.position : -1);
+    }
+
+    if (usage) {
+        usage->steps = s->steps;
+        usage->depth = s->peakDepth;
+        usage->elapsedNs = budgetClockNs() - start;
+    }
+    budgetState = saved;
+    return err;
+}
+
+/**
+ * 按编译时估计的代价检查求值是否超出预算（不执行求值）
+ *
+ * @param prog   编译结果
+ * @param rows   求值的行数（单行求值为 1）
+ * @param budget 预算
+ * @return 估计步数或嵌套深度超出上限、截止时间已过时返回 ERR_BUDGET_EXCEEDED
+ */
+CalcError checkCompiledBudget(const CompiledExpr* prog, size_t rows, const EvaluationBudget* budget) {
+    if (budget->maxSteps && (uint64_t)prog->cost.steps * rows > budget->maxSteps) {
+        return CALC_ERROR_CODE(ERR_BUDGET_EXCEEDED, budgetMessage(BUDGET_STEPS));
+    }
+    if (budget->maxDepth && prog->cost.depth > (uint32_t)budget->maxDepth) {
+        return CALC_ERROR_CODE(ERR_BUDGET_EXCEEDED, budgetMessage(BUDGET_DEPTH));
+    }
+    if (budget->deadlineNs && budgetClockNs() >= budget->deadlineNs) {
+        return CALC_ERROR_CODE(ERR_BUDGET_EXCEEDED, budgetMessage(BUDGET_DEADLINE));
+    }
+    return CALC_SUCCESS;
+}
@@ -0,0 +1,816 @@
+#include "calculator.h"
+#include "compiled_expression.h"
+#include "char_scan.h"
+#include "polynomial_evaluator.h"
+
+// 编译器状态
+typedef struct {
+    const char* expr;       // 表达式起始位置
+    const char* pos;        // 当前解析位置
+    const char* end;        // 表达式结束位置（不要求以 '\0' 结尾）
+    CompiledExpr* prog;     // 输出
+    Instruction* code;      // 指令缓冲区
+    int capacity;           // 缓冲区容量
+    int depth;              // 当前栈深度
+    int nesting;            // 括号嵌套层数
+    int maxNesting;         // 达到的最大括号嵌套层数
+    const DecimalContext* decimal;  // 十进制模式参数（NULL 表示普通模式）
+    const CharScan* scan;   // 字符分类位图
+    int vectors;            // 是否允许向量字面量与聚合函数
+} Compiler;
+
+#define COMPILER_POS(c) ((int)((c)->pos - (c)->expr))
+#define COMPILER_OFFSET(c, p) ((size_t)((p) - (c)->expr))
+#define MAX_NUMBER_TOKEN 64
+#define SHORT_TOKEN 8         // 逐字节查表的长度上限
+
+static CalcError parseExpression(Compiler* c);
+
+// 跳过 p 开始的 cls 类字符：短记号直接查表，超过 SHORT_TOKEN 个字节后按位图跳到记号结尾
+static inline const char* skipClass(Compiler* c, const char* p, CharClass cls) {
+    const char* limit = c->end - p > SHORT_TOKEN ? p + SHORT_TOKEN : c->end;
+    while (p < limit && charHasClass(*p, cls)) p++;
+    if (p < limit || p == c->end) {
+        return p;
+    }
+    return c->expr + skipCharClass(c->scan, cls, COMPILER_OFFSET(c, p));
+}
+
+static void skipSpaces(Compiler* c) {
+    if (c->pos < c->end && *c->pos == ' ') {
+        c->pos = skipClass(c, c->pos + 1, CHAR_SPACE);
+    }
+}
+
+static int peekChar(Compiler* c) {
+    skipSpaces(c);
+    return c->pos < c->end ? (unsigned char)*c->pos : '\0';
+}
+
+/**
+ * 匹配 c->pos 处的关键字（大小写不敏感，其后不能紧跟字母、数字或下划线）
+ * @return 匹配时返回关键字长度，否则返回 0
+ */
+static size_t matchKeyword(Compiler* c, const char* word) {
+    size_t n = 0;
+    for (; word[n]; n++) {
+        if (c->pos + n >= c->end || tolower((unsigned char)c->pos[n]) != word[n]) {
+            return 0;
+        }
+    }
+    return (c->pos + n < c->end && charHasClass(c->pos[n], CHAR_WORD)) ? 0 : n;
+}
+
+static int isOperatorKeyword(Compiler* c) {
+    return matchKeyword(c, "and") || matchKeyword(c, "or") || matchKeyword(c, "not");
+}
+
+/**
+ * 追加一条指令，并维护栈深度
+ */
+static CalcError emit(Compiler* c, OpCode op, int func, int slot, int position, double value) {
+    if (op == OP_CONST || op == OP_VAR) {
+        CalcError err = checkStackOverflow(c->depth, "数字栈");
+        if (err.code != 0) return err;
+        c->depth++;
+        if (c->depth > c->prog->maxStack) {
+            c->prog->maxStack = c->depth;
+        }
+    } else if (op == OP_PACK || op == OP_REDUCE) {
+        c->depth -= slot - 1;  // 弹出 slot 个值，压入一个结果
+    } else if (op == OP_SELECT) {
+        c->depth -= 2;  // 批量求值时条件与两个分支都在栈上
+    } else if (op != OP_NEG && op != OP_CALL && op != OP_NOT && op != OP_BRANCH && op != OP_JUMP) {
+        c->depth--;
+    }
+
+    if (c->prog->length >= c->capacity) {
+        int newCapacity = c->capacity ? c->capacity * 2 : 16;
+        Instruction* grown = (Instruction*)realloc(c->code, newCapacity * sizeof(Instruction));
+        if (grown == NULL) {
+            return CALC_ERROR_POS("内存分配失败", position);
+        }
+        c->code = grown;
+        c->capacity = newCapacity;
+    }
+
+    Instruction* ins = &c->code[c->prog->length++];
+    ins->op = (unsigned char)op;
+    ins->func = (unsigned char)func;
+    ins->slot = (unsigned short)slot;
+    ins->position = position;
+    ins->value = value;
+    return CALC_SUCCESS;
+}
+
+/**
+ * 把 index 处跳转指令的目标设为下一条指令
+ */
+static CalcError patchJump(Compiler* c, int index) {
+    if (c->prog->length > 0xFFFF) {
+        return CALC_ERROR_POS("表达式过长", c->code[index].position);
+    }
+    c->code[index].slot = (unsigned short)c->prog->length;
+    return CALC_SUCCESS;
+}
+
+// if(c, a, b) 的参数：不能为空
+static CalcError parseCallArgument(Compiler* c) {
+    int ch = peekChar(c);
+    if (ch == ',' || ch == ')') {
+        return CALC_ERROR_CODE_POS(ERR_SYNTAX, "缺少参数", COMPILER_POS(c));
+    }
+    return parseExpression(c);
+}
+
+/**
+ * 条件已编译，编译两个分支：[c] BRANCH [a] JUMP [b] SELECT
+ *
+ * @param separator 两个分支之间的分隔符（c ? a : b 为 ':'，if(c, a, b) 为 ','）
+ * @param position  ? 或参数列表的位置（用于错误报告）
+ */
+static CalcError parseBranches(Compiler* c, char separator, int position) {
+    int branch = c->prog->length;
+    CalcError err = emit(c, OP_BRANCH, OP_SELECT, 0, position, 0);
+    if (err.code != 0) return err;
+    err = (separator == ',') ? parseCallArgument(c) : parseExpression(c);
+    if (err.code != 0) return err;
+
+    if (peekChar(c) != separator) {
+        return separator == ':' ? CALC_ERROR_POS("条件运算缺少冒号", position)
+                                : CALC_ERROR_CODE_POS(ERR_SYNTAX, "参数个数不正确", position);
+    }
+    c->pos++;
+    int jump = c->prog->length;
+    err = emit(c, OP_JUMP, FUNC_NONE, 0, position, 0);
+    if (err.code != 0) return err;
+    err = patchJump(c, branch);
+    if (err.code != 0) return err;
+
+    err = (separator == ',') ? parseCallArgument(c) : parseExpression(c);
+    if (err.code != 0) return err;
+    err = emit(c, OP_SELECT, FUNC_NONE, 0, position, 0);
+    if (err.code != 0) return err;
+    return patchJump(c, jump);
+}
+
+/**
+ * 解析数字字面量
+ * 数字记号先复制到本地缓冲区，使 getNumberWithError 不会越过表达式结尾；
+ * 十进制模式下用 getDecimalWithError 直接得到定点尾数
+ */
+static CalcError parseNumber(Compiler* c) {
+    const char* tokenStart = c->pos;
+    const char* p = c->pos;
+    char buffer[MAX_NUMBER_TOKEN + 1];
+
+    // 数字与小数点成段跳过，遇到指数符号 e 时连同其后的正负号一起跳过
+    while (1) {
+        p = skipClass(c, p, CHAR_NUMBER);
+        if (p >= c->end || tolower(*p) != 'e') break;
+        p++;
+        if (p < c->end && (*p == '+' || *p == '-')) p++;
+    }
+    size_t len = (size_t)(p - tokenStart);
+    if (len > MAX_NUMBER_TOKEN) {
+        return CALC_ERROR_POS("数字太大", COMPILER_POS(c));
+    }
+    memcpy(buffer, tokenStart, len);
+    buffer[len] = '\0';
+
+    const char* cursor = buffer;
+    double value = 0;
+    Decimal decimal = {0, 0};
+    CalcError numErr = c->decimal ? getDecimalWithError(&cursor, c->decimal->scale, c->decimal->rounding, &decimal)
+                                  : getNumberWithError(&cursor, &value);
+    if (numErr.code != 0) {
+        if (numErr.position >= 0) {
+            numErr.position += COMPILER_POS(c);
+        }
+        return numErr;
+    }
+
+    int position = COMPILER_POS(c);
+    c->pos = tokenStart + (cursor - buffer);
+    CalcError err = emit(c, OP_CONST, FUNC_NONE, 0, position, value);
+    if (err.code == 0 && c->decimal) {
+        c->code[c->prog->length - 1].decimal = decimal.mantissa;
+    }
+    return err;
+}
+
+/**
+ * 查找或分配变量槽位
+ */
+static CalcError resolveVariable(Compiler* c, const char* name, size_t len, int* slot) {
+    if (len >= MAX_VARIABLE_NAME) {
+        return CALC_ERROR_CODE_POS(ERR_INVALID_ARGUMENT, "变量名过长", COMPILER_POS(c));
+    }
+    for (int i = 0; i < c->prog->varCount; i++) {
+        if (strncmp(c->prog->varNames[i], name, len) == 0 && c->prog->varNames[i][len] == '\0') {
+            *slot = i;
+            return CALC_SUCCESS;
+        }
+    }
+    if (c->prog->varCount >= MAX_COMPILED_VARIABLES) {
+        return CALC_ERROR_CODE_POS(ERR_STACK_OVERFLOW, "变量过多", COMPILER_POS(c));
+    }
+    memcpy(c->prog->varNames[c->prog->varCount], name, len);
+    c->prog->varNames[c->prog->varCount][len] = '\0';
+    *slot = c->prog->varCount++;
+    return CALC_SUCCESS;
+}
+
+/**
+ * 解析括号内的表达式（c->pos 指向左括号）
+ */
+static CalcError parseParenthesized(Compiler* c) {
+    CalcError err = checkStackOverflow(c->nesting, "运算符栈");
+    if (err.code != 0) return err;
+
+    c->pos++;  // 跳过左括号
+    if (peekChar(c) == ')') {
+        return CALC_ERROR_POS("括号内必须有表达式", COMPILER_POS(c));
+    }
+
+    if (++c->nesting > c->maxNesting) c->maxNesting = c->nesting;
+    err = parseExpression(c);
+    c->nesting--;
+    if (err.code != 0) return err;
+
+    if (peekChar(c) != ')') {
+        return CALC_ERROR_CODE_POS(ERR_MISSING_PARENTHESIS, "括号不匹配：左括号过多", COMPILER_POS(c));
+    }
+    c->pos++;
+    return CALC_SUCCESS;
+}
+
+/**
+ * 解析以逗号分隔的参数，直到 close 为止（c->pos 指向开始的括号）
+ * @param count 输出参数个数
+ */
+static CalcError parseArguments(Compiler* c, char close, int* count) {
+    CalcError err = checkStackOverflow(c->nesting, "运算符栈");
+    if (err.code != 0) return err;
+
+    c->pos++;  // 跳过开始的括号
+    *count = 0;
+    if (++c->nesting > c->maxNesting) c->maxNesting = c->nesting;
+    while (1) {
+        if (peekChar(c) == close || peekChar(c) == ',') {
+            c->nesting--;
+            return CALC_ERROR_POS(close == ']' ? "方括号内缺少元素" : "缺少参数", COMPILER_POS(c));
+        }
+        err = parseExpression(c);
+        if (err.code != 0) {
+            c->nesting--;
+            return err;
+        }
+        (*count)++;
+        if (peekChar(c) != ',') break;
+        c->pos++;
+    }
+    c->nesting--;
+
+    if (peekChar(c) != close) {
+        return close == ']' ? CALC_ERROR_CODE_POS(ERR_MISSING_PARENTHESIS, "方括号不匹配", COMPILER_POS(c))
+                            : CALC_ERROR_CODE_POS(ERR_MISSING_PARENTHESIS, "括号不匹配：左括号过多", COMPILER_POS(c));
+    }
+    c->pos++;
+    return CALC_SUCCESS;
+}
+
+/**
+ * 向量字面量 [e1, e2, ...]：依次压入各元素，再用 OP_PACK 拼接
+ * （元素本身是向量时按顺序展开）
+ */
+static CalcError parseVectorLiteral(Compiler* c) {
+    int position = COMPILER_POS(c);
+    int count;
+    CalcError err = parseArguments(c, ']', &count);
+    if (err.code != 0) return err;
+    return emit(c, OP_PACK, FUNC_NONE, count, position, 0);
+}
+
+/**
+ * 条件函数 if(c, a, b)（c->pos 指向 if 之后），与 c ? a : b 编译结果相同
+ */
+static CalcError parseConditionalCall(Compiler* c) {
+    if (peekChar(c) != '(') {
+        return CALC_ERROR_POS("函数后必须跟着括号", COMPILER_POS(c));
+    }
+    CalcError err = checkStackOverflow(c->nesting, "运算符栈");
+    if (err.code != 0) return err;
+
+    int argStartPos = COMPILER_POS(c) + 1;
+    c->pos++;
+    if (++c->nesting > c->maxNesting) c->maxNesting = c->nesting;
+    err = parseCallArgument(c);
+    if (err.code == 0 && peekChar(c) != ',') {
+        err = CALC_ERROR_CODE_POS(ERR_SYNTAX, "参数个数不正确", argStartPos);
+    }
+    if (err.code == 0) {
+        c->pos++;
+        err = parseBranches(c, ',', argStartPos);
+    }
+    c->nesting--;
+    if (err.code != 0) return err;
+
+    if (peekChar(c) == ',') {
+        return CALC_ERROR_CODE_POS(ERR_SYNTAX, "参数个数不正确", argStartPos);
+    }
+    if (peekChar(c) != ')') {
+        return CALC_ERROR_CODE_POS(ERR_MISSING_PARENTHESIS, "括号不匹配：左括号过多", COMPILER_POS(c));
+    }
+    c->pos++;
+    return CALC_SUCCESS;
+}
+
+/**
+ * 聚合函数调用（仅向量模式），参数是任意向量表达式
+ */
+static CalcError parseAggregateCall(Compiler* c, AggregateType type, int position) {
+    if (peekChar(c) != '(') {
+        return CALC_ERROR_POS("函数后必须跟着括号", COMPILER_POS(c));
+    }
+    int argStartPos = COMPILER_POS(c) + 1;
+    int count;
+    CalcError err = parseArguments(c, ')', &count);
+    if (err.code != 0) return err;
+    if (count != getAggregateArity(type)) {
+        return CALC_ERROR_CODE_POS(ERR_SYNTAX, "聚合函数参数个数不正确", position);
+    }
+    return emit(c, OP_REDUCE, type, count, argStartPos, 0);
+}
+
+/**
+ * 解析标识符：常量 pi/e、函数调用或变量
+ * 字母部分恰好是常量或函数名时按常量/函数处理（与 evaluateExpression 一致，
+ * 如 e2 = e*2），否则整个字母数字串作为变量名
+ */
+static CalcError parseIdentifier(Compiler* c) {
+    const char* start = c->pos;
+    const char* p = start;
+    int position = COMPILER_POS(c);
+
+    size_t ifLength = matchKeyword(c, "if");
+    if (ifLength != 0) {
+        c->pos += ifLength;
+        return parseConditionalCall(c);
+    }
+
+    p = skipClass(c, p, CHAR_ALPHA);
+    size_t alphaLen = (size_t)(p - start);
+
+    if (c->decimal && ((alphaLen == 2 && tolower(start[0]) == 'p' && tolower(start[1]) == 'i') ||
+                       (alphaLen == 1 && tolower(start[0]) == 'e'))) {
+        return CALC_ERROR_CODE_POS(ERR_INVALID_ARGUMENT, "十进制模式不支持常量pi和e", position);
+    }
+    if (alphaLen == 2 && tolower(start[0]) == 'p' && tolower(start[1]) == 'i') {
+        c->pos = p;
+        return emit(c, OP_CONST, FUNC_NONE, 0, position, PI);
+    }
+    if (alphaLen == 1 && tolower(start[0]) == 'e') {
+        c->pos = p;
+        return emit(c, OP_CONST, FUNC_NONE, 0, position, E);
+    }
+
+    if (alphaLen < 10) {
+        char name[10];
+        memcpy(name, start, alphaLen);
+        name[alphaLen] = '\0';
+
+        const char* cursor = name;
+        FuncType func = getFunction(&cursor);
+        if (func != FUNC_NONE) {
+            if (c->decimal) {
+                return CALC_ERROR_CODE_POS(ERR_INVALID_FUNCTION, "十进制模式不支持函数", position);
+            }
+            c->pos = p;
+            if (peekChar(c) != '(') {
+                return CALC_ERROR_POS("函数后必须跟着括号", COMPILER_POS(c));
+            }
+            int argStartPos = COMPILER_POS(c) + 1;
+            CalcError err = parseParenthesized(c);
+            if (err.code != 0) return err;
+            return emit(c, OP_CALL, func, 0, argStartPos, 0);
+        }
+
+        cursor = name;
+        AggregateType agg = getAggregateFunction(&cursor);
+        if (agg != AGG_NONE) {
+            c->pos = p;
+            if (peekChar(c) == '(') {
+                if (c->vectors) {
+                    return parseAggregateCall(c, agg, position);
+                }
+                return CALC_ERROR_CODE_POS(ERR_INVALID_FUNCTION, "编译表达式不支持聚合函数", position);
+            }
+            c->pos = start;
+        }
+    }
+
+    // 变量：字母开头的字母、数字、下划线串
+    p = skipClass(c, p, CHAR_WORD);
+    int slot;
+    CalcError err = resolveVariable(c, start, (size_t)(p - start), &slot);
+    if (err.code != 0) return err;
+    c->pos = p;
+    return emit(c, OP_VAR, FUNC_NONE, slot, position, 0);
+}
+
+// 原子：数字、常量、变量、函数调用、括号表达式、向量字面量
+static CalcError parseAtom(Compiler* c) {
+    int ch = peekChar(c);
+
+    if (charHasClass(ch, CHAR_NUMBER)) {
+        return parseNumber(c);
+    }
+    if (charHasClass(ch, CHAR_ALPHA)) {
+        if (isOperatorKeyword(c)) {
+            return CALC_ERROR_POS("运算符使用不正确", COMPILER_POS(c));
+        }
+        return parseIdentifier(c);
+    }
+    if (ch == '(') {
+        return parseParenthesized(c);
+    }
+    if (ch == '[' && c->vectors) {
+        return parseVectorLiteral(c);
+    }
+    if (ch == ')') {
+        return CALC_ERROR_POS("括号内必须有表达式", COMPILER_POS(c));
+    }
+    if (ch == '\0') {
+        return CALC_ERROR_CODE(ERR_SYNTAX, "表达式不完整");
+    }
+    if (charHasClass(ch, CHAR_OPERATOR) || memchr("<>=!?:", ch, 6)) {
+        return CALC_ERROR_POS("运算符使用不正确", COMPILER_POS(c));
+    }
+    return CALC_ERROR_POS("无效的字符", COMPILER_POS(c));
+}
+
+// 一元负号：只作用于紧随其后的原子（-2^2 = 4，与 evaluateExpression 一致）
+static CalcError parseUnary(Compiler* c) {
+    if (peekChar(c) != '-') {
+        return parseAtom(c);
+    }
+
+    int position = COMPILER_POS(c);
+    c->pos++;
+    int next = peekChar(c);
+    if (!(charHasClass(next, CHAR_NUMBER) || charHasClass(next, CHAR_ALPHA) || next == '(' ||
+          (next == '[' && c->vectors))) {
+        return CALC_ERROR_POS("运算符使用不正确", position);
+    }
+
+    CalcError err = parseAtom(c);
+    if (err.code != 0) return err;
+
+    // 数字字面量直接取负
+    Instruction* last = &c->code[c->prog->length - 1];
+    if (last->op == OP_CONST) {
+        if (c->decimal) {
+            last->decimal = -last->decimal;
+        } else {
+            last->value = -last->value;
+        }
+        return CALC_SUCCESS;
+    }
+    return emit(c, OP_NEG, FUNC_NONE, 0, position, 0);
+}
+
+// 幂运算：右结合
+static CalcError parsePower(Compiler* c) {
+    CalcError err = parseUnary(c);
+    if (err.code != 0) return err;
+
+    if (peekChar(c) == '^') {
+        int position = COMPILER_POS(c);
+        c->pos++;
+        err = parsePower(c);
+        if (err.code != 0) return err;
+        return emit(c, OP_POW, FUNC_NONE, 0, position, 0);
+    }
+    return CALC_SUCCESS;
+}
+
+// 乘除与隐式乘法：左结合
+static CalcError parseTerm(Compiler* c) {
+    CalcError err = parsePower(c);
+    if (err.code != 0) return err;
+
+    while (1) {
+        int ch = peekChar(c);
+        int position = COMPILER_POS(c);
+        OpCode op;
+
+        if (ch == '*' || ch == '/') {
+            op = (ch == '*') ? OP_MUL : OP_DIV;
+            c->pos++;
+        } else if (charHasClass(ch, CHAR_NUMBER) || (charHasClass(ch, CHAR_ALPHA) && !isOperatorKeyword(c)) ||
+                   ch == '(') {
+            op = OP_MUL;  // 隐式乘法，如 2pi, 2(3+4), (2)(3)
+        } else {
+            break;
+        }
+
+        err = parsePower(c);
+        if (err.code != 0) return err;
+        err = emit(c, op, FUNC_NONE, 0, position, 0);
+        if (err.code != 0) return err;
+    }
+    return CALC_SUCCESS;
+}
+
+// 加减：左结合
+static CalcError parseSum(Compiler* c) {
+    CalcError err = parseTerm(c);
+    if (err.code != 0) return err;
+
+    while (1) {
+        int ch = peekChar(c);
+        if (ch != '+' && ch != '-') break;
+
+        int position = COMPILER_POS(c);
+        c->pos++;
+        err = parseTerm(c);
+        if (err.code != 0) return err;
+        err = emit(c, ch == '+' ? OP_ADD : OP_SUB, FUNC_NONE, 0, position, 0);
+        if (err.code != 0) return err;
+    }
+    return CALC_SUCCESS;
+}
+
+// 比较：左结合，== 与 != 必须是两个字符
+static CalcError parseComparison(Compiler* c) {
+    CalcError err = parseSum(c);
+    if (err.code != 0) return err;
+
+    while (1) {
+        int ch = peekChar(c);
+        int twoChars = c->pos + 1 < c->end && c->pos[1] == '=';
+        OpCode op;
+        switch (ch) {
+            case '<': op = twoChars ? OP_LE : OP_LT; break;
+            case '>': op = twoChars ? OP_GE : OP_GT; break;
+            case '=': op = OP_EQ; break;
+            case '!': op = OP_NE; break;
+            default:  return CALC_SUCCESS;
+        }
+
+        int position = COMPILER_POS(c);
+        if ((ch == '=' || ch == '!') && !twoChars) {
+            return CALC_ERROR_POS("运算符使用不正确", position);
+        }
+        c->pos += twoChars ? 2 : 1;
+        err = parseSum(c);
+        if (err.code != 0) return err;
+        err = emit(c, op, FUNC_NONE, 0, position, 0);
+        if (err.code != 0) return err;
+    }
+}
+
+// 逻辑非：前缀关键字 not，优先级低于比较
+static CalcError parseNot(Compiler* c) {
+    peekChar(c);
+    size_t length = matchKeyword(c, "not");
+    if (length == 0) {
+        return parseComparison(c);
+    }
+
+    int position = COMPILER_POS(c);
+    c->pos += length;
+    CalcError err = parseNot(c);
+    if (err.code != 0) return err;
+    return emit(c, OP_NOT, FUNC_NONE, 0, position, 0);
+}
+
+/**
+ * 逻辑与 / 或：左结合，and 优先于 or
+ * 右操作数之前的 OP_BRANCH 在左操作数已经决定结果时跳过右操作数
+ */
+static CalcError parseLogical(Compiler* c, OpCode op) {
+    const char* word = (op == OP_OR) ? "or" : "and";
+    CalcError err = (op == OP_OR) ? parseLogical(c, OP_AND) : parseNot(c);
+    if (err.code != 0) return err;
+
+    while (1) {
+        peekChar(c);
+        size_t length = matchKeyword(c, word);
+        if (length == 0) break;
+
+        int position = COMPILER_POS(c);
+        c->pos += length;
+        int branch = c->prog->length;
+        err = emit(c, OP_BRANCH, op, 0, position, 0);
+        if (err.code != 0) return err;
+        err = (op == OP_OR) ? parseLogical(c, OP_AND) : parseNot(c);
+        if (err.code != 0) return err;
+        err = emit(c, op, FUNC_NONE, 0, position, 0);
+        if (err.code != 0) return err;
+        err = patchJump(c, branch);
+        if (err.code != 0) return err;
+    }
+    return CALC_SUCCESS;
+}
+
+// 条件运算 c ? a : b：优先级最低，右结合
+static CalcError parseExpression(Compiler* c) {
+    CalcError err = parseLogical(c, OP_OR);
+    if (err.code != 0) return err;
+
+    if (peekChar(c) != '?') {
+        return CALC_SUCCESS;
+    }
+    int position = COMPILER_POS(c);
+    c->pos++;
+    return parseBranches(c, ':', position);
+}
+
+/**
+ * 括号匹配与结尾运算符检查（与 evaluateExpression 的预检查一致）
+ */
+static CalcError precheckExpression(const CharScan* scan, const char* expr) {
+    CalcError err = checkBracketDepth(scan);
+    if (err.code != 0) return err;
+
+    size_t last = trimTrailingSpaces(scan);
+    if (last > 0 && (scanHasClass(scan, CHAR_OPERATOR, last - 1) || memchr("<>=!?:", expr[last - 1], 6))) {
+        return CALC_ERROR_POS("表达式不能以运算符结尾", (int)(last - 1));
+    }
+    return CALC_SUCCESS;
+}
+
+// 函数调用的加权代价（以一次加法为 1）
+static uint32_t functionWeight(FuncType func) {
+    switch (func) {
+        case FUNC_ABS:
+        case FUNC_RAD:
+        case FUNC_DEG:  return 1;
+        case FUNC_SQRT: return 4;
+        default:        return 20;
+    }
+}
+
+/**
+ * 估计求值代价：步数与 evaluateExpression 计入预算的步数一致
+ *
+ * @param prog    编译结果（code、length 已设置）
+ * @param nesting 括号的最大嵌套层数（库文件中保存的值）
+ */
+void estimateCompiledCost(CompiledExpr* prog, int nesting) {
+    ExpressionCost cost = {0, 0, (uint32_t)nesting + 1};
+    for (int i = 0; i < prog->length; i++) {
+        const Instruction* ins = &prog->code[i];
+        switch (ins->op) {
+            case OP_CONST:
+            case OP_VAR:    break;
+            case OP_NEG:    cost.weight += 1; break;
+            case OP_ADD:
+            case OP_SUB:
+            case OP_MUL:    cost.steps++; cost.weight += 1; break;
+            case OP_DIV:    cost.steps++; cost.weight += 4; break;
+            case OP_POW:    cost.steps++; cost.weight += 20; break;
+            case OP_CALL:   cost.steps++; cost.weight += functionWeight((FuncType)ins->func); break;
+            case OP_BRANCH:
+            case OP_JUMP:   break;
+            case OP_LT:
+            case OP_LE:
+            case OP_GT:
+            case OP_GE:
+            case OP_EQ:
+            case OP_NE:
+            case OP_NOT:
+            case OP_AND:
+            case OP_OR:
+            case OP_SELECT: cost.steps++; cost.weight += 1; break;
+            default:        cost.steps++; cost.weight += ins->slot; break;  // OP_PACK / OP_REDUCE
+        }
+    }
+    prog->cost = cost;
+}
+
+/**
+ * 编译（decimal 为 NULL 时为普通模式，vectors 非零时为向量模式）
+ */
+static CalcError compileWithContext(const char* expr, size_t len, const DecimalContext* decimal, int vectors,
+                                    CompiledExpr* prog) {
+    memset(prog, 0, sizeof(*prog));
+
+    if (!expr) {
+        return CALC_ERROR_CODE(ERR_EMPTY_EXPRESSION, "表达式不能为空");
+    }
+    CharScan scan;
+    CalcError err = scanCharacters(expr, len, &scan);
+    if (err.code != 0) return err;
+    if (skipCharClass(&scan, CHAR_SPACE, 0) == len) {
+        freeCharScan(&scan);
+        return CALC_ERROR_CODE(ERR_EMPTY_EXPRESSION, "表达式不能为空");
+    }
+
+    err = precheckExpression(&scan, expr);
+    if (err.code != 0) {
+        freeCharScan(&scan);
+        return err;
+    }
+
+    Compiler c = {expr, expr, expr + len, prog, NULL, 0, 0, 0, 0, decimal, &scan, vectors};
+    err = parseExpression(&c);
+    if (err.code == 0 && peekChar(&c) != '\0') {
+        err = (*c.pos == ')') ? CALC_ERROR_POS("括号不匹配：右括号过多", COMPILER_POS(&c))
+            : (*c.pos == ':') ? CALC_ERROR_POS("运算符使用不正确", COMPILER_POS(&c))
+                              : CALC_ERROR_POS("无效的字符", COMPILER_POS(&c));
+    }
+    freeCharScan(&scan);
+    if (err.code != 0) {
+        free(c.code);
+        memset(prog, 0, sizeof(*prog));
+        return err;
+    }
+
+    prog->storage = c.code;
+    prog->code = c.code;
+    if (decimal) {
+        prog->isDecimal = 1;
+        prog->decimal = *decimal;
+    }
+    prog->isVector = vectors;
+    estimateCompiledCost(prog, c.maxNesting);
+    if (!decimal) {
+        attachPolynomialPlans(prog);
+    }
+    return CALC_SUCCESS;
+}
+
+/**
+ * 编译表达式（表达式长度由 len 给出，不要求以 '\0' 结尾）
+ *
+ * @param expr 表达式
+ * @param len  表达式长度
+ * @param prog 输出的编译结果，使用完后需调用 freeCompiledExpression 释放
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+CalcError compileExpressionN(const char* expr, size_t len, CompiledExpr* prog) {
+    return compileWithContext(expr, len, NULL, 0, prog);
+}
+
+/**
+ * 以十进制定点模式编译表达式
+ * 数字字面量按 context 的小数位数和舍入方式直接转换为定点尾数
+ *
+ * @param expr    以 '\0' 结尾的表达式
+ * @param context 小数位数与舍入方式
+ * @param prog    输出的编译结果，使用完后需调用 freeCompiledExpression 释放
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+CalcError compileDecimalExpression(const char* expr, DecimalContext context, CompiledExpr* prog) {
+    if (context.scale < 0 || context.scale > MAX_DECIMAL_SCALE) {
+        memset(prog, 0, sizeof(*prog));
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "小数位数超出范围");
+    }
+    return compileWithContext(expr, expr ? strlen(expr) : 0, &context, 0, prog);
+}
+
+/**
+ * 以向量模式编译表达式
+ * 额外支持向量字面量 [e1, e2, ...] 与聚合函数 sum/mean/min/max/norm/dot，
+ * 结果只能用 evaluateCompiledVector 求值
+ *
+ * @param expr 以 '\0' 结尾的表达式
+ * @param prog 输出的编译结果，使用完后需调用 freeCompiledExpression 释放
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+CalcError compileVectorExpression(const char* expr, CompiledExpr* prog) {
+    return compileVectorExpressionN(expr, expr ? strlen(expr) : 0, prog);
+}
+
+// 以向量模式编译长度为 len 的表达式（不要求以 '\0' 结尾）
+CalcError compileVectorExpressionN(const char* expr, size_t len, CompiledExpr* prog) {
+    return compileWithContext(expr, len, NULL, 1, prog);
+}
+
+// 编译以 '\0' 结尾的表达式
+CalcError compileExpression(const char* expr, CompiledExpr* prog) {
+    return compileExpressionN(expr, expr ? strlen(expr) : 0, prog);
+}
+
+// 释放编译结果
+void freeCompiledExpression(CompiledExpr* prog) {
+    free(prog->storage);
+    free(prog->polynomials);
+    memset(prog, 0, sizeof(*prog));
+}
+
+/**
+ * 查找变量槽位
+ * @return 槽位下标，未找到返回 -1
+ */
+int findCompiledVariable(const CompiledExpr* prog, const char* name) {
+    for (int i = 0; i < prog->varCount; i++) {
+        if (strcmp(prog->varNames[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
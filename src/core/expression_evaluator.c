@@ -1,4 +1,8 @@
 #include "calculator.h"
+#include "char_scan.h"
+#include "series_evaluator.h"
+#include "numeric_solver.h"
+#include "evaluation_budget.h"
 
 /**
  * 查找匹配的右括号
@@ -38,15 +42,7 @@ static CalcError evaluateSubExpression(const char** current_pos, AngleMode mode,
     
     // 提取并计算括号内的表达式
     size_t len = endExpr - *current_pos - 1;  // 减1是为了不包含右括号
-    char* subExpr = (char*)malloc(len + 1);
-    if (subExpr == NULL) {
-        return CALC_ERROR_POS("内存分配失败", (int)(*current_pos - expr));
-    }
-    strncpy(subExpr, *current_pos, len);
-    subExpr[len] = '\0';
-    
-    CalcError subExprErr = evaluateExpression(subExpr, mode, value);
-    free(subExpr);
+    CalcError subExprErr = evaluateExpressionN(*current_pos, len, mode, value);
     
     if (subExprErr.code != 0) {
         if (subExprErr.position >= 0) {
@@ -93,6 +89,10 @@ static CalcError evaluateFunctionCall(FuncType func, const char** current_pos,
         return subExprErr;
     }
     
+    if (chargeEvaluationBudget(1) != ERR_SUCCESS) {
+        return budgetExceededError(argStartPos);
+    }
+    
     // 计算函数值
     CalcError funcErr = calculateFunctionWithError(func, value, mode, funcResult);
     if (funcErr.code != 0) {
@@ -103,6 +103,201 @@ static CalcError evaluateFunctionCall(FuncType func, const char** current_pos,
     return CALC_SUCCESS;
 }
 
+/**
+ * 计算聚合函数调用的值（如 sum(v), dot(a,b)）
+ * 参数必须是已绑定的数组变量名
+ * 
+ * @param agg         聚合函数类型
+ * @param current_pos 当前解析位置指针（指向函数名之后）
+ * @param aggResult   输出的聚合计算结果
+ * @param expr        原始表达式（用于计算错误位置）
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+static CalcError evaluateAggregateCall(AggregateType agg, const char** current_pos,
+                                        double* aggResult, const char* expr) {
+    const double* arrays[2] = {NULL, NULL};
+    size_t counts[2] = {0, 0};
+    int arity = getAggregateArity(agg);
+    
+    while (**current_pos == ' ') (*current_pos)++;
+    if (**current_pos != '(') {
+        return CALC_ERROR_POS("函数后必须跟着括号", (int)(*current_pos - expr));
+    }
+    (*current_pos)++;
+    int argStartPos = (int)(*current_pos - expr);
+    
+    for (int i = 0; i < arity; i++) {
+        while (**current_pos == ' ') (*current_pos)++;
+        const char* nameStart = *current_pos;
+        while (charHasClass(**current_pos, CHAR_WORD)) (*current_pos)++;
+        size_t nameLen = (size_t)(*current_pos - nameStart);
+        
+        if (nameLen == 0 || !charHasClass(*nameStart, CHAR_ALPHA)) {
+            return CALC_ERROR_CODE_POS(ERR_INVALID_ARGUMENT, "聚合函数的参数必须是数组变量",
+                                       (int)(nameStart - expr));
+        }
+        if (!lookupArrayVariable(nameStart, nameLen, &arrays[i], &counts[i])) {
+            return CALC_ERROR_CODE_POS(ERR_INVALID_ARGUMENT, "未绑定的数组变量", (int)(nameStart - expr));
+        }
+        
+        while (**current_pos == ' ') (*current_pos)++;
+        char expected = (i == arity - 1) ? ')' : ',';
+        if (**current_pos != expected) {
+            return CALC_ERROR_CODE_POS(ERR_SYNTAX, expected == ')' ? "聚合函数参数个数不正确" : "缺少参数",
+                                       (int)(*current_pos - expr));
+        }
+        (*current_pos)++;
+    }
+    
+    if (arity == 2 && counts[0] != counts[1]) {
+        return CALC_ERROR_CODE_POS(ERR_INVALID_ARGUMENT, "dot的两个数组长度必须相同", argStartPos);
+    }
+    
+    if (chargeEvaluationBudget(1) != ERR_SUCCESS) {
+        return budgetExceededError(argStartPos);
+    }
+    
+    CalcError aggErr = calculateAggregate(agg, arrays[0], arrays[1], counts[0], aggResult);
+    if (aggErr.code != 0) {
+        aggErr.position = argStartPos;
+        return aggErr;
+    }
+    
+    return CALC_SUCCESS;
+}
+
+/**
+ * 计算 [start, start + len) 内的子表达式（用于逗号分隔的参数）
+ */
+static CalcError evaluateArgument(const char* start, size_t len, AngleMode mode,
+                                  double* value, const char* expr) {
+    CalcError err = evaluateExpressionN(start, len, mode, value);
+    if (err.code != 0 && err.position >= 0) {
+        err.position += (int)(start - expr);
+    }
+    return err;
+}
+
+/**
+ * 拆分多参数调用的参数（如 sum(i, 1, 10, i^2)、if(c, a, b)），去掉两端空格
+ *
+ * @param current_pos 当前解析位置指针（指向函数名之后），返回时指向右括号之后
+ * @param expected    参数个数（不超过 4）
+ * @param args        输出各参数的起始位置
+ * @param lengths     输出各参数的长度
+ * @param argStartPos 输出左括号之后的位置
+ * @param expr        原始表达式（用于计算错误位置）
+ * @return 成功返回 CALC_SUCCESS，参数个数不符或有空参数时返回错误
+ */
+static CalcError splitCallArguments(const char** current_pos, int expected, const char* args[4],
+                                    size_t lengths[4], int* argStartPos, const char* expr) {
+    int depth = 0, count = 0;
+
+    while (**current_pos == ' ') (*current_pos)++;
+    (*current_pos)++;  // 调用方已确认是左括号
+    *argStartPos = (int)(*current_pos - expr);
+
+    // 按顶层逗号拆分
+    args[0] = *current_pos;
+    for (const char* p = *current_pos; ; p++) {
+        if (*p == '(' || *p == '[') {
+            depth++;
+        } else if ((*p == ')' || *p == ']') && depth > 0) {
+            depth--;
+        } else if (depth == 0 && (*p == ',' || *p == ')')) {
+            if (count + 1 > expected || (*p == ')' && count + 1 < expected)) {
+                return CALC_ERROR_CODE_POS(ERR_SYNTAX, "参数个数不正确", *argStartPos);
+            }
+            lengths[count] = (size_t)(p - args[count]);
+            if (*p == ')') {
+                *current_pos = p + 1;
+                break;
+            }
+            args[++count] = p + 1;
+        }
+    }
+    for (int i = 0; i < expected; i++) {
+        while (lengths[i] > 0 && *args[i] == ' ') {
+            args[i]++;
+            lengths[i]--;
+        }
+        while (lengths[i] > 0 && args[i][lengths[i] - 1] == ' ') lengths[i]--;
+        if (lengths[i] == 0) {
+            return CALC_ERROR_CODE_POS(ERR_SYNTAX, "缺少参数", (int)(args[i] - expr));
+        }
+    }
+    return CALC_SUCCESS;
+}
+
+/**
+ * 计算求和/连乘调用的值（如 sum(i, 1, 100, 1/i^2)）
+ * 上下限按普通表达式求值，项表达式交给 evaluateSeries 编译后整块计算
+ *
+ * @param type        SERIES_SUM 或 SERIES_PROD
+ * @param current_pos 当前解析位置指针（指向函数名之后）
+ * @param mode        角度模式
+ * @param seriesResult 输出的计算结果
+ * @param expr        原始表达式（用于计算错误位置）
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+static CalcError evaluateSeriesCall(SeriesType type, const char** current_pos, AngleMode mode,
+                                    double* seriesResult, const char* expr) {
+    const char* args[4];
+    size_t lengths[4];
+    int argStartPos;
+    CalcError err = splitCallArguments(current_pos, 4, args, lengths, &argStartPos, expr);
+    if (err.code != 0) return err;
+
+    double bounds[2];
+    for (int i = 0; i < 2; i++) {
+        err = evaluateArgument(args[i + 1], lengths[i + 1], mode, &bounds[i], expr);
+        if (err.code != 0) return err;
+    }
+
+    err = evaluateSeries(type, args[0], lengths[0], bounds[0], bounds[1], args[3], lengths[3], mode, seriesResult);
+    if (err.code != 0) {
+        err.position = err.position >= 0 ? err.position + (int)(args[3] - expr) : argStartPos;
+        return err;
+    }
+
+    return CALC_SUCCESS;
+}
+
+/**
+ * 计算求根/积分调用的值（如 solve(x^2-2, x, 0, 2)、integrate(x^2, x, 0, 3)）
+ * 区间端点按普通表达式求值，函数表达式交给 evaluateSolver 编译一次
+ *
+ * @param type         SOLVER_SOLVE 或 SOLVER_INTEGRATE
+ * @param current_pos  当前解析位置指针（指向函数名之后）
+ * @param mode         角度模式
+ * @param solverResult 输出的计算结果
+ * @param expr         原始表达式（用于计算错误位置）
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+static CalcError evaluateSolverCall(SolverType type, const char** current_pos, AngleMode mode,
+                                    double* solverResult, const char* expr) {
+    const char* args[4];
+    size_t lengths[4];
+    int argStartPos;
+    CalcError err = splitCallArguments(current_pos, 4, args, lengths, &argStartPos, expr);
+    if (err.code != 0) return err;
+
+    double bounds[2];
+    for (int i = 0; i < 2; i++) {
+        err = evaluateArgument(args[i + 2], lengths[i + 2], mode, &bounds[i], expr);
+        if (err.code != 0) return err;
+    }
+
+    err = evaluateSolver(type, args[0], lengths[0], args[1], lengths[1], bounds[0], bounds[1], mode, NULL,
+                         solverResult);
+    if (err.code != 0) {
+        err.position = err.position >= 0 ? err.position + (int)(args[0] - expr) : argStartPos;
+        return err;
+    }
+
+    return CALC_SUCCESS;
+}
+
 /**
  * 处理隐式乘法（如 2pi, 2(3+4), (2)(3) 等情况）
  * 当上一个 token 是数字或右括号，下一个是数字、常量或左括号时插入乘号
@@ -121,6 +316,9 @@ static CalcError handleImplicitMultiply(double* numbers, int* numTop,
         if (*numTop < 1) {
             return CALC_ERROR_CODE(ERR_SYNTAX, "运算符使用不正确");
         }
+        if (chargeEvaluationBudget(1) != ERR_SUCCESS) {
+            return budgetExceededError(-1);
+        }
         double b = numbers[(*numTop)--];
         double a = numbers[(*numTop)--];
         char op = operators[(*opTop)--];
@@ -140,8 +338,146 @@ static CalcError handleImplicitMultiply(double* numbers, int* numTop,
     return CALC_SUCCESS;
 }
 
-// 主函数修改为返回错误信息
-CalcError evaluateExpression(const char* expr, AngleMode mode, double* result) {
+/**
+ * 匹配关键字（大小写不敏感，其后不能紧跟字母、数字或下划线）
+ * @return 匹配时返回关键字长度，否则返回 0
+ */
+static size_t matchWord(const char* p, const char* word) {
+    size_t n = 0;
+    while (word[n]) {
+        if (tolower((unsigned char)p[n]) != word[n]) {
+            return 0;
+        }
+        n++;
+    }
+    return charHasClass(p[n], CHAR_WORD) ? 0 : n;
+}
+
+/**
+ * 匹配关键字运算符 and / or / not
+ *
+ * @param p      当前位置
+ * @param length 输出关键字长度
+ * @return OPERATOR_AND、OPERATOR_OR 或 OPERATOR_NOT，不是关键字时返回 '\0'
+ */
+static char matchOperatorKeyword(const char* p, size_t* length) {
+    if ((*length = matchWord(p, "and")) != 0) return OPERATOR_AND;
+    if ((*length = matchWord(p, "or")) != 0) return OPERATOR_OR;
+    if ((*length = matchWord(p, "not")) != 0) return OPERATOR_NOT;
+    return '\0';
+}
+
+/**
+ * 跳过不求值的文本（短路的右操作数或未选中的分支），返回其后的分隔符位置
+ * 在括号外遇到右括号、逗号、结尾，或优先级不高于 priority 的 and / or / ? / : 时停止。
+ * priority 为 PRIORITY_COND 时跳过的是整个分支：其中嵌套的 ? : 成对跳过，
+ * 停在第一个不成对的 : 上。跳过的文本不做语法检查
+ */
+static const char* skipOperand(const char* p, int priority) {
+    int depth = 0, nested = 0;
+    while (*p) {
+        if (*p == '(') {
+            depth++;
+        } else if (*p == ')') {
+            if (depth == 0) break;
+            depth--;
+        } else if (depth == 0) {
+            if (*p == ',') break;
+            if (*p == '?') {
+                if (priority != PRIORITY_COND) break;
+                nested++;
+            } else if (*p == ':') {
+                if (nested == 0) break;
+                nested--;
+            } else if (charHasClass(*p, CHAR_ALPHA)) {
+                size_t length;
+                char keyword = matchOperatorKeyword(p, &length);
+                if (keyword != '\0' && keyword != OPERATOR_NOT && getPriority(keyword) <= priority) break;
+                while (charHasClass(*p, CHAR_WORD)) p++;
+                continue;
+            }
+        }
+        p++;
+    }
+    return p;
+}
+
+/**
+ * 比较运算符 < <= > >= == !=
+ *
+ * @param length 输出运算符长度
+ * @return 运算符栈中的字符，单独的 = 或 ! 返回 '\0'
+ */
+static char matchComparison(const char* p, size_t* length) {
+    int twoChars = p[1] == '=';
+    *length = twoChars ? 2 : 1;
+    switch (*p) {
+        case '<': return twoChars ? OPERATOR_LE : '<';
+        case '>': return twoChars ? OPERATOR_GE : '>';
+        case '=': return twoChars ? OPERATOR_EQ : '\0';
+        default:  return twoChars ? OPERATOR_NE : '\0';
+    }
+}
+
+/**
+ * 计算条件函数调用 if(c, a, b)：c 非 0 时只计算 a，否则只计算 b
+ *
+ * @param current_pos 当前解析位置指针（指向 if 之后）
+ * @param mode        角度模式
+ * @param result      输出选中分支的值
+ * @param expr        原始表达式（用于计算错误位置）
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+static CalcError evaluateConditionalCall(const char** current_pos, AngleMode mode, double* result,
+                                         const char* expr) {
+    while (**current_pos == ' ') (*current_pos)++;
+    if (**current_pos != '(') {
+        return CALC_ERROR_POS("函数后必须跟着括号", (int)(*current_pos - expr));
+    }
+
+    const char* args[4];
+    size_t lengths[4];
+    int argStartPos;
+    CalcError err = splitCallArguments(current_pos, 3, args, lengths, &argStartPos, expr);
+    if (err.code != 0) return err;
+
+    double condition;
+    err = evaluateArgument(args[0], lengths[0], mode, &condition, expr);
+    if (err.code != 0) return err;
+    if (chargeEvaluationBudget(1) != ERR_SUCCESS) {
+        return budgetExceededError(argStartPos);
+    }
+    int chosen = (condition != 0) ? 1 : 2;
+    return evaluateArgument(args[chosen], lengths[chosen], mode, result, expr);
+}
+
+/**
+ * 计算长度为 len 的表达式（不要求以 '\0' 结尾）
+ * 较短的表达式复制到栈上的缓冲区，不分配内存
+ *
+ * @return 错误位置相对于 expr
+ */
+CalcError evaluateExpressionN(const char* expr, size_t len, AngleMode mode, double* result) {
+    char buffer[EXPRESSION_BUFFER_SIZE];
+    char* copy = buffer;
+    if (len >= sizeof(buffer)) {
+        copy = (char*)malloc(len + 1);
+        if (copy == NULL) {
+            return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+        }
+    }
+    memcpy(copy, expr, len);
+    copy[len] = '\0';
+
+    CalcError err = evaluateExpression(copy, mode, result);
+    if (copy != buffer) {
+        free(copy);
+    }
+    return err;
+}
+
+// 计算一层表达式（括号内的子表达式与函数参数递归调用 evaluateExpression）
+static CalcError evaluateLevel(const char* expr, AngleMode mode, double* result) {
     if (!expr || !*expr) {
         return CALC_ERROR_CODE(ERR_EMPTY_EXPRESSION, "表达式不能为空");
     }
@@ -159,7 +495,9 @@ CalcError evaluateExpression(const char* expr, AngleMode mode, double* result) {
         lastChar--;
         lastCharPos--;
     }
-    if (*lastChar == '+' || *lastChar == '-' || *lastChar == '*' || *lastChar == '/' || *lastChar == '^') {
+    if (*lastChar == '+' || *lastChar == '-' || *lastChar == '*' || *lastChar == '/' || *lastChar == '^' ||
+        *lastChar == '<' || *lastChar == '>' || *lastChar == '=' || *lastChar == '!' ||
+        *lastChar == '?' || *lastChar == ':') {
         return CALC_ERROR_POS("表达式不能以运算符结尾", lastCharPos);
     }
 
@@ -184,10 +522,63 @@ CalcError evaluateExpression(const char* expr, AngleMode mode, double* result) {
         }
         
         // 检查是否是函数或常量
-        if (isalpha(*current_pos)) {
+        if (charHasClass(*current_pos, CHAR_ALPHA)) {
+            // 关键字运算符：not 是前缀运算符，and / or 在左操作数已经决定结果时跳过右操作数
+            size_t keywordLength;
+            char keyword = matchOperatorKeyword(current_pos, &keywordLength);
+            if (keyword != '\0') {
+                // not 只能出现在比较之前（与编译器的语法一致：1 + not 0 是错误）
+                if (lastWasNumber != (keyword != OPERATOR_NOT) ||
+                    (keyword == OPERATOR_NOT && opTop >= 0 && getPriority(operators[opTop]) > PRIORITY_NOT)) {
+                    return CALC_ERROR_POS("运算符使用不正确", CURRENT_POS);
+                }
+                const char* operand = current_pos + keywordLength;
+                while (*operand == ' ') operand++;
+                if (*operand == '\0') {
+                    return CALC_ERROR_CODE(ERR_SYNTAX, "表达式不完整");
+                }
+                if (keyword != OPERATOR_NOT) {
+                    err = processOperators(numbers, &numTop, operators, &opTop, keyword, 0);
+                    if (err.code != 0) return err;
+                    if ((keyword == OPERATOR_OR) == (numbers[numTop] != 0)) {
+                        if (chargeEvaluationBudget(1) != ERR_SUCCESS) {
+                            return budgetExceededError(CURRENT_POS);
+                        }
+                        numbers[numTop] = (keyword == OPERATOR_OR);
+                        current_pos = skipOperand(operand, getPriority(keyword));
+                        continue;
+                    }
+                }
+                err = checkStackOverflow(opTop + 1, "运算符栈");
+                if (err.code != 0) return err;
+                operators[++opTop] = keyword;
+                current_pos = operand;
+                lastWasNumber = 0;
+                continue;
+            }
+            
+            // 检查是否是条件函数 if(c, a, b)
+            size_t ifLength = matchWord(current_pos, "if");
+            if (ifLength != 0) {
+                if (lastWasNumber) {
+                    err = handleImplicitMultiply(numbers, &numTop, operators, &opTop);
+                    if (err.code != 0) return err;
+                }
+                current_pos += ifLength;
+                double ifResult;
+                err = evaluateConditionalCall(&current_pos, mode, &ifResult, expr);
+                if (err.code != 0) return err;
+                
+                err = checkStackOverflow(numTop + 1, "数字栈");
+                if (err.code != 0) return err;
+                numbers[++numTop] = ifResult;
+                lastWasNumber = 1;
+                continue;
+            }
+            
             // 检查是否是 pi（大小写不敏感）
             if ((tolower(current_pos[0]) == 'p' && tolower(current_pos[1]) == 'i') && 
-                (!current_pos[2] || !isalpha(current_pos[2]))) {
+                (!current_pos[2] || !charHasClass(current_pos[2], CHAR_ALPHA))) {
                 // 如果前一个是数字或右括号，插入乘号
                 if (lastWasNumber) {
                     err = handleImplicitMultiply(numbers, &numTop, operators, &opTop);
@@ -202,7 +593,7 @@ CalcError evaluateExpression(const char* expr, AngleMode mode, double* result) {
             }
             
             // 检查是否是 e（自然对数的底，大小写不敏感）
-            if (tolower(*current_pos) == 'e' && (!current_pos[1] || !isalpha(current_pos[1]))) {
+            if (tolower(*current_pos) == 'e' && (!current_pos[1] || !charHasClass(current_pos[1], CHAR_ALPHA))) {
                 // 如果前一个是数字或右括号，插入乘号
                 if (lastWasNumber) {
                     err = handleImplicitMultiply(numbers, &numTop, operators, &opTop);
@@ -216,6 +607,62 @@ CalcError evaluateExpression(const char* expr, AngleMode mode, double* result) {
                 continue;
             }
             
+            // 检查是否是求和/连乘（如 sum(i, 1, 10, i^2)）
+            SeriesType series = getSeriesFunction(&current_pos);
+            if (series != SERIES_NONE) {
+                if (lastWasNumber) {
+                    err = handleImplicitMultiply(numbers, &numTop, operators, &opTop);
+                    if (err.code != 0) return err;
+                }
+                double seriesResult;
+                CalcError seriesErr = evaluateSeriesCall(series, &current_pos, mode, &seriesResult, expr);
+                if (seriesErr.code != 0) {
+                    return seriesErr;
+                }
+                
+                err = checkStackOverflow(numTop + 1, "数字栈");
+                if (err.code != 0) return err;
+                numbers[++numTop] = seriesResult;
+                lastWasNumber = 1;
+                continue;
+            }
+            
+            // 检查是否是求根/积分（如 solve(x^2-2, x, 0, 2)）
+            SolverType solver = getSolverFunction(&current_pos);
+            if (solver != SOLVER_NONE) {
+                if (lastWasNumber) {
+                    err = handleImplicitMultiply(numbers, &numTop, operators, &opTop);
+                    if (err.code != 0) return err;
+                }
+                double solverResult;
+                CalcError solverErr = evaluateSolverCall(solver, &current_pos, mode, &solverResult, expr);
+                if (solverErr.code != 0) {
+                    return solverErr;
+                }
+                
+                err = checkStackOverflow(numTop + 1, "数字栈");
+                if (err.code != 0) return err;
+                numbers[++numTop] = solverResult;
+                lastWasNumber = 1;
+                continue;
+            }
+            
+            // 检查是否是聚合函数（如 sum(v)）
+            AggregateType agg = getAggregateFunction(&current_pos);
+            if (agg != AGG_NONE) {
+                double aggResult;
+                CalcError aggErr = evaluateAggregateCall(agg, &current_pos, &aggResult, expr);
+                if (aggErr.code != 0) {
+                    return aggErr;
+                }
+                
+                err = checkStackOverflow(numTop + 1, "数字栈");
+                if (err.code != 0) return err;
+                numbers[++numTop] = aggResult;
+                lastWasNumber = 1;
+                continue;
+            }
+            
             // 检查是否是函数
             FuncType func = getFunction(&current_pos);
             if (func != FUNC_NONE) {
@@ -238,7 +685,7 @@ CalcError evaluateExpression(const char* expr, AngleMode mode, double* result) {
         }
         
         // 如果是数字或小数点
-        if (isdigit(*current_pos) || *current_pos == '.') {
+        if (charHasClass(*current_pos, CHAR_NUMBER)) {
             // 如果前一个是数字或右括号，插入乘号
             if (lastWasNumber) {
                 err = handleImplicitMultiply(numbers, &numTop, operators, &opTop);
@@ -274,6 +721,9 @@ CalcError evaluateExpression(const char* expr, AngleMode mode, double* result) {
             
             err = checkStackOverflow(opTop + 1, "运算符栈");
             if (err.code != 0) return err;
+            if (evaluationBudgetsUsed && enterBudgetLevel() != ERR_SUCCESS) {
+                return budgetExceededError(CURRENT_POS);
+            }
             operators[++opTop] = *current_pos;
             current_pos++;
             lastWasNumber = 0;
@@ -295,6 +745,7 @@ CalcError evaluateExpression(const char* expr, AngleMode mode, double* result) {
             // 弹出左括号
             if (opTop >= 0 && operators[opTop] == '(') {
                 opTop--;  // 移除左括号
+                if (evaluationBudgetsUsed) leaveBudgetLevel();
             } else {
                 return CALC_ERROR_POS("括号不匹配", CURRENT_POS);
             }
@@ -312,13 +763,13 @@ CalcError evaluateExpression(const char* expr, AngleMode mode, double* result) {
                 while (*lookahead == ' ') lookahead++;
                 char nextChar = *lookahead;
                 // 检查下一个字符是否可以跟在负号后面
-                if (isdigit(nextChar) || nextChar == '.' || isalpha(nextChar) || nextChar == '(') {
+                if (charHasClass(nextChar, CHAR_NUMBER) || charHasClass(nextChar, CHAR_ALPHA) || nextChar == '(') {
                     // 处理负数或负值表达式
                     current_pos = lookahead;  // 跳过负号和空格
                     
                     // 检查是否是常量 pi（大小写不敏感）
                     if ((tolower(current_pos[0]) == 'p' && tolower(current_pos[1]) == 'i') &&
-                        (!current_pos[2] || !isalpha(current_pos[2]))) {
+                        (!current_pos[2] || !charHasClass(current_pos[2], CHAR_ALPHA))) {
                         err = checkStackOverflow(numTop + 1, "数字栈");
                         if (err.code != 0) return err;
                         numbers[++numTop] = -PI;
@@ -326,7 +777,7 @@ CalcError evaluateExpression(const char* expr, AngleMode mode, double* result) {
                         lastWasNumber = 1;
                     }
                     // 检查是否是常量 e（大小写不敏感）
-                    else if (tolower(current_pos[0]) == 'e' && (!current_pos[1] || !isalpha(current_pos[1]))) {
+                    else if (tolower(current_pos[0]) == 'e' && (!current_pos[1] || !charHasClass(current_pos[1], CHAR_ALPHA))) {
                         err = checkStackOverflow(numTop + 1, "数字栈");
                         if (err.code != 0) return err;
                         numbers[++numTop] = -E;
@@ -347,10 +798,48 @@ CalcError evaluateExpression(const char* expr, AngleMode mode, double* result) {
                         numbers[++numTop] = -subValue;
                         lastWasNumber = 1;
                     }
-                    // 检查是否是函数（如 -sin(30)）
-                    else if (isalpha(current_pos[0])) {
-                        FuncType func = getFunction(&current_pos);
-                        if (func != FUNC_NONE) {
+                    // 检查是否是函数（如 -sin(30)、-sum(v)）
+                    else if (charHasClass(current_pos[0], CHAR_ALPHA)) {
+                        SeriesType series = getSeriesFunction(&current_pos);
+                        SolverType solver = (series == SERIES_NONE) ? getSolverFunction(&current_pos) : SOLVER_NONE;
+                        AggregateType agg = (series == SERIES_NONE && solver == SOLVER_NONE) ?
+                                            getAggregateFunction(&current_pos) : AGG_NONE;
+                        FuncType func = (series == SERIES_NONE && solver == SOLVER_NONE && agg == AGG_NONE) ?
+                                        getFunction(&current_pos) : FUNC_NONE;
+                        if (solver != SOLVER_NONE) {
+                            double solverResult;
+                            CalcError solverErr = evaluateSolverCall(solver, &current_pos, mode, &solverResult, expr);
+                            if (solverErr.code != 0) {
+                                return solverErr;
+                            }
+                            
+                            err = checkStackOverflow(numTop + 1, "数字栈");
+                            if (err.code != 0) return err;
+                            numbers[++numTop] = -solverResult;  // 取负值
+                            lastWasNumber = 1;
+                        } else if (series != SERIES_NONE) {
+                            double seriesResult;
+                            CalcError seriesErr = evaluateSeriesCall(series, &current_pos, mode, &seriesResult, expr);
+                            if (seriesErr.code != 0) {
+                                return seriesErr;
+                            }
+                            
+                            err = checkStackOverflow(numTop + 1, "数字栈");
+                            if (err.code != 0) return err;
+                            numbers[++numTop] = -seriesResult;  // 取负值
+                            lastWasNumber = 1;
+                        } else if (agg != AGG_NONE) {
+                            double aggResult;
+                            CalcError aggErr = evaluateAggregateCall(agg, &current_pos, &aggResult, expr);
+                            if (aggErr.code != 0) {
+                                return aggErr;
+                            }
+                            
+                            err = checkStackOverflow(numTop + 1, "数字栈");
+                            if (err.code != 0) return err;
+                            numbers[++numTop] = -aggResult;  // 取负值
+                            lastWasNumber = 1;
+                        } else if (func != FUNC_NONE) {
                             // 计算函数值
                             double funcResult;
                             CalcError funcErr = evaluateFunctionCall(func, &current_pos, mode, &funcResult, expr);
@@ -406,6 +895,64 @@ CalcError evaluateExpression(const char* expr, AngleMode mode, double* result) {
             continue;
         }
         
+        // 比较运算符
+        if (*current_pos == '<' || *current_pos == '>' || *current_pos == '=' || *current_pos == '!') {
+            size_t length;
+            char op = matchComparison(current_pos, &length);
+            if (op == '\0' || !lastWasNumber) {
+                return CALC_ERROR_POS("运算符使用不正确", CURRENT_POS);
+            }
+            err = processOperators(numbers, &numTop, operators, &opTop, op, 0);
+            if (err.code != 0) return err;
+            err = checkStackOverflow(opTop + 1, "运算符栈");
+            if (err.code != 0) return err;
+            operators[++opTop] = op;
+            current_pos += length;
+            lastWasNumber = 0;
+            continue;
+        }
+        
+        // 条件运算 c ? a : b：条件为真时计算 a 并在遇到 : 时跳过 b，否则直接跳到 b
+        if (*current_pos == '?') {
+            if (!lastWasNumber) {
+                return CALC_ERROR_POS("运算符使用不正确", CURRENT_POS);
+            }
+            err = processOperators(numbers, &numTop, operators, &opTop, OPERATOR_COND, 0);
+            if (err.code != 0) return err;
+            const char* colon = skipOperand(current_pos + 1, PRIORITY_COND);
+            if (*colon != ':') {
+                return CALC_ERROR_POS("条件运算缺少冒号", CURRENT_POS);
+            }
+            if (chargeEvaluationBudget(1) != ERR_SUCCESS) {
+                return budgetExceededError(CURRENT_POS);
+            }
+            if (numbers[numTop--] != 0) {
+                err = checkStackOverflow(opTop + 1, "运算符栈");
+                if (err.code != 0) return err;
+                operators[++opTop] = OPERATOR_COND;
+                current_pos++;
+            } else {
+                current_pos = colon + 1;
+            }
+            lastWasNumber = 0;
+            continue;
+        }
+        
+        if (*current_pos == ':') {
+            if (!lastWasNumber) {
+                return CALC_ERROR_POS("运算符使用不正确", CURRENT_POS);
+            }
+            err = processOperators(numbers, &numTop, operators, &opTop, OPERATOR_COND, 0);
+            if (err.code != 0) return err;
+            if (opTop < 0 || operators[opTop] != OPERATOR_COND) {
+                return CALC_ERROR_POS("运算符使用不正确", CURRENT_POS);
+            }
+            // 选中分支的值留在数字栈顶
+            opTop--;
+            current_pos = skipOperand(current_pos + 1, PRIORITY_COND);
+            continue;
+        }
+        
         // 无效字符
         return CALC_ERROR_POS("无效的字符", CURRENT_POS);
     }
@@ -424,3 +971,17 @@ CalcError evaluateExpression(const char* expr, AngleMode mode, double* result) {
     #undef CURRENT_POS
     return CALC_SUCCESS;
 }
+
+/**
+ * 计算表达式（当前线程有求值预算时，每层子表达式计入一层嵌套深度）
+ */
+CalcError evaluateExpression(const char* expr, AngleMode mode, double* result) {
+    if (!evaluationBudgetsUsed) {
+        return evaluateLevel(expr, mode, result);
+    }
+    int depth = currentBudgetDepth();
+    CalcError err = enterBudgetLevel() != ERR_SUCCESS ? budgetExceededError(-1)
+                                                      : evaluateLevel(expr, mode, result);
+    restoreBudgetDepth(depth);
+    return err;
+}
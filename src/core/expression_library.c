@@ -0,0 +1,315 @@
+#include "calculator.h"
+#include "expression_library.h"
+#include "file_mapping.h"
+
+// 文件头、记录头、变量名与指令的大小都是 8 的倍数，记录无需填充即可对齐
+#define LIBRARY_ALIGNMENT 8
+
+// ─── 写入 ───────────────────────────────────────────────────────────────────
+
+static CalcError writeBytes(LibraryWriter* writer, const void* data, size_t size) {
+    if (size > 0 && fwrite(data, 1, size, writer->file) != size) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "写入库文件失败");
+    }
+    writer->position += size;
+    return CALC_SUCCESS;
+}
+
+static CalcError writeHeader(LibraryWriter* writer, uint64_t indexOffset, uint64_t fileSize) {
+    LibraryFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC));
+    header.version = LIBRARY_VERSION;
+    header.endianTag = LIBRARY_ENDIAN_TAG;
+    header.instructionSize = sizeof(Instruction);
+    header.count = writer->count;
+    header.indexOffset = indexOffset;
+    header.fileSize = fileSize;
+    return writeBytes(writer, &header, sizeof(header));
+}
+
+/**
+ * 创建表达式库文件
+ *
+ * @param path   输出文件路径
+ * @param writer 写入器，之后用 appendLibraryExpression 追加表达式，closeLibraryWriter 完成写入
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+CalcError openLibraryWriter(const char* path, LibraryWriter* writer) {
+    memset(writer, 0, sizeof(*writer));
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法创建库文件");
+    }
+    // 先写入占位的文件头，完成时再回填
+    return writeHeader(writer, 0, 0);
+}
+
+/**
+ * 追加一条编译后的表达式
+ */
+CalcError appendLibraryExpression(LibraryWriter* writer, const CompiledExpr* prog, AngleMode mode) {
+    if (writer->count == UINT32_MAX) {
+        return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "库中表达式过多");
+    }
+    if (prog->isVector) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "库文件不支持向量表达式");
+    }
+    if (writer->count >= writer->capacity) {
+        uint32_t newCapacity = writer->capacity ? writer->capacity * 2 : 1024;
+        uint64_t* grown = (uint64_t*)realloc(writer->offsets, newCapacity * sizeof(uint64_t));
+        if (grown == NULL) {
+            return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+        }
+        writer->offsets = grown;
+        writer->capacity = newCapacity;
+    }
+
+    LibraryRecordHeader record;
+    memset(&record, 0, sizeof(record));
+    record.length = prog->length;
+    record.maxStack = prog->maxStack;
+    record.varCount = prog->varCount;
+    record.angleMode = (uint8_t)mode;
+    record.isDecimal = (uint8_t)prog->isDecimal;
+    record.decimalScale = (uint8_t)prog->decimal.scale;
+    record.decimalRounding = (uint8_t)prog->decimal.rounding;
+    record.nesting = prog->cost.depth > 0 ? prog->cost.depth - 1 : 0;
+
+    writer->offsets[writer->count] = writer->position;
+    CalcError err = writeBytes(writer, &record, sizeof(record));
+    if (err.code == 0) {
+        err = writeBytes(writer, prog->varNames, (size_t)prog->varCount * MAX_VARIABLE_NAME);
+    }
+    if (err.code == 0) {
+        err = writeBytes(writer, prog->code, (size_t)prog->length * sizeof(Instruction));
+    }
+    if (err.code != 0) return err;
+    writer->count++;
+    return CALC_SUCCESS;
+}
+
+/**
+ * 写入索引并回填文件头，关闭文件
+ */
+CalcError closeLibraryWriter(LibraryWriter* writer) {
+    CalcError err = CALC_SUCCESS;
+
+    if (writer->file == NULL) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "库文件未打开");
+    }
+
+    uint64_t indexOffset = writer->position;
+    err = writeBytes(writer, writer->offsets, (size_t)writer->count * sizeof(uint64_t));
+    if (err.code == 0) {
+        uint64_t fileSize = writer->position;
+        if (fseek(writer->file, 0, SEEK_SET) != 0) {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "写入库文件失败");
+        } else {
+            err = writeHeader(writer, indexOffset, fileSize);
+        }
+    }
+    if (fclose(writer->file) != 0 && err.code == 0) {
+        err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "写入库文件失败");
+    }
+
+    free(writer->offsets);
+    memset(writer, 0, sizeof(*writer));
+    return err;
+}
+
+// ─── 加载 ───────────────────────────────────────────────────────────────────
+
+/**
+ * 映射表达式库文件（只检查文件头与索引，不解析任何表达式）
+ *
+ * @param path 库文件路径
+ * @param lib  输出，使用完后需调用 closeExpressionLibrary
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+CalcError openExpressionLibrary(const char* path, ExpressionLibrary* lib) {
+    MappedFile file;
+    memset(lib, 0, sizeof(*lib));
+    CalcError err = mapReadOnlyFile(path, &file);
+    if (err.code != 0) return err;
+    lib->base = file.base;
+    lib->size = file.size;
+    lib->mapping = file.handle;
+
+    const LibraryFileHeader* header = (const LibraryFileHeader*)lib->base;
+    if (lib->size < sizeof(*header) || memcmp(header->magic, LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC)) != 0) {
+        err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "库文件格式不正确");
+    } else if (header->version != LIBRARY_VERSION || header->endianTag != LIBRARY_ENDIAN_TAG ||
+               header->instructionSize != sizeof(Instruction)) {
+        err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "库文件版本或平台不兼容");
+    } else if (header->fileSize != lib->size || header->indexOffset % LIBRARY_ALIGNMENT != 0 ||
+               header->indexOffset > lib->size ||
+               (lib->size - header->indexOffset) / sizeof(uint64_t) < header->count) {
+        err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "库文件已损坏");
+    }
+    if (err.code != 0) {
+        closeExpressionLibrary(lib);
+        return err;
+    }
+
+    lib->count = header->count;
+    lib->index = (const uint64_t*)(lib->base + header->indexOffset);
+    return CALC_SUCCESS;
+}
+
+// 尚未结束的条件分支（验证跳转目标与分支结构）
+typedef struct {
+    int branch;     // OP_BRANCH 的位置
+    int jump;       // OP_JUMP 的位置（尚未遇到时为 -1）
+    int depth;      // OP_BRANCH 处的栈深度
+} BranchFrame;
+
+/**
+ * 检查指令序列（防止损坏的文件导致越界访问）
+ * 跳转必须与编译器生成的结构一致：OP_BRANCH 与配对的 OP_AND / OP_OR / OP_SELECT 成对嵌套，
+ * 跳转目标恰好是配对指令（条件运算为 OP_JUMP）之后的位置
+ */
+static int isValidProgram(const Instruction* code, int length, int maxStack, int varCount) {
+    BranchFrame frames[MAX_EXPR];
+    int frameCount = 0;
+    int depth = 0;
+    for (int i = 0; i < length; i++) {
+        BranchFrame* frame = frameCount > 0 ? &frames[frameCount - 1] : NULL;
+        switch (code[i].op) {
+            case OP_CONST:
+                depth++;
+                break;
+            case OP_VAR:
+                if (code[i].slot >= varCount) return 0;
+                depth++;
+                break;
+            case OP_NEG:
+                if (depth < 1) return 0;
+                break;
+            case OP_CALL:
+                if (depth < 1 || code[i].func == FUNC_NONE || code[i].func > FUNC_DEG) return 0;
+                break;
+            case OP_ADD:
+            case OP_SUB:
+            case OP_MUL:
+            case OP_DIV:
+            case OP_POW:
+            case OP_LT:
+            case OP_LE:
+            case OP_GT:
+            case OP_GE:
+            case OP_EQ:
+            case OP_NE:
+                if (depth < 2) return 0;
+                depth--;
+                break;
+            case OP_NOT:
+                if (depth < 1) return 0;
+                break;
+            case OP_BRANCH:
+                if (depth < 1 || frameCount == MAX_EXPR ||
+                    (code[i].func != OP_AND && code[i].func != OP_OR && code[i].func != OP_SELECT)) {
+                    return 0;
+                }
+                frames[frameCount++] = (BranchFrame){i, -1, depth};
+                break;
+            case OP_JUMP:
+                if (frame == NULL || code[frame->branch].func != OP_SELECT || frame->jump >= 0 ||
+                    depth != frame->depth + 1 || code[frame->branch].slot != i + 1) {
+                    return 0;
+                }
+                frame->jump = i;
+                break;
+            case OP_SELECT:
+                if (frame == NULL || code[frame->branch].func != OP_SELECT || frame->jump < 0 ||
+                    depth != frame->depth + 2 || code[frame->jump].slot != i + 1) {
+                    return 0;
+                }
+                depth -= 2;
+                frameCount--;
+                break;
+            case OP_AND:
+            case OP_OR:
+                if (frame == NULL || code[frame->branch].func != code[i].op || depth != frame->depth + 1 ||
+                    code[frame->branch].slot != i + 1) {
+                    return 0;
+                }
+                depth--;
+                frameCount--;
+                break;
+            default:
+                return 0;
+        }
+        if (depth > maxStack) return 0;
+    }
+    return depth == 1 && frameCount == 0;
+}
+
+/**
+ * 取出第 index 条表达式
+ * prog 直接指向映射中的字节码（storage 为 NULL），无需释放，库关闭后失效
+ *
+ * @param lib   已映射的库
+ * @param index 表达式序号
+ * @param prog  输出的编译结果
+ * @param mode  可选，输出编译时的角度模式
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+CalcError getLibraryExpression(const ExpressionLibrary* lib, uint32_t index, CompiledExpr* prog, AngleMode* mode) {
+    if (index >= lib->count) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "表达式序号超出范围");
+    }
+
+    uint64_t offset = lib->index[index];
+    if (offset % LIBRARY_ALIGNMENT != 0 || offset > lib->size ||
+        lib->size - offset < sizeof(LibraryRecordHeader)) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "库文件已损坏");
+    }
+
+    const LibraryRecordHeader* record = (const LibraryRecordHeader*)(lib->base + offset);
+    if (record->varCount < 0 || record->varCount > MAX_COMPILED_VARIABLES) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "库文件已损坏");
+    }
+    const char* names = (const char*)(record + 1);
+    size_t namesSize = (size_t)record->varCount * MAX_VARIABLE_NAME;
+    if (lib->size - offset - sizeof(*record) < namesSize) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "库文件已损坏");
+    }
+    const Instruction* code = (const Instruction*)(names + namesSize);
+    size_t available = (lib->size - offset - sizeof(*record) - namesSize) / sizeof(Instruction);
+
+    if (record->length <= 0 || (size_t)record->length > available ||
+        record->maxStack <= 0 || record->maxStack > MAX_EXPR ||
+        record->angleMode > MODE_RAD || record->decimalScale > MAX_DECIMAL_SCALE ||
+        record->decimalRounding > DEC_ROUND_CEILING || record->nesting > MAX_EXPR ||
+        !isValidProgram(code, record->length, record->maxStack, record->varCount)) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "库文件已损坏");
+    }
+
+    prog->code = code;
+    prog->length = record->length;
+    prog->maxStack = record->maxStack;
+    prog->varCount = record->varCount;
+    memset(prog->varNames, 0, sizeof(prog->varNames));
+    memcpy(prog->varNames, names, namesSize);
+    for (int i = 0; i < record->varCount; i++) {
+        prog->varNames[i][MAX_VARIABLE_NAME - 1] = '\0';
+    }
+    prog->storage = NULL;
+    prog->polynomials = NULL;
+    prog->polynomialCount = 0;
+    prog->isDecimal = record->isDecimal != 0;
+    prog->isVector = 0;
+    prog->decimal.scale = record->decimalScale;
+    prog->decimal.rounding = (DecimalRounding)record->decimalRounding;
+    estimateCompiledCost(prog, (int)record->nesting);
+    if (mode) *mode = (AngleMode)record->angleMode;
+    return CALC_SUCCESS;
+}
+
+// 解除映射
+void closeExpressionLibrary(ExpressionLibrary* lib) {
+    MappedFile file = {lib->base, lib->size, lib->mapping};
+    unmapFile(&file);
+    memset(lib, 0, sizeof(*lib));
+}
@@ -0,0 +1,639 @@
+#include "calculator.h"
+#include "expression_profile.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILE_CLOCK_UNIT "周期"
+static inline uint64_t readClock(void) {
+    return __rdtsc();
+}
+#else
+#include <time.h>
+#define PROFILE_CLOCK_UNIT "纳秒"
+static inline uint64_t readClock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+#define LABEL_COLUMNS 30    // 树形标签列宽（显示宽度）
+
+const char* profileClockUnit(void) {
+    return PROFILE_CLOCK_UNIT;
+}
+
+// 两次连续读时钟的最小间隔，作为每次计时的固定开销
+static uint64_t measureClockOverhead(void) {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 256; i++) {
+        uint64_t t0 = readClock();
+        uint64_t t1 = readClock();
+        if (t1 - t0 < best) {
+            best = t1 - t0;
+        }
+    }
+    return best;
+}
+
+static inline uint64_t elapsed(uint64_t t0, uint64_t t1, uint64_t overhead) {
+    uint64_t ticks = t1 - t0;
+    return ticks > overhead ? ticks - overhead : 0;
+}
+
+static int isTrigFunction(int func) {
+    return func == FUNC_SIN || func == FUNC_COS || func == FUNC_TAN;
+}
+
+// 指令的操作数个数
+static int instructionArity(int op) {
+    switch (op) {
+        case OP_CONST:
+        case OP_VAR:  return 0;
+        case OP_NEG:
+        case OP_NOT:
+        case OP_CALL: return 1;
+        default:      return 2;
+    }
+}
+
+// 由后缀字节码恢复语法树：记录每个节点的子树起点与父节点
+static void buildTree(const CompiledExpr* prog, ProfileNode* nodes) {
+    int stack[MAX_EXPR];
+    int top = -1;
+
+    for (int i = 0; i < prog->length; i++) {
+        nodes[i].parent = -1;
+        switch (instructionArity(prog->code[i].op)) {
+            case 0:
+                nodes[i].start = i;
+                stack[++top] = i;
+                break;
+            case 1:
+                nodes[stack[top]].parent = i;
+                nodes[i].start = nodes[stack[top]].start;
+                stack[top] = i;
+                break;
+            default:
+                nodes[stack[top]].parent = i;
+                top--;
+                nodes[stack[top]].parent = i;
+                nodes[i].start = nodes[stack[top]].start;
+                stack[top] = i;
+                break;
+        }
+    }
+}
+
+/**
+ * 插桩求值一次：计算逻辑与 runCompiled 相同，但把函数与运算拆成
+ * 双精度计算和接近整数修正两步分别计时
+ */
+static ErrorCode runInstrumented(ExpressionProfile* profile, const double* vars, uint64_t overhead) {
+    const CompiledExpr* prog = profile->prog;
+    double stack[MAX_EXPR];
+    int64_t intStack[MAX_EXPR];
+    unsigned char isInt[MAX_EXPR];
+    int top = -1;
+
+    for (int i = 0; i < prog->length; i++) {
+        const Instruction* ins = &prog->code[i];
+        ProfileNode* node = &profile->nodes[i];
+        ErrorCode code = ERR_SUCCESS;
+        double raw = 0;
+        int snapped = 0;
+        uint64_t t0 = readClock(), t1, t2;
+
+        node->calls++;
+        switch (ins->op) {
+            case OP_CONST:
+            case OP_VAR:
+                top++;
+                stack[top] = (ins->op == OP_CONST) ? ins->value : vars[ins->slot];
+                isInt[top] = (unsigned char)doubleToExactInt64(stack[top], &intStack[top]);
+                t1 = t2 = readClock();
+                break;
+
+            case OP_NEG:
+                stack[top] = -stack[top];
+                if (isInt[top]) {
+                    isInt[top] = intStack[top] != INT64_MIN;
+                    intStack[top] = isInt[top] ? -intStack[top] : 0;
+                }
+                t1 = t2 = readClock();
+                break;
+
+            case OP_NOT:
+                stack[top] = (stack[top] == 0);
+                intStack[top] = (int64_t)stack[top];
+                isInt[top] = 1;
+                t1 = t2 = readClock();
+                break;
+
+            case OP_CALL: {
+                double argument = stack[top];
+                code = calculateFunctionRaw((FuncType)ins->func, argument, profile->mode, &raw);
+                t1 = t2 = readClock();
+                if (code != ERR_SUCCESS) {
+                    break;
+                }
+                int64_t intValue;
+                snapped = !isUndefined(raw) && isCloseToInteger(raw, &intValue);
+                stack[top] = snapped ? (double)intValue : raw;
+                t2 = readClock();
+                isInt[top] = fabs(stack[top]) <= (double)MAX_EXACT_DOUBLE_INTEGER &&
+                             doubleToExactInt64(stack[top], &intStack[top]);
+
+                if (isTrigFunction(ins->func)) {
+                    // 查表命中时不会执行特殊角检查
+                    double ignored;
+                    if (profile->mode == MODE_DEG &&
+                        lookupDegreeTrig((FuncType)ins->func, argument, &ignored) != 0) {
+                        node->tableHits++;
+                        break;
+                    }
+                    uint64_t s0 = readClock();
+                    int special = checkTrigSpecialAngle(argument, profile->mode, (FuncType)ins->func);
+                    uint64_t s1 = readClock();
+                    node->specialTicks += elapsed(s0, s1, overhead);
+                    node->specialHits += special != 0;
+                }
+                break;
+            }
+
+            default: {
+                char op = opcodeToOperator(ins->op);
+                top--;
+                if (isInt[top] && isInt[top + 1] &&
+                    performIntegerOperation(op, intStack[top], intStack[top + 1], &intStack[top])) {
+                    stack[top] = (double)intStack[top];
+                    t1 = t2 = readClock();
+                    node->integerHits++;
+                    break;
+                }
+                code = performFloatOperation(op, stack[top], stack[top + 1], &raw);
+                t1 = t2 = readClock();
+                node->powCalls += op == '^' && code != ERR_UNDEFINED;
+                if (code != ERR_SUCCESS) {
+                    break;
+                }
+                int64_t intValue;
+                snapped = isCloseToInteger(raw, &intValue);
+                stack[top] = snapped ? (double)intValue : raw;
+                t2 = readClock();
+                isInt[top] = fabs(stack[top]) <= (double)MAX_EXACT_DOUBLE_INTEGER &&
+                             doubleToExactInt64(stack[top], &intStack[top]);
+                break;
+            }
+        }
+
+        if (code != ERR_SUCCESS) {
+            node->ticks += elapsed(t0, t1, overhead);
+            return code;
+        }
+        node->ticks += elapsed(t0, t2, overhead);
+        if (t2 != t1) {
+            node->snapTicks += elapsed(t1, t2, overhead);
+            node->snaps += snapped && stack[top] != raw;
+        }
+    }
+    return ERR_SUCCESS;
+}
+
+// ─── 静态分析 ───────────────────────────────────────────────────────────────
+
+static int subtreeHasVariable(const ExpressionProfile* profile, int node) {
+    for (int i = profile->nodes[node].start; i <= node; i++) {
+        if (profile->prog->code[i].op == OP_VAR) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 两个子树的指令序列是否相同（不比较源位置）
+static int sameSubtree(const ExpressionProfile* profile, int a, int b) {
+    int startA = profile->nodes[a].start;
+    int startB = profile->nodes[b].start;
+    if (a - startA != b - startB) {
+        return 0;
+    }
+    for (int k = 0; k <= a - startA; k++) {
+        const Instruction* x = &profile->prog->code[startA + k];
+        const Instruction* y = &profile->prog->code[startB + k];
+        if (x->op != y->op || x->func != y->func || x->slot != y->slot ||
+            (x->op == OP_CONST && x->value != y->value)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int countOccurrences(const ExpressionProfile* profile, int node) {
+    int count = 0;
+    for (int i = 0; i < profile->prog->length; i++) {
+        count += sameSubtree(profile, node, i);
+    }
+    return count;
+}
+
+static void addHint(ExpressionProfile* profile, ProfileHintKind kind, int node, double value) {
+    if (profile->hintCount < MAX_PROFILE_HINTS) {
+        ProfileHint* hint = &profile->hints[profile->hintCount++];
+        hint->kind = kind;
+        hint->node = node;
+        hint->value = value;
+    }
+}
+
+/**
+ * 找出可以折叠的常量子表达式（取最大的不含变量的子树）和可改写的模式
+ */
+static void analyzeProgram(ExpressionProfile* profile) {
+    const CompiledExpr* prog = profile->prog;
+
+    for (int i = 0; i < prog->length; i++) {
+        const Instruction* ins = &prog->code[i];
+        int parent = profile->nodes[i].parent;
+        if (instructionArity(ins->op) == 0) {
+            continue;
+        }
+
+        if (!subtreeHasVariable(profile, i)) {
+            if (parent >= 0 && !subtreeHasVariable(profile, parent)) {
+                continue;
+            }
+            CompiledExpr view = *prog;
+            view.code = prog->code + profile->nodes[i].start;
+            view.length = i - profile->nodes[i].start + 1;
+            view.storage = NULL;
+            view.polynomials = NULL;
+            view.polynomialCount = 0;
+            double value;
+            if (evaluateCompiledFast(&view, NULL, profile->mode, &value) == ERR_SUCCESS) {
+                addHint(profile, HINT_FOLD, i, value);
+            }
+            continue;
+        }
+
+        if (ins->op == OP_POW && prog->code[i - 1].op == OP_CONST) {
+            double exponent = prog->code[i - 1].value;
+            if (exponent == 2 || exponent == 3) {
+                addHint(profile, HINT_SQUARE, i, exponent);
+            } else if (exponent == 0.5) {
+                addHint(profile, HINT_SQRT, i, exponent);
+            }
+        }
+
+        // 重复的子表达式：只在第一次出现处报告，且父节点本身不重复
+        int first = 1;
+        for (int j = 0; j < i && first; j++) {
+            first = !sameSubtree(profile, j, i);
+        }
+        int count = first ? countOccurrences(profile, i) : 0;
+        if (count > 1 && (parent < 0 || countOccurrences(profile, parent) == 1)) {
+            addHint(profile, HINT_REPEATED, i, count);
+        }
+    }
+}
+
+/**
+ * 分析编译后的表达式：插桩求值 runs 次，统计每个节点的耗时与计数
+ *
+ * @param prog    编译后的表达式（双精度模式）
+ * @param vars    变量值，按槽位顺序排列（无变量时可为 NULL）
+ * @param mode    角度模式
+ * @param runs    求值次数
+ * @param profile 输出分析结果（用 freeExpressionProfile 释放）
+ * @return 参数无效或内存分配失败时返回错误；求值出错不算失败，记录在 profile->error
+ */
+CalcError profileCompiled(const CompiledExpr* prog, const double* vars, AngleMode mode, int runs,
+                          ExpressionProfile* profile) {
+    memset(profile, 0, sizeof(*profile));
+    if (prog->isDecimal) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "十进制模式的表达式不支持分析");
+    }
+    if (prog->isVector) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "向量表达式不支持分析");
+    }
+    if (prog->length == 0 || prog->maxStack > MAX_EXPR) {
+        return CALC_ERROR_CODE(ERR_SYNTAX, "表达式不完整");
+    }
+    if (runs <= 0) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "运行次数必须大于0");
+    }
+    for (int i = 0; i < prog->length; i++) {
+        if (prog->code[i].op >= OP_AND && prog->code[i].op <= OP_SELECT) {
+            return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "含条件分支的表达式不支持分析");
+        }
+    }
+
+    profile->nodes = (ProfileNode*)calloc((size_t)prog->length, sizeof(ProfileNode));
+    if (profile->nodes == NULL) {
+        return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+    }
+    profile->prog = prog;
+    profile->mode = mode;
+    profile->clockOverhead = measureClockOverhead();
+    buildTree(prog, profile->nodes);
+    analyzeProgram(profile);
+
+    // 不插桩的求值作为对照
+    uint64_t start = readClock();
+    ErrorCode code = ERR_SUCCESS;
+    for (int r = 0; r < runs; r++) {
+        code = evaluateCompiledFast(prog, vars, mode, &profile->result);
+    }
+    profile->baselineTicks = readClock() - start;
+
+    if (code != ERR_SUCCESS) {
+        // 每次都在同一个节点出错，插桩求值一次即可
+        profile->error = diagnoseCompiled(prog, vars, mode);
+        profile->result = 0;
+        profile->baselineTicks /= (uint64_t)runs;
+        runs = 1;
+    }
+    profile->runs = runs;
+    for (int r = 0; r < runs; r++) {
+        if (runInstrumented(profile, vars, profile->clockOverhead) != ERR_SUCCESS) {
+            break;
+        }
+    }
+    return CALC_SUCCESS;
+}
+
+void freeExpressionProfile(ExpressionProfile* profile) {
+    free(profile->nodes);
+    profile->nodes = NULL;
+}
+
+// ─── 输出 ───────────────────────────────────────────────────────────────────
+
+typedef struct {
+    char* data;
+    size_t size;
+    size_t length;
+} TextBuffer;
+
+static void appendText(TextBuffer* out, const char* text) {
+    size_t n = strlen(text);
+    if (out->length + 1 < out->size) {
+        size_t room = out->size - out->length - 1;
+        size_t copy = n < room ? n : room;
+        memcpy(out->data + out->length, text, copy);
+        out->data[out->length + copy] = '\0';
+    }
+    out->length += n;
+}
+
+static int precedence(int op) {
+    switch (op) {
+        case OP_ADD:
+        case OP_SUB: return PRIORITY_ADD;
+        case OP_MUL:
+        case OP_DIV: return PRIORITY_MUL;
+        case OP_POW: return PRIORITY_POW;
+        case OP_LT:
+        case OP_LE:
+        case OP_GT:
+        case OP_GE:
+        case OP_EQ:
+        case OP_NE:  return PRIORITY_CMP;
+        case OP_NOT: return PRIORITY_NOT;
+        default:     return PRIORITY_POW + 1;
+    }
+}
+
+// 节点自身的标签：常量值、变量名、函数名或运算符
+static const char* nodeLabel(const ExpressionProfile* profile, int node, char* buffer, size_t size) {
+    const Instruction* ins = &profile->prog->code[node];
+    switch (ins->op) {
+        case OP_CONST: return formatNumber(ins->value, buffer, size);
+        case OP_VAR:   return profile->prog->varNames[ins->slot];
+        case OP_NEG:   return "-";
+        case OP_CALL:  return getFunctionName((FuncType)ins->func);
+        default:
+            snprintf(buffer, size, "%s", getOperatorSymbol(opcodeToOperator(ins->op)));
+            return buffer;
+    }
+}
+
+static void writeOperand(const ExpressionProfile* profile, int node, int parentheses, TextBuffer* out);
+
+// 由字节码还原子表达式（按需加括号，保持原来的求值顺序）
+static void writeSubtree(const ExpressionProfile* profile, int node, TextBuffer* out) {
+    const Instruction* ins = &profile->prog->code[node];
+    char label[32];
+
+    switch (ins->op) {
+        case OP_CONST:
+        case OP_VAR:
+            appendText(out, nodeLabel(profile, node, label, sizeof(label)));
+            break;
+        case OP_NEG:
+            appendText(out, "-");
+            writeOperand(profile, node - 1, instructionArity(profile->prog->code[node - 1].op) == 2, out);
+            break;
+        case OP_CALL:
+            appendText(out, getFunctionName((FuncType)ins->func));
+            writeOperand(profile, node - 1, 1, out);
+            break;
+        case OP_NOT:
+            appendText(out, "not ");
+            writeOperand(profile, node - 1, precedence(profile->prog->code[node - 1].op) < PRIORITY_NOT, out);
+            break;
+        default: {
+            int left = profile->nodes[node - 1].start - 1;
+            int right = node - 1;
+            int prec = precedence(ins->op);
+            int leftPrec = precedence(profile->prog->code[left].op);
+            int rightPrec = precedence(profile->prog->code[right].op);
+            // 加减与比较两侧加空格
+            writeOperand(profile, left, leftPrec < prec || (leftPrec == prec && ins->op == OP_POW), out);
+            if (prec <= PRIORITY_ADD) appendText(out, " ");
+            appendText(out, nodeLabel(profile, node, label, sizeof(label)));
+            if (prec <= PRIORITY_ADD) appendText(out, " ");
+            writeOperand(profile, right, rightPrec < prec || (rightPrec == prec && ins->op != OP_POW), out);
+            break;
+        }
+    }
+}
+
+static void writeOperand(const ExpressionProfile* profile, int node, int parentheses, TextBuffer* out) {
+    if (parentheses) appendText(out, "(");
+    writeSubtree(profile, node, out);
+    if (parentheses) appendText(out, ")");
+}
+
+/**
+ * 节点对应的子表达式文本
+ * @return 完整文本的长度（与 snprintf 相同，超过 size - 1 表示已截断）
+ */
+int formatProfileNode(const ExpressionProfile* profile, int node, char* buffer, size_t size) {
+    TextBuffer out = {buffer, size, 0};
+    if (size > 0) {
+        buffer[0] = '\0';
+    }
+    writeSubtree(profile, node, &out);
+    return (int)out.length;
+}
+
+static double percentOf(uint64_t part, uint64_t whole) {
+    return whole ? 100.0 * (double)part / (double)whole : 0.0;
+}
+
+// 节点的说明列：特殊角检查、int64 快速路径、pow 与接近整数修正
+static void describeNode(const ExpressionProfile* profile, int node, char* buffer, size_t size) {
+    const Instruction* ins = &profile->prog->code[node];
+    const ProfileNode* stats = &profile->nodes[node];
+    uint64_t floatCalls = stats->calls - stats->integerHits;
+    int length = 0;
+    buffer[0] = '\0';
+    if (stats->calls == 0 || instructionArity(ins->op) == 0 || ins->op == OP_NEG) {
+        return;
+    }
+
+    if (ins->op == OP_CALL && isTrigFunction(ins->func) && profile->mode == MODE_DEG) {
+        length += snprintf(buffer + length, size - length, "查表 %.0f%%；",
+                           percentOf(stats->tableHits, stats->calls));
+    }
+    uint64_t checked = stats->calls - stats->tableHits;
+    if (ins->op == OP_CALL && isTrigFunction(ins->func) && checked > 0) {
+        length += snprintf(buffer + length, size - length, "特殊角检查 %.1f（命中 %.0f%%）；",
+                           (double)stats->specialTicks / (double)checked, percentOf(stats->specialHits, checked));
+    }
+    if (stats->integerHits > 0) {
+        length += snprintf(buffer + length, size - length, "int64 %.0f%%；",
+                           percentOf(stats->integerHits, stats->calls));
+    }
+    if (ins->op == OP_POW && stats->powCalls > 0) {
+        length += snprintf(buffer + length, size - length, "pow %.0f%%；",
+                           percentOf(stats->powCalls, stats->calls));
+    }
+    if (floatCalls > 0) {
+        length += snprintf(buffer + length, size - length, "取整检查 %.1f（修正 %.0f%%）；",
+                           (double)stats->snapTicks / (double)floatCalls,
+                           percentOf(stats->snaps, floatCalls));
+    }
+    // 去掉最后的分号
+    if (length >= 3 && (size_t)length < size) {
+        buffer[length - 3] = '\0';
+    }
+}
+
+static void printTreeNode(const ExpressionProfile* profile, int node, char* prefix, size_t prefixLength,
+                          int prefixColumns, int isRoot, int isLast, uint64_t totalTicks, FILE* out) {
+    const ProfileNode* stats = &profile->nodes[node];
+    const char* branch = isRoot ? "" : (isLast ? "└─ " : "├─ ");
+    char label[32];
+    char note[200];
+    const char* text = nodeLabel(profile, node, label, sizeof(label));
+
+    uint64_t inclusive = 0;
+    for (int i = stats->start; i <= node; i++) {
+        inclusive += profile->nodes[i].ticks;
+    }
+    describeNode(profile, node, note, sizeof(note));
+
+    int columns = prefixColumns + (isRoot ? 0 : 3) + (int)strlen(text);
+    fprintf(out, "%s%s%s%*s %10.1f %6.1f%% %6.1f%%  %s\n", prefix, branch, text,
+            columns < LABEL_COLUMNS ? LABEL_COLUMNS - columns : 0, "",
+            (double)stats->ticks / (double)profile->runs, percentOf(stats->ticks, totalTicks),
+            percentOf(inclusive, totalTicks), note);
+
+    int children[2];
+    int count = 0;
+    int arity = instructionArity(profile->prog->code[node].op);
+    if (arity == 2) {
+        children[count++] = profile->nodes[node - 1].start - 1;
+    }
+    if (arity >= 1) {
+        children[count++] = node - 1;
+    }
+
+    const char* indent = isRoot ? "" : (isLast ? "   " : "│  ");
+    size_t indentLength = strlen(indent);
+    if (prefixLength + indentLength + 1 > 512) {
+        return;
+    }
+    memcpy(prefix + prefixLength, indent, indentLength + 1);
+    for (int c = 0; c < count; c++) {
+        printTreeNode(profile, children[c], prefix, prefixLength + indentLength,
+                      prefixColumns + (isRoot ? 0 : 3), 0, c == count - 1, totalTicks, out);
+    }
+    prefix[prefixLength] = '\0';
+}
+
+/**
+ * 打印分析结果：每个节点一行，列出自身耗时（每次求值）、自身与含子节点的占比和说明，
+ * 随后是可以折叠的常量和改写建议
+ */
+void printExpressionProfile(const ExpressionProfile* profile, FILE* out) {
+    const CompiledExpr* prog = profile->prog;
+    int root = prog->length - 1;
+    char text[MAX_EXPR * 4];
+    char number[50];
+
+    formatProfileNode(profile, root, text, sizeof(text));
+    fprintf(out, "explain %s（运行 %d 次，%s模式）\n", text, profile->runs,
+            profile->mode == MODE_DEG ? "角度" : "弧度");
+    if (profile->error.code != 0) {
+        fprintf(out, "求值出错：%s（位置 %d），只统计到出错的节点\n", profile->error.message,
+                profile->error.position);
+    } else {
+        fprintf(out, "结果：%s\n", formatNumber(profile->result, number, sizeof(number)));
+    }
+
+    uint64_t totalTicks = 0;
+    for (int i = 0; i < prog->length; i++) {
+        totalTicks += profile->nodes[i].ticks;
+    }
+    fprintf(out, "不插桩求值每次 %.1f %s；插桩后各节点自身耗时合计每次 %.1f %s（已扣除每次计时的开销 %llu）\n\n",
+            (double)profile->baselineTicks / (double)profile->runs, PROFILE_CLOCK_UNIT,
+            (double)totalTicks / (double)profile->runs, PROFILE_CLOCK_UNIT,
+            (unsigned long long)profile->clockOverhead);
+
+    // 表头按显示宽度对齐（中文字符占两列）
+    fprintf(out, "节点%*s    自身/次    自身    累计  说明\n", LABEL_COLUMNS - 4, "");
+    char prefix[512] = "";
+    printTreeNode(profile, root, prefix, 0, 0, 1, 1, totalTicks, out);
+
+    int folds = 0;
+    for (int h = 0; h < profile->hintCount; h++) {
+        const ProfileHint* hint = &profile->hints[h];
+        if (hint->kind != HINT_FOLD) continue;
+        if (folds++ == 0) fprintf(out, "\n常量折叠：\n");
+        formatProfileNode(profile, hint->node, text, sizeof(text));
+        fprintf(out, "  %s → %s\n", text, formatNumber(hint->value, number, sizeof(number)));
+    }
+
+    int rewrites = 0;
+    for (int h = 0; h < profile->hintCount; h++) {
+        const ProfileHint* hint = &profile->hints[h];
+        if (hint->kind == HINT_FOLD) continue;
+        if (rewrites++ == 0) fprintf(out, "\n建议改写：\n");
+        formatProfileNode(profile, hint->node, text, sizeof(text));
+
+        char base[MAX_EXPR * 4];
+        TextBuffer operand = {base, sizeof(base), 0};
+        int baseNode = prog->code[hint->node].op == OP_POW ? profile->nodes[hint->node - 1].start - 1 : -1;
+        if (baseNode >= 0) {
+            writeOperand(profile, baseNode, instructionArity(prog->code[baseNode].op) == 2, &operand);
+        }
+        switch (hint->kind) {
+            case HINT_SQUARE:
+                fprintf(out, "  %s → %s*%s%s%s（不调用 pow）\n", text, base, base,
+                        hint->value == 3 ? "*" : "", hint->value == 3 ? base : "");
+                break;
+            case HINT_SQRT:
+                formatProfileNode(profile, baseNode, base, sizeof(base));
+                fprintf(out, "  %s → sqrt(%s)\n", text, base);
+                break;
+            case HINT_REPEATED:
+                fprintf(out, "  %s 计算了 %.0f 次，可以先算出来作为变量传入\n", text, hint->value);
+                break;
+            default:
+                break;
+        }
+    }
+}
@@ -1,4 +1,17 @@
 #include "calculator.h"
+#include "expression_library.h"
+#include "calc_server.h"
+#include "shared_ring.h"
+#include "column_evaluator.h"
+#include "batch_format.h"
+#include "expression_profile.h"
+#include "function_cache.h"
+#include "vector_value.h"
+#include <signal.h>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
 
 // 添加历史记录管理函数
 void addToHistory(char history[][MAX_EXPR], int* historyCount, const char* entry) {
@@ -16,13 +29,511 @@ void addToHistory(char history[][MAX_EXPR], int* historyCount, const char* entry
     }
 }
 
-int main() {
+/**
+ * --compile-lib 模式：将文本文件中的表达式（每行一个，忽略空行和 # 开头的注释行）
+ * 编译后写入库文件，表达式序号为有效行的顺序；超过缓冲区的行报错并指出行号
+ */
+static int runCompileLibrary(int argc, char* argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "用法：%s --compile-lib <表达式文件> <库文件> [--rad]\n", argv[0]);
+        return 1;
+    }
+    AngleMode mode = (argc > 4 && strcmp(argv[4], "--rad") == 0) ? MODE_RAD : MODE_DEG;
+    
+    FILE* input = fopen(argv[2], "r");
+    if (input == NULL) {
+        fprintf(stderr, "错误: 无法打开表达式文件 %s\n", argv[2]);
+        return 1;
+    }
+    
+    LibraryWriter writer;
+    CalcError err = openLibraryWriter(argv[3], &writer);
+    if (err.code != 0) {
+        fprintf(stderr, "错误: %s\n", err.message);
+        fclose(input);
+        return 1;
+    }
+    
+    char line[MAX_EXPR * 4];
+    int lineNumber = 0;
+    while (fgets(line, sizeof(line), input) != NULL) {
+        lineNumber++;
+        // 没有读到换行且文件未结束：这一行超出缓冲区，不能拆成两个表达式
+        if (strchr(line, '\n') == NULL) {
+            int next = fgetc(input);
+            if (next != EOF && next != '\n') {
+                err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "表达式过长");
+                fprintf(stderr, "错误: 第%d行: %s（最多 %d 个字符）\n", lineNumber, err.message,
+                        (int)sizeof(line) - 1);
+                break;
+            }
+        }
+        line[strcspn(line, "\r\n")] = '\0';
+        const char* text = line;
+        while (*text == ' ') text++;
+        if (*text == '\0' || *text == '#') {
+            continue;
+        }
+        
+        CompiledExpr prog;
+        err = compileExpression(line, &prog);
+        if (err.code == 0) {
+            err = appendLibraryExpression(&writer, &prog, mode);
+            freeCompiledExpression(&prog);
+        }
+        if (err.code != 0) {
+            fprintf(stderr, "错误: 第%d行: %s\n", lineNumber, err.message);
+            break;
+        }
+    }
+    fclose(input);
+    
+    uint32_t count = writer.count;
+    CalcError closeErr = closeLibraryWriter(&writer);
+    if (err.code == 0 && closeErr.code != 0) {
+        err = closeErr;
+        fprintf(stderr, "错误: %s\n", err.message);
+    }
+    if (err.code != 0) {
+        remove(argv[3]);
+        return 1;
+    }
+    
+    printf("已编译 %u 个表达式到 %s\n", count, argv[3]);
+    return 0;
+}
+
+/**
+ * --eval-lib 模式：计算库文件中的一个表达式，变量以 name=value 形式给出
+ */
+static int runEvaluateLibrary(int argc, char* argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "用法：%s --eval-lib <库文件> <序号> [变量=值 ...]\n", argv[0]);
+        return 1;
+    }
+    
+    ExpressionLibrary lib;
+    CalcError err = openExpressionLibrary(argv[2], &lib);
+    if (err.code != 0) {
+        fprintf(stderr, "错误: %s\n", err.message);
+        return 1;
+    }
+    
+    CompiledExpr prog;
+    AngleMode mode;
+    double vars[MAX_COMPILED_VARIABLES] = {0};
+    double result;
+    err = getLibraryExpression(&lib, (uint32_t)strtoul(argv[3], NULL, 10), &prog, &mode);
+    for (int i = 4; err.code == 0 && i < argc; i++) {
+        char* equals = strchr(argv[i], '=');
+        if (equals == NULL) {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "变量格式应为 变量=值");
+            break;
+        }
+        *equals = '\0';
+        int slot = findCompiledVariable(&prog, argv[i]);
+        if (slot >= 0) {
+            vars[slot] = strtod(equals + 1, NULL);
+        }
+    }
+    if (err.code == 0) {
+        err = evaluateCompiled(&prog, vars, mode, &result);
+    }
+    closeExpressionLibrary(&lib);
+    
+    if (err.code != 0) {
+        fprintf(stderr, "错误: %s\n", err.message);
+        return 1;
+    }
+    char resultStr[50];
+    printf("%s\n", formatNumber(result, resultStr, sizeof(resultStr)));
+    return 0;
+}
+
+static CalcServer* activeServer = NULL;
+static SharedRing* activeRing = NULL;
+
+static void handleStopSignal(int sig) {
+    (void)sig;
+    if (activeServer) {
+        stopServer(activeServer);
+    }
+    if (activeRing) {
+        stopSharedRing(activeRing);
+    }
+}
+
+/**
+ * --serve 模式：在本地套接字上提供计算服务，Ctrl+C 停止
+ */
+static int runServe(int argc, char* argv[]) {
+    ServerConfig config = {NULL, DEFAULT_SERVER_PORT, 0, 0, 0, 0};
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            config.port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--unix") == 0 && i + 1 < argc) {
+            config.unixPath = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            config.threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-steps") == 0 && i + 1 < argc) {
+            config.maxSteps = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--max-depth") == 0 && i + 1 < argc) {
+            config.maxDepth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--timeout-us") == 0 && i + 1 < argc) {
+            config.timeoutMicros = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "用法：%s --serve [--port 端口 | --unix 路径] [--threads 线程数] "
+                    "[--max-steps 步数] [--max-depth 深度] [--timeout-us 微秒]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    CalcServer* server;
+    CalcError err = createServer(&config, &server);
+    if (err.code != 0) {
+        fprintf(stderr, "错误: %s\n", err.message);
+        return 1;
+    }
+    if (config.unixPath) {
+        printf("计算服务已启动：%s\n", config.unixPath);
+    } else {
+        printf("计算服务已启动：127.0.0.1:%d\n", getServerPort(server));
+    }
+    fflush(stdout);
+    
+    activeServer = server;
+    signal(SIGINT, handleStopSignal);
+    signal(SIGTERM, handleStopSignal);
+    err = runServer(server);
+    activeServer = NULL;
+    
+    ServerStats stats;
+    getServerStats(server, &stats);
+    printf("\n已处理 %llu 个请求（错误 %llu），p50 %.1fus，p99 %.1fus\n",
+           (unsigned long long)stats.requests, (unsigned long long)stats.errors,
+           stats.p50Micros, stats.p99Micros);
+    destroyServer(server);
+    if (err.code != 0) {
+        fprintf(stderr, "错误: %s\n", err.message);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * --serve-shm 模式：通过共享内存队列为同机的生产者进程提供计算服务，Ctrl+C 停止
+ */
+static int runServeSharedRing(int argc, char* argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "用法：%s --serve-shm <共享内存名称> [--capacity 槽位数]\n", argv[0]);
+        return 1;
+    }
+    uint32_t capacity = DEFAULT_RING_CAPACITY;
+    if (argc > 4 && strcmp(argv[3], "--capacity") == 0) {
+        capacity = (uint32_t)strtoul(argv[4], NULL, 10);
+    }
+    
+    SharedRing ring;
+    CalcError err = createSharedRing(argv[2], capacity, &ring);
+    if (err.code != 0) {
+        fprintf(stderr, "错误: %s\n", err.message);
+        return 1;
+    }
+    printf("共享内存队列已创建：%s（%u 个槽位）\n", argv[2], capacity);
+    fflush(stdout);
+    
+    activeRing = &ring;
+    signal(SIGINT, handleStopSignal);
+    signal(SIGTERM, handleStopSignal);
+    err = serveSharedRing(&ring);
+    activeRing = NULL;
+    closeSharedRing(&ring);
+    if (err.code != 0) {
+        fprintf(stderr, "错误: %s\n", err.message);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * --eval-shm 模式：通过共享内存队列计算一个表达式，变量以 name=value 形式给出
+ */
+static int runEvaluateSharedRing(int argc, char* argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "用法：%s --eval-shm <共享内存名称> <表达式> [变量=值 ...]\n", argv[0]);
+        return 1;
+    }
+    RingBinding bindings[MAX_RING_BINDINGS];
+    int bindingCount = 0;
+    for (int i = 4; i < argc; i++) {
+        char* equals = strchr(argv[i], '=');
+        size_t nameLength = equals ? (size_t)(equals - argv[i]) : 0;
+        if (nameLength == 0 || nameLength >= MAX_VARIABLE_NAME || bindingCount == MAX_RING_BINDINGS) {
+            fprintf(stderr, "错误: 变量格式应为 变量=值（最多 %d 个）\n", MAX_RING_BINDINGS);
+            return 1;
+        }
+        memset(bindings[bindingCount].name, 0, MAX_VARIABLE_NAME);
+        memcpy(bindings[bindingCount].name, argv[i], nameLength);
+        bindings[bindingCount].value = strtod(equals + 1, NULL);
+        bindingCount++;
+    }
+    
+    SharedRing ring;
+    CalcError err = openSharedRing(argv[2], &ring);
+    double result = 0;
+    if (err.code == 0) {
+        err = evaluateOverRing(&ring, argv[3], strlen(argv[3]), MODE_DEG, bindings, bindingCount, &result);
+        closeSharedRing(&ring);
+    }
+    if (err.code != 0) {
+        fprintf(stderr, "错误: %s（位置 %d）\n", err.message, err.position);
+        return 1;
+    }
+    char resultStr[50];
+    printf("%s\n", formatNumber(result, resultStr, sizeof(resultStr)));
+    return 0;
+}
+
+/**
+ * --csv / --columnar 模式：对数据文件按列计算公式，结果列追加在输入列之后
+ */
+static int runColumnMode(int argc, char* argv[]) {
+    int columnar = strcmp(argv[1], "--columnar") == 0;
+    const char* outputPath = NULL;
+    FormulaSet set;
+    memset(&set, 0, sizeof(set));
+    set.mode = MODE_DEG;
+    
+    int usage = argc < 3;
+    for (int i = 3; i < argc && !usage; i++) {
+        if (strcmp(argv[i], "--expr") == 0 && i + 1 < argc) {
+            CalcError err = addFormulaColumn(&set, argv[++i]);
+            if (err.code != 0) {
+                fprintf(stderr, "错误: 公式 %s：%s\n", argv[i], err.message);
+                freeFormulaSet(&set);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (strcmp(argv[i], "--rad") == 0) {
+            set.mode = MODE_RAD;
+        } else if (strcmp(argv[i], "--memo") == 0) {
+            setFunctionCacheEnabled(1);
+        } else {
+            usage = 1;
+        }
+    }
+    if (usage || set.count == 0 || (columnar && outputPath == NULL)) {
+        fprintf(stderr, "用法：%s --csv <输入.csv> --expr '结果列=表达式' [--expr ...] [--output 输出.csv] [--rad] [--memo]\n", argv[0]);
+        fprintf(stderr, "      %s --columnar <输入文件> --expr '结果列=表达式' [--expr ...] --output <输出文件> [--rad] [--memo]\n", argv[0]);
+        freeFormulaSet(&set);
+        return 1;
+    }
+    
+    ColumnStats stats;
+    CalcError err;
+    if (columnar) {
+        err = evaluateColumnarFile(argv[2], outputPath, &set, &stats);
+    } else {
+        FILE* input = fopen(argv[2], "rb");
+        FILE* output = outputPath ? fopen(outputPath, "wb") : stdout;
+        if (input == NULL || output == NULL) {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, input == NULL ? "无法打开输入文件" : "无法创建输出文件");
+        } else {
+            err = evaluateCsvStream(input, output, &set, &stats);
+        }
+        if (input) fclose(input);
+        if (output && output != stdout && fclose(output) != 0 && err.code == 0) {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "写入输出失败");
+        }
+    }
+    freeFormulaSet(&set);
+    
+    if (err.code != 0) {
+        fprintf(stderr, "错误: %s\n", err.message);
+        return 1;
+    }
+    if (stats.errors > 0) {
+        fprintf(stderr, "已处理 %llu 行，%llu 个结果出错（第一个在第 %llu 行）\n",
+                (unsigned long long)stats.rows, (unsigned long long)stats.errors,
+                (unsigned long long)stats.firstErrorRow);
+    }
+    if (functionCacheEnabled) {
+        FunctionCacheStats cacheStats;
+        getFunctionCacheStats(&cacheStats);
+        fprintf(stderr, "函数缓存：查询 %llu 次，命中率 %.1f%%，自动关闭 %u 次（其间直接计算 %llu 次）\n",
+                (unsigned long long)cacheStats.lookups,
+                cacheStats.lookups ? 100.0 * cacheStats.hits / cacheStats.lookups : 0.0,
+                cacheStats.disables, (unsigned long long)cacheStats.bypassed);
+    }
+    return 0;
+}
+
+/**
+ * --batch 模式：处理二进制批量请求，输入或输出为 - 时使用标准输入/输出（流式），
+ * 否则输入用 mmap 映射
+ */
+static int runBatchMode(int argc, char* argv[]) {
+    const char* libraryPath = NULL;
+    int usage = argc < 4;
+    for (int i = 4; i < argc && !usage; i++) {
+        if (strcmp(argv[i], "--lib") == 0 && i + 1 < argc) {
+            libraryPath = argv[++i];
+        } else {
+            usage = 1;
+        }
+    }
+    if (usage) {
+        fprintf(stderr, "用法：%s --batch <请求文件|-> <结果文件|-> [--lib 库文件]\n", argv[0]);
+        return 1;
+    }
+    
+    ExpressionLibrary lib;
+    CalcError err = CALC_SUCCESS;
+    if (libraryPath != NULL) {
+        err = openExpressionLibrary(libraryPath, &lib);
+        if (err.code != 0) {
+            fprintf(stderr, "错误: %s\n", err.message);
+            return 1;
+        }
+    }
+    const ExpressionLibrary* library = libraryPath ? &lib : NULL;
+    
+    BatchStats stats;
+    int streamInput = strcmp(argv[2], "-") == 0;
+    int streamOutput = strcmp(argv[3], "-") == 0;
+    if (!streamInput && !streamOutput) {
+        err = processBatchFile(argv[2], argv[3], library, &stats);
+    } else {
+        FILE* input = streamInput ? stdin : fopen(argv[2], "rb");
+        FILE* output = streamOutput ? stdout : fopen(argv[3], "wb");
+#ifdef _WIN32
+        if (streamInput) _setmode(_fileno(stdin), _O_BINARY);
+        if (streamOutput) _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        if (input == NULL || output == NULL) {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, input == NULL ? "无法打开输入文件" : "无法创建输出文件");
+        } else {
+            err = processBatchStream(input, output, library, &stats);
+        }
+        if (input && input != stdin) fclose(input);
+        if (output && output != stdout && fclose(output) != 0 && err.code == 0) {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "写入输出失败");
+        }
+    }
+    if (libraryPath != NULL) {
+        closeExpressionLibrary(&lib);
+    }
+    
+    if (err.code != 0) {
+        fprintf(stderr, "错误: %s\n", err.message);
+        return 1;
+    }
+    if (stats.errors > 0) {
+        fprintf(stderr, "已处理 %llu 条请求，%llu 条出错\n",
+                (unsigned long long)stats.records, (unsigned long long)stats.errors);
+    }
+    return 0;
+}
+
+/**
+ * 编译表达式并打印逐节点的性能分析（REPL 的 explain 命令与 --explain 模式共用）
+ */
+static CalcError explainExpression(const char* expr, const double* vars, AngleMode mode, int runs) {
+    static const double zeros[MAX_COMPILED_VARIABLES] = {0};
+    CompiledExpr prog;
+    CalcError err = compileExpression(expr, &prog);
+    if (err.code != 0) {
+        return err;
+    }
+    ExpressionProfile profile;
+    err = profileCompiled(&prog, vars ? vars : zeros, mode, runs, &profile);
+    if (err.code == 0) {
+        printExpressionProfile(&profile, stdout);
+        freeExpressionProfile(&profile);
+    }
+    freeCompiledExpression(&prog);
+    return err;
+}
+
+/**
+ * --explain 模式：分析一个表达式，变量以 name=value 形式给出（未给出的变量取 0）
+ */
+static int runExplain(int argc, char* argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "用法：%s --explain <表达式> [--runs 次数] [--rad] [变量=值 ...]\n", argv[0]);
+        return 1;
+    }
+    
+    CompiledExpr prog;
+    CalcError err = compileExpression(argv[2], &prog);
+    if (err.code != 0) {
+        fprintf(stderr, "错误: %s\n", err.message);
+        return 1;
+    }
+    
+    AngleMode mode = MODE_DEG;
+    int runs = DEFAULT_PROFILE_RUNS;
+    double vars[MAX_COMPILED_VARIABLES] = {0};
+    for (int i = 3; err.code == 0 && i < argc; i++) {
+        char* equals = strchr(argv[i], '=');
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--rad") == 0) {
+            mode = MODE_RAD;
+        } else if (equals != NULL) {
+            *equals = '\0';
+            int slot = findCompiledVariable(&prog, argv[i]);
+            if (slot >= 0) {
+                vars[slot] = strtod(equals + 1, NULL);
+            }
+        } else {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "变量格式应为 变量=值");
+        }
+    }
+    freeCompiledExpression(&prog);
+    if (err.code == 0) {
+        err = explainExpression(argv[2], vars, mode, runs);
+    }
+    if (err.code != 0) {
+        fprintf(stderr, "错误: %s\n", err.message);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
     // 设置控制台代码页（仅Windows）
 #ifdef _WIN32
     SetConsoleOutputCP(65001);  // UTF-8
     SetConsoleCP(65001);       // UTF-8
 #endif
     
+    if (argc > 1 && strcmp(argv[1], "--compile-lib") == 0) {
+        return runCompileLibrary(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--eval-lib") == 0) {
+        return runEvaluateLibrary(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0) {
+        return runServe(argc, argv);
+    }
+    if (argc > 1 && (strcmp(argv[1], "--csv") == 0 || strcmp(argv[1], "--columnar") == 0)) {
+        return runColumnMode(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0) {
+        return runBatchMode(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--serve-shm") == 0) {
+        return runServeSharedRing(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--eval-shm") == 0) {
+        return runEvaluateSharedRing(argc, argv);
+    }
+    if (argc > 1 && strcmp(argv[1], "--explain") == 0) {
+        return runExplain(argc, argv);
+    }
+    
     char expression[MAX_EXPR];
     char history[HISTORY_SIZE][MAX_EXPR];  // 保存最近HISTORY_SIZE条历史记录
     // 初始化历史记录数组
@@ -31,11 +542,17 @@ int main() {
     }
     int historyCount = 0;
     AngleMode mode = MODE_DEG;  // 默认使用角度模式
+    int decimalMode = 0;        // 是否使用十进制定点模式
+    DecimalContext decimalContext = {2, DEC_ROUND_HALF_EVEN};
+    VectorArena arena;          // 向量表达式的中间结果
+    initVectorArena(&arena);
     
     printf("计算器启动 (默认使用角度模式)\n");
     printf("特殊命令：\n");
     printf("  mode     - 切换角度/弧度模式\n");
+    printf("  decimal N - 十进制定点模式，保留N位小数（decimal off 关闭）\n");
     printf("  history  - 显示历史记录\n");
+    printf("  explain 表达式 - 逐节点分析求值耗时\n");
     printf("  help     - 显示帮助信息\n");
     printf("  q        - 退出程序\n");
     printf("基本函数：\n");
@@ -56,10 +573,22 @@ int main() {
     printf("  deg(x)   - 弧度转角度\n");
     printf("常量支持：\n");
     printf("  pi       - 圆周率 (3.14159...)\n");
-    printf("  e        - 自然对数的底 (2.71828...)\n\n");
+    printf("  e        - 自然对数的底 (2.71828...)\n");
+    printf("求和与连乘：\n");
+    printf("  sum(i,a,b,expr)  - 对整数 i=a..b 求和\n");
+    printf("  prod(i,a,b,expr) - 对整数 i=a..b 连乘\n");
+    printf("求根与积分：\n");
+    printf("  solve(expr,x,lo,hi)     - 在 [lo,hi] 内求 expr=0 的根\n");
+    printf("  integrate(expr,x,a,b)   - 求 expr 在 [a,b] 上的积分\n");
+    printf("向量：\n");
+    printf("  [1,2,3]  - 向量字面量，运算与函数逐元素计算，sum/mean/min/max/norm/dot 归约\n\n");
     
     while (1) {
-        printf("\n请输入计算表达式 [%s]: ", mode == MODE_DEG ? "角度" : "弧度");
+        if (decimalMode) {
+            printf("\n请输入计算表达式 [十进制 %d位]: ", decimalContext.scale);
+        } else {
+            printf("\n请输入计算表达式 [%s]: ", mode == MODE_DEG ? "角度" : "弧度");
+        }
         if (fgets(expression, sizeof(expression), stdin) == NULL) {
             break;
         }
@@ -86,6 +615,21 @@ int main() {
             continue;
         }
         
+        if (strncmp(expression, "decimal", 7) == 0 && (expression[7] == ' ' || expression[7] == '\0')) {
+            int scale;
+            if (strcmp(expression + 7, " off") == 0) {
+                decimalMode = 0;
+                printf("关闭十进制模式\n");
+            } else if (sscanf(expression + 7, "%d", &scale) == 1 && scale >= 0 && scale <= MAX_DECIMAL_SCALE) {
+                decimalMode = 1;
+                decimalContext.scale = scale;
+                printf("切换到十进制模式，保留%d位小数\n", scale);
+            } else {
+                printf("用法：decimal N（0 <= N <= %d）或 decimal off\n", MAX_DECIMAL_SCALE);
+            }
+            continue;
+        }
+        
         if (strcmp(expression, "help") == 0) {
             printf("计算器使用帮助：\n");
             printf("1. 支持的运算：+, -, *, /, ^ (幂运算)\n");
@@ -100,6 +644,8 @@ int main() {
             printf("4. 角度模式下，三角函数的参数单位为角度\n");
             printf("5. 弧度模式下，三角函数的参数单位为弧度\n");
             printf("6. 使用括号可以改变计算优先级\n");
+            printf("   十进制模式（decimal N）下只支持 + - * / ^，结果精确到N位小数\n");
+            printf("   含方括号的表达式按向量计算，如 [1,2,3]*2 = [2, 4, 6]，sum([1,2,3]^2) = 14\n");
             printf("7. 例子：\n");
             printf("   - 1 + 2 * 3 = 7\n");
             printf("   - (1 + 2) * 3 = 9\n");
@@ -112,6 +658,14 @@ int main() {
             continue;
         }
         
+        if (strncmp(expression, "explain ", 8) == 0) {
+            CalcError explainErr = explainExpression(expression + 8, NULL, mode, DEFAULT_PROFILE_RUNS);
+            if (explainErr.code != 0) {
+                printf("错误: %s\n", explainErr.message);
+            }
+            continue;
+        }
+        
         if (strcmp(expression, "history") == 0) {
             printf("历史记录：\n");
             for (int i = 0; i < historyCount; i++) {
@@ -128,9 +682,20 @@ int main() {
             continue;
         }
         
-        // 计算结果
-        double result;
-        CalcError err = evaluateExpression(expression, mode, &result);
+        // 计算结果（含方括号的表达式按向量求值）
+        double result = 0;
+        Decimal decimalResult = {0, 0};
+        VectorValue vectorResult = scalarValue(0);
+        int vectorMode = !decimalMode && strchr(expression, '[') != NULL;
+        CalcError err;
+        if (decimalMode) {
+            err = evaluateDecimalExpression(expression, decimalContext, &decimalResult);
+        } else if (vectorMode) {
+            resetVectorArena(&arena);
+            err = evaluateVectorExpression(expression, mode, &arena, &vectorResult);
+        } else {
+            err = evaluateExpression(expression, mode, &result);
+        }
         
         // 显示结果
         if (err.code != 0) {
@@ -154,6 +719,25 @@ int main() {
             } else if (strstr(err.message, "括号")) {
                 printf("提示：请检查括号是否匹配\n");
             }
+        } else if (decimalMode) {
+            char resultStr[50];
+            formatDecimal(decimalResult, resultStr, sizeof(resultStr));
+            printf("%s = %s\n", expression, resultStr);
+            
+            // 添加到历史记录
+            char historyEntry[MAX_EXPR];
+            snprintf(historyEntry, sizeof(historyEntry), "%s = %s", expression, resultStr);
+            addToHistory(history, &historyCount, historyEntry);
+        } else if (vectorMode) {
+            char resultStr[MAX_EXPR * 4];
+            formatVector(&vectorResult, resultStr, sizeof(resultStr));
+            printf("%s = %s\n", expression, resultStr);
+            
+            // 添加到历史记录（较长的向量以 ... 结尾）
+            char historyEntry[MAX_EXPR];
+            formatVector(&vectorResult, resultStr, 50);
+            snprintf(historyEntry, sizeof(historyEntry), "%s = %.49s", expression, resultStr);
+            addToHistory(history, &historyCount, historyEntry);
         } else if (isUndefined(result)) {
             printf("%s = 未定义\n", expression);
             
@@ -181,5 +765,6 @@ int main() {
         }
     }
     
+    freeVectorArena(&arena);
     return 0;
 } 
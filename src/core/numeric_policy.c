@@ -0,0 +1,130 @@
+#include "calculator.h"
+#include "numeric_policy.h"
+#include "vector_value.h"
+
+/**
+ * 不识别特殊角时的函数定义域检查（只按参数判断）
+ */
+static inline ErrorCode functionDomainError(FuncType func, double value) {
+    switch (func) {
+        case FUNC_ASIN:
+        case FUNC_ACOS: return fabs(value) > 1.0 ? ERR_INVALID_ARGUMENT : ERR_SUCCESS;
+        case FUNC_SQRT: return value < 0 ? ERR_INVALID_ARGUMENT : ERR_SUCCESS;
+        case FUNC_LOG:
+        case FUNC_LN:   return value <= 0 ? ERR_INVALID_ARGUMENT : ERR_SUCCESS;
+        default:        return ERR_SUCCESS;
+    }
+}
+
+// ─── 实例 ───────────────────────────────────────────────────────────────────
+
+// 默认策略
+#define POLICY_NAME             Checked
+#define POLICY_OVERFLOW_CHECKS  1
+#define POLICY_DOMAIN_ERRORS    1
+#define POLICY_SNAP_INTEGERS    1
+#define POLICY_SNAP_ANGLES      1
+#include "numeric_policy_template.h"
+
+// IEEE 语义
+#define POLICY_NAME             Ieee
+#define POLICY_OVERFLOW_CHECKS  0
+#define POLICY_DOMAIN_ERRORS    0
+#define POLICY_SNAP_INTEGERS    0
+#define POLICY_SNAP_ANGLES      0
+#include "numeric_policy_template.h"
+
+// ─── 入口 ───────────────────────────────────────────────────────────────────
+
+ErrorCode performPolicyOperation(NumericPolicy policy, char op, double a, double b, double* result) {
+    return policy == POLICY_IEEE ? policyOperationIeee(op, a, b, result)
+                                 : policyOperationChecked(op, a, b, result);
+}
+
+ErrorCode calculatePolicyFunction(NumericPolicy policy, FuncType func, double value, AngleMode mode,
+                                  double* result) {
+    return policy == POLICY_IEEE ? policyFunctionIeee(func, value, mode, result)
+                                 : policyFunctionChecked(func, value, mode, result);
+}
+
+static ErrorCode checkPolicyProgram(const CompiledExpr* prog) {
+    if (prog->length == 0 || prog->maxStack > MAX_EXPR) {
+        return ERR_SYNTAX;
+    }
+    return (prog->isDecimal || prog->isVector) ? ERR_INVALID_ARGUMENT : ERR_SUCCESS;
+}
+
+/**
+ * 按指定策略对单组变量取值求值
+ *
+ * @return POLICY_CHECKED 出错时返回错误代码（调用 diagnoseCompiled 得到消息与位置）；
+ *         POLICY_IEEE 只有表达式本身无效时才返回错误
+ */
+ErrorCode evaluateCompiledPolicy(const CompiledExpr* prog, const double* vars, AngleMode mode,
+                                 NumericPolicy policy, double* result) {
+    ErrorCode code = checkPolicyProgram(prog);
+    if (code != ERR_SUCCESS) {
+        return code;
+    }
+    return policy == POLICY_IEEE ? policyRunIeee(prog, vars, mode, result)
+                                 : policyRunChecked(prog, vars, mode, result);
+}
+
+/**
+ * 按指定策略批量求值：实例在进入循环之前选定
+ *
+ * @param results 输出结果（POLICY_CHECKED 出错的行为 NaN）
+ * @param errors  可选，输出每行的错误代码
+ * @return 全部成功返回 CALC_SUCCESS，否则返回第一个出错行的错误（消息与位置由 diagnoseCompiled 给出）
+ */
+CalcError evaluateCompiledBatchPolicy(const CompiledExpr* prog, const double* const* columns, size_t rows,
+                                      AngleMode mode, NumericPolicy policy, double* results, ErrorCode* errors) {
+    ErrorCode code = checkPolicyProgram(prog);
+    if (code == ERR_SYNTAX) {
+        return CALC_ERROR_CODE(ERR_SYNTAX, "表达式不完整");
+    }
+    if (code != ERR_SUCCESS) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, prog->isVector ? "向量表达式只能按向量求值"
+                                                                    : "十进制模式的表达式只能按十进制求值");
+    }
+
+    size_t stackSize = (size_t)prog->maxStack * BATCH_BLOCK_SIZE * sizeof(double);
+    double* stack = (double*)malloc(stackSize + branchSnapshotSize(prog));
+    if (stack == NULL) {
+        return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+    }
+    unsigned char* snapshots = (unsigned char*)stack + stackSize;
+    void (*block)(const CompiledExpr*, const double* const*, size_t, size_t, AngleMode, double*,
+                  unsigned char*, unsigned char*, double*) = (policy == POLICY_IEEE) ? policyBlockIeee
+                                                                                      : policyBlockChecked;
+
+    unsigned char rowErrors[BATCH_BLOCK_SIZE];
+    size_t firstErrorRow = rows;
+    int firstErrorCode = 0;
+    for (size_t offset = 0; offset < rows; offset += BATCH_BLOCK_SIZE) {
+        size_t count = (rows - offset < BATCH_BLOCK_SIZE) ? rows - offset : BATCH_BLOCK_SIZE;
+        memset(rowErrors, 0, count);
+        block(prog, columns, offset, count, mode, stack, rowErrors, snapshots, results + offset);
+        for (size_t r = 0; r < count; r++) {
+            if (errors) errors[offset + r] = (ErrorCode)rowErrors[r];
+            if (rowErrors[r] && firstErrorRow == rows) {
+                firstErrorRow = offset + r;
+                firstErrorCode = rowErrors[r];
+            }
+        }
+    }
+    free(stack);
+
+    if (firstErrorRow == rows) {
+        return CALC_SUCCESS;
+    }
+    double vars[MAX_COMPILED_VARIABLES];
+    for (int v = 0; v < prog->varCount; v++) {
+        vars[v] = columns[v][firstErrorRow];
+    }
+    CalcError err = diagnoseCompiled(prog, vars, mode);
+    if (err.code == firstErrorCode) {
+        return err;
+    }
+    return CALC_ERROR_CODE(firstErrorCode, getErrorDescription(firstErrorCode));
+}
@@ -0,0 +1,407 @@
+#include "calculator.h"
+#include "numeric_solver.h"
+#include "evaluation_budget.h"
+
+#define KRONROD_POINTS  15
+
+// Gauss-Kronrod 7-15 节点（正半轴，最后一个为中点）与权重
+static const double kronrodNodes[8] = {
+    0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+    0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+    0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+    0.207784955007898467600689403773245, 0.000000000000000000000000000000000,
+};
+static const double kronrodWeights[8] = {
+    0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+    0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+    0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+    0.204432940075298892414161999234649, 0.209482141084727828012999174891714,
+};
+// 7 点 Gauss 权重，对应 kronrodNodes[1]、[3]、[5]、[7]
+static const double gaussWeights[4] = {
+    0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+    0.381830050505118944950369775488975, 0.417959183673469387755102040816327,
+};
+
+// 子区间及其积分与误差估计
+typedef struct {
+    double a;
+    double b;
+    double estimate;
+    double error;
+} Interval;
+
+SolverOptions defaultSolverOptions(SolverType type) {
+    SolverOptions options;
+    if (type == SOLVER_INTEGRATE) {
+        options.tolerance = INTEGRATE_TOLERANCE;
+        options.maxIterations = INTEGRATE_MAX_INTERVALS;
+    } else {
+        options.tolerance = SOLVE_TOLERANCE;
+        options.maxIterations = SOLVE_MAX_ITERATIONS;
+    }
+    return options;
+}
+
+/**
+ * 识别 solve/integrate 的四参数形式（名字大小写不敏感）
+ */
+SolverType getSolverFunction(const char** expr) {
+    const char* p = *expr;
+    char name[10] = {0};
+    int n = 0;
+
+    while (isalpha((unsigned char)*p) && n < 9) {
+        name[n++] = tolower(*p);
+        p++;
+    }
+    if (isalpha((unsigned char)*p)) {
+        return SOLVER_NONE;
+    }
+    SolverType type = strcmp(name, "solve") == 0 ? SOLVER_SOLVE
+                    : strcmp(name, "integrate") == 0 ? SOLVER_INTEGRATE : SOLVER_NONE;
+    if (type == SOLVER_NONE) {
+        return SOLVER_NONE;
+    }
+
+    const char* q = p;
+    while (*q == ' ') q++;
+    if (*q != '(') {
+        return SOLVER_NONE;
+    }
+    int depth = 0, commas = 0;
+    for (q++; *q; q++) {
+        if (*q == '(' || *q == '[') {
+            depth++;
+        } else if (*q == ')' || *q == ']') {
+            if (depth == 0) break;
+            depth--;
+        } else if (*q == ',' && depth == 0) {
+            commas++;
+        }
+    }
+    if (commas != 3) {
+        return SOLVER_NONE;
+    }
+
+    *expr = p;
+    return type;
+}
+
+// 求值预算：每个点计入一次函数体的步数
+static CalcError chargePoints(const VectorFunction* fn, size_t count) {
+    uint64_t steps = fn->prog.cost.steps > 0 ? fn->prog.cost.steps : 1;
+    if (chargeEvaluationBudget(steps * count) != ERR_SUCCESS) {
+        return budgetExceededError(-1);
+    }
+    return CALC_SUCCESS;
+}
+
+// ─── 求根 ───────────────────────────────────────────────────────────────────
+
+static CalcError evaluateAt(const VectorFunction* fn, double x, AngleMode mode, VectorArena* arena, double* y) {
+    CalcError err = chargePoints(fn, 1);
+    if (err.code != 0) {
+        return err;
+    }
+    return evaluateVectorFunction(fn, &x, 1, mode, arena, y);
+}
+
+/**
+ * Brent 方法求根：反二次插值 / 割线，步长不理想时退回二分
+ *
+ * @param fn      以 compileVectorFunction 编译的函数
+ * @param lo, hi  有根区间，f(lo) 与 f(hi) 必须异号（或其中之一为 0）
+ * @param options 容差与求值次数上限（NULL 使用默认值）
+ * @param root    输出的根
+ * @return 成功返回 CALC_SUCCESS；未在预算内收敛返回 ERR_UNDEFINED
+ */
+CalcError solveFunction(const VectorFunction* fn, double lo, double hi, AngleMode mode,
+                        const SolverOptions* options, double* root) {
+    SolverOptions defaults = defaultSolverOptions(SOLVER_SOLVE);
+    if (options == NULL) options = &defaults;
+    if (!isfinite(lo) || !isfinite(hi)) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "求根区间必须是有限数");
+    }
+
+    VectorArena arena;
+    initVectorArena(&arena);
+    double a = lo, b = hi, fa, fb;
+    CalcError err = evaluateAt(fn, a, mode, &arena, &fa);
+    if (err.code == 0) err = evaluateAt(fn, b, mode, &arena, &fb);
+    int evaluations = 2;
+    if (err.code == 0 && ((fa > 0 && fb > 0) || (fa < 0 && fb < 0))) {
+        err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "求根区间两端的函数值必须异号");
+    }
+
+    double c = a, fc = fa, d = b - a, e = d;
+    while (err.code == 0) {
+        if ((fb > 0 && fc > 0) || (fb < 0 && fc < 0)) {
+            c = a;
+            fc = fa;
+            d = e = b - a;
+        }
+        // 保证 b 是目前最好的近似
+        if (fabs(fc) < fabs(fb)) {
+            a = b; b = c; c = a;
+            fa = fb; fb = fc; fc = fa;
+        }
+        double tol = 2 * DBL_EPSILON * fabs(b) + 0.5 * options->tolerance;
+        double middle = 0.5 * (c - b);
+        if (fabs(middle) <= tol || fb == 0) {
+            *root = b;
+            break;
+        }
+        if (evaluations >= options->maxIterations) {
+            err = CALC_ERROR_CODE(ERR_UNDEFINED, "求根未在迭代次数内收敛");
+            break;
+        }
+
+        if (fabs(e) >= tol && fabs(fa) > fabs(fb)) {
+            double s = fb / fa, p, q;
+            if (a == c) {
+                // 割线
+                p = 2 * middle * s;
+                q = 1 - s;
+            } else {
+                // 反二次插值
+                double r;
+                q = fa / fc;
+                r = fb / fc;
+                p = s * (2 * middle * q * (q - r) - (b - a) * (r - 1));
+                q = (q - 1) * (r - 1) * (s - 1);
+            }
+            if (p > 0) q = -q;
+            p = fabs(p);
+            double bound1 = 3 * middle * q - fabs(tol * q);
+            double bound2 = fabs(e * q);
+            if (2 * p < (bound1 < bound2 ? bound1 : bound2)) {
+                e = d;
+                d = p / q;
+            } else {
+                d = middle;
+                e = d;
+            }
+        } else {
+            d = middle;
+            e = d;
+        }
+
+        a = b;
+        fa = fb;
+        b += fabs(d) > tol ? d : copysign(tol, middle);
+        err = evaluateAt(fn, b, mode, &arena, &fb);
+        evaluations++;
+    }
+
+    freeVectorArena(&arena);
+    return err;
+}
+
+// ─── 积分 ───────────────────────────────────────────────────────────────────
+
+// 区间的 15 个节点：中点在前，然后是 c - h·x、c + h·x
+static void fillNodes(const Interval* interval, double* x) {
+    double center = 0.5 * (interval->a + interval->b);
+    double half = 0.5 * (interval->b - interval->a);
+    x[0] = center;
+    for (int j = 0; j < 7; j++) {
+        x[1 + 2 * j] = center - half * kronrodNodes[j];
+        x[2 + 2 * j] = center + half * kronrodNodes[j];
+    }
+}
+
+// 由节点函数值计算 Kronrod 积分与误差估计（QUADPACK qk15）
+static void kronrodRule(Interval* interval, const double* f) {
+    double half = 0.5 * (interval->b - interval->a);
+    double kronrod = kronrodWeights[7] * f[0];
+    double gauss = gaussWeights[3] * f[0];
+    double absolute = fabs(kronrod);
+
+    for (int j = 0; j < 7; j++) {
+        double pair = f[1 + 2 * j] + f[2 + 2 * j];
+        kronrod += kronrodWeights[j] * pair;
+        absolute += kronrodWeights[j] * (fabs(f[1 + 2 * j]) + fabs(f[2 + 2 * j]));
+        if (j % 2 == 1) {
+            gauss += gaussWeights[j / 2] * pair;
+        }
+    }
+    double mean = 0.5 * kronrod;
+    double deviation = kronrodWeights[7] * fabs(f[0] - mean);
+    for (int j = 0; j < 7; j++) {
+        deviation += kronrodWeights[j] * (fabs(f[1 + 2 * j] - mean) + fabs(f[2 + 2 * j] - mean));
+    }
+
+    double scale = fabs(half);
+    double err = fabs((kronrod - gauss) * half);
+    deviation *= scale;
+    absolute *= scale;
+    if (deviation != 0 && err != 0) {
+        double ratio = pow(200 * err / deviation, 1.5);
+        err = deviation * (ratio < 1 ? ratio : 1);
+    }
+    if (absolute > DBL_MIN / (50 * DBL_EPSILON) && err < 50 * DBL_EPSILON * absolute) {
+        err = 50 * DBL_EPSILON * absolute;
+    }
+    interval->estimate = kronrod * half;
+    interval->error = err;
+}
+
+/**
+ * 对 intervals[indices[0..count)] 求值：全部节点拼成一个向量整体求函数值
+ */
+static CalcError evaluateIntervals(const VectorFunction* fn, Interval* intervals, const size_t* indices,
+                                   size_t count, AngleMode mode, VectorArena* arena, double* x, double* f) {
+    for (size_t i = 0; i < count; i++) {
+        fillNodes(&intervals[indices[i]], x + i * KRONROD_POINTS);
+    }
+    CalcError err = chargePoints(fn, count * KRONROD_POINTS);
+    if (err.code == 0) {
+        err = evaluateVectorFunction(fn, x, count * KRONROD_POINTS, mode, arena, f);
+    }
+    if (err.code != 0) {
+        return err;
+    }
+    for (size_t i = 0; i < count; i++) {
+        kronrodRule(&intervals[indices[i]], f + i * KRONROD_POINTS);
+    }
+    return CALC_SUCCESS;
+}
+
+/**
+ * 全局自适应 Gauss-Kronrod 积分
+ * 每一轮：误差估计总和未达到容差时，把误差超过平均份额（容差 / 子区间数）的子区间
+ * 二等分，本轮新子区间的节点一次求值
+ *
+ * @param fn      以 compileVectorFunction 编译的函数
+ * @param a, b    积分区间（a > b 时结果取负）
+ * @param options 容差与子区间数上限（NULL 使用默认值）
+ * @param result  输出的积分值
+ * @return 成功返回 CALC_SUCCESS；子区间数超出预算或无法再细分时返回 ERR_UNDEFINED
+ */
+CalcError integrateFunction(const VectorFunction* fn, double a, double b, AngleMode mode,
+                            const SolverOptions* options, double* result) {
+    SolverOptions defaults = defaultSolverOptions(SOLVER_INTEGRATE);
+    if (options == NULL) options = &defaults;
+    if (!isfinite(a) || !isfinite(b)) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "积分区间必须是有限数");
+    }
+    if (a == b) {
+        *result = 0;
+        return CALC_SUCCESS;
+    }
+    if (options->maxIterations < 1) {
+        return CALC_ERROR_CODE(ERR_UNDEFINED, "积分未在子区间数上限内收敛");
+    }
+    double sign = 1;
+    if (a > b) {
+        double t = a; a = b; b = t;
+        sign = -1;
+    }
+
+    // 子区间总数（含已被细分的）不超过预算，所有缓冲区按预算一次分配
+    size_t capacity = (size_t)options->maxIterations;
+    Interval* intervals = (Interval*)malloc(capacity * sizeof(Interval));
+    size_t* indices = (size_t*)malloc(capacity * sizeof(size_t));
+    double* x = (double*)malloc(capacity * 2 * KRONROD_POINTS * sizeof(double));
+    if (intervals == NULL || indices == NULL || x == NULL) {
+        free(intervals);
+        free(indices);
+        free(x);
+        return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+    }
+    double* f = x + capacity * KRONROD_POINTS;
+
+    VectorArena arena;
+    initVectorArena(&arena);
+    intervals[0].a = a;
+    intervals[0].b = b;
+    indices[0] = 0;
+    size_t count = 1, evaluated = 1;
+    CalcError err = evaluateIntervals(fn, intervals, indices, 1, mode, &arena, x, f);
+
+    while (err.code == 0) {
+        // Neumaier 补偿累加
+        double total = 0, compensation = 0, totalError = 0;
+        for (size_t i = 0; i < count; i++) {
+            double value = intervals[i].estimate;
+            double t = total + value;
+            if (fabs(total) >= fabs(value)) {
+                compensation += (total - t) + value;
+            } else {
+                compensation += (value - t) + total;
+            }
+            total = t;
+            totalError += intervals[i].error;
+        }
+        total += compensation;
+        double tolerance = options->tolerance * (fabs(total) > 1 ? fabs(total) : 1);
+        if (totalError <= tolerance) {
+            *result = sign * total;
+            break;
+        }
+
+        // 细分误差超过平均份额的子区间：左半替换原区间，右半追加到末尾
+        double share = tolerance / (double)count;
+        size_t fresh = 0, active = count;
+        for (size_t i = 0; i < active && err.code == 0; i++) {
+            Interval* interval = &intervals[i];
+            double middle = 0.5 * (interval->a + interval->b);
+            if (interval->error <= share || !(middle > interval->a && middle < interval->b)) {
+                continue;
+            }
+            if (evaluated + 2 > capacity) {
+                err = CALC_ERROR_CODE(ERR_UNDEFINED, "积分未在子区间数上限内收敛");
+                break;
+            }
+            intervals[count].a = middle;
+            intervals[count].b = interval->b;
+            interval->b = middle;
+            indices[fresh++] = i;
+            indices[fresh++] = count++;
+            evaluated += 2;
+        }
+        if (err.code == 0 && fresh == 0) {
+            err = CALC_ERROR_CODE(ERR_UNDEFINED, "积分未收敛");
+        }
+        if (err.code == 0) {
+            err = evaluateIntervals(fn, intervals, indices, fresh, mode, &arena, x, f);
+        }
+    }
+
+    freeVectorArena(&arena);
+    free(intervals);
+    free(indices);
+    free(x);
+    return err;
+}
+
+/**
+ * 编译 body 并求根或积分，结果与普通函数一样做接近整数的修正
+ */
+CalcError evaluateSolver(SolverType type, const char* body, size_t bodyLen, const char* name, size_t nameLen,
+                         double lo, double hi, AngleMode mode, const SolverOptions* options, double* result) {
+    VectorFunction fn;
+    CalcError err = compileVectorFunction(body, bodyLen, name, nameLen, &fn);
+    if (err.code != 0) {
+        return err;
+    }
+    if (type == SOLVER_SOLVE) {
+        err = solveFunction(&fn, lo, hi, mode, options, result);
+    } else {
+        err = integrateFunction(&fn, lo, hi, mode, options, result);
+    }
+    freeVectorFunction(&fn);
+    if (err.code != 0) {
+        return err;
+    }
+
+    if (!isfinite(*result)) {
+        return CALC_ERROR_CODE(ERR_OVERFLOW, "计算结果太大");
+    }
+    int64_t intValue;
+    if (isCloseToInteger(*result, &intValue)) {
+        *result = intValue;
+    }
+    return CALC_SUCCESS;
+}
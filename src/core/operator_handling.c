@@ -1,7 +1,83 @@
 #include "calculator.h"
+#include "evaluation_budget.h"
 
-// 执行基本运算
-CalcError performOperation(char op, double a, double b, double* result) {
+/**
+ * 整数幂运算（平方求幂，带溢出检查）
+ * @return 1 表示结果精确，0 表示溢出
+ */
+static int integerPower(int64_t base, int64_t exponent, int64_t* result) {
+    int64_t acc = 1;
+    while (exponent > 0) {
+        if (exponent & 1) {
+            if (__builtin_mul_overflow(acc, base, &acc)) return 0;
+        }
+        exponent >>= 1;
+        if (exponent > 0 && __builtin_mul_overflow(base, base, &base)) return 0;
+    }
+    *result = acc;
+    return 1;
+}
+
+/**
+ * 整数快速路径：在 int64_t 上执行 + - * / ^，使用溢出检查内建函数
+ * 
+ * @return 1 表示得到精确的整数结果；0 表示需要回退到双精度计算
+ *         （溢出、除不尽、负指数、除数为0等，错误由双精度路径报告）
+ */
+int performIntegerOperation(char op, int64_t a, int64_t b, int64_t* result) {
+#if defined(__GNUC__) || defined(__clang__)
+    switch (op) {
+        case '+':
+            return !__builtin_add_overflow(a, b, result);
+        case '-':
+            return !__builtin_sub_overflow(a, b, result);
+        case '*':
+            return !__builtin_mul_overflow(a, b, result);
+        case '/':
+            // 只处理能整除的情况（INT64_MIN / -1 会溢出）
+            if (b == 0 || (a == INT64_MIN && b == -1) || a % b != 0) {
+                return 0;
+            }
+            *result = a / b;
+            return 1;
+        case '^':
+            if (b < 0) {
+                return 0;
+            }
+            return integerPower(a, b, result);
+        default:
+            return 0;
+    }
+#else
+    (void)op; (void)a; (void)b; (void)result;
+    return 0;
+#endif
+}
+
+/**
+ * 比较与逻辑运算：op 为 < > 或 OPERATOR_LE / GE / EQ / NE / AND / OR
+ * 按双精度精确比较（与 C 的比较运算相同，NaN 只满足 !=）；逻辑运算非 0 为真
+ *
+ * @return 成立返回 1，否则返回 0
+ */
+int compareOperands(char op, double a, double b) {
+    switch (op) {
+        case '<':          return a < b;
+        case '>':          return a > b;
+        case OPERATOR_LE:  return a <= b;
+        case OPERATOR_GE:  return a >= b;
+        case OPERATOR_EQ:  return a == b;
+        case OPERATOR_NE:  return a != b;
+        case OPERATOR_AND: return a != 0 && b != 0;
+        case OPERATOR_OR:  return a != 0 || b != 0;
+        default:           return 0;
+    }
+}
+
+/**
+ * 双精度运算（不做整数快速路径与接近整数修正）
+ */
+ErrorCode performFloatOperation(char op, double a, double b, double* result) {
     switch (op) {
         case '+':
             *result = a + b;
@@ -14,28 +90,55 @@ CalcError performOperation(char op, double a, double b, double* result) {
             break;
         case '/':
             if (fabs(b) < ABSOLUTE_ZERO_THRESHOLD) {
-                return CALC_ERROR_CODE(ERR_DIV_BY_ZERO, "除数不能为0");
+                return ERR_DIV_BY_ZERO;
             }
             *result = a / b;
             break;
         case '^':
-            // 处理特殊情况：0的负数次幂
-            if (fabs(a) < ABSOLUTE_ZERO_THRESHOLD && b < 0) {
-                return CALC_ERROR_CODE(ERR_UNDEFINED, "0的负数次幂未定义");
-            }
-            // 处理特殊情况：负数的小数次幂
-            if (a < 0 && fabs(b - (int64_t)b) > EPSILON) {
-                return CALC_ERROR_CODE(ERR_UNDEFINED, "负数不能开非整数次方根");
+            // 0的负数次幂、负数的小数次幂无定义
+            if ((fabs(a) < ABSOLUTE_ZERO_THRESHOLD && b < 0) ||
+                (a < 0 && fabs(b - (int64_t)b) > EPSILON)) {
+                return ERR_UNDEFINED;
             }
             *result = pow(a, b);
             break;
+        case '<':
+        case '>':
+        case OPERATOR_LE:
+        case OPERATOR_GE:
+        case OPERATOR_EQ:
+        case OPERATOR_NE:
+        case OPERATOR_AND:
+        case OPERATOR_OR:
+            *result = compareOperands(op, a, b);
+            return ERR_SUCCESS;
         default:
-            return CALC_ERROR_CODE(ERR_SYNTAX, "无效的运算符");
+            return ERR_SYNTAX;
     }
     
     // 处理溢出和无穷大
     if (isInfinite(*result)) {
-        return CALC_ERROR_CODE(ERR_OVERFLOW, "计算结果太大");
+        return ERR_OVERFLOW;
+    }
+    return ERR_SUCCESS;
+}
+
+/**
+ * 执行基本运算（快速路径：只返回错误代码，不构造错误消息）
+ */
+ErrorCode performOperationCode(char op, double a, double b, double* result) {
+    // 整数快速路径：操作数都是整数且结果在 2^53 以内时，结果精确，无需 pow() 和接近整数修正
+    int64_t intA, intB, intResult;
+    if (doubleToExactInt64(a, &intA) && doubleToExactInt64(b, &intB) &&
+        performIntegerOperation(op, intA, intB, &intResult) &&
+        intResult >= -MAX_EXACT_DOUBLE_INTEGER && intResult <= MAX_EXACT_DOUBLE_INTEGER) {
+        *result = (double)intResult;
+        return ERR_SUCCESS;
+    }
+    
+    ErrorCode code = performFloatOperation(op, a, b, result);
+    if (code != ERR_SUCCESS) {
+        return code;
     }
     
     // 处理接近整数的浮点数
@@ -44,6 +147,33 @@ CalcError performOperation(char op, double a, double b, double* result) {
         *result = intValue;
     }
     
+    return ERR_SUCCESS;
+}
+
+/**
+ * 运算出错时的错误消息（只在出错后调用，根据操作数区分同一错误代码的不同原因）
+ */
+const char* describeOperationError(double a, double b, ErrorCode code) {
+    switch (code) {
+        case ERR_DIV_BY_ZERO:
+            return "除数不能为0";
+        case ERR_UNDEFINED:
+            return (fabs(a) < ABSOLUTE_ZERO_THRESHOLD && b < 0) ? "0的负数次幂未定义" : "负数不能开非整数次方根";
+        case ERR_OVERFLOW:
+            return "计算结果太大";
+        case ERR_SYNTAX:
+            return "无效的运算符";
+        default:
+            return getErrorDescription(code);
+    }
+}
+
+// 执行基本运算
+CalcError performOperation(char op, double a, double b, double* result) {
+    ErrorCode code = performOperationCode(op, a, b, result);
+    if (code != ERR_SUCCESS) {
+        return CALC_ERROR_CODE(code, describeOperationError(a, b, code));
+    }
     return CALC_SUCCESS;
 }
 
@@ -56,8 +186,8 @@ CalcError processOperators(double* numbers, int* numTop, char* operators, int* o
     while (*opTop >= 0) {
         char stackOp = operators[*opTop];
         
-        // 如果栈顶是左括号，停止处理（用于右括号匹配）
-        if (stackOp == '(') {
+        // 如果栈顶是左括号或 ? 的标记，停止处理（用于右括号与 : 的匹配）
+        if (stackOp == '(' || stackOp == OPERATOR_COND) {
             break;
         }
         
@@ -81,9 +211,25 @@ CalcError processOperators(double* numbers, int* numTop, char* operators, int* o
         
         if (!shouldProcess) break;
         
+        // not 是前缀一元运算符
+        if (stackOp == OPERATOR_NOT) {
+            if (*numTop < 0) {
+                return CALC_ERROR_CODE(ERR_SYNTAX, "运算符使用不正确");
+            }
+            if (chargeEvaluationBudget(1) != ERR_SUCCESS) {
+                return budgetExceededError(-1);
+            }
+            (*opTop)--;
+            numbers[*numTop] = numbers[*numTop] == 0;
+            continue;
+        }
+        
         if (*numTop < 1) {
             return CALC_ERROR_CODE(ERR_SYNTAX, "运算符使用不正确");
         }
+        if (chargeEvaluationBudget(1) != ERR_SUCCESS) {
+            return budgetExceededError(-1);
+        }
         
         double b = numbers[(*numTop)--];
         double a = numbers[(*numTop)--];
@@ -0,0 +1,696 @@
+#include "calculator.h"
+#include "polynomial_evaluator.h"
+
+// 验证用的采样点（避开 0 和 ±1 之外的整数，减少接近整数修正的影响）
+static const double kSamplePoints[] = {-2.75, -1.3, -1, -0.45, 0.2, 0.85, 1.6, 3.4};
+
+// ─── 识别 ───────────────────────────────────────────────────────────────────
+
+typedef enum {
+    SYMBOL_OTHER,           // 不是多项式
+    SYMBOL_POLYNOMIAL,
+    SYMBOL_RATIONAL
+} SymbolKind;
+
+// 字节码栈上一个值的符号形式
+typedef struct {
+    int start;              // 子树第一条指令
+    SymbolKind kind;
+    int slot;               // 自变量槽位，常量为 -1
+    int degree;
+    int denominatorDegree;
+    double numerator[MAX_POLYNOMIAL_DEGREE + 1];
+    double denominator[MAX_POLYNOMIAL_DEGREE + 1];
+    // 原指令的每一步是否都是整数运算（常量、系数与中间结果都是整数）
+    int exact;
+    // 原指令中间结果绝对值的上界：系数非负的多项式，在 |x| 处取值（exact 时有效）
+    int boundDegree;
+    int denominatorBoundDegree;
+    double bound[MAX_POLYNOMIAL_DEGREE + 1];
+    double denominatorBound[MAX_POLYNOMIAL_DEGREE + 1];
+} Symbol;
+
+// 收集到的候选子树
+typedef struct {
+    PolynomialPlan* plans;
+    int count;
+    int capacity;
+} PlanList;
+
+static void setConstant(Symbol* s, double value) {
+    s->kind = SYMBOL_POLYNOMIAL;
+    s->slot = -1;
+    s->degree = 0;
+    s->denominatorDegree = 0;
+    s->numerator[0] = value;
+}
+
+static int isIntegralPolynomial(const double* c, int degree) {
+    int64_t unused;
+    for (int k = 0; k <= degree; k++) {
+        if (!doubleToExactInt64(c[k], &unused)) return 0;
+    }
+    return 1;
+}
+
+// a += b（上界多项式）
+static void addBound(double* a, int* aDegree, const double* b, int bDegree) {
+    for (int k = *aDegree + 1; k <= bDegree; k++) a[k] = 0;
+    for (int k = 0; k <= bDegree; k++) a[k] += b[k];
+    if (bDegree > *aDegree) *aDegree = bDegree;
+}
+
+// out = a·b（上界多项式），次数超出上限时返回 0
+static int multiplyBound(const double* a, int aDegree, const double* b, int bDegree, double* out, int* outDegree) {
+    if (aDegree + bDegree > MAX_POLYNOMIAL_DEGREE) {
+        return 0;
+    }
+    double product[MAX_POLYNOMIAL_DEGREE + 1] = {0};
+    for (int i = 0; i <= aDegree; i++) {
+        for (int j = 0; j <= bDegree; j++) product[i + j] += a[i] * b[j];
+    }
+    *outDegree = aDegree + bDegree;
+    memcpy(out, product, (size_t)(*outDegree + 1) * sizeof(double));
+    return 1;
+}
+
+/**
+ * 二元运算之后更新 a 的上界与 exact 标志（a 的系数已是运算结果，上界仍是运算前的）
+ * 上界覆盖两个操作数与结果：|a ± b|、|a / c|（整数 c）都不超过 Ba + Bb，
+ * |a·b| ≤ Ba·Bb，|a^n| ≤ Ba^n；各项取和，因此也覆盖操作数内部的中间结果
+ */
+static void combineBounds(Symbol* a, const Symbol* b, int op) {
+    if (!a->exact || !b->exact || !isIntegralPolynomial(a->numerator, a->degree)) {
+        a->exact = 0;
+        return;
+    }
+    if (a->kind == SYMBOL_RATIONAL) {
+        a->denominatorBoundDegree = b->boundDegree;
+        memcpy(a->denominatorBound, b->bound, (size_t)(b->boundDegree + 1) * sizeof(double));
+        return;
+    }
+
+    double extra[MAX_POLYNOMIAL_DEGREE + 1];
+    int extraDegree = 0;
+    if (op == OP_MUL) {
+        a->exact = multiplyBound(a->bound, a->boundDegree, b->bound, b->boundDegree, extra, &extraDegree);
+    } else if (op == OP_POW) {
+        extra[0] = 1;
+        for (int n = (int)b->numerator[0]; a->exact && n > 0; n--) {
+            a->exact = multiplyBound(extra, extraDegree, a->bound, a->boundDegree, extra, &extraDegree);
+        }
+    } else {
+        extra[0] = fabs(a->numerator[0]);  // 常量之间的运算：结果本身
+        extraDegree = 0;
+    }
+    addBound(a->bound, &a->boundDegree, b->bound, b->boundDegree);
+    addBound(a->bound, &a->boundDegree, extra, extraDegree);
+}
+
+static int isConstant(const Symbol* s) {
+    return s->kind == SYMBOL_POLYNOMIAL && s->degree == 0;
+}
+
+// 非零系数个数不超过 1（单项式 c*x^k）
+static int isMonomial(const Symbol* s) {
+    int terms = 0;
+    for (int k = 0; k <= s->degree; k++) {
+        if (s->numerator[k] != 0) terms++;
+    }
+    return terms <= 1;
+}
+
+// 两个多项式的自变量是否一致（常量与任何变量一致）
+static int mergeSlot(const Symbol* a, const Symbol* b, int* slot) {
+    if (a->slot >= 0 && b->slot >= 0 && a->slot != b->slot) {
+        return 0;
+    }
+    *slot = a->slot >= 0 ? a->slot : b->slot;
+    return 1;
+}
+
+// 去掉为 0 的最高次系数，退化为常量时不再关联变量
+static void trimDegree(Symbol* s) {
+    while (s->degree > 0 && s->numerator[s->degree] == 0) {
+        s->degree--;
+    }
+    if (s->degree == 0) {
+        s->slot = -1;
+    }
+}
+
+/**
+ * 子树结束时，如果它是值得改写的多项式/有理式则记录为候选
+ */
+static void finishSymbol(const Symbol* s, int end, PlanList* list) {
+    if (s->slot < 0 || list->count >= list->capacity) {
+        return;
+    }
+    if (!(s->kind == SYMBOL_RATIONAL || (s->kind == SYMBOL_POLYNOMIAL && s->degree >= 2))) {
+        return;
+    }
+
+    PolynomialPlan* plan = &list->plans[list->count++];
+    memset(plan, 0, sizeof(*plan));
+    plan->start = s->start;
+    plan->end = end;
+    plan->slot = s->slot;
+    plan->degree = s->degree;
+    plan->isRational = s->kind == SYMBOL_RATIONAL;
+    memcpy(plan->numerator, s->numerator, (size_t)(s->degree + 1) * sizeof(double));
+    if (plan->isRational) {
+        plan->denominatorDegree = s->denominatorDegree;
+        memcpy(plan->denominator, s->denominator, (size_t)(s->denominatorDegree + 1) * sizeof(double));
+    } else {
+        plan->denominator[0] = 1;
+    }
+
+    // 精确形式需要原指令每一步都是整数运算，且系数与上界都能放进 int64_t
+    // （不是整数运算时上界没有维护，不能读取）
+    if (!s->exact) {
+        return;
+    }
+    plan->isExact = 1;
+    plan->boundDegree = s->boundDegree;
+    for (int k = 0; k <= plan->degree; k++) {
+        plan->isExact &= doubleToExactInt64(plan->numerator[k], &plan->integerNumerator[k]);
+    }
+    for (int k = 0; k <= s->boundDegree; k++) {
+        plan->isExact &= doubleToExactInt64(s->bound[k], &plan->integerBound[k]);
+    }
+    if (plan->isRational) {
+        plan->denominatorBoundDegree = s->denominatorBoundDegree;
+        for (int k = 0; k <= plan->denominatorDegree; k++) {
+            plan->isExact &= doubleToExactInt64(plan->denominator[k], &plan->integerDenominator[k]);
+        }
+        for (int k = 0; k <= s->denominatorBoundDegree; k++) {
+            plan->isExact &= doubleToExactInt64(s->denominatorBound[k], &plan->integerDenominatorBound[k]);
+        }
+    }
+}
+
+/**
+ * 二元运算：常量之间按 performOperationCode 计算，与原指令的修正一致
+ * 得到的不是多项式时 a 变为 SYMBOL_OTHER
+ */
+static void combineCoefficients(Symbol* a, const Symbol* b, int op) {
+    int slot;
+
+    if (a->kind != SYMBOL_POLYNOMIAL || b->kind != SYMBOL_POLYNOMIAL || !mergeSlot(a, b, &slot)) {
+        a->kind = SYMBOL_OTHER;
+        return;
+    }
+    if (isConstant(a) && isConstant(b)) {
+        double value;
+        if (performOperationCode(opcodeToOperator(op), a->numerator[0], b->numerator[0], &value) != ERR_SUCCESS) {
+            a->kind = SYMBOL_OTHER;
+            return;
+        }
+        setConstant(a, value);
+        return;
+    }
+
+    switch (op) {
+        case OP_ADD:
+        case OP_SUB: {
+            double sign = (op == OP_ADD) ? 1 : -1;
+            for (int k = a->degree + 1; k <= b->degree; k++) a->numerator[k] = 0;
+            for (int k = 0; k <= b->degree; k++) a->numerator[k] += sign * b->numerator[k];
+            if (b->degree > a->degree) a->degree = b->degree;
+            a->slot = slot;
+            trimDegree(a);
+            return;
+        }
+
+        case OP_MUL: {
+            // 只乘单项式：系数逐个相乘，不展开两个多项式的乘积
+            if ((!isMonomial(a) && !isMonomial(b)) || a->degree + b->degree > MAX_POLYNOMIAL_DEGREE) {
+                break;
+            }
+            double product[MAX_POLYNOMIAL_DEGREE + 1] = {0};
+            for (int i = 0; i <= a->degree; i++) {
+                if (a->numerator[i] == 0) continue;
+                for (int j = 0; j <= b->degree; j++) {
+                    product[i + j] += a->numerator[i] * b->numerator[j];
+                }
+            }
+            a->degree += b->degree;
+            memcpy(a->numerator, product, (size_t)(a->degree + 1) * sizeof(double));
+            a->slot = slot;
+            trimDegree(a);
+            return;
+        }
+
+        case OP_DIV:
+            if (isConstant(b)) {
+                if (fabs(b->numerator[0]) < ABSOLUTE_ZERO_THRESHOLD) break;
+                for (int k = 0; k <= a->degree; k++) a->numerator[k] /= b->numerator[0];
+                return;
+            }
+            // 多项式 / 多项式
+            a->kind = SYMBOL_RATIONAL;
+            a->slot = slot;
+            a->denominatorDegree = b->degree;
+            memcpy(a->denominator, b->numerator, (size_t)(b->degree + 1) * sizeof(double));
+            return;
+
+        case OP_POW: {
+            // 单项式的非负整数次幂
+            double exponent = b->numerator[0];
+            if (!isConstant(b) || !isMonomial(a) || exponent < 0 || exponent != floor(exponent) ||
+                a->degree * exponent > MAX_POLYNOMIAL_DEGREE) {
+                break;
+            }
+            int n = (int)exponent;
+            if (n == 0) {
+                setConstant(a, 1);
+                return;
+            }
+            double coefficient;
+            if (performOperationCode('^', a->numerator[a->degree], exponent, &coefficient) != ERR_SUCCESS) {
+                break;
+            }
+            int degree = a->degree * n;
+            memset(a->numerator, 0, (size_t)(degree + 1) * sizeof(double));
+            a->numerator[degree] = coefficient;
+            a->degree = degree;
+            return;
+        }
+
+        default:
+            break;
+    }
+    a->kind = SYMBOL_OTHER;
+}
+
+static void combineSymbols(Symbol* a, const Symbol* b, int op) {
+    combineCoefficients(a, b, op);
+    if (a->kind != SYMBOL_OTHER) {
+        combineBounds(a, b, op);
+    }
+}
+
+/**
+ * 在后缀字节码上模拟求值，得到每个子树的符号形式，收集最大的多项式子树
+ */
+static int findPolynomials(const CompiledExpr* prog, PlanList* list) {
+    Symbol* stack = (Symbol*)malloc((size_t)prog->maxStack * sizeof(Symbol));
+    if (stack == NULL) {
+        return 0;
+    }
+    int top = -1;
+
+    for (int i = 0; i < prog->length; i++) {
+        const Instruction* ins = &prog->code[i];
+        Symbol* s;
+
+        switch (ins->op) {
+            case OP_CONST:
+                s = &stack[++top];
+                setConstant(s, ins->value);
+                s->start = i;
+                s->exact = isIntegralPolynomial(&ins->value, 0);
+                s->boundDegree = 0;
+                s->bound[0] = fabs(ins->value);
+                break;
+
+            case OP_VAR:
+                s = &stack[++top];
+                s->start = i;
+                s->kind = SYMBOL_POLYNOMIAL;
+                s->slot = ins->slot;
+                s->degree = 1;
+                s->denominatorDegree = 0;
+                s->numerator[0] = 0;
+                s->numerator[1] = 1;
+                s->exact = 1;
+                s->boundDegree = 1;
+                s->bound[0] = 0;
+                s->bound[1] = 1;
+                break;
+
+            case OP_NEG:
+                s = &stack[top];
+                if (s->kind != SYMBOL_OTHER) {
+                    for (int k = 0; k <= s->degree; k++) s->numerator[k] = -s->numerator[k];
+                }
+                break;
+
+            case OP_CALL:
+            case OP_NOT:
+            case OP_BRANCH:
+            case OP_JUMP:
+                // 子树不跨越跳转：条件与分支各自在跳转指令之前结束
+                finishSymbol(&stack[top], i, list);
+                stack[top].kind = SYMBOL_OTHER;
+                break;
+
+            case OP_SELECT:
+                finishSymbol(&stack[top], i, list);
+                top -= 2;
+                stack[top].kind = SYMBOL_OTHER;
+                break;
+
+            case OP_PACK:
+            case OP_REDUCE: {
+                int first = top - ins->slot + 1;
+                for (int k = first; k <= top; k++) {
+                    finishSymbol(&stack[k], k < top ? stack[k + 1].start : i, list);
+                }
+                top = first;
+                stack[top].kind = SYMBOL_OTHER;
+                break;
+            }
+
+            default: {
+                Symbol* a = &stack[top - 1];
+                Symbol* b = &stack[top];
+                Symbol before = *a;
+                combineSymbols(a, b, ins->op);
+                if (a->kind == SYMBOL_OTHER) {
+                    finishSymbol(&before, b->start, list);
+                    finishSymbol(b, i, list);
+                }
+                top--;
+                break;
+            }
+        }
+    }
+    if (top == 0) {
+        finishSymbol(&stack[0], prog->length, list);
+    }
+    free(stack);
+    return 1;
+}
+
+// ─── 求值 ───────────────────────────────────────────────────────────────────
+
+// int64_t 上的 Horner 形式，溢出时返回 0
+static int hornerInteger(const int64_t* c, int degree, int64_t x, int64_t* result) {
+    int64_t sum = c[degree];
+    for (int k = degree - 1; k >= 0; k--) {
+        if (!performIntegerOperation('*', sum, x, &sum) || !performIntegerOperation('+', sum, c[k], &sum)) {
+            return 0;
+        }
+    }
+    *result = sum;
+    return 1;
+}
+
+// 上界多项式在 |x| 处的值不超过 2^53
+static int withinExactRange(const int64_t* bound, int degree, int64_t magnitude) {
+    int64_t value;
+    return hornerInteger(bound, degree, magnitude, &value) && value <= MAX_EXACT_DOUBLE_INTEGER;
+}
+
+/**
+ * 精确形式：原指令每一步都是整数运算、自变量为整数且中间结果都不超过 2^53 时，
+ * 原指令的单行求值（int64_t）与批量求值（双精度）都没有舍入，结果就是精确整数运算的结果，
+ * 这里在 int64_t 上按 Horner 形式算出同一个值。条件不满足时返回 0
+ */
+static int evaluateExactForm(const PolynomialPlan* plan, double x, CalcNumber* result) {
+    int64_t intX;
+    if (!doubleToExactInt64(x, &intX) || fabs(x) > (double)MAX_EXACT_DOUBLE_INTEGER) {
+        return 0;
+    }
+    int64_t magnitude = intX < 0 ? -intX : intX;
+    if (!withinExactRange(plan->integerBound, plan->boundDegree, magnitude) ||
+        (plan->isRational &&
+         !withinExactRange(plan->integerDenominatorBound, plan->denominatorBoundDegree, magnitude))) {
+        return 0;
+    }
+
+    int64_t p, q = 1;
+    if (!hornerInteger(plan->integerNumerator, plan->degree, intX, &p) ||
+        (plan->isRational && !hornerInteger(plan->integerDenominator, plan->denominatorDegree, intX, &q)) ||
+        q == 0) {
+        return 0;
+    }
+    int64_t quotient;
+    if (performIntegerOperation('/', p, q, &quotient)) {
+        result->value = (double)quotient;
+        result->intValue = quotient;
+        result->isInteger = 1;
+        return 1;
+    }
+    // 除不尽：与原指令一样转为双精度相除
+    if (performOperationCode('/', (double)p, (double)q, &result->value) != ERR_SUCCESS) {
+        return 0;
+    }
+    result->isInteger = fabs(result->value) <= (double)MAX_EXACT_DOUBLE_INTEGER &&
+                        doubleToExactInt64(result->value, &result->intValue);
+    if (!result->isInteger) {
+        result->intValue = 0;
+    }
+    return 1;
+}
+
+/**
+ * Estrin 形式：每一级把相邻两项合并为 t[2k] + t[2k+1]·p，然后 p 自乘，
+ * 同一级内的运算互不依赖；lanes 行同时计算，内层循环可以向量化
+ */
+#define ESTRIN_LEVELS(T, c, degree, p, t)                                               \
+    do {                                                                                \
+        int n_ = (degree) + 1;                                                          \
+        for (int k_ = 0; k_ < n_; k_++)                                                 \
+            for (int l_ = 0; l_ < POLYNOMIAL_LANES; l_++) (t)[k_][l_] = (T)(c)[k_];     \
+        while (n_ > 1) {                                                                \
+            int half_ = n_ / 2;                                                         \
+            for (int k_ = 0; k_ < half_; k_++)                                          \
+                for (int l_ = 0; l_ < POLYNOMIAL_LANES; l_++)                           \
+                    (t)[k_][l_] = (t)[2 * k_][l_] + (t)[2 * k_ + 1][l_] * (p)[l_];      \
+            if (n_ & 1)                                                                 \
+                for (int l_ = 0; l_ < POLYNOMIAL_LANES; l_++) (t)[half_][l_] = (t)[n_ - 1][l_]; \
+            n_ = half_ + (n_ & 1);                                                      \
+            for (int l_ = 0; l_ < POLYNOMIAL_LANES; l_++) (p)[l_] *= (p)[l_];           \
+        }                                                                               \
+    } while (0)
+
+// 单个自变量的 Estrin 形式，运算顺序与 ESTRIN_LEVELS 的每一行相同
+static double estrin(const double* c, int degree, double x) {
+    double t[MAX_POLYNOMIAL_DEGREE + 1];
+    int n = degree + 1;
+    memcpy(t, c, (size_t)n * sizeof(double));
+    while (n > 1) {
+        int half = n / 2;
+        for (int k = 0; k < half; k++) t[k] = t[2 * k] + t[2 * k + 1] * x;
+        if (n & 1) t[half] = t[n - 1];
+        n = half + (n & 1);
+        x *= x;
+    }
+    return t[0];
+}
+
+// 由分子、分母的 Estrin 结果得到最终值（与原指令一样修正接近整数的结果），需要回退时返回 0
+static int finishFloatForm(const PolynomialPlan* plan, double numerator, double denominator, double* result) {
+    double value = numerator;
+    if (plan->isRational) {
+        if (fabs(denominator) < ABSOLUTE_ZERO_THRESHOLD) return 0;
+        value /= denominator;
+    }
+    if (!isfinite(value)) return 0;
+    int64_t intValue;
+    if (isCloseToInteger(value, &intValue)) {
+        value = (double)intValue;
+    }
+    *result = value;
+    return 1;
+}
+
+// 双精度形式（单行），与 evaluatePolynomialArray 的每一行逐位相同
+static int evaluateFloatForm(const PolynomialPlan* plan, double x, double* result) {
+    double numerator = estrin(plan->numerator, plan->degree, x);
+    double denominator = plan->isRational ? estrin(plan->denominator, plan->denominatorDegree, x) : 1;
+    return finishFloatForm(plan, numerator, denominator, result);
+}
+
+/**
+ * 单行求值：先尝试精确形式，POLYNOMIAL_FAST 时再用双精度 Estrin 形式
+ */
+int evaluatePolynomialNumber(const PolynomialPlan* plan, double x, CalcNumber* result) {
+    if (plan->isExact && evaluateExactForm(plan, x, result)) {
+        return 1;
+    }
+    double value;
+    if (!plan->fast || !evaluateFloatForm(plan, x, &value)) {
+        return 0;
+    }
+    result->value = value;
+    result->isInteger = fabs(value) <= (double)MAX_EXACT_DOUBLE_INTEGER && doubleToExactInt64(value, &result->intValue);
+    if (!result->isInteger) {
+        result->intValue = 0;
+    }
+    return 1;
+}
+
+/**
+ * 对数组求值：每一行与 evaluatePolynomialNumber 的结果逐位相同
+ * POLYNOMIAL_FAST 时 Estrin 形式按 POLYNOMIAL_LANES 行一组计算
+ */
+size_t evaluatePolynomialArray(const PolynomialPlan* plan, const double* x, size_t count, double* out) {
+    double t[MAX_POLYNOMIAL_DEGREE + 1][POLYNOMIAL_LANES];
+    double p[POLYNOMIAL_LANES];
+    double numerator[POLYNOMIAL_LANES];
+
+    for (size_t base = 0; base < count; base += POLYNOMIAL_LANES) {
+        size_t lanes = count - base < POLYNOMIAL_LANES ? count - base : POLYNOMIAL_LANES;
+        if (plan->fast) {
+            for (int l = 0; l < POLYNOMIAL_LANES; l++) p[l] = (size_t)l < lanes ? x[base + l] : 0;
+            double xs[POLYNOMIAL_LANES];
+            memcpy(xs, p, sizeof(xs));
+
+            ESTRIN_LEVELS(double, plan->numerator, plan->degree, p, t);
+            memcpy(numerator, t[0], sizeof(numerator));
+            if (plan->isRational) {
+                memcpy(p, xs, sizeof(p));
+                ESTRIN_LEVELS(double, plan->denominator, plan->denominatorDegree, p, t);
+            }
+        }
+
+        for (size_t l = 0; l < lanes; l++) {
+            CalcNumber exact;
+            if (plan->isExact && evaluateExactForm(plan, x[base + l], &exact)) {
+                out[base + l] = exact.value;
+                continue;
+            }
+            if (!plan->fast || !finishFloatForm(plan, numerator[l], plan->isRational ? t[0][l] : 1, &out[base + l])) {
+                return base + l;
+            }
+        }
+    }
+    return count;
+}
+
+/**
+ * 对数组求值（单精度 Estrin 形式，只在 POLYNOMIAL_FAST 时使用）
+ */
+size_t evaluatePolynomialArrayF32(const PolynomialPlan* plan, const double* x, size_t count, float* out) {
+    float t[MAX_POLYNOMIAL_DEGREE + 1][POLYNOMIAL_LANES];
+    float p[POLYNOMIAL_LANES];
+    float numerator[POLYNOMIAL_LANES];
+
+    if (!plan->fast) {
+        return 0;
+    }
+    for (size_t base = 0; base < count; base += POLYNOMIAL_LANES) {
+        size_t lanes = count - base < POLYNOMIAL_LANES ? count - base : POLYNOMIAL_LANES;
+        for (int l = 0; l < POLYNOMIAL_LANES; l++) p[l] = (size_t)l < lanes ? (float)x[base + l] : 0;
+        float xs[POLYNOMIAL_LANES];
+        memcpy(xs, p, sizeof(xs));
+
+        ESTRIN_LEVELS(float, plan->numerator, plan->degree, p, t);
+        memcpy(numerator, t[0], sizeof(numerator));
+        if (plan->isRational) {
+            memcpy(p, xs, sizeof(p));
+            ESTRIN_LEVELS(float, plan->denominator, plan->denominatorDegree, p, t);
+        }
+
+        for (size_t l = 0; l < lanes; l++) {
+            float value = numerator[l];
+            if (plan->isRational) {
+                if (fabsf(t[0][l]) < ABSOLUTE_ZERO_THRESHOLD_F32) return base + l;
+                value /= t[0][l];
+            }
+            if (!isfinite(value)) return base + l;
+            out[base + l] = value;
+        }
+    }
+    return count;
+}
+
+/**
+ * 设置 prog 中多项式子树的改写方式
+ */
+void setPolynomialMode(CompiledExpr* prog, PolynomialMode mode) {
+    for (int k = 0; k < prog->polynomialCount; k++) {
+        prog->polynomials[k].fast = mode == POLYNOMIAL_FAST;
+    }
+}
+
+// ─── 验证 ───────────────────────────────────────────────────────────────────
+
+static inline double horner(const double* c, int degree, double x) {
+    double sum = c[degree];
+    for (int k = degree - 1; k >= 0; k--) {
+        sum = sum * x + c[k];
+    }
+    return sum;
+}
+
+// 各项绝对值之和（Horner 形式舍入误差的自然尺度）
+static double absoluteSum(const double* c, int degree, double x) {
+    double sum = 0;
+    for (int k = degree; k >= 0; k--) {
+        sum = sum * fabs(x) + fabs(c[k]);
+    }
+    return sum;
+}
+
+/**
+ * 在采样点上比较改写结果与原指令的结果
+ * 原指令出错或改写需要回退的采样点跳过（运行时同样回到原指令）
+ */
+static int validatePlan(const CompiledExpr* prog, const PolynomialPlan* plan) {
+    CompiledExpr view = *prog;
+    view.code = prog->code + plan->start;
+    view.length = plan->end - plan->start;
+    view.storage = NULL;
+    view.polynomials = NULL;
+    view.polynomialCount = 0;
+    view.isVector = 0;
+
+    double vars[MAX_COMPILED_VARIABLES] = {0};
+    for (size_t k = 0; k < sizeof(kSamplePoints) / sizeof(kSamplePoints[0]); k++) {
+        double x = kSamplePoints[k];
+        double expected, actual;
+        vars[plan->slot] = x;
+        if (evaluateCompiledFast(&view, vars, MODE_RAD, &expected) != ERR_SUCCESS ||
+            !evaluateFloatForm(plan, x, &actual)) {
+            continue;
+        }
+
+        double scale = absoluteSum(plan->numerator, plan->degree, x);
+        if (plan->isRational) {
+            double q = horner(plan->denominator, plan->denominatorDegree, x);
+            scale = (scale + fabs(actual) * absoluteSum(plan->denominator, plan->denominatorDegree, x)) / fabs(q);
+        }
+        if (fabs(actual - expected) > POLYNOMIAL_TOLERANCE * (scale > 1 ? scale : 1)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int comparePlans(const void* a, const void* b) {
+    return ((const PolynomialPlan*)a)->start - ((const PolynomialPlan*)b)->start;
+}
+
+/**
+ * 识别并验证多项式子树，附加到 prog 上
+ */
+void attachPolynomialPlans(CompiledExpr* prog) {
+    if (prog->isDecimal || prog->length < 3 || prog->maxStack > MAX_EXPR) {
+        return;
+    }
+
+    PlanList list = {NULL, 0, prog->length / 3};
+    list.plans = (PolynomialPlan*)malloc((size_t)list.capacity * sizeof(PolynomialPlan));
+    if (list.plans == NULL || !findPolynomials(prog, &list)) {
+        free(list.plans);
+        return;
+    }
+
+    int kept = 0;
+    for (int k = 0; k < list.count; k++) {
+        if (validatePlan(prog, &list.plans[k])) {
+            list.plans[kept++] = list.plans[k];
+        }
+    }
+    if (kept == 0) {
+        free(list.plans);
+        return;
+    }
+    qsort(list.plans, (size_t)kept, sizeof(PolynomialPlan), comparePlans);
+    prog->polynomials = list.plans;
+    prog->polynomialCount = kept;
+}
@@ -0,0 +1,355 @@
+#include "calculator.h"
+#include "series_evaluator.h"
+#include "vector_value.h"
+#include "evaluation_budget.h"
+#ifndef _WIN32
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+#define SERIES_MAX_INDEX   9007199254740992.0   // 2^53，下标超过后不能精确表示
+#define SERIES_RESCALE     0x1p-256             // 连乘尾数低于此值时重新规格化
+
+// 一块的部分结果：求和为 hi + lo，连乘为 (hi + lo) * 2^exponent
+typedef struct {
+    double hi;
+    double lo;
+    long exponent;
+} SeriesPartial;
+
+// 一个线程负责的连续块
+typedef struct {
+    const VectorFunction* fn;
+    SeriesType type;
+    AngleMode mode;
+    double from;
+    size_t terms;
+    size_t firstBlock;
+    size_t endBlock;
+    SeriesPartial* partials;
+    uint64_t deadline;      // 求值预算的截止时间（0 表示不限时），每块检查一次
+    CalcError error;
+} SeriesRange;
+
+/**
+ * 识别 sum/prod 的四参数形式（名字大小写不敏感）
+ */
+SeriesType getSeriesFunction(const char** expr) {
+    const char* p = *expr;
+    char name[5] = {0};
+    int n = 0;
+
+    while (isalpha((unsigned char)*p) && n < 4) {
+        name[n++] = tolower(*p);
+        p++;
+    }
+    if (isalpha((unsigned char)*p)) {
+        return SERIES_NONE;
+    }
+    SeriesType type = strcmp(name, "sum") == 0 ? SERIES_SUM : strcmp(name, "prod") == 0 ? SERIES_PROD : SERIES_NONE;
+    if (type == SERIES_NONE) {
+        return SERIES_NONE;
+    }
+
+    const char* q = p;
+    while (*q == ' ') q++;
+    if (*q != '(') {
+        return SERIES_NONE;
+    }
+    int depth = 0, commas = 0;
+    for (q++; *q; q++) {
+        if (*q == '(' || *q == '[') {
+            depth++;
+        } else if (*q == ')' || *q == ']') {
+            if (depth == 0) break;
+            depth--;
+        } else if (*q == ',' && depth == 0) {
+            commas++;
+        }
+    }
+    if (commas != 3) {
+        return SERIES_NONE;
+    }
+
+    *expr = p;
+    return type;
+}
+
+// ─── 补偿连乘 ───────────────────────────────────────────────────────────────
+
+// Dekker 拆分：a = hi + lo，各占 26 位尾数
+static inline void splitDouble(double a, double* hi, double* lo) {
+    double t = 134217729.0 * a;
+    *hi = t - (t - a);
+    *lo = a - *hi;
+}
+
+// a * b 的舍入误差（p 为 a * b 的浮点结果）
+static inline double productError(double a, double b, double p) {
+    double ah, al, bh, bl;
+    splitDouble(a, &ah, &al);
+    splitDouble(b, &bh, &bl);
+    return ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+}
+
+// 尾数过小时把指数移到 exponent 中
+static inline void rescalePartial(SeriesPartial* p) {
+    if (p->hi != 0 && fabs(p->hi) < SERIES_RESCALE) {
+        int e;
+        frexp(p->hi, &e);
+        p->hi = ldexp(p->hi, -e);
+        p->lo = ldexp(p->lo, -e);
+        p->exponent += e;
+    }
+}
+
+// p *= m * 2^e（|m| 不超过 2，两侧尾数都有界，拆分不会溢出）
+static inline void multiplyPartial(SeriesPartial* p, double m, long e) {
+    double hi = p->hi * m;
+    double lo = p->lo * m + productError(p->hi, m, hi);
+    p->hi = hi + lo;
+    p->lo = lo - (p->hi - hi);
+    p->exponent += e;
+    rescalePartial(p);
+}
+
+static void multiplyTerms(SeriesPartial* p, const double* data, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        int e;
+        double m = frexp(data[i], &e);
+        multiplyPartial(p, m, e);
+    }
+}
+
+// ─── 分块求值 ───────────────────────────────────────────────────────────────
+
+// 串行计算 [firstBlock, endBlock) 的部分结果，遇到第一个错误即停止
+static void runSeriesRange(SeriesRange* r) {
+    VectorArena arena;
+    double* index = (double*)malloc(2 * SERIES_BLOCK_SIZE * sizeof(double));
+    double* terms = index + SERIES_BLOCK_SIZE;
+
+    r->error = CALC_SUCCESS;
+    if (index == NULL) {
+        r->error = CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+        return;
+    }
+    initVectorArena(&arena);
+
+    for (size_t block = r->firstBlock; block < r->endBlock; block++) {
+        if (r->deadline && budgetClockNs() >= r->deadline) {
+            r->error = CALC_ERROR_CODE(ERR_BUDGET_EXCEEDED, "超出求值时限");
+            break;
+        }
+        size_t start = block * SERIES_BLOCK_SIZE;
+        size_t count = r->terms - start < SERIES_BLOCK_SIZE ? r->terms - start : SERIES_BLOCK_SIZE;
+        for (size_t k = 0; k < count; k++) {
+            index[k] = r->from + (double)(start + k);
+        }
+        r->error = evaluateVectorFunction(r->fn, index, count, r->mode, &arena, terms);
+        if (r->error.code != 0) break;
+
+        SeriesPartial* p = &r->partials[block];
+        if (r->type == SERIES_SUM) {
+            p->hi = sumArray(terms, count);
+            p->lo = 0;
+            p->exponent = 0;
+        } else {
+            p->hi = 1;
+            p->lo = 0;
+            p->exponent = 0;
+            multiplyTerms(p, terms, count);
+        }
+    }
+
+    freeVectorArena(&arena);
+    free(index);
+}
+
+#ifndef _WIN32
+static void* runSeriesThread(void* arg) {
+    runSeriesRange((SeriesRange*)arg);
+    return NULL;
+}
+#endif
+
+/**
+ * 按块计算全部部分结果；项数较多时把连续的块分给多个线程
+ * 多个线程出错时返回块序号最小的错误，与串行计算一致
+ */
+static CalcError computePartials(const SeriesRange* base, size_t blocks) {
+    int threads = 1;
+#ifndef _WIN32
+    if (base->terms >= SERIES_PARALLEL_THRESHOLD) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (int)(base->terms / (SERIES_PARALLEL_THRESHOLD / 2));
+        if (threads > SERIES_MAX_THREADS) threads = SERIES_MAX_THREADS;
+        if (cpus > 0 && threads > cpus) threads = (int)cpus;
+        if ((size_t)threads > blocks) threads = (int)blocks;
+    }
+#endif
+    if (threads <= 1) {
+        SeriesRange range = *base;
+        range.firstBlock = 0;
+        range.endBlock = blocks;
+        runSeriesRange(&range);
+        return range.error;
+    }
+
+#ifndef _WIN32
+    SeriesRange ranges[SERIES_MAX_THREADS];
+    pthread_t tids[SERIES_MAX_THREADS];
+    int started[SERIES_MAX_THREADS] = {0};
+    size_t per = (blocks + threads - 1) / threads;
+
+    for (int t = 0; t < threads; t++) {
+        ranges[t] = *base;
+        ranges[t].firstBlock = (size_t)t * per < blocks ? (size_t)t * per : blocks;
+        ranges[t].endBlock = ranges[t].firstBlock + per < blocks ? ranges[t].firstBlock + per : blocks;
+        ranges[t].error = CALC_SUCCESS;
+        // 第 0 段由当前线程计算；线程创建失败时也退化为当前线程计算
+        if (t > 0 && pthread_create(&tids[t], NULL, runSeriesThread, &ranges[t]) == 0) {
+            started[t] = 1;
+        }
+    }
+    for (int t = 0; t < threads; t++) {
+        if (!started[t]) runSeriesRange(&ranges[t]);
+    }
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) pthread_join(tids[t], NULL);
+    }
+    for (int t = 0; t < threads; t++) {
+        if (ranges[t].error.code != 0) return ranges[t].error;
+    }
+    return CALC_SUCCESS;
+#else
+    return CALC_SUCCESS;
+#endif
+}
+
+// 按块顺序合并部分结果
+static double combinePartials(SeriesType type, const SeriesPartial* partials, size_t blocks) {
+    if (type == SERIES_SUM) {
+        // Neumaier 补偿累加
+        double sum = 0, compensation = 0;
+        for (size_t b = 0; b < blocks; b++) {
+            double x = partials[b].hi;
+            double t = sum + x;
+            if (fabs(sum) >= fabs(x)) {
+                compensation += (sum - t) + x;
+            } else {
+                compensation += (x - t) + sum;
+            }
+            sum = t;
+        }
+        return sum + compensation;
+    }
+
+    SeriesPartial product = {1, 0, 0};
+    for (size_t b = 0; b < blocks; b++) {
+        const SeriesPartial* p = &partials[b];
+        double hi = product.hi * p->hi;
+        double lo = productError(product.hi, p->hi, hi) + product.hi * p->lo + product.lo * p->hi;
+        product.hi = hi + lo;
+        product.lo = lo - (product.hi - hi);
+        product.exponent += p->exponent;
+        rescalePartial(&product);
+    }
+    if (product.hi == 0) {
+        return 0;
+    }
+    // 指数超出 double 范围时直接得到 inf 或 0
+    long e = product.exponent;
+    if (e > 4096) e = 4096;
+    if (e < -4096) e = -4096;
+    return ldexp(product.hi + product.lo, (int)e);
+}
+
+// ─── 入口 ───────────────────────────────────────────────────────────────────
+
+/**
+ * 项表达式中第一个 sum/prod 四参数调用的位置，没有时返回 -1
+ * （项表达式整块编译，不支持嵌套的求和与连乘；只在编译失败时查找）
+ */
+static int findNestedSeries(const char* body, size_t bodyLen) {
+    for (size_t k = 0; k < bodyLen; k++) {
+        if (!isalpha((unsigned char)body[k]) ||
+            (k > 0 && (isalnum((unsigned char)body[k - 1]) || body[k - 1] == '_'))) {
+            continue;
+        }
+        const char* p = body + k;
+        if (getSeriesFunction(&p) != SERIES_NONE) {
+            return (int)k;
+        }
+    }
+    return -1;
+}
+
+/**
+ * 计算 sum(index, from, to, body) 或 prod(index, from, to, body)
+ *
+ * @param type     SERIES_SUM 或 SERIES_PROD
+ * @param index    下标变量名
+ * @param from     下标起点（整数）
+ * @param to       下标终点（整数，包含）
+ * @param body     项表达式，可引用下标和已绑定的数组变量
+ * @param mode     角度模式
+ * @param result   输出结果
+ * @return 成功返回 CALC_SUCCESS；项出错时返回第一个出错的块中的错误（position 为 body 内的位置），
+ *         下标变量名与上下限错误的 position 为 -1
+ */
+CalcError evaluateSeries(SeriesType type, const char* index, size_t indexLen, double from, double to,
+                         const char* body, size_t bodyLen, AngleMode mode, double* result) {
+    if (!isfinite(from) || !isfinite(to) || from != floor(from) || to != floor(to)) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "求和上下限必须是整数");
+    }
+    if (fabs(from) > SERIES_MAX_INDEX || fabs(to) > SERIES_MAX_INDEX) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "求和上下限超出范围");
+    }
+    if (to >= from && to - from >= SERIES_MAX_TERMS) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "求和项数过多");
+    }
+
+    VectorFunction fn;
+    CalcError err = compileVectorFunction(body, bodyLen, index, indexLen, &fn);
+    if (err.code != 0) {
+        int nested = findNestedSeries(body, bodyLen);
+        return nested >= 0 ? CALC_ERROR_CODE_POS(ERR_INVALID_ARGUMENT, "求和与连乘不能嵌套", nested) : err;
+    }
+
+    size_t terms = to < from ? 0 : (size_t)(to - from) + 1;
+    // 求值预算：全部项的步数在计算之前一次计入
+    uint64_t termSteps = fn.prog.cost.steps > 0 ? fn.prog.cost.steps : 1;
+    if (chargeEvaluationBudget((uint64_t)terms * termSteps) != ERR_SUCCESS) {
+        freeVectorFunction(&fn);
+        return budgetExceededError(-1);
+    }
+    size_t blocks = (terms + SERIES_BLOCK_SIZE - 1) / SERIES_BLOCK_SIZE;
+    SeriesPartial* partials = NULL;
+    if (blocks > 0) {
+        partials = (SeriesPartial*)malloc(blocks * sizeof(SeriesPartial));
+        if (partials == NULL) {
+            freeVectorFunction(&fn);
+            return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+        }
+        SeriesRange base = {&fn, type, mode, from, terms, 0, 0, partials, currentBudgetDeadline(), CALC_SUCCESS};
+        err = computePartials(&base, blocks);
+    }
+    if (err.code == 0) {
+        *result = terms > 0 ? combinePartials(type, partials, blocks) : (type == SERIES_SUM ? 0 : 1);
+    }
+    free(partials);
+    freeVectorFunction(&fn);
+    if (err.code != 0) {
+        return err;
+    }
+
+    if (!isfinite(*result)) {
+        return CALC_ERROR_CODE(ERR_OVERFLOW, "计算结果太大");
+    }
+    int64_t intValue;
+    if (isCloseToInteger(*result, &intValue)) {
+        *result = intValue;
+    }
+    return CALC_SUCCESS;
+}
@@ -0,0 +1,821 @@
+#ifdef __linux__
+#define _GNU_SOURCE     // accept4
+#endif
+
+#include "calculator.h"
+#include "calc_server.h"
+#include "evaluation_budget.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <pthread.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define RESPONSE_SIZE        256    // 单条响应的最大长度
+#define READ_CHUNK           16384  // 每次读取的字节数
+#define MAX_EPOLL_EVENTS     64
+#define LATENCY_SUB_BUCKETS  16     // 每个 2 的幂区间划分的子区间数（误差约 6%）
+#define LATENCY_BUCKETS      ((64 - 3) * LATENCY_SUB_BUCKETS)
+
+typedef struct Connection Connection;
+
+// 一条请求（按到达顺序挂在所属连接上，计算线程完成后由事件循环按顺序发送）
+typedef struct Job {
+    Connection* conn;
+    struct Job* next;           // 同一连接中的下一条请求
+    struct Job* queueNext;      // 工作队列或完成列表中的下一项
+    uint64_t startNs;           // 收到请求的时间
+    int collected;              // 事件循环已从完成列表取走（仅事件循环访问）
+    char response[RESPONSE_SIZE];
+    char request[];             // 请求文本（不含换行符）
+} Job;
+
+struct Connection {
+    int fd;
+    char* in;                   // 未处理的输入
+    size_t inLength;
+    size_t inCapacity;
+    char* out;                  // 待发送的输出
+    size_t outLength;
+    size_t outSent;
+    size_t outCapacity;
+    Job* head;                  // 未发送的请求（按到达顺序）
+    Job* tail;
+    int pending;                // 未发送的请求数
+    int closing;                // 不再接受新请求，发送完成后关闭
+    int peerClosed;             // 对端已关闭写端，处理完缓冲区中的请求后关闭
+    int closed;                 // 套接字已关闭，等待未完成的请求后释放
+    uint32_t events;            // 当前注册的 epoll 事件
+    Connection* nextConnection; // 服务的连接链表
+    Connection* nextReady;      // 有已完成请求的连接链表
+    int ready;                  // 是否已在 nextReady 链表中
+};
+
+struct CalcServer {
+    int listenFd;
+    int epollFd;
+    int wakeFd;                 // eventfd：计算完成或停止时唤醒事件循环
+    int port;
+    char unixPath[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    int stopRequested;
+    EvaluationBudget budget;    // 每条请求的预算（deadlineNs 为相对收到请求的时限）
+
+    pthread_t threads[MAX_SERVER_THREADS];
+    int threadCount;
+    pthread_mutex_t lock;       // 保护以下字段
+    pthread_cond_t available;
+    int lockInitialized;
+    Job* queueHead;             // 等待计算的请求
+    Job* queueTail;
+    Job* completed;             // 已完成、等待事件循环发送的请求
+    int stopping;               // 计算线程退出
+
+    Connection* connections;    // 所有连接（仅事件循环访问）
+    int connectionCount;
+    int closedCount;
+    uint64_t requests;
+    uint64_t errors;
+    uint64_t maxLatencyNs;
+    uint64_t latency[LATENCY_BUCKETS];
+};
+
+static uint64_t nowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// ─── 延迟统计（对数线性直方图）───────────────────────────────────────────────
+
+static int latencyBucket(uint64_t ns) {
+    if (ns < LATENCY_SUB_BUCKETS) {
+        return (int)ns;
+    }
+    int exponent = 63 - __builtin_clzll(ns);
+    int sub = (int)((ns >> (exponent - 4)) & (LATENCY_SUB_BUCKETS - 1));
+    return (exponent - 3) * LATENCY_SUB_BUCKETS + sub;
+}
+
+// 子区间的中点（纳秒）
+static double bucketMidpointNs(int index) {
+    if (index < LATENCY_SUB_BUCKETS) {
+        return index;
+    }
+    int exponent = index / LATENCY_SUB_BUCKETS + 3;
+    int sub = index % LATENCY_SUB_BUCKETS;
+    double width = ldexp(1.0, exponent - 4);
+    return (LATENCY_SUB_BUCKETS + sub) * width + width / 2;
+}
+
+// 调用者持有 server->lock
+static double latencyPercentileMicros(const CalcServer* server, double fraction) {
+    if (server->requests == 0) {
+        return 0;
+    }
+    uint64_t target = (uint64_t)ceil(fraction * (double)server->requests);
+    uint64_t cumulative = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        cumulative += server->latency[i];
+        if (cumulative >= target && cumulative > 0) {
+            double ns = bucketMidpointNs(i);
+            if (ns > (double)server->maxLatencyNs) ns = (double)server->maxLatencyNs;
+            return ns / 1000.0;
+        }
+    }
+    return server->maxLatencyNs / 1000.0;
+}
+
+/**
+ * 获取服务统计（可在任意线程调用）
+ */
+void getServerStats(CalcServer* server, ServerStats* stats) {
+    pthread_mutex_lock(&server->lock);
+    stats->requests = server->requests;
+    stats->errors = server->errors;
+    stats->connections = server->connectionCount;
+    stats->p50Micros = latencyPercentileMicros(server, 0.50);
+    stats->p99Micros = latencyPercentileMicros(server, 0.99);
+    stats->maxMicros = server->maxLatencyNs / 1000.0;
+    pthread_mutex_unlock(&server->lock);
+}
+
+// ─── 请求处理（计算线程）─────────────────────────────────────────────────────
+
+static int errorResponse(char* response, CalcError err) {
+    snprintf(response, RESPONSE_SIZE, "ERR %d %d %s", err.code, err.position, err.message);
+    return 1;
+}
+
+/**
+ * 解析变量绑定：name=value，以空格或逗号分隔
+ */
+static int bindRequestVariables(const CompiledExpr* prog, const char* text, double* vars, char* response) {
+    int bound[MAX_COMPILED_VARIABLES] = {0};
+
+    while (*text) {
+        while (*text == ' ' || *text == ',') text++;
+        if (*text == '\0') break;
+
+        const char* equals = strchr(text, '=');
+        size_t nameLength = equals ? (size_t)(equals - text) : 0;
+        if (nameLength == 0 || nameLength >= MAX_VARIABLE_NAME || memchr(text, ' ', nameLength)) {
+            return errorResponse(response, CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "变量绑定格式应为 变量=值"));
+        }
+        char name[MAX_VARIABLE_NAME];
+        memcpy(name, text, nameLength);
+        name[nameLength] = '\0';
+
+        char* end;
+        double value = strtod(equals + 1, &end);
+        if (end == equals + 1 || (*end != '\0' && *end != ' ' && *end != ',')) {
+            return errorResponse(response, CALC_ERROR_CODE(ERR_INVALID_NUMBER, "变量值格式不正确"));
+        }
+        int slot = findCompiledVariable(prog, name);
+        if (slot >= 0) {
+            vars[slot] = value;
+            bound[slot] = 1;
+        }
+        text = end;
+    }
+
+    for (int i = 0; i < prog->varCount; i++) {
+        if (!bound[i]) {
+            snprintf(response, RESPONSE_SIZE, "ERR %d -1 未绑定的变量: %s", ERR_INVALID_ARGUMENT, prog->varNames[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// EVAL [DEG|RAD] <表达式> [| 变量=值 ...]
+static int evaluateRequest(const CalcServer* server, const Job* job, const char* args, char* response) {
+    AngleMode mode = MODE_DEG;
+    while (*args == ' ') args++;
+    if ((strncasecmp(args, "DEG", 3) == 0 || strncasecmp(args, "RAD", 3) == 0) &&
+        (args[3] == ' ' || args[3] == '\0')) {
+        mode = (toupper((unsigned char)args[0]) == 'R') ? MODE_RAD : MODE_DEG;
+        args += 3;
+    }
+
+    const char* bar = strchr(args, '|');
+    size_t length = bar ? (size_t)(bar - args) : strlen(args);
+
+    CompiledExpr prog;
+    CalcError err = compileExpressionN(args, length, &prog);
+    if (err.code != 0) {
+        return errorResponse(response, err);
+    }
+
+    // 按编译时估计的代价拒绝超出预算的表达式；在队列中等待超时的请求不再计算
+    EvaluationBudget budget = server->budget;
+    budget.deadlineNs = budget.deadlineNs ? job->startNs + budget.deadlineNs : 0;
+    err = checkCompiledBudget(&prog, 1, &budget);
+    if (err.code != 0) {
+        freeCompiledExpression(&prog);
+        return errorResponse(response, err);
+    }
+
+    double vars[MAX_COMPILED_VARIABLES] = {0};
+    double result;
+    int failed = bindRequestVariables(&prog, bar ? bar + 1 : "", vars, response);
+    if (!failed) {
+        err = evaluateCompiled(&prog, vars, mode, &result);
+        if (err.code != 0) {
+            failed = errorResponse(response, err);
+        } else {
+            snprintf(response, RESPONSE_SIZE, "OK %.17g", result);
+        }
+    }
+    freeCompiledExpression(&prog);
+    return failed;
+}
+
+/**
+ * 处理一条请求，生成响应
+ * @return 1 表示响应为 ERR
+ */
+static int handleRequest(CalcServer* server, Job* job) {
+    const char* text = job->request;
+    while (*text == ' ') text++;
+
+    if (strncasecmp(text, "EVAL", 4) == 0 && (text[4] == ' ' || text[4] == '\0')) {
+        return evaluateRequest(server, job, text + 4, job->response);
+    }
+    if (strcasecmp(text, "STATS") == 0) {
+        ServerStats stats;
+        getServerStats(server, &stats);
+        snprintf(job->response, RESPONSE_SIZE,
+                 "STATS requests=%llu errors=%llu connections=%d p50_us=%.1f p99_us=%.1f max_us=%.1f",
+                 (unsigned long long)stats.requests, (unsigned long long)stats.errors, stats.connections,
+                 stats.p50Micros, stats.p99Micros, stats.maxMicros);
+        return 0;
+    }
+    if (strcasecmp(text, "PING") == 0) {
+        snprintf(job->response, RESPONSE_SIZE, "PONG");
+        return 0;
+    }
+    if (strcasecmp(text, "QUIT") == 0) {
+        snprintf(job->response, RESPONSE_SIZE, "BYE");
+        return 0;
+    }
+    return errorResponse(job->response, CALC_ERROR_CODE(ERR_SYNTAX, "未知的命令"));
+}
+
+static void wakeEventLoop(CalcServer* server) {
+    uint64_t one = 1;
+    ssize_t written = write(server->wakeFd, &one, sizeof(one));
+    (void)written;  // 计数器已非零时写入失败也能唤醒
+}
+
+/**
+ * 记录统计并把请求放入完成列表（调用者持有 server->lock）
+ */
+static void completeJob(CalcServer* server, Job* job, int failed, uint64_t elapsed) {
+    server->requests++;
+    server->errors += (uint64_t)failed;
+    server->latency[latencyBucket(elapsed)]++;
+    if (elapsed > server->maxLatencyNs) server->maxLatencyNs = elapsed;
+
+    // 完成列表由空变为非空时才需要唤醒（事件循环每次取走整个列表）
+    int wasEmpty = server->completed == NULL;
+    job->queueNext = server->completed;
+    server->completed = job;
+    if (wasEmpty) {
+        wakeEventLoop(server);
+    }
+}
+
+static void* workerMain(void* arg) {
+    CalcServer* server = (CalcServer*)arg;
+
+    pthread_mutex_lock(&server->lock);
+    while (1) {
+        while (server->queueHead == NULL && !server->stopping) {
+            pthread_cond_wait(&server->available, &server->lock);
+        }
+        if (server->stopping) {
+            break;
+        }
+
+        Job* job = server->queueHead;
+        server->queueHead = job->queueNext;
+        if (server->queueHead == NULL) server->queueTail = NULL;
+        pthread_mutex_unlock(&server->lock);
+
+        int failed = handleRequest(server, job);
+        uint64_t elapsed = nowNs() - job->startNs;
+
+        pthread_mutex_lock(&server->lock);
+        completeJob(server, job, failed, elapsed);
+    }
+    pthread_mutex_unlock(&server->lock);
+    return NULL;
+}
+
+// ─── 连接处理（事件循环线程）─────────────────────────────────────────────────
+
+static int appendBytes(char** buffer, size_t* length, size_t* capacity, const char* data, size_t size) {
+    if (*length + size > *capacity) {
+        size_t newCapacity = *capacity ? *capacity : READ_CHUNK;
+        while (newCapacity < *length + size) newCapacity *= 2;
+        char* grown = (char*)realloc(*buffer, newCapacity);
+        if (grown == NULL) return 0;
+        *buffer = grown;
+        *capacity = newCapacity;
+    }
+    memcpy(*buffer + *length, data, size);
+    *length += size;
+    return 1;
+}
+
+static void closeConnection(CalcServer* server, Connection* conn) {
+    if (conn->closed) return;
+    epoll_ctl(server->epollFd, EPOLL_CTL_DEL, conn->fd, NULL);
+    close(conn->fd);
+    conn->closed = 1;
+    conn->closing = 1;
+    server->closedCount++;
+    pthread_mutex_lock(&server->lock);
+    server->connectionCount--;
+    pthread_mutex_unlock(&server->lock);
+}
+
+static void updateEvents(CalcServer* server, Connection* conn) {
+    if (conn->closed) return;
+    uint32_t events = 0;
+    if (!conn->closing && !conn->peerClosed && conn->pending < MAX_PIPELINED_REQUESTS) events |= EPOLLIN;
+    if (conn->outSent < conn->outLength) events |= EPOLLOUT;
+    if (events != conn->events) {
+        struct epoll_event ev = {events, {.ptr = conn}};
+        epoll_ctl(server->epollFd, EPOLL_CTL_MOD, conn->fd, &ev);
+        conn->events = events;
+    }
+}
+
+static void flushOutput(CalcServer* server, Connection* conn) {
+    while (!conn->closed && conn->outSent < conn->outLength) {
+        ssize_t sent = send(conn->fd, conn->out + conn->outSent, conn->outLength - conn->outSent, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) closeConnection(server, conn);
+            return;
+        }
+        conn->outSent += (size_t)sent;
+    }
+    conn->outLength = conn->outSent = 0;
+    if (conn->pending == 0 && (conn->closing || (conn->peerClosed && conn->inLength == 0))) {
+        closeConnection(server, conn);
+    }
+}
+
+// 把一条请求挂到连接上
+static Job* addJob(Connection* conn, const char* request, size_t length, uint64_t startNs) {
+    Job* job = (Job*)malloc(sizeof(Job) + length + 1);
+    if (job == NULL) return NULL;
+    memset(job, 0, sizeof(Job));
+    job->conn = conn;
+    job->startNs = startNs;
+    memcpy(job->request, request, length);
+    job->request[length] = '\0';
+    if (conn->tail) conn->tail->next = job;
+    else conn->head = job;
+    conn->tail = job;
+    conn->pending++;
+    return job;
+}
+
+/**
+ * 从输入缓冲区切出完整的请求行，批量放入工作队列
+ */
+static void processInput(CalcServer* server, Connection* conn) {
+    Job* batchHead = NULL;
+    Job* batchTail = NULL;
+    size_t consumed = 0;
+    uint64_t startNs = nowNs();
+
+    while (!conn->closing && conn->pending < MAX_PIPELINED_REQUESTS) {
+        char* start = conn->in + consumed;
+        char* newline = memchr(start, '\n', conn->inLength - consumed);
+        // 超长请求无论是否已收到换行符都拒绝
+        size_t lineLength = newline ? (size_t)(newline - start) : conn->inLength - consumed;
+        if (newline && lineLength > 0 && start[lineLength - 1] == '\r') lineLength--;
+        if (lineLength > MAX_REQUEST_LINE) {
+            Job* job = addJob(conn, "", 0, startNs);
+            if (job == NULL) break;
+            // 不经过计算线程：直接放入完成列表，由事件循环发送错误响应后关闭连接
+            errorResponse(job->response, CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "请求过长"));
+            pthread_mutex_lock(&server->lock);
+            completeJob(server, job, 1, nowNs() - startNs);
+            pthread_mutex_unlock(&server->lock);
+            conn->closing = 1;
+            break;
+        }
+        if (newline == NULL) {
+            break;
+        }
+
+        size_t length = lineLength;
+        consumed += (size_t)(newline - start) + 1;
+        if (length == 0) continue;
+
+        Job* job = addJob(conn, start, length, startNs);
+        if (job == NULL) {
+            closeConnection(server, conn);
+            break;
+        }
+        if (batchTail) batchTail->queueNext = job;
+        else batchHead = job;
+        batchTail = job;
+
+        // QUIT 之后的请求不再处理
+        const char* command = job->request;
+        while (*command == ' ') command++;
+        if (strcasecmp(command, "QUIT") == 0) {
+            conn->closing = 1;
+        }
+    }
+    if (conn->closing) {
+        consumed = conn->inLength;
+    }
+
+    if (consumed > 0) {
+        memmove(conn->in, conn->in + consumed, conn->inLength - consumed);
+        conn->inLength -= consumed;
+    }
+
+    if (batchHead) {
+        pthread_mutex_lock(&server->lock);
+        if (server->queueTail) server->queueTail->queueNext = batchHead;
+        else server->queueHead = batchHead;
+        server->queueTail = batchTail;
+        pthread_cond_broadcast(&server->available);
+        pthread_mutex_unlock(&server->lock);
+    }
+}
+
+/**
+ * 按请求顺序取出已完成的响应写入输出缓冲区
+ */
+static void collectResponses(CalcServer* server, Connection* conn) {
+    // 只发送事件循环已取走的请求：取走列表之后才完成的请求仍挂在新的完成列表上
+    while (conn->head && conn->head->collected) {
+        Job* job = conn->head;
+        conn->head = job->next;
+        if (conn->head == NULL) conn->tail = NULL;
+        conn->pending--;
+
+        if (!conn->closed) {
+            size_t length = strlen(job->response);
+            job->response[length] = '\n';
+            if (!appendBytes(&conn->out, &conn->outLength, &conn->outCapacity, job->response, length + 1)) {
+                closeConnection(server, conn);
+            }
+        }
+        free(job);
+    }
+
+    if (!conn->closed) {
+        processInput(server, conn);  // 恢复因流水线上限暂停处理的请求
+        flushOutput(server, conn);
+        updateEvents(server, conn);
+    }
+}
+
+static void readInput(CalcServer* server, Connection* conn) {
+    char chunk[READ_CHUNK];
+    while (!conn->closing && !conn->peerClosed && conn->inLength <= MAX_REQUEST_LINE + READ_CHUNK) {
+        ssize_t received = recv(conn->fd, chunk, sizeof(chunk), 0);
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) closeConnection(server, conn);
+            break;
+        }
+        if (received == 0) {
+            // 对端不再发送：最后一行可以没有换行符，处理完已收到的请求后关闭
+            conn->peerClosed = 1;
+            if (conn->inLength > 0 && conn->in[conn->inLength - 1] != '\n') {
+                appendBytes(&conn->in, &conn->inLength, &conn->inCapacity, "\n", 1);
+            }
+            processInput(server, conn);
+            break;
+        }
+        if (!appendBytes(&conn->in, &conn->inLength, &conn->inCapacity, chunk, (size_t)received)) {
+            closeConnection(server, conn);
+            return;
+        }
+        processInput(server, conn);
+    }
+}
+
+static void acceptConnections(CalcServer* server) {
+    while (1) {
+        int fd = accept4(server->listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;  // EAGAIN 或暂时性错误
+        }
+        if (server->unixPath[0] == '\0') {
+            int one = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+
+        Connection* conn = (Connection*)calloc(1, sizeof(Connection));
+        struct epoll_event ev = {EPOLLIN, {.ptr = conn}};
+        if (conn == NULL || epoll_ctl(server->epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            free(conn);
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        conn->events = EPOLLIN;
+        conn->nextConnection = server->connections;
+        server->connections = conn;
+        pthread_mutex_lock(&server->lock);
+        server->connectionCount++;
+        pthread_mutex_unlock(&server->lock);
+    }
+}
+
+static void freeConnection(Connection* conn) {
+    Job* job = conn->head;
+    while (job) {
+        Job* next = job->next;
+        free(job);
+        job = next;
+    }
+    free(conn->in);
+    free(conn->out);
+    free(conn);
+}
+
+// 释放已关闭且没有未完成请求的连接
+static void releaseClosedConnections(CalcServer* server) {
+    Connection** link = &server->connections;
+    while (*link) {
+        Connection* conn = *link;
+        if (conn->closed && conn->pending == 0) {
+            *link = conn->nextConnection;
+            server->closedCount--;
+            freeConnection(conn);
+        } else {
+            link = &conn->nextConnection;
+        }
+    }
+}
+
+// ─── 服务生命周期 ───────────────────────────────────────────────────────────
+
+static CalcError openListenSocket(CalcServer* server, const ServerConfig* config) {
+    if (config->unixPath) {
+        struct sockaddr_un addr;
+        if (strlen(config->unixPath) >= sizeof(addr.sun_path)) {
+            return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "套接字路径过长");
+        }
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, config->unixPath);
+
+        server->listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (server->listenFd < 0) {
+            return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法创建套接字");
+        }
+        unlink(config->unixPath);
+        if (bind(server->listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法绑定套接字路径");
+        }
+        strcpy(server->unixPath, config->unixPath);
+    } else {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // 只接受本机连接
+        addr.sin_port = htons((uint16_t)config->port);
+
+        server->listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (server->listenFd < 0) {
+            return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法创建套接字");
+        }
+        int one = 1;
+        setsockopt(server->listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(server->listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+            return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法绑定端口");
+        }
+        socklen_t addrLength = sizeof(addr);
+        getsockname(server->listenFd, (struct sockaddr*)&addr, &addrLength);
+        server->port = ntohs(addr.sin_port);
+    }
+
+    if (listen(server->listenFd, SOMAXCONN) != 0) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法监听套接字");
+    }
+    return CALC_SUCCESS;
+}
+
+/**
+ * 创建服务：打开监听套接字并启动计算线程
+ *
+ * @param config 服务配置
+ * @param server 输出，使用完后需调用 destroyServer
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+CalcError createServer(const ServerConfig* config, CalcServer** server) {
+    CalcServer* s = (CalcServer*)calloc(1, sizeof(CalcServer));
+    *server = NULL;
+    if (s == NULL) {
+        return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+    }
+    s->listenFd = s->epollFd = s->wakeFd = -1;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->available, NULL);
+    s->lockInitialized = 1;
+    s->budget.maxSteps = config->maxSteps;
+    s->budget.maxDepth = config->maxDepth;
+    s->budget.deadlineNs = (uint64_t)config->timeoutMicros * 1000u;
+
+    CalcError err = openListenSocket(s, config);
+    if (err.code == 0) {
+        s->epollFd = epoll_create1(EPOLL_CLOEXEC);
+        s->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        struct epoll_event listenEvent = {EPOLLIN, {.ptr = &s->listenFd}};
+        struct epoll_event wakeEvent = {EPOLLIN, {.ptr = &s->wakeFd}};
+        if (s->epollFd < 0 || s->wakeFd < 0 ||
+            epoll_ctl(s->epollFd, EPOLL_CTL_ADD, s->listenFd, &listenEvent) != 0 ||
+            epoll_ctl(s->epollFd, EPOLL_CTL_ADD, s->wakeFd, &wakeEvent) != 0) {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法创建事件循环");
+        }
+    }
+
+    int threads = config->threads > 0 ? config->threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > MAX_SERVER_THREADS) threads = MAX_SERVER_THREADS;
+    while (err.code == 0 && s->threadCount < threads) {
+        if (pthread_create(&s->threads[s->threadCount], NULL, workerMain, s) != 0) {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法创建计算线程");
+            break;
+        }
+        s->threadCount++;
+    }
+
+    if (err.code != 0) {
+        destroyServer(s);
+        return err;
+    }
+    *server = s;
+    return CALC_SUCCESS;
+}
+
+// 实际监听的 TCP 端口（配置端口为 0 时由系统分配），Unix 域套接字返回 0
+int getServerPort(const CalcServer* server) {
+    return server->port;
+}
+
+/**
+ * 运行事件循环，直到 stopServer 被调用
+ */
+CalcError runServer(CalcServer* server) {
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+
+    while (!__atomic_load_n(&server->stopRequested, __ATOMIC_ACQUIRE)) {
+        int count = epoll_wait(server->epollFd, events, MAX_EPOLL_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "事件循环出错");
+        }
+
+        for (int i = 0; i < count; i++) {
+            void* tag = events[i].data.ptr;
+            if (tag == &server->listenFd) {
+                acceptConnections(server);
+            } else if (tag == &server->wakeFd) {
+                uint64_t counter;
+                ssize_t got = read(server->wakeFd, &counter, sizeof(counter));
+                (void)got;
+
+                pthread_mutex_lock(&server->lock);
+                Job* job = server->completed;
+                server->completed = NULL;
+                pthread_mutex_unlock(&server->lock);
+
+                // 先找出涉及的连接（collectResponses 会释放列表中的请求）
+                Connection* ready = NULL;
+                for (; job; job = job->queueNext) {
+                    job->collected = 1;
+                    if (!job->conn->ready) {
+                        job->conn->ready = 1;
+                        job->conn->nextReady = ready;
+                        ready = job->conn;
+                    }
+                }
+                while (ready) {
+                    Connection* conn = ready;
+                    ready = conn->nextReady;
+                    conn->ready = 0;
+                    collectResponses(server, conn);
+                }
+            } else {
+                Connection* conn = (Connection*)tag;
+                uint32_t ev = events[i].events;
+                if (conn->closed) continue;
+                if (ev & EPOLLIN) readInput(server, conn);
+                if (!conn->closed && (ev & (EPOLLHUP | EPOLLERR))) closeConnection(server, conn);
+                if (!conn->closed) {
+                    flushOutput(server, conn);
+                    updateEvents(server, conn);
+                }
+            }
+        }
+
+        if (server->closedCount > 0) {
+            releaseClosedConnections(server);
+        }
+    }
+    return CALC_SUCCESS;
+}
+
+/**
+ * 请求停止事件循环（可在其他线程或信号处理函数中调用）
+ */
+void stopServer(CalcServer* server) {
+    __atomic_store_n(&server->stopRequested, 1, __ATOMIC_RELEASE);
+    wakeEventLoop(server);
+}
+
+/**
+ * 停止计算线程，关闭所有连接并释放服务
+ */
+void destroyServer(CalcServer* server) {
+    if (server == NULL) return;
+
+    if (server->lockInitialized) {
+        pthread_mutex_lock(&server->lock);
+        server->stopping = 1;
+        pthread_cond_broadcast(&server->available);
+        pthread_mutex_unlock(&server->lock);
+    }
+    for (int i = 0; i < server->threadCount; i++) {
+        pthread_join(server->threads[i], NULL);
+    }
+
+    // 所有请求（包括队列中与已完成的）都挂在所属连接上
+    while (server->connections) {
+        Connection* conn = server->connections;
+        server->connections = conn->nextConnection;
+        if (!conn->closed) close(conn->fd);
+        freeConnection(conn);
+    }
+
+    if (server->listenFd >= 0) close(server->listenFd);
+    if (server->epollFd >= 0) close(server->epollFd);
+    if (server->wakeFd >= 0) close(server->wakeFd);
+    if (server->unixPath[0] != '\0') unlink(server->unixPath);
+    if (server->lockInitialized) {
+        pthread_mutex_destroy(&server->lock);
+        pthread_cond_destroy(&server->available);
+    }
+    free(server);
+}
+
+#else // !__linux__
+
+// 服务模式依赖 epoll，其他平台只提供报错的接口
+
+CalcError createServer(const ServerConfig* config, CalcServer** server) {
+    (void)config;
+    *server = NULL;
+    return CALC_ERROR_CODE(ERR_INVALID_FUNCTION, "当前平台不支持服务模式");
+}
+
+int getServerPort(const CalcServer* server) {
+    (void)server;
+    return 0;
+}
+
+CalcError runServer(CalcServer* server) {
+    (void)server;
+    return CALC_ERROR_CODE(ERR_INVALID_FUNCTION, "当前平台不支持服务模式");
+}
+
+void stopServer(CalcServer* server) {
+    (void)server;
+}
+
+void destroyServer(CalcServer* server) {
+    (void)server;
+}
+
+void getServerStats(CalcServer* server, ServerStats* stats) {
+    (void)server;
+    memset(stats, 0, sizeof(*stats));
+}
+
+#endif // __linux__
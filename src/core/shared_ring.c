@@ -0,0 +1,429 @@
+#include "calculator.h"
+#include "shared_ring.h"
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#define RING_MIN_SPIN           64          // 自旋上限的下界
+#define RING_MAX_SPIN           16384       // 自旋上限的上界
+#define RING_RESULT_TIMEOUT_NS  100000000L  // 生产者休眠的超时（用于发现服务已停止）
+#define RING_FULL_SPINS         4096        // 队列满时重试的次数上限
+#define MAX_RING_CAPACITY       (1u << 20)
+
+static inline void cpuRelax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// 共享内存跨进程使用，不能用 FUTEX_PRIVATE_FLAG
+static void futexWait(uint32_t* word, uint32_t expected, long timeoutNs) {
+    struct timespec timeout = {0, timeoutNs};
+    syscall(SYS_futex, word, FUTEX_WAIT, expected, timeoutNs > 0 ? &timeout : NULL, NULL, 0);
+}
+
+static void futexWake(uint32_t* word) {
+    syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+/**
+ * 自旋等待 *word 变为 target，并按结果调整自旋上限
+ * @return 自旋期间等到返回 1，否则返回 0（调用者应改用 futex 休眠）
+ */
+static int spinUntil(SharedRing* ring, const uint32_t* word, uint32_t target) {
+    for (uint32_t i = 0; i < ring->spinLimit; i++) {
+        if (__atomic_load_n(word, __ATOMIC_ACQUIRE) == target) {
+            if (ring->spinLimit < RING_MAX_SPIN) ring->spinLimit *= 2;
+            return 1;
+        }
+        cpuRelax();
+    }
+    if (ring->spinLimit > RING_MIN_SPIN) ring->spinLimit /= 2;
+    return 0;
+}
+
+static CalcError mapSharedRing(int fd, size_t size, SharedRing* ring) {
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法映射共享内存");
+    }
+    ring->header = (RingHeader*)base;
+    ring->slots = (RingSlot*)((char*)base + sizeof(RingHeader));
+    ring->size = size;
+    ring->spinLimit = RING_MIN_SPIN;
+    return CALC_SUCCESS;
+}
+
+// ─── 服务端 ─────────────────────────────────────────────────────────────────
+
+/**
+ * 创建共享队列（服务端调用；同名的旧共享内存会被删除）
+ *
+ * @param name 共享内存名称，如 "/calc"
+ * @param capacity 槽位数，必须是 2 的幂
+ * @param ring 输出，使用完后需调用 closeSharedRing
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+CalcError createSharedRing(const char* name, uint32_t capacity, SharedRing* ring) {
+    memset(ring, 0, sizeof(*ring));
+    if (capacity < 2 || capacity > MAX_RING_CAPACITY || (capacity & (capacity - 1)) != 0) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "槽位数必须是 2 的幂");
+    }
+    if (strlen(name) >= sizeof(ring->name)) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "共享内存名称过长");
+    }
+
+    shm_unlink(name);
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    size_t size = sizeof(RingHeader) + (size_t)capacity * sizeof(RingSlot);
+    if (fd < 0) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法创建共享内存");
+    }
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        shm_unlink(name);
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法设置共享内存大小");
+    }
+    CalcError err = mapSharedRing(fd, size, ring);
+    if (err.code != 0) {
+        shm_unlink(name);
+        return err;
+    }
+    strcpy(ring->name, name);
+    ring->owner = 1;
+
+    // ftruncate 已将内容清零，只需设置槽位序号；magic 最后写入，生产者据此判断初始化完成
+    for (uint32_t i = 0; i < capacity; i++) {
+        ring->slots[i].sequence = i;
+    }
+    ring->header->version = SHARED_RING_VERSION;
+    ring->header->capacity = capacity;
+    ring->header->slotSize = sizeof(RingSlot);
+    __atomic_store_n(&ring->header->magic, SHARED_RING_MAGIC, __ATOMIC_RELEASE);
+    return CALC_SUCCESS;
+}
+
+// 直接对共享内存中的表达式按长度编译求值，结果写回槽位
+static void processRingSlot(RingSlot* slot) {
+    size_t length = slot->length <= MAX_RING_EXPRESSION ? slot->length : MAX_RING_EXPRESSION;
+    AngleMode mode = slot->mode == MODE_RAD ? MODE_RAD : MODE_DEG;
+    double vars[MAX_COMPILED_VARIABLES] = {0};
+    int bound[MAX_COMPILED_VARIABLES] = {0};
+    double value = 0;
+    CompiledExpr prog;
+
+    CalcError err = compileExpressionN(slot->expression, length, &prog);
+    if (err.code != 0) {
+        slot->errorCode = err.code;
+        slot->errorPosition = err.position;
+        slot->result = 0;
+        return;
+    }
+
+    int count = slot->bindingCount <= MAX_RING_BINDINGS ? slot->bindingCount : MAX_RING_BINDINGS;
+    for (int i = 0; i < count && err.code == 0; i++) {
+        const RingBinding* binding = &slot->bindings[i];
+        if (memchr(binding->name, '\0', sizeof(binding->name)) == NULL) {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "变量名过长");
+            break;
+        }
+        int index = findCompiledVariable(&prog, binding->name);
+        if (index >= 0) {
+            vars[index] = binding->value;
+            bound[index] = 1;
+        }
+    }
+    for (int i = 0; i < prog.varCount && err.code == 0; i++) {
+        if (!bound[i]) {
+            err = CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "未绑定的变量");
+        }
+    }
+    if (err.code == 0) {
+        err = evaluateCompiled(&prog, vars, mode, &value);
+    }
+    freeCompiledExpression(&prog);
+
+    slot->errorCode = err.code;
+    slot->errorPosition = err.position;
+    slot->result = err.code == 0 ? value : 0;
+}
+
+/**
+ * 按顺序处理请求，直到 stopSharedRing 被调用（单个消费者）
+ */
+CalcError serveSharedRing(SharedRing* ring) {
+    RingHeader* header = ring->header;
+    uint32_t mask = header->capacity - 1;
+    uint64_t head = __atomic_load_n(&header->head, __ATOMIC_RELAXED);
+
+    while (!__atomic_load_n(&header->stopping, __ATOMIC_ACQUIRE)) {
+        RingSlot* slot = &ring->slots[head & mask];
+
+        if (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) != RING_SLOT_REQUEST) {
+            if (spinUntil(ring, &slot->state, RING_SLOT_REQUEST)) {
+                continue;
+            }
+            // 先读取信号值再检查槽位，生产者在此之后发布的请求一定会改变信号值
+            uint32_t signal = __atomic_load_n(&header->requestSignal, __ATOMIC_SEQ_CST);
+            __atomic_store_n(&header->consumerSleeping, 1, __ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&slot->state, __ATOMIC_SEQ_CST) != RING_SLOT_REQUEST &&
+                !__atomic_load_n(&header->stopping, __ATOMIC_SEQ_CST)) {
+                futexWait(&header->requestSignal, signal, 0);
+            }
+            __atomic_store_n(&header->consumerSleeping, 0, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        processRingSlot(slot);
+        head++;
+        __atomic_store_n(&header->head, head, __ATOMIC_RELEASE);
+        __atomic_store_n(&slot->state, RING_SLOT_DONE, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&slot->waiting, __ATOMIC_SEQ_CST)) {
+            futexWake(&slot->state);
+        }
+    }
+    return CALC_SUCCESS;
+}
+
+/**
+ * 请求停止服务（可在其他线程、其他进程或信号处理函数中调用）
+ */
+void stopSharedRing(SharedRing* ring) {
+    __atomic_store_n(&ring->header->stopping, 1, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&ring->header->requestSignal, 1, __ATOMIC_SEQ_CST);
+    futexWake(&ring->header->requestSignal);
+}
+
+// ─── 生产者 ─────────────────────────────────────────────────────────────────
+
+/**
+ * 连接到已创建的共享队列
+ */
+CalcError openSharedRing(const char* name, SharedRing* ring) {
+    memset(ring, 0, sizeof(*ring));
+    if (strlen(name) >= sizeof(ring->name)) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "共享内存名称过长");
+    }
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "共享内存不存在");
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(RingHeader)) {
+        close(fd);
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "共享内存格式不正确");
+    }
+    CalcError err = mapSharedRing(fd, (size_t)info.st_size, ring);
+    if (err.code != 0) {
+        return err;
+    }
+    strcpy(ring->name, name);
+
+    const RingHeader* header = ring->header;
+    uint32_t capacity = header->capacity;
+    if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SHARED_RING_MAGIC ||
+        header->version != SHARED_RING_VERSION || header->slotSize != sizeof(RingSlot) ||
+        capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        sizeof(RingHeader) + (size_t)capacity * sizeof(RingSlot) > ring->size) {
+        closeSharedRing(ring);
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "共享内存格式不正确");
+    }
+    return CALC_SUCCESS;
+}
+
+/**
+ * 提交一条请求（不等待结果，可以连续提交多条）
+ *
+ * @param expr 表达式（不要求以 '\0' 结尾）
+ * @param len 表达式长度
+ * @param ticket 输出，传给 waitRingResult 取回结果
+ * @return 成功返回 CALC_SUCCESS；队列已满时返回 ERR_STACK_OVERFLOW，调用者应先取回
+ *         已提交请求的结果再重试（结果写回原槽位，未取回的结果会占住槽位）
+ */
+CalcError submitRingRequest(SharedRing* ring, const char* expr, size_t len, AngleMode mode,
+                            const RingBinding* bindings, int bindingCount, uint64_t* ticket) {
+    if (len > MAX_RING_EXPRESSION) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "表达式过长");
+    }
+    if (bindingCount < 0 || bindingCount > MAX_RING_BINDINGS) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "变量绑定过多");
+    }
+
+    RingHeader* header = ring->header;
+    uint32_t mask = header->capacity - 1;
+    uint64_t position = __atomic_load_n(&header->tail, __ATOMIC_RELAXED);
+    RingSlot* slot;
+    uint32_t spins = 0;
+
+    // 多个生产者用 CAS 认领槽位；槽位序号落后于认领位置说明上一轮的结果还未取走（队列已满）
+    while (1) {
+        slot = &ring->slots[position & mask];
+        uint64_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        int64_t difference = (int64_t)(sequence - position);
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(&header->tail, &position, position + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (difference < 0) {
+            if (__atomic_load_n(&header->stopping, __ATOMIC_ACQUIRE)) {
+                return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "计算服务已停止");
+            }
+            if (++spins > RING_FULL_SPINS) {
+                return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "共享队列已满");
+            }
+            if (spins % RING_MIN_SPIN == 0) sched_yield();
+            else cpuRelax();
+            position = __atomic_load_n(&header->tail, __ATOMIC_RELAXED);
+        } else {
+            position = __atomic_load_n(&header->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    memcpy(slot->expression, expr, len);
+    slot->length = (uint16_t)len;
+    slot->mode = (uint8_t)mode;
+    slot->bindingCount = (uint8_t)bindingCount;
+    if (bindingCount > 0) {
+        memcpy(slot->bindings, bindings, (size_t)bindingCount * sizeof(RingBinding));
+    }
+    slot->waiting = 0;
+
+    // 发布请求，消费者休眠时唤醒
+    __atomic_store_n(&slot->state, RING_SLOT_REQUEST, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&header->requestSignal, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&header->consumerSleeping, __ATOMIC_SEQ_CST)) {
+        futexWake(&header->requestSignal);
+    }
+    *ticket = position;
+    return CALC_SUCCESS;
+}
+
+/**
+ * 等待并取回结果，随后释放槽位
+ *
+ * @param ticket submitRingRequest 返回的编号
+ * @param result 输出，计算结果
+ * @return 服务端的错误代码与位置（消息为该错误代码的描述）
+ */
+CalcError waitRingResult(SharedRing* ring, uint64_t ticket, double* result) {
+    RingHeader* header = ring->header;
+    RingSlot* slot = &ring->slots[ticket & (header->capacity - 1)];
+
+    while (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) != RING_SLOT_DONE) {
+        if (spinUntil(ring, &slot->state, RING_SLOT_DONE)) {
+            break;
+        }
+        __atomic_store_n(&slot->waiting, 1, __ATOMIC_SEQ_CST);
+        uint32_t state = __atomic_load_n(&slot->state, __ATOMIC_SEQ_CST);
+        if (state != RING_SLOT_DONE) {
+            futexWait(&slot->state, state, RING_RESULT_TIMEOUT_NS);
+        }
+        if (__atomic_load_n(&slot->state, __ATOMIC_ACQUIRE) != RING_SLOT_DONE &&
+            __atomic_load_n(&header->stopping, __ATOMIC_ACQUIRE)) {
+            return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "计算服务已停止");
+        }
+    }
+
+    CalcError err = CALC_SUCCESS;
+    if (slot->errorCode != 0) {
+        err = CALC_ERROR_CODE_POS(slot->errorCode, getErrorDescription(slot->errorCode), slot->errorPosition);
+    }
+    *result = slot->result;
+
+    // 释放槽位给下一轮的生产者
+    slot->waiting = 0;
+    __atomic_store_n(&slot->state, RING_SLOT_EMPTY, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->sequence, ticket + header->capacity, __ATOMIC_RELEASE);
+    return err;
+}
+
+/**
+ * 提交一条请求并等待结果（没有占用槽位，队列满时一直重试）
+ */
+CalcError evaluateOverRing(SharedRing* ring, const char* expr, size_t len, AngleMode mode,
+                           const RingBinding* bindings, int bindingCount, double* result) {
+    uint64_t ticket;
+    CalcError err;
+    do {
+        err = submitRingRequest(ring, expr, len, mode, bindings, bindingCount, &ticket);
+    } while (err.code == ERR_STACK_OVERFLOW);
+    if (err.code != 0) {
+        return err;
+    }
+    return waitRingResult(ring, ticket, result);
+}
+
+/**
+ * 解除映射；创建者同时删除共享内存
+ */
+void closeSharedRing(SharedRing* ring) {
+    if (ring->header != NULL) {
+        munmap(ring->header, ring->size);
+    }
+    if (ring->owner) {
+        shm_unlink(ring->name);
+    }
+    memset(ring, 0, sizeof(*ring));
+}
+
+#else // !__linux__
+
+// 共享队列依赖 futex，其他平台只提供报错的接口
+
+CalcError createSharedRing(const char* name, uint32_t capacity, SharedRing* ring) {
+    (void)name;
+    (void)capacity;
+    memset(ring, 0, sizeof(*ring));
+    return CALC_ERROR_CODE(ERR_INVALID_FUNCTION, "当前平台不支持共享内存队列");
+}
+
+CalcError serveSharedRing(SharedRing* ring) {
+    (void)ring;
+    return CALC_ERROR_CODE(ERR_INVALID_FUNCTION, "当前平台不支持共享内存队列");
+}
+
+void stopSharedRing(SharedRing* ring) {
+    (void)ring;
+}
+
+CalcError openSharedRing(const char* name, SharedRing* ring) {
+    (void)name;
+    memset(ring, 0, sizeof(*ring));
+    return CALC_ERROR_CODE(ERR_INVALID_FUNCTION, "当前平台不支持共享内存队列");
+}
+
+CalcError submitRingRequest(SharedRing* ring, const char* expr, size_t len, AngleMode mode,
+                            const RingBinding* bindings, int bindingCount, uint64_t* ticket) {
+    (void)ring; (void)expr; (void)len; (void)mode; (void)bindings; (void)bindingCount; (void)ticket;
+    return CALC_ERROR_CODE(ERR_INVALID_FUNCTION, "当前平台不支持共享内存队列");
+}
+
+CalcError waitRingResult(SharedRing* ring, uint64_t ticket, double* result) {
+    (void)ring; (void)ticket; (void)result;
+    return CALC_ERROR_CODE(ERR_INVALID_FUNCTION, "当前平台不支持共享内存队列");
+}
+
+CalcError evaluateOverRing(SharedRing* ring, const char* expr, size_t len, AngleMode mode,
+                           const RingBinding* bindings, int bindingCount, double* result) {
+    (void)ring; (void)expr; (void)len; (void)mode; (void)bindings; (void)bindingCount; (void)result;
+    return CALC_ERROR_CODE(ERR_INVALID_FUNCTION, "当前平台不支持共享内存队列");
+}
+
+void closeSharedRing(SharedRing* ring) {
+    (void)ring;
+}
+
+#endif // __linux__
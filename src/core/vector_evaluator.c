@@ -0,0 +1,509 @@
+#include "calculator.h"
+#include "vector_value.h"
+#include "polynomial_evaluator.h"
+
+// 操作数的元素：标量按长度 1、步长 0 处理
+static inline const double* valueData(const VectorValue* v) {
+    return v->isVector ? v->data : &v->scalar;
+}
+
+static inline size_t valueStep(const VectorValue* v) {
+    return v->isVector ? 1 : 0;
+}
+
+static inline size_t valueCount(const VectorValue* v) {
+    return v->isVector ? v->count : 1;
+}
+
+/**
+ * 逐元素二元运算，标量广播到向量长度
+ */
+static CalcError applyOperation(const Instruction* ins, const VectorValue* lhs, const VectorValue* rhs,
+                                VectorArena* arena, VectorValue* out) {
+    char op = opcodeToOperator(ins->op);
+    ErrorCode code;
+
+    if (!lhs->isVector && !rhs->isVector) {
+        double value;
+        code = performOperationCode(op, lhs->scalar, rhs->scalar, &value);
+        if (code != ERR_SUCCESS) {
+            return CALC_ERROR_CODE_POS(code, describeOperationError(lhs->scalar, rhs->scalar, code),
+                                       ins->position);
+        }
+        *out = scalarValue(value);
+        return CALC_SUCCESS;
+    }
+
+    if (lhs->isVector && rhs->isVector && lhs->count != rhs->count) {
+        return CALC_ERROR_CODE_POS(ERR_INVALID_ARGUMENT, "向量长度不一致", ins->position);
+    }
+    size_t count = lhs->isVector ? lhs->count : rhs->count;
+    double* data = allocateVector(arena, count);
+    if (data == NULL) {
+        return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+    }
+
+    const double* a = valueData(lhs);
+    const double* b = valueData(rhs);
+    size_t aStep = valueStep(lhs), bStep = valueStep(rhs);
+    if (ins->op >= OP_LT && ins->op <= OP_NE) {
+        vectorCompare(op, a, aStep, b, bStep, data, count);
+        *out = vectorValue(data, count);
+        return CALC_SUCCESS;
+    }
+    size_t failed = vectorArithmetic(op, a, aStep, b, bStep, data, count, &code);
+    if (failed < count) {
+        return CALC_ERROR_CODE_POS(code, describeOperationError(a[failed * aStep], b[failed * bStep], code),
+                                   ins->position);
+    }
+    *out = vectorValue(data, count);
+    return CALC_SUCCESS;
+}
+
+/**
+ * 多项式子树：标量与向量的每个元素结果相同（见 evaluatePolynomialArray）
+ * @return 成功返回 1；需要回到原指令求值（或内存不足）时返回 0
+ */
+static int applyPolynomial(const PolynomialPlan* plan, const VectorValue* x, VectorArena* arena, VectorValue* out) {
+    if (!x->isVector) {
+        CalcNumber value;
+        if (!evaluatePolynomialNumber(plan, x->scalar, &value)) {
+            return 0;
+        }
+        *out = scalarValue(value.value);
+        return 1;
+    }
+    double* data = allocateVector(arena, x->count);
+    if (data == NULL || evaluatePolynomialArray(plan, x->data, x->count, data) < x->count) {
+        return 0;
+    }
+    *out = vectorValue(data, x->count);
+    return 1;
+}
+
+/**
+ * POLYNOMIAL_FAST 的子树有元素需要回退时整个子树执行原指令，之后把能改写的元素
+ * 换回改写结果，使每个元素都与标量求值逐位一致（内存不足时保留原指令的结果）
+ */
+static void restorePolynomialElements(const PolynomialPlan* plan, const VectorValue* x, VectorArena* arena,
+                                      VectorValue* value) {
+    if (!x->isVector || !value->isVector || value->count != x->count) {
+        return;
+    }
+    double* data = allocateVector(arena, x->count);
+    if (data == NULL) {
+        return;
+    }
+    for (size_t k = 0; k < x->count; k++) {
+        CalcNumber number;
+        data[k] = evaluatePolynomialNumber(plan, x->data[k], &number) ? number.value : value->data[k];
+    }
+    *value = vectorValue(data, x->count);
+}
+
+/**
+ * 拼接 count 个值（标量作为单个元素）
+ */
+static CalcError packValues(const VectorValue* values, int count, VectorArena* arena, VectorValue* out) {
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += valueCount(&values[i]);
+    }
+    double* data = allocateVector(arena, total);
+    if (data == NULL) {
+        return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+    }
+    size_t offset = 0;
+    for (int i = 0; i < count; i++) {
+        size_t n = valueCount(&values[i]);
+        if (n > 0) {
+            memcpy(data + offset, valueData(&values[i]), n * sizeof(double));
+        }
+        offset += n;
+    }
+    *out = vectorValue(data, total);
+    return CALC_SUCCESS;
+}
+
+/**
+ * 聚合函数：标量参数视为长度为 1 的向量
+ */
+static CalcError reduceValues(const Instruction* ins, const VectorValue* args, VectorValue* out) {
+    AggregateType type = (AggregateType)ins->func;
+    const double* b = NULL;
+    if (ins->slot == 2) {
+        if (valueCount(&args[0]) != valueCount(&args[1])) {
+            return CALC_ERROR_CODE_POS(ERR_INVALID_ARGUMENT, "dot的两个数组长度必须相同", ins->position);
+        }
+        b = valueData(&args[1]);
+    }
+    double value;
+    CalcError err = calculateAggregate(type, valueData(&args[0]), b, valueCount(&args[0]), &value);
+    if (err.code != 0) {
+        err.position = ins->position;
+        return err;
+    }
+    *out = scalarValue(value);
+    return CALC_SUCCESS;
+}
+
+/**
+ * 对向量模式编译的表达式求值
+ * 标量之间的运算与 evaluateCompiled 相同；含向量的运算结果分配在 arena 中，
+ * 结果在 resetVectorArena / freeVectorArena 之前有效
+ *
+ * @param prog   以 compileVectorExpression 编译的表达式
+ * @param vars   变量值，按槽位顺序排列（无变量时可为 NULL）
+ * @param mode   角度模式
+ * @param arena  中间结果与向量结果的分配器
+ * @param result 输出结果（标量或向量）
+ * @return 成功返回 CALC_SUCCESS，否则返回错误（position 为出错运算在表达式中的位置）
+ */
+CalcError evaluateCompiledVector(const CompiledExpr* prog, const VectorValue* vars, AngleMode mode,
+                                 VectorArena* arena, VectorValue* result) {
+    if (prog->length == 0 || prog->maxStack > MAX_EXPR) {
+        return CALC_ERROR_CODE(ERR_SYNTAX, "表达式不完整");
+    }
+    if (!prog->isVector) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "表达式未以向量模式编译");
+    }
+
+    VectorValue stack[MAX_EXPR];
+    int top = -1;
+    const PolynomialPlan* poly = prog->polynomials;
+    const PolynomialPlan* polyEnd = poly + prog->polynomialCount;
+    const PolynomialPlan* pending = NULL;   // 正在按原指令执行、结束后需要换回改写结果的子树
+
+    for (int i = 0; i < prog->length; i++) {
+        const Instruction* ins = &prog->code[i];
+        VectorValue* v;
+        CalcError err = CALC_SUCCESS;
+
+        if (poly < polyEnd && i == poly->start) {
+            if (applyPolynomial(poly, &vars[poly->slot], arena, &stack[top + 1])) {
+                top++;
+                i = poly->end - 1;
+                poly++;
+                continue;
+            }
+            if (poly->fast) {
+                pending = poly;
+            }
+            poly++;
+        }
+
+        switch (ins->op) {
+            case OP_CONST:
+                stack[++top] = scalarValue(ins->value);
+                break;
+
+            case OP_VAR:
+                stack[++top] = vars[ins->slot];
+                break;
+
+            case OP_NEG: {
+                v = &stack[top];
+                if (!v->isVector) {
+                    v->scalar = -v->scalar;
+                    break;
+                }
+                double* data = allocateVector(arena, v->count);
+                if (data == NULL) {
+                    return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+                }
+                vectorNegate(v->data, data, v->count);
+                v->data = data;
+                break;
+            }
+
+            case OP_CALL: {
+                FuncType func = (FuncType)ins->func;
+                ErrorCode code;
+                v = &stack[top];
+                if (!v->isVector) {
+                    double argument = v->scalar;
+                    code = calculateFunctionCode(func, argument, mode, &v->scalar);
+                    if (code != ERR_SUCCESS) {
+                        return CALC_ERROR_CODE_POS(code, describeFunctionError(func, code), ins->position);
+                    }
+                    break;
+                }
+                double* data = allocateVector(arena, v->count);
+                if (data == NULL) {
+                    return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+                }
+                if (vectorFunction(func, v->data, data, v->count, mode, &code) < v->count) {
+                    return CALC_ERROR_CODE_POS(code, describeFunctionError(func, code), ins->position);
+                }
+                v->data = data;
+                break;
+            }
+
+            case OP_PACK:
+                top -= ins->slot - 1;
+                err = packValues(&stack[top], ins->slot, arena, &stack[top]);
+                break;
+
+            case OP_REDUCE:
+                top -= ins->slot - 1;
+                err = reduceValues(ins, &stack[top], &stack[top]);
+                break;
+
+            case OP_NOT: {
+                v = &stack[top];
+                if (!v->isVector) {
+                    v->scalar = (v->scalar == 0);
+                    break;
+                }
+                static const double zero = 0;
+                double* data = allocateVector(arena, v->count);
+                if (data == NULL) {
+                    return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+                }
+                vectorCompare(OPERATOR_EQ, v->data, 1, &zero, 0, data, v->count);
+                v->data = data;
+                break;
+            }
+
+            // 条件分支沿跳转执行，条件与 and / or 的操作数必须是标量
+            case OP_AND:
+            case OP_OR:
+            case OP_BRANCH:
+                v = &stack[top];
+                if (v->isVector) {
+                    return CALC_ERROR_CODE_POS(ERR_INVALID_ARGUMENT, "条件必须是标量", ins->position);
+                }
+                if (ins->op != OP_BRANCH) {
+                    v->scalar = (v->scalar != 0);
+                } else if (!branchTaken(ins, v->scalar)) {
+                    top--;
+                } else {
+                    if (ins->func == OP_SELECT) {
+                        top--;
+                    } else {
+                        v->scalar = (ins->func == OP_OR);
+                    }
+                    i = ins->slot - 1;
+                    poly = seekPolynomialPlan(poly, polyEnd, ins->slot);
+                }
+                break;
+
+            case OP_JUMP:
+                i = ins->slot - 1;
+                poly = seekPolynomialPlan(poly, polyEnd, ins->slot);
+                break;
+
+            case OP_SELECT:
+                break;
+
+            default:
+                top--;
+                err = applyOperation(ins, &stack[top], &stack[top + 1], arena, &stack[top]);
+                break;
+        }
+        if (err.code != 0) {
+            return err;
+        }
+        if (pending && i == pending->end - 1) {
+            restorePolynomialElements(pending, &vars[pending->slot], arena, &stack[top]);
+            pending = NULL;
+        }
+    }
+
+    *result = stack[0];
+    return CALC_SUCCESS;
+}
+
+/**
+ * 编译并求值向量表达式，变量取 bindArrayVariable 绑定的数组
+ */
+CalcError evaluateVectorExpression(const char* expr, AngleMode mode, VectorArena* arena, VectorValue* result) {
+    CompiledExpr prog;
+    CalcError err = compileVectorExpression(expr, &prog);
+    if (err.code != 0) {
+        return err;
+    }
+
+    VectorValue vars[MAX_COMPILED_VARIABLES];
+    for (int slot = 0; slot < prog.varCount; slot++) {
+        const double* data;
+        size_t count;
+        if (!lookupArrayVariable(prog.varNames[slot], strlen(prog.varNames[slot]), &data, &count)) {
+            int position = -1;
+            for (int i = 0; i < prog.length && position < 0; i++) {
+                if (prog.code[i].op == OP_VAR && prog.code[i].slot == slot) {
+                    position = prog.code[i].position;
+                }
+            }
+            freeCompiledExpression(&prog);
+            return CALC_ERROR_CODE_POS(ERR_INVALID_ARGUMENT, "未绑定的数组变量", position);
+        }
+        vars[slot] = vectorValue(data, count);
+    }
+
+    err = evaluateCompiledVector(&prog, vars, mode, arena, result);
+    freeCompiledExpression(&prog);
+    return err;
+}
+
+/**
+ * 编译以 name 为自变量的函数
+ * 不含聚合函数、方括号与条件分支时，只要引用了自变量以外的（数组）变量，函数值就一定是向量，
+ * 这种情况在编译时报错；含聚合函数时留到逐点求值时检查
+ *
+ * @param body    函数表达式
+ * @param name    自变量名，必须能单独编译为一个变量（不能是 pi、e 或函数名）
+ * @param fn      输出的函数，用完后调用 freeVectorFunction
+ * @return 成功返回 CALC_SUCCESS；变量名无效时 position 为 -1，其余错误为 body 内的位置
+ */
+CalcError compileVectorFunction(const char* body, size_t bodyLen, const char* name, size_t nameLen,
+                                VectorFunction* fn) {
+    char variable[MAX_VARIABLE_NAME];
+    if (nameLen == 0 || nameLen >= MAX_VARIABLE_NAME) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "变量名无效");
+    }
+    memcpy(variable, name, nameLen);
+    variable[nameLen] = '\0';
+    CalcError err = compileVectorExpression(variable, &fn->prog);
+    if (err.code != 0) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "变量名无效");
+    }
+    int valid = fn->prog.length == 1 && fn->prog.code[0].op == OP_VAR;
+    freeCompiledExpression(&fn->prog);
+    if (!valid) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "变量名无效");
+    }
+
+    char* text = (char*)malloc(bodyLen + 1);
+    if (text == NULL) {
+        return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+    }
+    memcpy(text, body, bodyLen);
+    text[bodyLen] = '\0';
+    err = compileVectorExpression(text, &fn->prog);
+    free(text);
+    if (err.code != 0) {
+        return err;
+    }
+
+    fn->slot = findCompiledVariable(&fn->prog, variable);
+    fn->vectorized = 1;
+    for (int i = 0; i < fn->prog.length; i++) {
+        int op = fn->prog.code[i].op;
+        if (op == OP_PACK || op == OP_REDUCE || op == OP_BRANCH) {
+            fn->vectorized = 0;     // 条件分支要求标量条件，逐点求值
+        }
+    }
+
+    for (int slot = 0; slot < fn->prog.varCount; slot++) {
+        const double* data;
+        size_t count;
+        if (slot == fn->slot) {
+            fn->vars[slot] = scalarValue(0);
+            continue;
+        }
+        int position = -1;
+        for (int i = 0; i < fn->prog.length && position < 0; i++) {
+            if (fn->prog.code[i].op == OP_VAR && fn->prog.code[i].slot == slot) {
+                position = fn->prog.code[i].position;
+            }
+        }
+        if (!lookupArrayVariable(fn->prog.varNames[slot], strlen(fn->prog.varNames[slot]), &data, &count)) {
+            err = CALC_ERROR_CODE_POS(ERR_INVALID_ARGUMENT, "未绑定的数组变量", position);
+        } else if (fn->vectorized) {
+            err = CALC_ERROR_CODE_POS(ERR_INVALID_ARGUMENT, "函数值必须是标量", position);
+        }
+        if (err.code != 0) {
+            freeCompiledExpression(&fn->prog);
+            return err;
+        }
+        fn->vars[slot] = vectorValue(data, count);
+    }
+    return CALC_SUCCESS;
+}
+
+/**
+ * 求 fn 在 x[0..count) 处的值
+ * 可以整体求值时自变量作为一个向量参与运算（SIMD 内核），否则逐点求值
+ *
+ * @param arena 中间结果的分配器，返回前会 reset
+ * @param out   输出 count 个函数值
+ * @return 成功返回 CALC_SUCCESS，否则返回出错运算的错误（position 为 body 内的位置）
+ */
+CalcError evaluateVectorFunction(const VectorFunction* fn, const double* x, size_t count, AngleMode mode,
+                                 VectorArena* arena, double* out) {
+    VectorValue vars[MAX_COMPILED_VARIABLES];
+    VectorValue value;
+    CalcError err = CALC_SUCCESS;
+
+    memcpy(vars, fn->vars, (size_t)fn->prog.varCount * sizeof(VectorValue));
+    if (!fn->vectorized) {
+        for (size_t i = 0; i < count && err.code == 0; i++) {
+            if (fn->slot >= 0) {
+                vars[fn->slot] = scalarValue(x[i]);
+            }
+            err = evaluateCompiledVector(&fn->prog, vars, mode, arena, &value);
+            if (err.code == 0 && value.isVector) {
+                err = CALC_ERROR_CODE_POS(ERR_INVALID_ARGUMENT, "函数值必须是标量", 0);
+            }
+            if (err.code == 0) {
+                out[i] = value.scalar;
+            }
+            resetVectorArena(arena);
+        }
+        return err;
+    }
+
+    if (fn->slot >= 0) {
+        vars[fn->slot] = vectorValue(x, count);
+    }
+    err = evaluateCompiledVector(&fn->prog, vars, mode, arena, &value);
+    if (err.code == 0) {
+        if (!value.isVector) {
+            // 与自变量无关：广播
+            for (size_t i = 0; i < count; i++) {
+                out[i] = value.scalar;
+            }
+        } else {
+            memcpy(out, value.data, count * sizeof(double));
+        }
+    }
+    resetVectorArena(arena);
+    return err;
+}
+
+void freeVectorFunction(VectorFunction* fn) {
+    freeCompiledExpression(&fn->prog);
+}
+
+/**
+ * 格式化为 [1, 2, 3]（标量直接格式化），元素过多或缓冲区不足时以 ... 结尾
+ */
+char* formatVector(const VectorValue* value, char* buffer, size_t bufferSize) {
+    if (!value->isVector) {
+        return formatNumber(value->scalar, buffer, bufferSize);
+    }
+
+    size_t length = 0;
+    buffer[length++] = '[';
+    for (size_t i = 0; i < value->count; i++) {
+        char item[50];
+        formatNumber(value->data[i], item, sizeof(item));
+        size_t itemLength = strlen(item);
+        // 留出 ", ...]" 与结尾 '\0' 的位置
+        if (i == VECTOR_FORMAT_ITEMS || length + itemLength + 8 > bufferSize) {
+            memcpy(buffer + length, "...", 3);
+            length += 3;
+            break;
+        }
+        memcpy(buffer + length, item, itemLength);
+        length += itemLength;
+        if (i + 1 < value->count) {
+            memcpy(buffer + length, ", ", 2);
+            length += 2;
+        }
+    }
+    buffer[length++] = ']';
+    buffer[length] = '\0';
+    return buffer;
+}
@@ -0,0 +1,393 @@
+#include "calculator.h"
+#include "aggregate_functions.h"
+#ifndef _WIN32
+    #include <pthread.h>
+    #include <unistd.h>
+#endif
+
+// 数组变量绑定表
+typedef struct {
+    char name[MAX_VARIABLE_NAME];
+    const double* data;
+    size_t count;
+    int used;
+} ArrayBinding;
+
+static ArrayBinding arrayBindings[MAX_ARRAY_VARIABLES];
+
+/**
+ * 在绑定表中查找变量（nameLen 允许 name 不以 '\0' 结尾）
+ * @return 找到返回下标，否则返回 -1
+ */
+static int findArrayBinding(const char* name, size_t nameLen) {
+    if (nameLen == 0 || nameLen >= MAX_VARIABLE_NAME) {
+        return -1;
+    }
+    for (int i = 0; i < MAX_ARRAY_VARIABLES; i++) {
+        if (arrayBindings[i].used && strncmp(arrayBindings[i].name, name, nameLen) == 0 &&
+            arrayBindings[i].name[nameLen] == '\0') {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * 绑定数组变量（同名变量会被覆盖）
+ * 只保存指针，调用方需保证数据在使用期间有效
+ */
+CalcError bindArrayVariable(const char* name, const double* data, size_t count) {
+    if (!name || !isalpha((unsigned char)name[0])) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无效的变量名");
+    }
+    size_t nameLen = strlen(name);
+    if (nameLen >= MAX_VARIABLE_NAME) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "变量名过长");
+    }
+    for (size_t i = 0; i < nameLen; i++) {
+        if (!isalnum((unsigned char)name[i]) && name[i] != '_') {
+            return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无效的变量名");
+        }
+    }
+    if (data == NULL && count > 0) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "数组数据不能为空");
+    }
+
+    int slot = findArrayBinding(name, nameLen);
+    if (slot < 0) {
+        for (int i = 0; i < MAX_ARRAY_VARIABLES; i++) {
+            if (!arrayBindings[i].used) {
+                slot = i;
+                break;
+            }
+        }
+    }
+    if (slot < 0) {
+        return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "数组变量过多");
+    }
+
+    snprintf(arrayBindings[slot].name, MAX_VARIABLE_NAME, "%s", name);
+    arrayBindings[slot].data = data;
+    arrayBindings[slot].count = count;
+    arrayBindings[slot].used = 1;
+    return CALC_SUCCESS;
+}
+
+// 解除数组变量绑定
+void unbindArrayVariable(const char* name) {
+    int slot = findArrayBinding(name, strlen(name));
+    if (slot >= 0) {
+        arrayBindings[slot].used = 0;
+    }
+}
+
+// 清空所有数组变量
+void clearArrayVariables(void) {
+    for (int i = 0; i < MAX_ARRAY_VARIABLES; i++) {
+        arrayBindings[i].used = 0;
+    }
+}
+
+/**
+ * 查找数组变量
+ * @return 找到返回 1，否则返回 0
+ */
+int lookupArrayVariable(const char* name, size_t nameLen, const double** data, size_t* count) {
+    int slot = findArrayBinding(name, nameLen);
+    if (slot < 0) {
+        return 0;
+    }
+    *data = arrayBindings[slot].data;
+    *count = arrayBindings[slot].count;
+    return 1;
+}
+
+// 获取聚合函数类型（失败时恢复指针位置）
+AggregateType getAggregateFunction(const char** expr) {
+    const char* start = *expr;
+    char func[6] = {0};
+    int i = 0;
+
+    while (isalpha((unsigned char)**expr) && i < 5) {
+        func[i++] = tolower(**expr);
+        (*expr)++;
+    }
+    func[i] = '\0';
+
+    // 名字后面还有字母说明是更长的标识符
+    if (!isalpha((unsigned char)**expr)) {
+        if (strcmp(func, "sum") == 0) return AGG_SUM;
+        if (strcmp(func, "mean") == 0) return AGG_MEAN;
+        if (strcmp(func, "min") == 0) return AGG_MIN;
+        if (strcmp(func, "max") == 0) return AGG_MAX;
+        if (strcmp(func, "norm") == 0) return AGG_NORM;
+        if (strcmp(func, "dot") == 0) return AGG_DOT;
+    }
+
+    *expr = start;
+    return AGG_NONE;
+}
+
+// 聚合函数参数个数
+int getAggregateArity(AggregateType type) {
+    return type == AGG_DOT ? 2 : 1;
+}
+
+// ─── 归约内核 ───────────────────────────────────────────────────────────────
+
+/**
+ * 叶子块求和：4 路 Kahan 补偿累加
+ * 各路之间没有依赖，编译器可将其向量化
+ */
+static double sumBlock(const double* data, size_t count) {
+    double s[4] = {0, 0, 0, 0};
+    double c[4] = {0, 0, 0, 0};
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        for (int k = 0; k < 4; k++) {
+            double y = data[i + k] - c[k];
+            double t = s[k] + y;
+            c[k] = (t - s[k]) - y;
+            s[k] = t;
+        }
+    }
+    double tail = 0;
+    for (; i < count; i++) {
+        tail += data[i];
+    }
+    return ((s[0] + s[1]) + (s[2] + s[3])) - ((c[0] + c[1]) + (c[2] + c[3])) + tail;
+}
+
+// 叶子块点积：4 路 Kahan 补偿累加
+static double dotBlock(const double* a, const double* b, size_t count) {
+    double s[4] = {0, 0, 0, 0};
+    double c[4] = {0, 0, 0, 0};
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4) {
+        for (int k = 0; k < 4; k++) {
+            double y = a[i + k] * b[i + k] - c[k];
+            double t = s[k] + y;
+            c[k] = (t - s[k]) - y;
+            s[k] = t;
+        }
+    }
+    double tail = 0;
+    for (; i < count; i++) {
+        tail += a[i] * b[i];
+    }
+    return ((s[0] + s[1]) + (s[2] + s[3])) - ((c[0] + c[1]) + (c[2] + c[3])) + tail;
+}
+
+// 成对求和：递归二分直到叶子块大小
+static double sumPairwise(const double* data, size_t count) {
+    if (count <= AGGREGATE_BLOCK_SIZE) {
+        return sumBlock(data, count);
+    }
+    size_t half = (count / 2 + AGGREGATE_BLOCK_SIZE - 1) / AGGREGATE_BLOCK_SIZE * AGGREGATE_BLOCK_SIZE;
+    return sumPairwise(data, half) + sumPairwise(data + half, count - half);
+}
+
+// 成对点积
+static double dotPairwise(const double* a, const double* b, size_t count) {
+    if (count <= AGGREGATE_BLOCK_SIZE) {
+        return dotBlock(a, b, count);
+    }
+    size_t half = (count / 2 + AGGREGATE_BLOCK_SIZE - 1) / AGGREGATE_BLOCK_SIZE * AGGREGATE_BLOCK_SIZE;
+    return dotPairwise(a, b, half) + dotPairwise(a + half, b + half, count - half);
+}
+
+// 最小值/最大值：4 路比较（count 必须大于 0）
+static double minMaxBlock(const double* data, size_t count, int wantMax) {
+    double m[4] = {data[0], data[0], data[0], data[0]};
+    size_t i = 0;
+
+    if (wantMax) {
+        for (; i + 4 <= count; i += 4) {
+            for (int k = 0; k < 4; k++) {
+                m[k] = data[i + k] > m[k] ? data[i + k] : m[k];
+            }
+        }
+        for (; i < count; i++) {
+            m[0] = data[i] > m[0] ? data[i] : m[0];
+        }
+        double x = m[0] > m[1] ? m[0] : m[1];
+        double y = m[2] > m[3] ? m[2] : m[3];
+        return x > y ? x : y;
+    }
+
+    for (; i + 4 <= count; i += 4) {
+        for (int k = 0; k < 4; k++) {
+            m[k] = data[i + k] < m[k] ? data[i + k] : m[k];
+        }
+    }
+    for (; i < count; i++) {
+        m[0] = data[i] < m[0] ? data[i] : m[0];
+    }
+    double x = m[0] < m[1] ? m[0] : m[1];
+    double y = m[2] < m[3] ? m[2] : m[3];
+    return x < y ? x : y;
+}
+
+// 串行归约一段数据（sum/dot/min/max 四种基本归约）
+static double reduceRange(AggregateType type, const double* a, const double* b, size_t count) {
+    switch (type) {
+        case AGG_SUM:
+            return sumPairwise(a, count);
+        case AGG_DOT:
+            return dotPairwise(a, b, count);
+        case AGG_MIN:
+            return minMaxBlock(a, count, 0);
+        case AGG_MAX:
+            return minMaxBlock(a, count, 1);
+        default:
+            return 0;
+    }
+}
+
+// ─── 并行分块 ───────────────────────────────────────────────────────────────
+
+typedef struct {
+    AggregateType type;
+    const double* a;
+    const double* b;
+    size_t count;
+    double value;
+} ReduceChunk;
+
+#ifndef _WIN32
+static void* runReduceChunk(void* arg) {
+    ReduceChunk* chunk = (ReduceChunk*)arg;
+    chunk->value = reduceRange(chunk->type, chunk->a, chunk->b, chunk->count);
+    return NULL;
+}
+#endif
+
+/**
+ * 对大数组按块并行归约
+ * 块边界对齐到 AGGREGATE_BLOCK_SIZE，部分结果按块顺序合并，
+ * 结果不依赖线程调度顺序
+ */
+static double reduceArray(AggregateType type, const double* a, const double* b, size_t count) {
+    int threads = 1;
+#ifndef _WIN32
+    if (count >= AGGREGATE_PARALLEL_THRESHOLD) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (int)(count / (AGGREGATE_PARALLEL_THRESHOLD / 2));
+        if (threads > AGGREGATE_MAX_THREADS) threads = AGGREGATE_MAX_THREADS;
+        if (cpus > 0 && threads > cpus) threads = (int)cpus;
+    }
+#endif
+    if (threads <= 1) {
+        return reduceRange(type, a, b, count);
+    }
+
+#ifndef _WIN32
+    ReduceChunk chunks[AGGREGATE_MAX_THREADS];
+    pthread_t tids[AGGREGATE_MAX_THREADS];
+    int started[AGGREGATE_MAX_THREADS] = {0};
+    size_t per = (count / threads + AGGREGATE_BLOCK_SIZE - 1) / AGGREGATE_BLOCK_SIZE * AGGREGATE_BLOCK_SIZE;
+    size_t offset = 0;
+
+    for (int t = 0; t < threads; t++) {
+        size_t n = (t == threads - 1 || offset + per > count) ? count - offset : per;
+        chunks[t].type = type;
+        chunks[t].a = a + offset;
+        chunks[t].b = b ? b + offset : NULL;
+        chunks[t].count = n;
+        offset += n;
+        // 第 0 块由当前线程计算；线程创建失败时也退化为当前线程计算
+        if (t > 0 && n > 0 && pthread_create(&tids[t], NULL, runReduceChunk, &chunks[t]) == 0) {
+            started[t] = 1;
+        }
+    }
+    for (int t = 0; t < threads; t++) {
+        if (!started[t] && chunks[t].count > 0) {
+            chunks[t].value = reduceRange(type, chunks[t].a, chunks[t].b, chunks[t].count);
+        }
+    }
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) pthread_join(tids[t], NULL);
+    }
+
+    double result = chunks[0].value;
+    for (int t = 1; t < threads; t++) {
+        if (chunks[t].count == 0) continue;
+        if (type == AGG_MIN) {
+            result = chunks[t].value < result ? chunks[t].value : result;
+        } else if (type == AGG_MAX) {
+            result = chunks[t].value > result ? chunks[t].value : result;
+        } else {
+            result += chunks[t].value;
+        }
+    }
+    return result;
+#else
+    return reduceRange(type, a, b, count);
+#endif
+}
+
+// 数组求和（成对 + Kahan 补偿）
+double sumArray(const double* data, size_t count) {
+    return count > 0 ? reduceArray(AGG_SUM, data, NULL, count) : 0.0;
+}
+
+// 数组点积（成对 + Kahan 补偿）
+double dotArrays(const double* a, const double* b, size_t count) {
+    return count > 0 ? reduceArray(AGG_DOT, a, b, count) : 0.0;
+}
+
+/**
+ * 计算聚合函数
+ * @param a      第一个数组
+ * @param b      第二个数组（仅 dot 使用，长度需与 a 相同）
+ * @param count  数组长度
+ */
+CalcError calculateAggregate(AggregateType type, const double* a, const double* b,
+                             size_t count, double* result) {
+    switch (type) {
+        case AGG_SUM:
+            *result = sumArray(a, count);
+            break;
+
+        case AGG_MEAN:
+            if (count == 0) {
+                return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "mean的参数不能为空数组");
+            }
+            *result = sumArray(a, count) / (double)count;
+            break;
+
+        case AGG_MIN:
+        case AGG_MAX:
+            if (count == 0) {
+                return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT,
+                                       type == AGG_MIN ? "min的参数不能为空数组" : "max的参数不能为空数组");
+            }
+            *result = reduceArray(type, a, NULL, count);
+            break;
+
+        case AGG_NORM:
+            *result = sqrt(dotArrays(a, a, count));
+            break;
+
+        case AGG_DOT:
+            *result = dotArrays(a, b, count);
+            break;
+
+        default:
+            return CALC_ERROR_CODE(ERR_INVALID_FUNCTION, "无效的函数");
+    }
+
+    if (isInfinite(*result)) {
+        return CALC_ERROR_CODE(ERR_OVERFLOW, "计算结果太大");
+    }
+
+    // 与普通函数保持一致：处理接近整数的结果
+    int64_t intValue;
+    if (isCloseToInteger(*result, &intValue)) {
+        *result = intValue;
+    }
+
+    return CALC_SUCCESS;
+}
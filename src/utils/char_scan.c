@@ -0,0 +1,250 @@
+#include "calculator.h"
+#include "char_scan.h"
+
+// 定义 CHAR_SCAN_SCALAR 时强制使用查表实现
+#if !defined(CHAR_SCAN_SCALAR) && (defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)))
+#define SCAN_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define SCAN_AVX2           // 运行时检测 CPU 是否支持
+#include <immintrin.h>
+#endif
+#endif
+
+#define SCAN_WORD_BYTES 64
+
+// 每字节一位：CHAR_SPACE 为最低位，依次到 CHAR_OPERATOR（非 ASCII 字节不属于任何类别）
+const unsigned char charClassTable[256] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x40, 0x80, 0x80, 0x00, 0x80, 0x10, 0x80,
+    0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A,
+    0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x80, 0x08,
+    0x00, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A,
+    0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+static inline int countTrailingZeros(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(bits);
+#else
+    int count = 0;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        count++;
+    }
+    return count;
+#endif
+}
+
+static inline int countBits(uint64_t bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(bits);
+#else
+    int count = 0;
+    for (; bits; bits &= bits - 1) count++;
+    return count;
+#endif
+}
+
+// ─── 分类 ───────────────────────────────────────────────────────────────────
+//
+// 每个分类函数处理 count 个完整的 64 字节块，第 w 块 cls 类的位图写入
+// maps[cls * stride + w]。范围判断 lo <= c <= hi 平移到有符号数的最小值处后
+// 只需一次有符号比较；非 ASCII 字节为负数，不会落在任何区间内。
+
+typedef void (*ClassifyFunc)(const unsigned char* bytes, size_t count, uint64_t* maps, size_t stride);
+
+#ifndef SCAN_SSE2
+static void classifyScalar(const unsigned char* bytes, size_t count, uint64_t* maps, size_t stride) {
+    for (size_t w = 0; w < count; w++, bytes += SCAN_WORD_BYTES) {
+        uint64_t out[CHAR_CLASS_COUNT] = {0};
+        for (int i = 0; i < SCAN_WORD_BYTES; i++) {
+            unsigned int classes = charClassTable[bytes[i]];
+            for (int cls = 0; classes; cls++, classes >>= 1) {
+                out[cls] |= (uint64_t)(classes & 1) << i;
+            }
+        }
+        for (int cls = 0; cls < CHAR_CLASS_COUNT; cls++) {
+            maps[cls * stride + w] = out[cls];
+        }
+    }
+}
+#endif
+
+// 一组向量比较得到 LANES 个字节的各类掩码，按 lane 偏移合并到 64 位位图
+#define CLASSIFY_LANES(LANES, LOAD, SET1, EQ, GT, ADD, OR, MASK)                                   \
+    for (size_t w = 0; w < count; w++, bytes += SCAN_WORD_BYTES) {                                  \
+        uint64_t space = 0, alpha = 0, digit = 0, word = 0, number = 0, open = 0, close = 0, op = 0; \
+        for (int lane = 0; lane < SCAN_WORD_BYTES; lane += LANES) {                                 \
+            c = LOAD(bytes + lane);                                                                 \
+            lower = OR(c, SET1(0x20));                                                              \
+            uint64_t alphaBits = MASK(GT(SET1(-128 + 26), ADD(lower, SET1(-128 - 'a'))));            \
+            uint64_t digitBits = MASK(GT(SET1(-128 + 10), ADD(c, SET1(-128 - '0'))));                \
+            /* '*' 与 '+' 相邻，用一次区间比较 */                                                    \
+            uint64_t opBits = MASK(OR(OR(GT(SET1(-128 + 2), ADD(c, SET1(-128 - '*'))), EQ(c, SET1('^'))), \
+                                      OR(EQ(c, SET1('-')), EQ(c, SET1('/')))));                     \
+            space |= MASK(EQ(c, SET1(' '))) << lane;                                                \
+            alpha |= alphaBits << lane;                                                             \
+            digit |= digitBits << lane;                                                             \
+            word |= (alphaBits | digitBits | MASK(EQ(c, SET1('_')))) << lane;                       \
+            number |= (digitBits | MASK(EQ(c, SET1('.')))) << lane;                                 \
+            open |= MASK(EQ(c, SET1('('))) << lane;                                                 \
+            close |= MASK(EQ(c, SET1(')'))) << lane;                                                \
+            op |= opBits << lane;                                                                   \
+        }                                                                                           \
+        maps[CHAR_SPACE * stride + w] = space;                                                      \
+        maps[CHAR_ALPHA * stride + w] = alpha;                                                      \
+        maps[CHAR_DIGIT * stride + w] = digit;                                                      \
+        maps[CHAR_WORD * stride + w] = word;                                                        \
+        maps[CHAR_NUMBER * stride + w] = number;                                                    \
+        maps[CHAR_OPEN * stride + w] = open;                                                        \
+        maps[CHAR_CLOSE * stride + w] = close;                                                      \
+        maps[CHAR_OPERATOR * stride + w] = op;                                                      \
+    }
+
+#ifdef SCAN_SSE2
+#define SSE2_LOAD(p)    _mm_loadu_si128((const __m128i*)(p))
+#define SSE2_SET1(x)    _mm_set1_epi8((char)(x))
+#define SSE2_MASK(v)    ((uint64_t)(uint16_t)_mm_movemask_epi8(v))
+
+static void classifySse2(const unsigned char* bytes, size_t count, uint64_t* maps, size_t stride) {
+    __m128i c, lower;
+    CLASSIFY_LANES(16, SSE2_LOAD, SSE2_SET1, _mm_cmpeq_epi8, _mm_cmpgt_epi8, _mm_add_epi8, _mm_or_si128,
+                   SSE2_MASK)
+}
+#endif
+
+#ifdef SCAN_AVX2
+#define AVX2_LOAD(p)    _mm256_loadu_si256((const __m256i*)(p))
+#define AVX2_SET1(x)    _mm256_set1_epi8((char)(x))
+#define AVX2_MASK(v)    ((uint64_t)(uint32_t)_mm256_movemask_epi8(v))
+
+__attribute__((target("avx2")))
+static void classifyAvx2(const unsigned char* bytes, size_t count, uint64_t* maps, size_t stride) {
+    __m256i c, lower;
+    CLASSIFY_LANES(32, AVX2_LOAD, AVX2_SET1, _mm256_cmpeq_epi8, _mm256_cmpgt_epi8, _mm256_add_epi8,
+                   _mm256_or_si256, AVX2_MASK)
+}
+#endif
+
+// 选择当前 CPU 可用的最宽实现（__builtin_cpu_supports 只读取启动时缓存的 CPU 信息）
+static ClassifyFunc selectClassifier(void) {
+#ifdef SCAN_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return classifyAvx2;
+    }
+#endif
+#ifdef SCAN_SSE2
+    return classifySse2;
+#else
+    return classifyScalar;
+#endif
+}
+
+/**
+ * 对表达式分类，结果用完后调用 freeCharScan 释放
+ */
+CalcError scanCharacters(const char* expr, size_t len, CharScan* scan) {
+    scan->length = len;
+    scan->words = len / SCAN_WORD_BYTES + 1;   // 末尾至少留一个不完整的字，跳转时不会越界
+    scan->maps = scan->inlineMaps;
+    if (scan->words > CHAR_SCAN_INLINE_WORDS) {
+        scan->maps = (uint64_t*)malloc(CHAR_CLASS_COUNT * scan->words * sizeof(uint64_t));
+        if (scan->maps == NULL) {
+            scan->maps = scan->inlineMaps;
+            scan->words = 0;
+            return CALC_ERROR_CODE(ERR_STACK_OVERFLOW, "内存分配失败");
+        }
+    }
+
+    ClassifyFunc classify = selectClassifier();
+
+    // 完整的块直接分类，最后不足 64 字节的部分补 '\0'（不属于任何类别）
+    size_t full = len / SCAN_WORD_BYTES;
+    unsigned char tail[SCAN_WORD_BYTES] = {0};
+    classify((const unsigned char*)expr, full, scan->maps, scan->words);
+    memcpy(tail, expr + full * SCAN_WORD_BYTES, len - full * SCAN_WORD_BYTES);
+    classify(tail, 1, scan->maps + full, scan->words);
+    return CALC_SUCCESS;
+}
+
+void freeCharScan(CharScan* scan) {
+    if (scan->maps != scan->inlineMaps) {
+        free(scan->maps);
+    }
+    scan->maps = scan->inlineMaps;
+    scan->words = 0;
+}
+
+// ─── 查询 ───────────────────────────────────────────────────────────────────
+
+size_t skipCharClass(const CharScan* scan, CharClass cls, size_t pos) {
+    if (pos >= scan->length) {
+        return scan->length;
+    }
+    const uint64_t* map = scan->maps + (size_t)cls * scan->words;
+    size_t w = pos / SCAN_WORD_BYTES;
+    uint64_t outside = ~map[w] & (~(uint64_t)0 << (pos % SCAN_WORD_BYTES));
+    while (outside == 0) {   // 表达式之后的位都为 0，最后一个字一定能停下
+        outside = ~map[++w];
+    }
+    size_t next = w * SCAN_WORD_BYTES + (size_t)countTrailingZeros(outside);
+    return next < scan->length ? next : scan->length;
+}
+
+size_t trimTrailingSpaces(const CharScan* scan) {
+    const uint64_t* spaces = scan->maps + (size_t)CHAR_SPACE * scan->words;
+    size_t end = scan->length;
+    while (end > 0) {
+        size_t w = (end - 1) / SCAN_WORD_BYTES;
+        int bit = (int)((end - 1) % SCAN_WORD_BYTES);
+        uint64_t nonSpace = ~spaces[w] & (~(uint64_t)0 >> (SCAN_WORD_BYTES - 1 - bit));
+        if (nonSpace != 0) {
+            int top = 63;
+            while (!((nonSpace >> top) & 1)) top--;
+            return w * SCAN_WORD_BYTES + (size_t)top + 1;
+        }
+        end = w * SCAN_WORD_BYTES;
+    }
+    return 0;
+}
+
+int scanHasClass(const CharScan* scan, CharClass cls, size_t pos) {
+    if (pos >= scan->length) {
+        return 0;
+    }
+    return (int)((scan->maps[(size_t)cls * scan->words + pos / SCAN_WORD_BYTES] >> (pos % SCAN_WORD_BYTES)) & 1);
+}
+
+/**
+ * 括号深度检查：按 64 字节一组累加（左括号数 - 右括号数）。只有一组中的右括号数
+ * 超过进入该组时的深度，深度才可能在组内变为负数，此时才逐个括号累加定位
+ */
+CalcError checkBracketDepth(const CharScan* scan) {
+    const uint64_t* opens = scan->maps + (size_t)CHAR_OPEN * scan->words;
+    const uint64_t* closes = scan->maps + (size_t)CHAR_CLOSE * scan->words;
+    long depth = 0;
+    for (size_t w = 0; w < scan->words; w++) {
+        int closeCount = countBits(closes[w]);
+        if (closeCount <= depth) {
+            depth += countBits(opens[w]) - closeCount;
+            continue;
+        }
+        for (uint64_t parens = opens[w] | closes[w]; parens; parens &= parens - 1) {
+            int bit = countTrailingZeros(parens);
+            if ((closes[w] >> bit) & 1) {
+                if (--depth < 0) {
+                    return CALC_ERROR_POS("括号不匹配：右括号过多", (int)(w * SCAN_WORD_BYTES + (size_t)bit));
+                }
+            } else {
+                depth++;
+            }
+        }
+    }
+    if (depth > 0) {
+        return CALC_ERROR_CODE(ERR_MISSING_PARENTHESIS, "括号不匹配：左括号过多");
+    }
+    return CALC_SUCCESS;
+}
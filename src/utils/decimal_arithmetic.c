@@ -0,0 +1,304 @@
+#include "calculator.h"
+
+// 10^0 ~ 10^19
+static const uint64_t POW10[20] = {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL,
+    100000000ULL, 1000000000ULL, 10000000000ULL, 100000000000ULL, 1000000000000ULL,
+    10000000000000ULL, 100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+    100000000000000000ULL, 1000000000000000000ULL, 10000000000000000000ULL
+};
+
+#define DECIMAL_OVERFLOW CALC_ERROR_CODE(ERR_OVERFLOW, "计算结果太大")
+#define DECIMAL_POW_GUARD_DIGITS 6   // 幂运算中间结果额外保留的小数位数
+
+static uint64_t magnitude(int64_t value) {
+    return value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+}
+
+// 64 位 × 64 位 = 128 位（hi:lo）
+static void multiplyU64(uint64_t a, uint64_t b, uint64_t* hi, uint64_t* lo) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 product = (unsigned __int128)a * b;
+    *hi = (uint64_t)(product >> 64);
+    *lo = (uint64_t)product;
+#else
+    uint64_t aLo = a & 0xffffffffu, aHi = a >> 32;
+    uint64_t bLo = b & 0xffffffffu, bHi = b >> 32;
+    uint64_t ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+    uint64_t mid = (ll >> 32) + (lh & 0xffffffffu) + (hl & 0xffffffffu);
+    *lo = (mid << 32) | (ll & 0xffffffffu);
+    *hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+// 128 位 ÷ 64 位，要求 hi < divisor 且 divisor <= 2^63
+static void divideU128(uint64_t hi, uint64_t lo, uint64_t divisor, uint64_t* quotient, uint64_t* remainder) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 dividend = ((unsigned __int128)hi << 64) | lo;
+    *quotient = (uint64_t)(dividend / divisor);
+    *remainder = (uint64_t)(dividend % divisor);
+#else
+    uint64_t rem = hi, quot = 0;
+    for (int i = 63; i >= 0; i--) {
+        rem = (rem << 1) | ((lo >> i) & 1);
+        quot <<= 1;
+        if (rem >= divisor) {
+            rem -= divisor;
+            quot |= 1;
+        }
+    }
+    *quotient = quot;
+    *remainder = rem;
+#endif
+}
+
+// 余数与除数一半的比较：-1 小于一半，0 恰好一半，1 大于一半
+static int compareHalf(uint64_t remainder, uint64_t divisor) {
+    uint64_t other = divisor - remainder;
+    return remainder > other ? 1 : (remainder < other ? -1 : 0);
+}
+
+/**
+ * 截断后的商是否需要加 1（按绝对值）
+ *
+ * @param quotient 截断后的商（绝对值）
+ * @param half     舍去部分与 0.5 的比较结果
+ * @param inexact  舍去部分是否非零
+ * @param negative 结果是否为负数
+ */
+static int roundingIncrement(uint64_t quotient, int half, int inexact, int negative, DecimalRounding rounding) {
+    switch (rounding) {
+        case DEC_ROUND_HALF_EVEN: return half > 0 || (half == 0 && inexact && (quotient & 1));
+        case DEC_ROUND_HALF_UP:   return half >= 0 && inexact;
+        case DEC_ROUND_FLOOR:     return inexact && negative;
+        case DEC_ROUND_CEILING:   return inexact && !negative;
+        default:                  return 0;
+    }
+}
+
+// 将带符号的绝对值转为尾数，超出 ±INT64_MAX 时报告溢出
+static CalcError toMantissa(uint64_t value, int negative, int64_t* mantissa) {
+    if (value > (uint64_t)INT64_MAX) {
+        return DECIMAL_OVERFLOW;
+    }
+    *mantissa = negative ? -(int64_t)value : (int64_t)value;
+    return CALC_SUCCESS;
+}
+
+// (hi:lo) / divisor，按舍入方式取整
+static CalcError divideRounded(uint64_t hi, uint64_t lo, uint64_t divisor, int negative,
+                               DecimalRounding rounding, int64_t* mantissa) {
+    if (hi >= divisor) {
+        return DECIMAL_OVERFLOW;
+    }
+    uint64_t quotient, remainder;
+    divideU128(hi, lo, divisor, &quotient, &remainder);
+    if (remainder != 0 &&
+        roundingIncrement(quotient, compareHalf(remainder, divisor), 1, negative, rounding)) {
+        if (quotient == UINT64_MAX) return DECIMAL_OVERFLOW;
+        quotient++;
+    }
+    return toMantissa(quotient, negative, mantissa);
+}
+
+/**
+ * 改变小数位数：增加位数时精确，减少位数时按舍入方式处理
+ */
+CalcError rescaleDecimal(Decimal value, int scale, DecimalRounding rounding, Decimal* result) {
+    if (scale < 0 || scale > MAX_DECIMAL_SCALE || value.scale < 0 || value.scale > MAX_DECIMAL_SCALE) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "小数位数超出范围");
+    }
+
+    int negative = value.mantissa < 0;
+    uint64_t hi, lo;
+    CalcError err;
+    if (scale >= value.scale) {
+        multiplyU64(magnitude(value.mantissa), POW10[scale - value.scale], &hi, &lo);
+        if (hi != 0) return DECIMAL_OVERFLOW;
+        err = toMantissa(lo, negative, &result->mantissa);
+    } else {
+        err = divideRounded(0, magnitude(value.mantissa), POW10[value.scale - scale], negative,
+                            rounding, &result->mantissa);
+    }
+    if (err.code != 0) return err;
+    result->scale = scale;
+    return CALC_SUCCESS;
+}
+
+/**
+ * 由十进制数字构造定点数：值为 (digits + 0.tail) * 10^exponent
+ *
+ * @param digits     有效数字（最多 19 位）
+ * @param exponent   十进制指数
+ * @param tailDigit  digits 之后被舍去的第一位数字
+ * @param tailSticky 更后面被舍去的数字是否非零
+ * @param scale      目标小数位数
+ * @param rounding   舍入方式
+ * @param result     输出
+ */
+CalcError decimalFromDigits(uint64_t digits, int exponent, int tailDigit, int tailSticky,
+                            int scale, DecimalRounding rounding, Decimal* result) {
+    if (scale < 0 || scale > MAX_DECIMAL_SCALE) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "小数位数超出范围");
+    }
+    result->scale = scale;
+
+    if (digits == 0 && tailDigit == 0 && !tailSticky) {
+        result->mantissa = 0;
+        return CALC_SUCCESS;
+    }
+
+    int shift = exponent + scale;
+    int tailInexact = tailDigit != 0 || tailSticky;
+    uint64_t quotient;
+    int half, inexact;
+
+    if (shift > 0) {
+        // 舍去的尾部数字会落在整数位上，只可能在数值已经溢出时出现
+        uint64_t hi, lo;
+        if (shift > 19 || tailInexact) return DECIMAL_OVERFLOW;
+        multiplyU64(digits, POW10[shift], &hi, &lo);
+        if (hi != 0) return DECIMAL_OVERFLOW;
+        return toMantissa(lo, 0, &result->mantissa);
+    }
+
+    if (shift == 0) {
+        quotient = digits;
+        half = tailDigit > 5 ? 1 : (tailDigit == 5 ? (tailSticky ? 1 : 0) : -1);
+        inexact = tailInexact;
+    } else if (-shift <= 19) {
+        uint64_t divisor = POW10[-shift];
+        uint64_t remainder = digits % divisor;
+        quotient = digits / divisor;
+        half = compareHalf(remainder, divisor);
+        if (half == 0 && tailInexact) half = 1;
+        inexact = remainder != 0 || tailInexact;
+    } else {
+        // digits < 10^19，远小于 10^|shift| 的一半
+        quotient = 0;
+        half = -1;
+        inexact = 1;
+    }
+
+    if (inexact && roundingIncrement(quotient, half, inexact, 0, rounding)) {
+        quotient++;
+    }
+    return toMantissa(quotient, 0, &result->mantissa);
+}
+
+// 平方求幂，中间结果保持 base 的小数位数
+static CalcError powerAtScale(Decimal base, uint64_t exponent, DecimalRounding rounding, Decimal* result) {
+    Decimal acc = {(int64_t)POW10[base.scale], base.scale};
+    CalcError err;
+    while (exponent > 0) {
+        if (exponent & 1) {
+            err = performDecimalOperation('*', acc, base, rounding, &acc);
+            if (err.code != 0) return err;
+        }
+        exponent >>= 1;
+        if (exponent > 0) {
+            err = performDecimalOperation('*', base, base, rounding, &base);
+            if (err.code != 0) return err;
+        }
+    }
+    *result = acc;
+    return CALC_SUCCESS;
+}
+
+/**
+ * 整数次幂
+ * 中间结果多保留 DECIMAL_POW_GUARD_DIGITS 位小数以减少逐步舍入的误差，
+ * 多保留的位数导致溢出时退回到原小数位数计算
+ */
+static CalcError decimalPower(Decimal base, Decimal exponent, DecimalRounding rounding, Decimal* result) {
+    if (exponent.mantissa % (int64_t)POW10[exponent.scale] != 0) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "十进制模式的指数必须是整数");
+    }
+    int64_t n = exponent.mantissa / (int64_t)POW10[exponent.scale];
+    if (base.mantissa == 0 && n < 0) {
+        return CALC_ERROR_CODE(ERR_UNDEFINED, "0的负数次幂未定义");
+    }
+
+    int guardScale = base.scale + DECIMAL_POW_GUARD_DIGITS;
+    if (guardScale > MAX_DECIMAL_SCALE) guardScale = MAX_DECIMAL_SCALE;
+
+    Decimal guarded, acc;
+    CalcError err = rescaleDecimal(base, guardScale, DEC_ROUND_HALF_EVEN, &guarded);
+    if (err.code == 0) {
+        err = powerAtScale(guarded, magnitude(n), DEC_ROUND_HALF_EVEN, &acc);
+    }
+    if (err.code == ERR_OVERFLOW) {
+        err = powerAtScale(base, magnitude(n), rounding, &acc);
+    }
+    if (err.code != 0) return err;
+
+    if (n < 0) {
+        Decimal one = {(int64_t)POW10[acc.scale], acc.scale};
+        err = performDecimalOperation('/', one, acc, rounding, &acc);
+        if (err.code != 0) return err;
+    }
+    return rescaleDecimal(acc, base.scale, rounding, result);
+}
+
+/**
+ * 十进制定点运算（performOperation 的十进制版本）
+ * 操作数小数位数不同时先精确扩展到较大的位数
+ */
+CalcError performDecimalOperation(char op, Decimal a, Decimal b, DecimalRounding rounding, Decimal* result) {
+    if (op == '^') {
+        return decimalPower(a, b, rounding, result);
+    }
+
+    int scale = a.scale > b.scale ? a.scale : b.scale;
+    CalcError err = rescaleDecimal(a, scale, rounding, &a);
+    if (err.code != 0) return err;
+    err = rescaleDecimal(b, scale, rounding, &b);
+    if (err.code != 0) return err;
+
+    int negative = (a.mantissa < 0) != (b.mantissa < 0);
+    uint64_t hi, lo;
+    result->scale = scale;
+
+    switch (op) {
+        case '+':
+        case '-': {
+            int64_t rhs = (op == '+') ? b.mantissa : -b.mantissa;
+            if ((rhs > 0 && a.mantissa > INT64_MAX - rhs) || (rhs < 0 && a.mantissa < -INT64_MAX - rhs)) {
+                return DECIMAL_OVERFLOW;
+            }
+            result->mantissa = a.mantissa + rhs;
+            return CALC_SUCCESS;
+        }
+        case '*':
+            multiplyU64(magnitude(a.mantissa), magnitude(b.mantissa), &hi, &lo);
+            return divideRounded(hi, lo, POW10[scale], negative, rounding, &result->mantissa);
+        case '/':
+            if (b.mantissa == 0) {
+                return CALC_ERROR_CODE(ERR_DIV_BY_ZERO, "除数不能为0");
+            }
+            multiplyU64(magnitude(a.mantissa), POW10[scale], &hi, &lo);
+            return divideRounded(hi, lo, magnitude(b.mantissa), negative, rounding, &result->mantissa);
+        default: {
+            // 比较与 and / or：同一小数位数下比较尾数即可，结果为 1 或 0
+            int truth;
+            switch (op) {
+                case '<':          truth = a.mantissa < b.mantissa; break;
+                case '>':          truth = a.mantissa > b.mantissa; break;
+                case OPERATOR_LE:  truth = a.mantissa <= b.mantissa; break;
+                case OPERATOR_GE:  truth = a.mantissa >= b.mantissa; break;
+                case OPERATOR_EQ:  truth = a.mantissa == b.mantissa; break;
+                case OPERATOR_NE:  truth = a.mantissa != b.mantissa; break;
+                case OPERATOR_AND: truth = a.mantissa != 0 && b.mantissa != 0; break;
+                case OPERATOR_OR:  truth = a.mantissa != 0 || b.mantissa != 0; break;
+                default:           return CALC_ERROR_CODE(ERR_SYNTAX, "无效的运算符");
+            }
+            result->mantissa = truth ? (int64_t)POW10[scale] : 0;
+            return CALC_SUCCESS;
+        }
+    }
+}
+
+// 转换为双精度（仅用于显示或与浮点结果比较）
+double decimalToDouble(Decimal value) {
+    return (double)value.mantissa / (double)POW10[value.scale];
+}
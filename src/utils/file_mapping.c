@@ -0,0 +1,107 @@
+#include "calculator.h"
+#include "file_mapping.h"
+
+#ifndef _WIN32
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+/**
+ * 以只读方式映射整个文件（空文件视为错误）
+ *
+ * @param path 文件路径
+ * @param file 输出，使用完后需调用 unmapFile
+ * @return 成功返回 CALC_SUCCESS，否则返回错误
+ */
+CalcError mapReadOnlyFile(const char* path, MappedFile* file) {
+    memset(file, 0, sizeof(*file));
+#ifdef _WIN32
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法打开文件");
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+        CloseHandle(handle);
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "文件为空或无法读取");
+    }
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle);
+    if (mapping == NULL) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法映射文件");
+    }
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == NULL) {
+        CloseHandle(mapping);
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法映射文件");
+    }
+    file->base = (const unsigned char*)view;
+    file->size = (size_t)size.QuadPart;
+    file->handle = mapping;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法打开文件");
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "文件为空或无法读取");
+    }
+    void* view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  // 映射建立后不再需要文件描述符
+    if (view == MAP_FAILED) {
+        return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法映射文件");
+    }
+    file->base = (const unsigned char*)view;
+    file->size = (size_t)st.st_size;
+#endif
+    return CALC_SUCCESS;
+}
+
+// 解除映射
+void unmapFile(MappedFile* file) {
+    if (file->base != NULL) {
+#ifdef _WIN32
+        UnmapViewOfFile(file->base);
+        CloseHandle((HANDLE)file->handle);
+#else
+        munmap((void*)file->base, file->size);
+#endif
+    }
+    memset(file, 0, sizeof(*file));
+}
+
+#ifdef _WIN32
+// 打开文件只为读取其标识（卷序列号与文件索引）
+static int getFileIdentity(const char* path, BY_HANDLE_FILE_INFORMATION* info) {
+    HANDLE handle = CreateFileA(path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                                OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+    int ok = GetFileInformationByHandle(handle, info) != 0;
+    CloseHandle(handle);
+    return ok;
+}
+#endif
+
+/**
+ * 判断两个路径是否为同一个文件（任一路径不存在时返回 0）
+ *
+ * 只比较路径字符串无法识别 ./in.col、符号链接与硬链接；输出文件以 "wb" 打开时会截断仍在映射中的输入
+ */
+int isSameFile(const char* a, const char* b) {
+#ifdef _WIN32
+    BY_HANDLE_FILE_INFORMATION infoA, infoB;
+    return getFileIdentity(a, &infoA) && getFileIdentity(b, &infoB) &&
+           infoA.dwVolumeSerialNumber == infoB.dwVolumeSerialNumber &&
+           infoA.nFileIndexHigh == infoB.nFileIndexHigh && infoA.nFileIndexLow == infoB.nFileIndexLow;
+#else
+    struct stat stA, stB;
+    return stat(a, &stA) == 0 && stat(b, &stB) == 0 && stA.st_dev == stB.st_dev && stA.st_ino == stB.st_ino;
+#endif
+}
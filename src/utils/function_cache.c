@@ -0,0 +1,115 @@
+#include "function_cache.h"
+#include <string.h>
+
+#define CACHE_TAG_VALID  0x10000u
+
+int functionCacheEnabled = 0;
+
+// 每个线程的缓存（线程局部存储，初始为全零：空表、开启状态）
+typedef struct {
+    FunctionCacheEntry entries[FUNCTION_CACHE_SIZE];
+    FunctionCacheStats stats;
+    uint32_t windowLookups;
+    uint32_t windowHits;
+    uint32_t retryCountdown;
+    int disabled;           // 自动关闭
+} FunctionCache;
+
+static _Thread_local FunctionCache threadCache;
+
+void setFunctionCacheEnabled(int enabled) {
+    functionCacheEnabled = enabled != 0;
+}
+
+void getFunctionCacheStats(FunctionCacheStats* stats) {
+    *stats = threadCache.stats;
+    stats->active = !threadCache.disabled;
+}
+
+void resetFunctionCache(void) {
+    memset(&threadCache, 0, sizeof(threadCache));
+}
+
+// 只缓存调用 libm 的函数
+static int isCacheableFunction(FuncType func) {
+    switch (func) {
+        case FUNC_SIN: case FUNC_COS: case FUNC_TAN:
+        case FUNC_ASIN: case FUNC_ACOS: case FUNC_ATAN:
+        case FUNC_LOG: case FUNC_LN:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static inline uint64_t doubleBits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline uint32_t cacheTag(FuncType func, AngleMode mode) {
+    return CACHE_TAG_VALID | ((uint32_t)mode << 8) | (uint32_t)func;
+}
+
+static inline FunctionCacheEntry* cacheSlot(uint64_t bits, uint32_t tag) {
+    uint64_t hash = (bits ^ ((uint64_t)tag << 40)) * 0x9e3779b97f4a7c15ULL;
+    return &threadCache.entries[hash >> (64 - FUNCTION_CACHE_BITS)];
+}
+
+// 窗口结束时检查命中率
+static void closeWindow(FunctionCache* cache) {
+    if (cache->windowHits < FUNCTION_CACHE_MIN_HITS) {
+        cache->disabled = 1;
+        cache->retryCountdown = FUNCTION_CACHE_RETRY;
+        cache->stats.disables++;
+    }
+    cache->windowLookups = 0;
+    cache->windowHits = 0;
+}
+
+int lookupFunctionCache(FuncType func, double value, AngleMode mode, double* result, ErrorCode* code,
+                        FunctionCacheEntry** entry) {
+    FunctionCache* cache = &threadCache;
+    *entry = NULL;
+    if (!isCacheableFunction(func)) {
+        return 0;
+    }
+    if (cache->disabled) {
+        cache->stats.bypassed++;
+        if (--cache->retryCountdown == 0) {
+            // 重新尝试：旧的缓存项已经过时，清空后开启新的窗口
+            memset(cache->entries, 0, sizeof(cache->entries));
+            cache->disabled = 0;
+        }
+        return 0;
+    }
+
+    uint64_t bits = doubleBits(value);
+    uint32_t tag = cacheTag(func, mode);
+    FunctionCacheEntry* slot = cacheSlot(bits, tag);
+    int hit = slot->tag == tag && slot->bits == bits;
+
+    cache->stats.lookups++;
+    cache->windowLookups++;
+    if (hit) {
+        cache->stats.hits++;
+        cache->windowHits++;
+        *result = slot->result;
+        *code = (ErrorCode)slot->code;
+    } else {
+        *entry = slot;
+    }
+    if (cache->windowLookups == FUNCTION_CACHE_WINDOW) {
+        closeWindow(cache);
+    }
+    return hit;
+}
+
+void storeFunctionCache(FunctionCacheEntry* entry, FuncType func, double value, AngleMode mode,
+                        double result, ErrorCode code) {
+    entry->bits = doubleBits(value);
+    entry->tag = cacheTag(func, mode);
+    entry->code = (int32_t)code;
+    entry->result = result;
+}
@@ -1,4 +1,6 @@
 #include "calculator.h"
+#include "trig_reduction.h"
+#include "function_cache.h"
 #include <math.h>
 
 // 角度转弧度
@@ -12,102 +14,54 @@ double radianToDegree(double radian) {
 }
 
 /**
- * 检查三角函数的特殊角度并返回标准值
+ * 检查三角函数的特殊角度并返回标准值（按归约后的余数判断，见 trig_reduction.h）
  * @param angle 角度值
  * @param mode 角度模式
  * @param funcType 函数类型（sin, cos, tan）
  * @return 0: 非特殊值; 1: 应为0; 2: 应为1; 3: 应为-1; 4: 无定义
  */
-static int checkTrigSpecialAngle(double angle, AngleMode mode, FuncType funcType) {
-    double epsilon = (mode == MODE_DEG) ? ANGLE_EPSILON_DEG : ANGLE_EPSILON_RAD;
-    double fullCircle = (mode == MODE_DEG) ? 360.0 : 2 * PI;
-    double right_angle = (mode == MODE_DEG) ? 90.0 : PI/2;
-    double half_circle = (mode == MODE_DEG) ? 180.0 : PI;
-    
-    // 规范化角度到[0, fullCircle)
-    angle = fmod(angle, fullCircle);
-    if (angle < 0) angle += fullCircle;
-    
-    // 特殊角度数组: 0°, 90°, 180°, 270°
-    double specialAngles[4] = {0, right_angle, half_circle, right_angle + half_circle};
-    
-    // 找到最接近的特殊角度
-    int closestIndex = -1;
-    double minDiff = epsilon;
-    
-    for (int i = 0; i < 4; i++) {
-        double diff = fabs(angle - specialAngles[i]);
-        if (diff <= minDiff) {
-            minDiff = diff;
-            closestIndex = i;
-        }
-    }
-    
-    // 如果没有找到接近的特殊角度
-    if (closestIndex == -1) {
-        return 0;
-    }
-    
-    // 根据三角函数类型和特殊角度确定返回值
-    switch (funcType) {
-        case FUNC_SIN:
-            // sin: 0° = 0, 90° = 1, 180° = 0, 270° = -1
-            if (closestIndex == 0 || closestIndex == 2) return 1; // 值应为0
-            if (closestIndex == 1) return 2; // 值应为1
-            if (closestIndex == 3) return 3; // 值应为-1
-            break;
-            
-        case FUNC_COS:
-            // cos: 0° = 1, 90° = 0, 180° = -1, 270° = 0
-            if (closestIndex == 1 || closestIndex == 3) return 1; // 值应为0
-            if (closestIndex == 0) return 2; // 值应为1
-            if (closestIndex == 2) return 3; // 值应为-1
-            break;
-            
-        case FUNC_TAN:
-            // tan: 0° = 0, 90° = 无定义, 180° = 0, 270° = 无定义
-            if (closestIndex == 0 || closestIndex == 2) return 1; // 值应为0
-            if (closestIndex == 1 || closestIndex == 3) return 4; // 无定义
-            break;
-            
-        default:
-            break;
-    }
-    
-    return 0; // 非特殊角
+int checkTrigSpecialAngle(double angle, AngleMode mode, FuncType funcType) {
+    TrigReduction reduction;
+    reduceAngle(angle, mode, &reduction);
+    return classifySpecialAngle(&reduction, mode, funcType);
 }
 
 /**
- * 计算数学函数，带错误处理
+ * 计算数学函数，不做最后的接近整数修正（特殊角仍返回精确值）
  */
-CalcError calculateFunctionWithError(FuncType func, double value, AngleMode mode, double* result) {
+ErrorCode calculateFunctionRaw(FuncType func, double value, AngleMode mode, double* result) {
     // 检查输入是否有效
     if (isUndefined(value)) {
         *result = value;
-        return CALC_SUCCESS;
+        return ERR_SUCCESS;
     }
     
-    double angle;
+    TrigReduction reduction;
     int specialValue;
     
     switch (func) {
         case FUNC_SIN:
-            // 检查特殊角度
-            specialValue = checkTrigSpecialAngle(value, mode, FUNC_SIN);
+            // 整数或半整数度直接查表
+            if (mode == MODE_DEG && lookupDegreeTrig(FUNC_SIN, value, result)) {
+                return ERR_SUCCESS;
+            }
+            
+            // 归约后检查特殊角度
+            reduceAngle(value, mode, &reduction);
+            specialValue = classifySpecialAngle(&reduction, mode, FUNC_SIN);
             if (specialValue == 1) {
                 *result = 0.0;
-                return CALC_SUCCESS;
+                return ERR_SUCCESS;
             } else if (specialValue == 2) {
                 *result = 1.0;
-                return CALC_SUCCESS;
+                return ERR_SUCCESS;
             } else if (specialValue == 3) {
                 *result = -1.0;
-                return CALC_SUCCESS;
+                return ERR_SUCCESS;
             }
             
-            // 常规计算
-            angle = (mode == MODE_DEG) ? degreeToRadian(value) : value;
-            *result = sin(angle);
+            // 常规计算（在归约后的 [-π/4, π/4] 上调用 libm）
+            *result = trigFromReduction(FUNC_SIN, &reduction);
             
             // 处理接近零的值
             if (fabs(*result) < EPSILON) {
@@ -116,22 +70,27 @@ CalcError calculateFunctionWithError(FuncType func, double value, AngleMode mode
             break;
             
         case FUNC_COS:
-            // 检查特殊角度
-            specialValue = checkTrigSpecialAngle(value, mode, FUNC_COS);
+            // 整数或半整数度直接查表
+            if (mode == MODE_DEG && lookupDegreeTrig(FUNC_COS, value, result)) {
+                return ERR_SUCCESS;
+            }
+            
+            // 归约后检查特殊角度
+            reduceAngle(value, mode, &reduction);
+            specialValue = classifySpecialAngle(&reduction, mode, FUNC_COS);
             if (specialValue == 1) {
                 *result = 0.0;
-                return CALC_SUCCESS;
+                return ERR_SUCCESS;
             } else if (specialValue == 2) {
                 *result = 1.0;
-                return CALC_SUCCESS;
+                return ERR_SUCCESS;
             } else if (specialValue == 3) {
                 *result = -1.0;
-                return CALC_SUCCESS;
+                return ERR_SUCCESS;
             }
             
-            // 常规计算
-            angle = (mode == MODE_DEG) ? degreeToRadian(value) : value;
-            *result = cos(angle);
+            // 常规计算（在归约后的 [-π/4, π/4] 上调用 libm）
+            *result = trigFromReduction(FUNC_COS, &reduction);
             
             // 处理接近零的值
             if (fabs(*result) < EPSILON) {
@@ -140,24 +99,29 @@ CalcError calculateFunctionWithError(FuncType func, double value, AngleMode mode
             break;
             
         case FUNC_TAN:
-            // 检查特殊角度
-            specialValue = checkTrigSpecialAngle(value, mode, FUNC_TAN);
+            // 整数或半整数度直接查表（90°、270° 等无定义）
+            if (mode == MODE_DEG && (specialValue = lookupDegreeTrig(FUNC_TAN, value, result)) != 0) {
+                return specialValue == 1 ? ERR_SUCCESS : ERR_UNDEFINED;
+            }
+            
+            // 归约后检查特殊角度
+            reduceAngle(value, mode, &reduction);
+            specialValue = classifySpecialAngle(&reduction, mode, FUNC_TAN);
             if (specialValue == 1) {
                 *result = 0.0;
-                return CALC_SUCCESS;
+                return ERR_SUCCESS;
             } else if (specialValue == 4) {
-                return CALC_ERROR_CODE(ERR_UNDEFINED, "tan函数在该点处无定义");
+                return ERR_UNDEFINED;
             }
             
-            // 常规计算
-            angle = (mode == MODE_DEG) ? degreeToRadian(value) : value;
-            *result = tan(angle);
+            // 常规计算（在归约后的 [-π/4, π/4] 上调用 libm）
+            *result = trigFromReduction(FUNC_TAN, &reduction);
             break;
             
         case FUNC_ASIN:
             // 检查参数范围
             if (fabs(value) > 1.0) {
-                return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "asin的参数必须在[-1,1]范围内");
+                return ERR_INVALID_ARGUMENT;
             }
             *result = asin(value);
             if (mode == MODE_DEG) {
@@ -168,7 +132,7 @@ CalcError calculateFunctionWithError(FuncType func, double value, AngleMode mode
         case FUNC_ACOS:
             // 检查参数范围
             if (fabs(value) > 1.0) {
-                return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "acos的参数必须在[-1,1]范围内");
+                return ERR_INVALID_ARGUMENT;
             }
             *result = acos(value);
             if (mode == MODE_DEG) {
@@ -186,7 +150,7 @@ CalcError calculateFunctionWithError(FuncType func, double value, AngleMode mode
         case FUNC_SQRT:
             // 检查参数范围
             if (value < 0) {
-                return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "负数不能开平方根");
+                return ERR_INVALID_ARGUMENT;
             }
             *result = sqrt(value);
             break;
@@ -194,7 +158,7 @@ CalcError calculateFunctionWithError(FuncType func, double value, AngleMode mode
         case FUNC_LOG:
             // 检查参数范围
             if (value <= 0) {
-                return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "log函数的参数必须大于0");
+                return ERR_INVALID_ARGUMENT;
             }
             *result = log10(value);
             break;
@@ -202,7 +166,7 @@ CalcError calculateFunctionWithError(FuncType func, double value, AngleMode mode
         case FUNC_LN:
             // 检查参数范围
             if (value <= 0) {
-                return CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "ln函数的参数必须大于0");
+                return ERR_INVALID_ARGUMENT;
             }
             *result = log(value);
             break;
@@ -220,14 +184,87 @@ CalcError calculateFunctionWithError(FuncType func, double value, AngleMode mode
             break;
             
         default:
-            return CALC_ERROR_CODE(ERR_INVALID_FUNCTION, "无效的函数");
+            return ERR_INVALID_FUNCTION;
     }
     
-    // 检查结果是否接近整数
-    int64_t intValue;
-    if (isCloseToInteger(*result, &intValue)) {
-        *result = intValue;
+    return ERR_SUCCESS;
+}
+
+/**
+ * 按 IEEE 语义计算数学函数：直接调用 libm，不查表、不识别特殊角、不修正结果，
+ * 定义域之外返回 NaN（log/ln 的 0 返回 -inf），NaN 与 Inf 照常传播
+ */
+double calculateFunctionIEEE(FuncType func, double value, AngleMode mode) {
+    double angle = (mode == MODE_DEG) ? degreeToRadian(value) : value;
+    double inverse;
+
+    switch (func) {
+        case FUNC_SIN:  return sin(angle);
+        case FUNC_COS:  return cos(angle);
+        case FUNC_TAN:  return tan(angle);
+        case FUNC_ASIN: inverse = asin(value); break;
+        case FUNC_ACOS: inverse = acos(value); break;
+        case FUNC_ATAN: inverse = atan(value); break;
+        case FUNC_SQRT: return sqrt(value);
+        case FUNC_LOG:  return log10(value);
+        case FUNC_LN:   return log(value);
+        case FUNC_ABS:  return fabs(value);
+        case FUNC_RAD:  return degreeToRadian(value);
+        case FUNC_DEG:  return radianToDegree(value);
+        default:        return NAN;
+    }
+    return (mode == MODE_DEG) ? radianToDegree(inverse) : inverse;
+}
+
+/**
+ * 计算数学函数（快速路径：只返回错误代码，不构造错误消息）
+ * 开启函数缓存时先查当前线程的缓存（见 function_cache.h）
+ */
+ErrorCode calculateFunctionCode(FuncType func, double value, AngleMode mode, double* result) {
+    FunctionCacheEntry* entry = NULL;
+    ErrorCode code;
+    if (functionCacheEnabled && lookupFunctionCache(func, value, mode, result, &code, &entry)) {
+        return code;
     }
     
+    code = calculateFunctionRaw(func, value, mode, result);
+    if (code == ERR_SUCCESS && !isUndefined(*result)) {
+        // 检查结果是否接近整数
+        int64_t intValue;
+        if (isCloseToInteger(*result, &intValue)) {
+            *result = intValue;
+        }
+    }
+    
+    if (entry != NULL) {
+        storeFunctionCache(entry, func, value, mode, *result, code);
+    }
+    return code;
+}
+
+/**
+ * 函数出错时的错误消息（每个函数的每种错误代码只有一种原因）
+ */
+const char* describeFunctionError(FuncType func, ErrorCode code) {
+    switch (func) {
+        case FUNC_TAN:  return "tan函数在该点处无定义";
+        case FUNC_ASIN: return "asin的参数必须在[-1,1]范围内";
+        case FUNC_ACOS: return "acos的参数必须在[-1,1]范围内";
+        case FUNC_SQRT: return "负数不能开平方根";
+        case FUNC_LOG:  return "log函数的参数必须大于0";
+        case FUNC_LN:   return "ln函数的参数必须大于0";
+        default:
+            return code == ERR_INVALID_FUNCTION ? "无效的函数" : getErrorDescription(code);
+    }
+}
+
+/**
+ * 计算数学函数，带错误处理
+ */
+CalcError calculateFunctionWithError(FuncType func, double value, AngleMode mode, double* result) {
+    ErrorCode code = calculateFunctionCode(func, value, mode, result);
+    if (code != ERR_SUCCESS) {
+        return CALC_ERROR_CODE(code, describeFunctionError(func, code));
+    }
     return CALC_SUCCESS;
-} 
\ No newline at end of file
+}
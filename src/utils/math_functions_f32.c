@@ -0,0 +1,215 @@
+#include "calculator.h"
+#include "trig_reduction.h"
+
+// ─── 单精度向量化函数内核（EVAL_FP32 批量求值使用）─────────────────────────
+//
+// 多项式系数取自 Cephes 单精度数学库。循环体只包含算术与条件选择，
+// 不调用 libm，编译器可以将整个循环向量化。三角函数的参数归约在双精度下
+// 完成：角度模式按 90° 精确归约，因此 sin(30)、cos(60) 等仍为精确值；弧度模式
+// 使用与标量路径相同的 Cody-Waite 归约（codyWaiteReduce）。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define DEGREE_FAST_RANGE 1e9                        // 角度模式超出此范围的参数使用双精度标量计算
+#define PIO2_F32          1.5707963267948966f
+#define PIO4_F32          0.7853981633974483f
+#define SQRT_HALF_F32     0.70710678118654752f
+
+// 记录元素错误（只保留第一个错误）
+#define SET_ELEMENT_ERROR(errs, i, code) do { if ((errs)[i] == 0) (errs)[i] = (unsigned char)(code); } while (0)
+
+// sin(x)，x ∈ [-pi/4, pi/4]
+static inline float sinPolyF32(float x) {
+    float z = x * x;
+    return ((-1.9515295891E-4f * z + 8.3321608736E-3f) * z - 1.6666654611E-1f) * z * x + x;
+}
+
+// cos(x)，x ∈ [-pi/4, pi/4]
+static inline float cosPolyF32(float x) {
+    float z = x * x;
+    return ((2.443315711809948E-5f * z - 1.388731625493765E-3f) * z + 4.166664568298827E-2f) * z * z
+           - 0.5f * z + 1.0f;
+}
+
+// atan(x)，全定义域
+static inline float atanF32(float value) {
+    float x = fabsf(value);
+    int isBig = x > 2.414213562373095f;   // tan(3pi/8)
+    int isMid = x > 0.4142135623730950f;  // tan(pi/8)
+    float big = -1.0f / x;
+    float mid = (x - 1.0f) / (x + 1.0f);
+    float base = isBig ? PIO2_F32 : (isMid ? PIO4_F32 : 0.0f);
+    float t = isBig ? big : (isMid ? mid : x);
+    float z = t * t;
+    float y = base + ((((8.05374449538e-2f * z - 1.38776856032E-1f) * z + 1.99777106478E-1f) * z
+                       - 3.33329491539E-1f) * z * t + t);
+    return value < 0 ? -y : y;
+}
+
+// ln(x)，x > 0
+static inline float lnF32(float value) {
+    // 非规格化数先放大 2^23
+    int subnormal = value < FLT_MIN;
+    float x = subnormal ? value * 8388608.0f : value;
+
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    int exponent = (int)((bits >> 23) & 0xff) - 126 - (subnormal ? 23 : 0);
+    bits = (bits & 0x007fffffu) | 0x3f000000u;  // 尾数归一化到 [0.5, 1)
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+
+    int small = m < SQRT_HALF_F32;
+    exponent -= small;
+    x = small ? m + m - 1.0f : m - 1.0f;
+
+    float z = x * x;
+    float y = ((((((((7.0376836292E-2f * x - 1.1514610310E-1f) * x + 1.1676998740E-1f) * x
+                    - 1.2420140846E-1f) * x + 1.4249322787E-1f) * x - 1.6668057665E-1f) * x
+                 + 2.0000714765E-1f) * x - 2.4999993993E-1f) * x + 3.3333331174E-1f) * x * z;
+    float fe = (float)exponent;
+    y += -2.12194440e-4f * fe;
+    y += -0.5f * z;
+    return x + y + 0.693359375f * fe;
+}
+
+/**
+ * sin/cos/tan 块内核
+ * 参数先在双精度下归约到 [-pi/4, pi/4] 并得到象限，再用单精度多项式计算
+ */
+static void trigBlockF32(FuncType func, const float* input, float* output, size_t count,
+                         AngleMode mode, unsigned char* errors) {
+    // tan 在极点附近（与 checkTrigSpecialAngle 的容差一致）无定义
+    float poleEpsilon = (float)((mode == MODE_DEG) ? degreeToRadian(ANGLE_EPSILON_DEG) : ANGLE_EPSILON_RAD);
+    // 弧度模式超出 Cody-Waite 范围的参数交给标量路径（Payne-Hanek）
+    double fastRange = (mode == MODE_DEG) ? DEGREE_FAST_RANGE : CODY_WAITE_LIMIT;
+    int outOfRange = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        outOfRange |= !(fabs((double)input[i]) < fastRange);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        double x = input[i];
+
+        // 超大参数（极少见）回退到双精度标量计算
+        if (outOfRange && !(fabs(x) < fastRange)) {
+            double value;
+            ErrorCode code = calculateFunctionCode(func, x, mode, &value);
+            if (code != ERR_SUCCESS) SET_ELEMENT_ERROR(errors, i, code);
+            output[i] = (float)value;
+            continue;
+        }
+
+        double r;
+        int quadrant;
+        if (mode == MODE_DEG) {
+            double q = (x * (1.0 / 90.0) + TRIG_ROUND_MAGIC) - TRIG_ROUND_MAGIC;
+            r = (x - q * 90.0) * (PI / 180.0);
+            quadrant = (int)((int64_t)q & 3);
+        } else {
+            TrigReduction reduction = codyWaiteReduce(x);
+            r = reduction.hi;
+            quadrant = reduction.quadrant;
+        }
+        float rf = (float)r;
+        float s = sinPolyF32(rf);
+        float c = cosPolyF32(rf);
+
+        // sin(r + q*pi/2), cos(r + q*pi/2)
+        float sinValue = (quadrant & 1) ? c : s;
+        float cosValue = (quadrant & 1) ? s : c;
+        sinValue = (quadrant == 2 || quadrant == 3) ? -sinValue : sinValue;
+        cosValue = (quadrant == 1 || quadrant == 2) ? -cosValue : cosValue;
+
+        if (func == FUNC_SIN) {
+            output[i] = sinValue;
+        } else if (func == FUNC_COS) {
+            output[i] = cosValue;
+        } else {
+            if (fabsf(cosValue) <= poleEpsilon) SET_ELEMENT_ERROR(errors, i, ERR_UNDEFINED);
+            output[i] = sinValue / cosValue;
+        }
+    }
+}
+
+/**
+ * 单精度函数块计算（calculateFunctionWithError 的批量单精度版本）
+ *
+ * @param func   函数类型
+ * @param input  输入数组
+ * @param output 输出数组（可以与 input 相同）
+ * @param count  元素个数
+ * @param mode   角度模式
+ * @param errors 每个元素的错误代码，已有错误的元素不会被覆盖
+ */
+void calculateFunctionBlockF32(FuncType func, const float* input, float* output, size_t count,
+                               AngleMode mode, unsigned char* errors) {
+    const float toDegree = (mode == MODE_DEG) ? (float)(180.0 / PI) : 1.0f;
+
+    switch (func) {
+        case FUNC_SIN:
+        case FUNC_COS:
+        case FUNC_TAN:
+            trigBlockF32(func, input, output, count, mode, errors);
+            break;
+
+        case FUNC_ASIN:
+            for (size_t i = 0; i < count; i++) {
+                float x = input[i];
+                if (fabsf(x) > 1.0f) SET_ELEMENT_ERROR(errors, i, ERR_INVALID_ARGUMENT);
+                x = x > 1.0f ? 1.0f : (x < -1.0f ? -1.0f : x);
+                output[i] = atanF32(x / sqrtf((1.0f - x) * (1.0f + x))) * toDegree;
+            }
+            break;
+
+        case FUNC_ACOS:
+            for (size_t i = 0; i < count; i++) {
+                float x = input[i];
+                if (fabsf(x) > 1.0f) SET_ELEMENT_ERROR(errors, i, ERR_INVALID_ARGUMENT);
+                x = x > 1.0f ? 1.0f : (x < -1.0f ? -1.0f : x);
+                output[i] = 2.0f * atanF32(sqrtf((1.0f - x) / (1.0f + x))) * toDegree;
+            }
+            break;
+
+        case FUNC_ATAN:
+            for (size_t i = 0; i < count; i++) {
+                output[i] = atanF32(input[i]) * toDegree;
+            }
+            break;
+
+        case FUNC_SQRT:
+            for (size_t i = 0; i < count; i++) {
+                float x = input[i];
+                if (x < 0) SET_ELEMENT_ERROR(errors, i, ERR_INVALID_ARGUMENT);
+                output[i] = sqrtf(x < 0 ? 0.0f : x);
+            }
+            break;
+
+        case FUNC_LOG:
+        case FUNC_LN: {
+            float scale = (func == FUNC_LOG) ? 0.43429448190325182f : 1.0f;
+            for (size_t i = 0; i < count; i++) {
+                float x = input[i];
+                if (!(x > 0)) SET_ELEMENT_ERROR(errors, i, ERR_INVALID_ARGUMENT);
+                output[i] = lnF32(x > 0 ? x : 1.0f) * scale;
+            }
+            break;
+        }
+
+        case FUNC_ABS:
+            for (size_t i = 0; i < count; i++) output[i] = fabsf(input[i]);
+            break;
+
+        case FUNC_RAD:
+            for (size_t i = 0; i < count; i++) output[i] = input[i] * (float)(PI / 180.0);
+            break;
+
+        case FUNC_DEG:
+            for (size_t i = 0; i < count; i++) output[i] = input[i] * (float)(180.0 / PI);
+            break;
+
+        default:
+            for (size_t i = 0; i < count; i++) SET_ELEMENT_ERROR(errors, i, ERR_INVALID_FUNCTION);
+            break;
+    }
+}
@@ -70,4 +70,59 @@ char* formatNumber(double value, char* buffer, size_t bufferSize) {
     }
     
     return buffer;
-} 
\ No newline at end of file
+}
+
+/**
+ * 格式化十进制定点数（不经过 double，移除尾部多余的零）
+ * 
+ * @param value 要格式化的定点数
+ * @param buffer 输出缓冲区
+ * @param bufferSize 缓冲区大小
+ * @return 格式化后的字符串（指向buffer的指针）
+ */
+char* formatDecimal(Decimal value, char* buffer, size_t bufferSize) {
+    uint64_t absValue = value.mantissa < 0 ? (uint64_t)0 - (uint64_t)value.mantissa : (uint64_t)value.mantissa;
+    uint64_t divisor = 1;
+    for (int i = 0; i < value.scale; i++) {
+        divisor *= 10;
+    }
+    
+    uint64_t intPart = absValue / divisor;
+    uint64_t fracPart = absValue % divisor;
+    const char* sign = value.mantissa < 0 ? "-" : "";
+    
+    if (fracPart == 0) {
+        snprintf(buffer, bufferSize, "%s%" PRIu64, sign, intPart);
+        return buffer;
+    }
+    
+    // 移除小数部分尾部的零
+    int digits = value.scale;
+    while (fracPart % 10 == 0) {
+        fracPart /= 10;
+        digits--;
+    }
+    snprintf(buffer, bufferSize, "%s%" PRIu64 ".%0*" PRIu64, sign, intPart, digits, fracPart);
+    return buffer;
+}
+
+/**
+ * 以能精确还原的最短形式（15~17 位有效数字）格式化双精度数，用于数据文件输出
+ *
+ * @param value 要格式化的数值
+ * @param buffer 输出缓冲区（至少 32 字节）
+ * @param bufferSize 缓冲区大小
+ * @return 写入的字符数
+ */
+int formatRoundTrip(double value, char* buffer, size_t bufferSize) {
+    int length = 0;
+    for (int digits = 15; digits <= 17; digits++) {
+        double parsed;
+        length = snprintf(buffer, bufferSize, "%.*g", digits, value);
+        // 15 位以内的尾数走 parseNumberField 的快速路径，不必调用 strtod
+        if (digits == 17 || (parseNumberField(buffer, buffer + length, &parsed) && parsed == value)) {
+            break;
+        }
+    }
+    return length;
+}
@@ -112,6 +112,186 @@ CalcError getNumberWithError(const char** expr, double* result) {
     return CALC_SUCCESS;
 }
 
+/**
+ * 解析十进制定点数（十进制模式使用）
+ * 语法检查与 getNumberWithError 相同；尾数直接由数字串得到，不经过 double
+ *
+ * @param expr     表达式指针，成功后指向数字之后
+ * @param scale    小数位数
+ * @param rounding 超出小数位数部分的舍入方式
+ * @param result   输出
+ */
+CalcError getDecimalWithError(const char** expr, int scale, DecimalRounding rounding, Decimal* result) {
+    // 先按普通数字解析，得到相同的错误消息并确定数字的结尾
+    const char* cursor = *expr;
+    double ignored;
+    CalcError err = getNumberWithError(&cursor, &ignored);
+    if (err.code != 0) {
+        return err;
+    }
+    
+    const char* p = *expr;
+    while (*p == ' ') p++;
+    const char* start = p;
+    
+    uint64_t digits = 0;
+    int significant = 0;    // 已记录的有效数字位数（最多 19 位）
+    int exponent = 0;
+    int tailDigit = 0;
+    int tailSticky = 0;
+    int hasDecimal = 0;
+    
+    for (; p < cursor && (isdigit(*p) || *p == '.'); p++) {
+        if (*p == '.') {
+            hasDecimal = 1;
+            continue;
+        }
+        int d = *p - '0';
+        if (significant < 19) {
+            if (digits == 0 && d == 0) {
+                if (hasDecimal) exponent--;  // 前导零
+                continue;
+            }
+            digits = digits * 10 + (uint64_t)d;
+            significant++;
+            if (hasDecimal) exponent--;
+        } else {
+            if (significant == 19) {
+                tailDigit = d;
+                significant++;
+            } else {
+                tailSticky |= d != 0;
+            }
+            if (!hasDecimal) exponent++;
+        }
+    }
+    
+    if (p < cursor && tolower(*p) == 'e') {
+        p++;
+        int sign = 1;
+        if (*p == '+' || *p == '-') {
+            sign = (*p == '-') ? -1 : 1;
+            p++;
+        }
+        int value = 0;
+        while (p < cursor && isdigit(*p)) {
+            if (value < 1000) value = value * 10 + (*p - '0');
+            p++;
+        }
+        exponent += sign * value;
+    }
+    
+    err = decimalFromDigits(digits, exponent, tailDigit, tailSticky, scale, rounding, result);
+    if (err.code != 0) {
+        return CALC_ERROR_POS("数字太大", (int)(cursor - start));
+    }
+    *expr = cursor;
+    return CALC_SUCCESS;
+}
+
+// 10 的 0~22 次幂都能被 double 精确表示
+static const double EXACT_POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+#define MAX_NUMBER_FIELD 128    // 交给 strtod 的字段最大长度
+
+/**
+ * 快速解析数据字段中的数值（CSV 等批量输入使用，字段不要求以 '\0' 结尾）
+ * 接受可选的正负号、小数与科学计数法，忽略首尾空格。有效数字不超过 2^53 且
+ * 10 的幂在 ±22 以内时，一次乘除即得到正确舍入的结果；其余情况交给 strtod。
+ *
+ * @param begin  字段起始
+ * @param end    字段结尾（不含）
+ * @param result 输出
+ * @return 字段是合法的数值返回 1，否则返回 0
+ */
+int parseNumberField(const char* begin, const char* end, double* result) {
+    while (begin < end && *begin == ' ') begin++;
+    while (end > begin && end[-1] == ' ') end--;
+    
+    const char* p = begin;
+    int negative = 0;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        p++;
+    }
+    
+    uint64_t mantissa = 0;
+    int significant = 0;    // 已累积的有效数字位数
+    int truncated = 0;      // 超过 19 位有效数字，尾数不精确
+    int exponent = 0;
+    int hasDigit = 0;
+    
+    for (; p < end && isdigit((unsigned char)*p); p++) {
+        hasDigit = 1;
+        if (significant < 19) {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            significant += mantissa != 0;
+        } else {
+            exponent++;
+            truncated |= *p != '0';
+        }
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && isdigit((unsigned char)*p); p++) {
+            hasDigit = 1;
+            if (significant < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                significant += mantissa != 0;
+                exponent--;
+            } else {
+                truncated |= *p != '0';
+            }
+        }
+    }
+    if (!hasDigit) {
+        return 0;
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        int exponentSign = 1;
+        if (p < end && (*p == '+' || *p == '-')) {
+            exponentSign = *p == '-' ? -1 : 1;
+            p++;
+        }
+        if (p == end || !isdigit((unsigned char)*p)) {
+            return 0;
+        }
+        int value = 0;
+        for (; p < end && isdigit((unsigned char)*p); p++) {
+            if (value < 100000) value = value * 10 + (*p - '0');
+        }
+        exponent += exponentSign * value;
+    }
+    if (p != end) {
+        return 0;
+    }
+    
+    double value;
+    if (!truncated && mantissa <= MAX_EXACT_DOUBLE_INTEGER && exponent >= -22 && exponent <= 22) {
+        value = (double)mantissa;
+        value = exponent < 0 ? value / EXACT_POWERS_OF_TEN[-exponent] : value * EXACT_POWERS_OF_TEN[exponent];
+    } else {
+        char buffer[MAX_NUMBER_FIELD];
+        size_t length = (size_t)(end - begin);
+        if (length >= sizeof(buffer)) {
+            return 0;
+        }
+        memcpy(buffer, begin, length);
+        buffer[length] = '\0';
+        value = strtod(buffer, NULL);   // 已含符号
+        if (isinf(value)) {
+            return 0;
+        }
+        *result = value;
+        return 1;
+    }
+    *result = negative ? -value : value;
+    return 1;
+}
+
 // 获取函数类型
 FuncType getFunction(const char** expr) {
     const char* start = *expr;  // 保存起始位置，失败时恢复
@@ -142,6 +322,14 @@ FuncType getFunction(const char** expr) {
     return FUNC_NONE;
 }
 
+// 函数名（FUNC_NONE 返回空字符串）
+const char* getFunctionName(FuncType func) {
+    static const char* const names[] = {
+        "", "sin", "cos", "tan", "asin", "acos", "atan", "sqrt", "log", "ln", "abs", "rad", "deg"
+    };
+    return (func >= 0 && (size_t)func < sizeof(names) / sizeof(names[0])) ? names[func] : "";
+}
+
 // 获取运算符优先级
 int getPriority(char op) {
     switch (op) {
@@ -153,9 +341,45 @@ int getPriority(char op) {
             return PRIORITY_MUL;
         case '^':
             return PRIORITY_POW;
+        case '<':
+        case '>':
+        case OPERATOR_LE:
+        case OPERATOR_GE:
+        case OPERATOR_EQ:
+        case OPERATOR_NE:
+            return PRIORITY_CMP;
+        case OPERATOR_NOT:
+            return PRIORITY_NOT;
+        case OPERATOR_AND:
+            return PRIORITY_AND;
+        case OPERATOR_OR:
+            return PRIORITY_OR;
+        case OPERATOR_COND:
+            return PRIORITY_COND;
         case '(':
             return PRIORITY_PAR;
         default:
             return -1;
     }
+}
+
+// 运算符栈中的字符对应的源文本（如 OPERATOR_LE 为 "<="）
+const char* getOperatorSymbol(char op) {
+    switch (op) {
+        case '+':          return "+";
+        case '-':          return "-";
+        case '*':          return "*";
+        case '/':          return "/";
+        case '^':          return "^";
+        case '<':          return "<";
+        case '>':          return ">";
+        case OPERATOR_LE:  return "<=";
+        case OPERATOR_GE:  return ">=";
+        case OPERATOR_EQ:  return "==";
+        case OPERATOR_NE:  return "!=";
+        case OPERATOR_AND: return "and";
+        case OPERATOR_OR:  return "or";
+        case OPERATOR_NOT: return "not";
+        default:           return "";
+    }
 } 
@@ -32,8 +32,8 @@ int isCloseToInteger(double value, int64_t* intValue) {
     // 四舍五入到最接近的整数
     double rounded = round(value);
     
-    // 检查是否在 int64_t 范围内，防止转换溢出
-    if (rounded > (double)INT64_MAX || rounded < (double)INT64_MIN) {
+    // 检查是否在 int64_t 范围内，防止转换溢出（(double)INT64_MAX 即 2^63，已超出范围）
+    if (rounded >= (double)INT64_MAX || rounded < (double)INT64_MIN) {
         return 0;
     }
     
@@ -44,6 +44,23 @@ int isCloseToInteger(double value, int64_t* intValue) {
     return 0;
 }
 
+/**
+ * 检查数值是否恰好是 int64_t 可表示的整数（不做容差修正）
+ * 如果是，返回对应的整数值
+ */
+int doubleToExactInt64(double value, int64_t* intValue) {
+    // 2^63 本身不在 int64_t 范围内，使用严格小于
+    if (!(value >= -9223372036854775808.0 && value < 9223372036854775808.0)) {
+        return 0;
+    }
+    int64_t truncated = (int64_t)value;
+    if ((double)truncated != value) {
+        return 0;
+    }
+    *intValue = truncated;
+    return 1;
+}
+
 /**
  * 判断是否无穷大
  * 包括处理浮点数的infinity和超大数值
@@ -58,4 +75,36 @@ int isInfinite(double value) {
  */
 int isUndefined(double value) {
     return isnan(value);
-} 
\ No newline at end of file
+}
+
+/**
+ * 单精度浮点数比较函数（isDoubleEqual 的单精度版本）
+ */
+int isFloatEqual(float a, float b) {
+    if (isnan(a) || isnan(b)) return 0;
+    if (isinf(a) && isinf(b)) return (a > 0) == (b > 0);
+
+    if (fabsf(a) < ABSOLUTE_ZERO_THRESHOLD_F32 && fabsf(b) < ABSOLUTE_ZERO_THRESHOLD_F32) {
+        return 1;
+    }
+    if (fabsf(a) < EPSILON_F32 || fabsf(b) < EPSILON_F32) {
+        return fabsf(a - b) < EPSILON_F32;
+    }
+    return fabsf(a - b) < EPSILON_F32 || fabsf((a - b) / ((fabsf(a) > fabsf(b)) ? a : b)) < RELATIVE_EPSILON_F32;
+}
+
+/**
+ * 将数组中接近整数的单精度值修正为整数（isCloseToInteger 的批量单精度版本）
+ * 循环体无分支，便于编译器向量化
+ */
+void snapFloatArray(float* values, size_t count) {
+    const float roundMagic = 12582912.0f;  // 1.5 * 2^23，加减后得到最接近的整数
+    for (size_t i = 0; i < count; i++) {
+        float x = values[i];
+        float rounded = (x + roundMagic) - roundMagic;
+        float diff = fabsf(x - rounded);
+        // |x| >= 2^22 时 float 已无小数部分，无需修正
+        int snap = fabsf(x) < 4194304.0f && (diff < EPSILON_F32 || diff < RELATIVE_EPSILON_F32 * fabsf(rounded));
+        values[i] = snap ? rounded : x;
+    }
+}
@@ -0,0 +1,224 @@
+#include "calculator.h"
+#include "trig_reduction.h"
+
+#define PIO2_HI        1.5707963267948966192e+00   // π/2 的双双精度表示
+#define PIO2_LO        6.1232339957367658e-17
+#define PIO180_HI      1.7453292519943295e-02      // π/180 的双双精度表示
+#define PIO180_LO      2.9486522708701687e-19
+#define DEGREE_LIMIT   6e15                        // 小于约 2^46·90 的角度不需要 fmod
+#define DEKKER_SPLIT   134217729.0                 // 2^27 + 1
+#define PAYNE_HANEK_FRACTION_BITS 117              // 小数部分保留的位数
+
+// 2/π 的二进制展开（小数点后第 1 位起，每个字 64 位，高位在前）
+static const uint64_t twoOverPiBits[22] = {
+    0xa2f9836e4e441529ULL, 0xfc2757d1f534ddc0ULL, 0xdb6295993c439041ULL,
+    0xfe5163abdebbc561ULL, 0xb7246e3a424dd2e0ULL, 0x06492eea09d1921cULL,
+    0xfe1deb1cb129a73eULL, 0xe88235f52ebb4484ULL, 0xe99c7026b45f7e41ULL,
+    0x3991d639835339f4ULL, 0x9c845f8bbdf9283bULL, 0x1ff897ffde05980fULL,
+    0xef2f118b5a0a6d1fULL, 0x6d367ecf27cb09b7ULL, 0x4f463f669e5fea2dULL,
+    0x7527bac7ebe5f17bULL, 0x3d0739f78a5292eaULL, 0x6bfb5fb11f8d5d08ULL,
+    0x56033046fc7b6babULL, 0xf0cfbc209af4361dULL, 0xa9e391615ee61b08ULL,
+    0x6599855f14a06840ULL,
+};
+
+// 精确乘积（Dekker 拆分，不依赖 FMA）：a * b = *hi + *lo
+static inline void exactProduct(double a, double b, double* hi, double* lo) {
+    double p = a * b;
+    double t = DEKKER_SPLIT * a;
+    double aHi = t - (t - a), aLo = a - aHi;
+    t = DEKKER_SPLIT * b;
+    double bHi = t - (t - b), bLo = b - bHi;
+    *hi = p;
+    *lo = ((aHi * bHi - p) + aHi * bLo + aLo * bHi) + aLo * bLo;
+}
+
+// (hi + lo) · (π/2 或 π/180 的双双精度表示)，结果规格化
+static void multiplyDoubleDouble(double hi, double lo, double cHi, double cLo, TrigReduction* out) {
+    double p, e;
+    exactProduct(hi, cHi, &p, &e);
+    e += hi * cLo + lo * cHi;
+    out->hi = p + e;
+    out->lo = e - (out->hi - p);
+}
+
+// 2/π 展开中从第 position 位（从 1 开始）起的 64 位
+static uint64_t twoOverPiWindow(int position) {
+    int word = (position - 1) / 64;
+    int offset = (position - 1) % 64;
+    uint64_t bits = twoOverPiBits[word] << offset;
+    if (offset != 0) {
+        bits |= twoOverPiBits[word + 1] >> (64 - offset);
+    }
+    return bits;
+}
+
+// 64×64 → 128 位乘法：返回低 64 位，高 64 位写入 *high
+static inline uint64_t multiplyWide(uint64_t a, uint64_t b, uint64_t* high) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 t = (unsigned __int128)a * b;
+    *high = (uint64_t)(t >> 64);
+    return (uint64_t)t;
+#else
+    // 拆成 32 位的四个部分积（MSVC 等没有 128 位整数的编译器）
+    uint64_t aLo = a & 0xffffffffULL, aHi = a >> 32;
+    uint64_t bLo = b & 0xffffffffULL, bHi = b >> 32;
+    uint64_t ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+    uint64_t middle = (ll >> 32) + (lh & 0xffffffffULL) + (hl & 0xffffffffULL);
+    *high = hh + (lh >> 32) + (hl >> 32) + (middle >> 32);
+    return (middle << 32) | (ll & 0xffffffffULL);
+#endif
+}
+
+// 256 位整数（小端 64 位字）中从第 low 位起的 64 位
+static uint64_t bitsAt(const uint64_t* limbs, int low) {
+    int word = low / 64;
+    int offset = low % 64;
+    uint64_t bits = limbs[word] >> offset;
+    if (offset != 0 && word + 1 < 4) {
+        bits |= limbs[word + 1] << (64 - offset);
+    }
+    return bits;
+}
+
+/**
+ * Payne-Hanek 归约（x > 0，有限）
+ * x = m·2^E（m 为 53 位整数）。x·2/π 中 2/π 的前 E-2 位只贡献 4 的倍数，可以跳过，
+ * 因此只取与 E 对应的 192 位窗口 V：x·2/π ≡ m·V·2^-(shift) (mod 4)
+ */
+static void payneHanekReduce(double x, TrigReduction* out) {
+    int exponent;
+    double mantissa = frexp(x, &exponent);             // x = mantissa·2^exponent，mantissa ∈ [0.5, 1)
+    uint64_t m = (uint64_t)ldexp(mantissa, 53);
+    int e = exponent - 53;
+    int start = e - 1 > 1 ? e - 1 : 1;
+    int shift = start + 191 - e;
+
+    uint64_t v[3] = {twoOverPiWindow(start + 128), twoOverPiWindow(start + 64), twoOverPiWindow(start)};
+    uint64_t product[4];
+    uint64_t carry = 0;
+    for (int i = 0; i < 3; i++) {
+        uint64_t high;
+        product[i] = multiplyWide(m, v[i], &high) + carry;
+        carry = high + (product[i] < carry);
+    }
+    product[3] = carry;
+
+    // 整数部分的低两位是象限，其后 128 位是小数部分（fractionHi、fractionLo）
+    int quadrant = (int)(bitsAt(product, shift) & 3);
+    uint64_t fractionHi = bitsAt(product, shift - 64);
+    uint64_t fractionLo = bitsAt(product, shift - 128);
+
+    // 小数部分不小于 0.5 时取下一个象限，余数为负：把小数部分看作有符号数，保留 117 位
+    // （高 53 位可精确转成 double），转成双双精度后乘以 π/2
+    quadrant = (quadrant + (int)(fractionHi >> 63)) & 3;
+    int drop = 128 - PAYNE_HANEK_FRACTION_BITS;
+    int64_t scaledHi = (int64_t)fractionHi >> drop;
+    uint64_t scaledLo = (fractionLo >> drop) | (fractionHi << (64 - drop));
+    double upper = ldexp((double)scaledHi, 64);
+    double lower = (double)scaledLo;
+    double hi = upper + lower;
+    double lo = lower - (hi - upper);
+    multiplyDoubleDouble(ldexp(hi, -PAYNE_HANEK_FRACTION_BITS), ldexp(lo, -PAYNE_HANEK_FRACTION_BITS),
+                         PIO2_HI, PIO2_LO, out);
+    out->quadrant = quadrant;
+}
+
+/**
+ * 弧度归约：|x| <= π/4 不归约，其次 Cody-Waite，超过 CODY_WAITE_LIMIT 用 Payne-Hanek
+ */
+void reduceRadians(double x, TrigReduction* out) {
+    double ax = fabs(x);
+    if (ax <= PI / 4) {
+        out->hi = x;
+        out->lo = 0;
+        out->quadrant = 0;
+    } else if (ax < CODY_WAITE_LIMIT) {
+        *out = codyWaiteReduce(x);
+    } else if (!isfinite(x)) {
+        out->hi = x - x;   // NaN
+        out->lo = 0;
+        out->quadrant = 0;
+    } else {
+        payneHanekReduce(ax, out);
+        if (x < 0) {
+            out->hi = -out->hi;
+            out->lo = -out->lo;
+            out->quadrant = (4 - out->quadrant) & 3;
+        }
+    }
+    out->remainder = out->hi;
+}
+
+/**
+ * 角度归约：余数在 [-45°, 45°] 内，全程精确
+ * |x| < DEGREE_LIMIT 时 q·90 与 x - q·90 都精确（q 取整偏差一也不影响），
+ * 更大的参数先用 fmod(x, 360) 精确归约
+ */
+void reduceDegrees(double degrees, TrigReduction* out) {
+    double r = degrees;
+    if (!(fabs(r) < DEGREE_LIMIT)) {
+        r = fmod(r, 360.0);
+    }
+    double q = (r * (1.0 / 90.0) + TRIG_ROUND_MAGIC) - TRIG_ROUND_MAGIC;
+    r -= q * 90.0;
+    out->remainder = r;
+    out->quadrant = (int)((int64_t)q & 3);
+    multiplyDoubleDouble(r, 0, PIO180_HI, PIO180_LO, out);
+}
+
+void reduceAngle(double angle, AngleMode mode, TrigReduction* out) {
+    if (mode == MODE_DEG) {
+        reduceDegrees(angle, out);
+    } else {
+        reduceRadians(angle, out);
+    }
+}
+
+/**
+ * 由归约结果计算三角函数：在 [-π/4, π/4] 上调用 libm，再用一阶项修正 lo
+ * （|lo| 不超过 hi 的半个 ulp，修正项中的 cos(hi)、sin(hi) 用低阶近似即可）
+ */
+double trigFromReduction(FuncType func, const TrigReduction* reduction) {
+    double hi = reduction->hi;
+    double lo = reduction->lo;
+    int quadrant = reduction->quadrant;
+
+    if (func == FUNC_TAN) {
+        double t = tan(hi);
+        t += lo * (1 + t * t);
+        return (quadrant & 1) ? -1 / t : t;
+    }
+
+    // cos(x) = sin(x + π/2)
+    if (func == FUNC_COS) {
+        quadrant = (quadrant + 1) & 3;
+    }
+    double value = (quadrant & 1) ? cos(hi) - lo * hi : sin(hi) + lo * (1 - 0.5 * hi * hi);
+    return (quadrant & 2) ? -value : value;
+}
+
+/**
+ * 特殊角判断：余数在容差以内时，结果由象限决定
+ * （象限 0～3 对应 0°、90°、180°、270°）
+ */
+int classifySpecialAngle(const TrigReduction* reduction, AngleMode mode, FuncType func) {
+    double epsilon = (mode == MODE_DEG) ? ANGLE_EPSILON_DEG : ANGLE_EPSILON_RAD;
+    if (!(fabs(reduction->remainder) <= epsilon)) {
+        return 0;
+    }
+
+    int quadrant = reduction->quadrant;
+    switch (func) {
+        case FUNC_SIN:
+            // sin: 0° = 0, 90° = 1, 180° = 0, 270° = -1
+            return (quadrant & 1) ? (quadrant == 1 ? 2 : 3) : 1;
+        case FUNC_COS:
+            // cos: 0° = 1, 90° = 0, 180° = -1, 270° = 0
+            return (quadrant & 1) ? 1 : (quadrant == 0 ? 2 : 3);
+        case FUNC_TAN:
+            // tan: 0° = 0, 90° = 无定义, 180° = 0, 270° = 无定义
+            return (quadrant & 1) ? 4 : 1;
+        default:
+            return 0;
+    }
+}
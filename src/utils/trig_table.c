@@ -0,0 +1,155 @@
+#include "calculator.h"
+
+// ─── 角度模式三角函数查表 ───────────────────────────────────────────────────
+//
+// 角度模式的输入大多是整数或半整数度。这些角度直接查表：表中是 0°～90°
+// 每 0.5° 的 sin 与 0°～89.5° 每 0.5° 的 tan，均为正确舍入的双精度值
+// （按 80 位十进制精度计算后舍入），其余象限由对称性得到。
+// 查表比 fmod + 特殊角比较 + 角度转弧度 + libm 更快，而且 sin(30) 正好是 0.5、
+// tan(45) 正好是 1，不再依赖接近整数的修正。
+// ─────────────────────────────────────────────────────────────────────────────
+
+#define HALF_DEGREES_PER_TURN 720   // 一周的半度数
+
+// sinHalfDegree[k] = sin(k/2°)，k = 0..180
+static const double sinHalfDegree[181] = {
+    0.0, 0.008726535498373935, 0.01745240643728351, 0.026176948307873153,
+    0.03489949670250097, 0.043619387365336, 0.052335956242943835, 0.06104853953485687,
+    0.0697564737441253, 0.07845909572784494, 0.08715574274765818, 0.095845752520224,
+    0.10452846326765347, 0.11320321376790672, 0.12186934340514748, 0.1305261922200516,
+    0.13917310096006544, 0.14780941112961063, 0.15643446504023087, 0.16504760586067765,
+    0.17364817766693036, 0.18223552549214744, 0.1908089953765448, 0.1993679344171972,
+    0.20791169081775934, 0.21643961393810288, 0.224951054343865, 0.23344536385590542,
+    0.24192189559966773, 0.25038000405444144, 0.25881904510252074, 0.2672383760782569,
+    0.27563735581699916, 0.2840153447039226, 0.2923717047227367, 0.3007057995042731,
+    0.30901699437494745, 0.31730465640509214, 0.32556815445715664, 0.3338068592337709,
+    0.3420201433256687, 0.3502073812594675, 0.35836794954530027, 0.3665012267242973,
+    0.374606593415912, 0.3826834323650898, 0.39073112848927377, 0.3987490689252462,
+    0.4067366430758002, 0.414693242656239, 0.42261826174069944, 0.43051109680829514,
+    0.4383711467890774, 0.44619781310980877, 0.4539904997395468, 0.4617486132350339,
+    0.46947156278589075, 0.4771587602596084, 0.484809620246337, 0.4924235601034671,
+    0.5, 0.5075383629607042, 0.5150380749100542, 0.5224985647159489,
+    0.5299192642332049, 0.5372996083468239, 0.5446390350150271, 0.5519369853120581,
+    0.5591929034707468, 0.5664062369248328, 0.573576436351046, 0.5807029557109398,
+    0.5877852522924731, 0.5948227867513413, 0.6018150231520483, 0.6087614290087207,
+    0.6156614753256583, 0.6225146366376195, 0.6293203910498375, 0.636078220277764,
+    0.6427876096865394, 0.6494480483301837, 0.6560590289905073, 0.6626200482157375,
+    0.6691306063588582, 0.6755902076156602, 0.6819983600624985, 0.688354575693754,
+    0.6946583704589973, 0.7009092642998509, 0.7071067811865476, 0.7132504491541816,
+    0.7193398003386512, 0.7253743710122876, 0.7313537016191705, 0.7372773368101241,
+    0.7431448254773942, 0.7489557207890022, 0.754709580222772, 0.7604059656000309,
+    0.766044443118978, 0.77162458338772, 0.7771459614569709, 0.7826081568524139,
+    0.7880107536067219, 0.7933533402912352, 0.7986355100472928, 0.8038568606172173,
+    0.8090169943749475, 0.8141155183563192, 0.8191520442889918, 0.8241261886220157,
+    0.8290375725550417, 0.8338858220671682, 0.838670567945424, 0.8433914458128857,
+    0.848048096156426, 0.8526401643540922, 0.8571673007021123, 0.8616291604415257,
+    0.8660254037844386, 0.8703556959398997, 0.8746197071393959, 0.8788171126619654,
+    0.882947592858927, 0.8870108331782217, 0.8910065241883679, 0.8949343616020251,
+    0.898794046299167, 0.9025852843498606, 0.9063077870366499, 0.9099612708765432,
+    0.9135454576426009, 0.917060074385124, 0.9205048534524404, 0.9238795325112867,
+    0.9271838545667874, 0.9304175679820246, 0.9335804264972017, 0.9366721892483976,
+    0.9396926207859084, 0.9426414910921784, 0.9455185755993168, 0.9483236552061993,
+    0.9510565162951535, 0.9537169507482269, 0.9563047559630354, 0.958819734868193,
+    0.9612616959383189, 0.963630453208623, 0.9659258262890683, 0.9681476403781077,
+    0.9702957262759965, 0.9723699203976766, 0.9743700647852352, 0.9762960071199334,
+    0.9781476007338057, 0.9799247046208296, 0.981627183447664, 0.9832549075639546,
+    0.984807753012208, 0.9862856015372314, 0.9876883405951378, 0.9890158633619168,
+    0.9902680687415704, 0.9914448613738104, 0.992546151641322, 0.9935718556765875,
+    0.9945218953682733, 0.9953961983671789, 0.9961946980917455, 0.996917333733128,
+    0.9975640502598242, 0.9981347984218669, 0.9986295347545738, 0.9990482215818578,
+    0.9993908270190958, 0.9996573249755573, 0.9998476951563913, 0.9999619230641713,
+    1.0,
+};
+
+// tanHalfDegree[k] = tan(k/2°)，k = 0..179
+static const double tanHalfDegree[180] = {
+    0.0, 0.00872686779075879, 0.017455064928217585, 0.026185921569186928,
+    0.03492076949174773, 0.043660942908512065, 0.0524077792830412, 0.061162620150484306,
+    0.06992681194351041, 0.07870170682461845, 0.08748866352592401, 0.09628904819753861,
+    0.10510423526567646, 0.1139356083016455, 0.12278456090290459, 0.13165249758739586,
+    0.14054083470239145, 0.14945100134912778, 0.1583844403245363, 0.16734260908141954,
+    0.17632698070846498, 0.18533904493153439, 0.19438030913771848, 0.20345229942369936,
+    0.21255656167002213, 0.2216946626429399, 0.23086819112556312, 0.24007875908011603,
+    0.24932800284318068, 0.2586175843558903, 0.2679491924311227, 0.2773245440598385,
+    0.2867453857588079, 0.29621349496208027, 0.30573068145866034, 0.3152987888789835,
+    0.32491969623290634, 0.33459531950207316, 0.34432761328966527, 0.35411857253069806,
+    0.36397023426620234, 0.3738846794848047, 0.3838640350354158, 0.3939104756149424,
+    0.4040262258351568, 0.41421356237309503, 0.42447481620960476, 0.4348123749609336,
+    0.44522868530853615, 0.45572625553258467, 0.4663076581549986, 0.4769755326981602,
+    0.48773258856586144, 0.4985816080534315, 0.5095254494944288, 0.5205670505517462,
+    0.5317094316614788, 0.5429556996384369, 0.5543090514527689, 0.56577277818777,
+    0.5773502691896257, 0.5890450164205511, 0.6008606190275604, 0.612800788139932,
+    0.6248693519093275, 0.6370702608074932, 0.6494075931975106, 0.6618855611956915,
+    0.6745085168424266, 0.6872809586016132, 0.7002075382097098, 0.7132930678970054,
+    0.7265425280053609, 0.7399610750284876, 0.7535540501027942, 0.7673269879789604,
+    0.7812856265067174, 0.7954359166678284, 0.8097840331950071, 0.8243363858174958,
+    0.83909963117728, 0.8540806854634666, 0.8692867378162267, 0.8847252645559438,
+    0.9004040442978399, 0.9163311740174234, 0.9325150861376617, 0.9489645667148797,
+    0.965688774807074, 0.9826972631156901, 1.0, 1.0176073929721252,
+    1.0355303137905696, 1.0537801252809622, 1.0723687100246826, 1.0913085010692714,
+    1.1106125148291928, 1.130294386361753, 1.1503684072210096, 1.1708495661125393,
+    1.19175359259421, 1.2130970040929328, 1.2348971565350515, 1.2571722989189547,
+    1.2799416321930788, 1.3032253728412058, 1.32704482162041, 1.3514224379458084,
+    1.3763819204711736, 1.401948294476336, 1.4281480067421144, 1.4550090286724449,
+    1.4825609685127403, 1.510835193614901, 1.539864963814583, 1.5696855771174902,
+    1.6003345290410504, 1.6318516871287896, 1.6642794823505178, 1.697663119326089,
+    1.7320508075688772, 1.767494016242891, 1.804047755271424, 1.841770886033458,
+    1.880726465346332, 1.9209821269711658, 1.9626105055051506, 2.0056897082590197,
+    2.050303841579296, 2.0965435990881747, 2.1445069205095586, 2.194299731165038,
+    2.246036773904216, 2.299842547236257, 2.3558523658237527, 2.414213562373095,
+    2.475086853416296, 2.5386478956643073, 2.6050890646938014, 2.6746214939268236,
+    2.747477419454622, 2.8239128856008007, 2.9042108776758226, 2.988684962742893,
+    3.0776835371752536, 3.1715948023632126, 3.270852618484141, 3.375943422591246,
+    3.4874144438409087, 3.6058835087608743, 3.732050807568877, 3.866713094898738,
+    4.010780933535845, 4.165299770090417, 4.3314758742841555, 4.510708503662057,
+    4.704630109478455, 4.915157031071205, 5.14455401597031, 5.395517174319138,
+    5.671281819617709, 5.975764364433065, 6.313751514675043, 6.69115623831741,
+    7.115369722384209, 7.59575411272515, 8.144346427974593, 8.776887356869956,
+    9.514364454222585, 10.385397080138159, 11.430052302761343, 12.706204736174705,
+    14.300666256711928, 16.349855476099673, 19.08113668772821, 22.9037655484312,
+    28.636253282915604, 38.18845929702561, 57.28996163075942, 114.58865012930961,
+};
+
+// 半度数 k（0 <= k < 720）的正弦
+static double sinHalfDegrees(int k) {
+    if (k <= 180) return sinHalfDegree[k];
+    if (k <= 360) return sinHalfDegree[360 - k];
+    if (k <= 540) return -sinHalfDegree[k - 360];
+    return -sinHalfDegree[720 - k];
+}
+
+/**
+ * 查表计算角度模式的 sin/cos/tan
+ * @param func    FUNC_SIN、FUNC_COS 或 FUNC_TAN
+ * @param degrees 角度
+ * @param result  查表结果
+ * @return 0: 不是整数或半整数度（需要常规计算）; 1: 已查表; 2: 无定义（tan 90°、270° 等）
+ */
+int lookupDegreeTrig(FuncType func, double degrees, double* result) {
+    double twice = degrees * 2;
+    // 超过 2^53 的值都是整数，但这里只处理 int64_t 能表示的半度数
+    if (!(fabs(twice) < 9.0e18) || twice != (double)(int64_t)twice) {
+        return 0;
+    }
+    int k = (int)((int64_t)twice % HALF_DEGREES_PER_TURN);
+    if (k < 0) {
+        k += HALF_DEGREES_PER_TURN;
+    }
+
+    switch (func) {
+        case FUNC_SIN:
+            *result = sinHalfDegrees(k);
+            return 1;
+        case FUNC_COS:
+            *result = sinHalfDegrees((k + 180) % HALF_DEGREES_PER_TURN);
+            return 1;
+        case FUNC_TAN:
+            // 周期为 180°
+            k %= 360;
+            if (k == 180) return 2;
+            *result = (k < 180) ? tanHalfDegree[k] : -tanHalfDegree[360 - k];
+            return 1;
+        default:
+            return 0;
+    }
+}
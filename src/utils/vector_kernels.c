@@ -0,0 +1,472 @@
+#include "calculator.h"
+#include "vector_value.h"
+
+// 定义 VECTOR_SCALAR 时强制使用逐元素实现
+#if !defined(VECTOR_SCALAR) && (defined(__x86_64__) || defined(_M_X64) || (defined(__i386__) && defined(__SSE2__)))
+#define VECTOR_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define VECTOR_AVX          // 运行时检测 CPU 是否支持
+#include <immintrin.h>
+#endif
+#endif
+
+#define SNAP_LIMIT   2251799813685248.0     // 2^51：不超过时可以用加减 ROUND_MAGIC 取整
+#define ROUND_MAGIC  6755399441055744.0     // 1.5 * 2^52
+
+// ─── arena ──────────────────────────────────────────────────────────────────
+
+struct VectorArenaBlock {
+    VectorArenaBlock* next;
+    unsigned char* base;    // 按 VECTOR_ALIGNMENT 对齐的可用空间起点
+    size_t capacity;        // 可用字节数
+};
+
+void initVectorArena(VectorArena* arena) {
+    arena->blocks = NULL;
+    arena->used = 0;
+}
+
+/**
+ * 分配 count 个 double，起点按 VECTOR_ALIGNMENT 对齐
+ * 当前块不够时新开一块（至少 VECTOR_ARENA_BLOCK 字节，且不小于上一块）
+ * @return 失败返回 NULL
+ */
+double* allocateVector(VectorArena* arena, size_t count) {
+    if (count > ((size_t)-1 - VECTOR_ARENA_BLOCK) / sizeof(double)) {
+        return NULL;
+    }
+    size_t bytes = (count * sizeof(double) + VECTOR_ALIGNMENT - 1) & ~(size_t)(VECTOR_ALIGNMENT - 1);
+    VectorArenaBlock* block = arena->blocks;
+
+    if (block == NULL || block->capacity - arena->used < bytes) {
+        size_t capacity = VECTOR_ARENA_BLOCK;
+        if (block != NULL && block->capacity > capacity) capacity = block->capacity;
+        if (bytes > capacity) capacity = bytes;
+
+        unsigned char* raw = (unsigned char*)malloc(sizeof(VectorArenaBlock) + VECTOR_ALIGNMENT + capacity);
+        if (raw == NULL) {
+            return NULL;
+        }
+        block = (VectorArenaBlock*)raw;
+        uintptr_t start = (uintptr_t)(raw + sizeof(VectorArenaBlock));
+        block->base = raw + sizeof(VectorArenaBlock) +
+                      ((VECTOR_ALIGNMENT - start % VECTOR_ALIGNMENT) % VECTOR_ALIGNMENT);
+        block->capacity = capacity;
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->used = 0;
+    }
+
+    double* data = (double*)(block->base + arena->used);
+    arena->used += bytes;
+    return data;
+}
+
+// 释放除当前块以外的所有块，当前块从头开始复用
+void resetVectorArena(VectorArena* arena) {
+    if (arena->blocks == NULL) {
+        return;
+    }
+    VectorArenaBlock* block = arena->blocks->next;
+    while (block != NULL) {
+        VectorArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->blocks->next = NULL;
+    arena->used = 0;
+}
+
+void freeVectorArena(VectorArena* arena) {
+    resetVectorArena(arena);
+    free(arena->blocks);
+    initVectorArena(arena);
+}
+
+// ─── 逐元素运算 ─────────────────────────────────────────────────────────────
+
+/**
+ * 用 performOperationCode 逐个计算 [start, end)
+ * @return 第一个出错元素的下标，全部成功返回 end
+ */
+static size_t computeElements(char op, const double* a, size_t aStep, const double* b, size_t bStep,
+                              double* out, size_t start, size_t end, ErrorCode* code) {
+    for (size_t i = start; i < end; i++) {
+        *code = performOperationCode(op, a[i * aStep], b[i * bStep], &out[i]);
+        if (*code != ERR_SUCCESS) {
+            return i;
+        }
+    }
+    return end;
+}
+
+#ifdef VECTOR_SSE2
+/**
+ * 重新计算 lanes 掩码选中的元素（第 k 位对应 start + k）
+ * @return 第一个出错元素的下标，全部成功返回 SIZE_MAX
+ */
+static size_t recomputeLanes(char op, const double* a, size_t aStep, const double* b, size_t bStep,
+                             double* out, size_t start, unsigned lanes, ErrorCode* code) {
+    for (size_t i = start; lanes; i++, lanes >>= 1) {
+        if ((lanes & 1) && computeElements(op, a, aStep, b, bStep, out, i, i + 1, code) == i) {
+            return i;
+        }
+    }
+    return SIZE_MAX;
+}
+#endif
+
+/*
+ * 一次 LANES 个元素：先按浮点运算得到结果，再按 isCloseToInteger 的判断
+ * （|r - round(r)| < EPSILON 或相对差 < RELATIVE_EPSILON）修正接近整数的结果。
+ * |r| < 2^51 时加减 ROUND_MAGIC 得到最接近的整数，只在 .5 处与 round() 不同；
+ * 超过 2^51、恰好差 .5 以及除数接近 0 的元素标记为慢速，逐个重新计算。
+ * 两个整数运算在 performOperationCode 中走整数快速路径，结果不超过 2^53 时
+ * 与浮点运算的结果相同，因此两条路径的结果逐位一致。
+ */
+#define ARITHMETIC_LANES(LANES, VEC, LOAD, STORE, SET1, OPERATE, CHECK_DIVISOR, ADD, SUB, DIV, AND, ANDNOT, \
+                         OR, MAX, EQ, LT, NLT, MASK)                                                         \
+    do {                                                                                                      \
+        const VEC sign = SET1(-0.0), limit = SET1(SNAP_LIMIT), magic = SET1(ROUND_MAGIC), half = SET1(0.5);  \
+        const VEC epsilon = SET1(EPSILON), relative = SET1(RELATIVE_EPSILON);                                \
+        const VEC tiny = SET1(ABSOLUTE_ZERO_THRESHOLD);                                                      \
+        const VEC aFill = SET1(a[0]), bFill = SET1(b[0]);                                                    \
+        for (; i + LANES <= count; i += LANES) {                                                             \
+            VEC x = aStep ? LOAD(a + i) : aFill;                                                             \
+            VEC y = bStep ? LOAD(b + i) : bFill;                                                             \
+            VEC r = OPERATE(x, y);                                                                           \
+            VEC magnitude = ANDNOT(sign, r);                                                                 \
+            VEC slow = NLT(magnitude, limit);                                                                \
+            if (CHECK_DIVISOR) slow = OR(slow, LT(ANDNOT(sign, y), tiny));                                   \
+            VEC rounded = SUB(ADD(r, magic), magic);                                                         \
+            VEC diff = ANDNOT(sign, SUB(r, rounded));                                                        \
+            slow = OR(slow, EQ(diff, half));                                                                 \
+            VEC snap = OR(LT(diff, epsilon), LT(DIV(diff, MAX(magnitude, ANDNOT(sign, rounded))), relative)); \
+            STORE(out + i, OR(AND(snap, rounded), ANDNOT(snap, r)));                                         \
+            unsigned slowLanes = (unsigned)MASK(slow);                                                       \
+            if (slowLanes) {                                                                                 \
+                size_t failed = recomputeLanes(op, a, aStep, b, bStep, out, i, slowLanes, code);             \
+                if (failed != SIZE_MAX) return failed;                                                       \
+            }                                                                                                \
+        }                                                                                                    \
+    } while (0)
+
+#define NEGATE_LANES(LANES, VEC, LOAD, STORE, SET1, XOR)                \
+    do {                                                                \
+        const VEC sign = SET1(-0.0);                                    \
+        for (; i + LANES <= count; i += LANES) {                        \
+            STORE(out + i, XOR(LOAD(input + i), sign));                 \
+        }                                                               \
+    } while (0)
+
+typedef size_t (*ArithmeticFunc)(char op, const double* a, size_t aStep, const double* b, size_t bStep,
+                                 double* out, size_t count, ErrorCode* code);
+typedef void (*NegateFunc)(const double* input, double* out, size_t count);
+
+#ifdef VECTOR_SSE2
+#define SSE2_LANES(OPERATE, CHECK_DIVISOR)                                                                    \
+    ARITHMETIC_LANES(2, __m128d, _mm_loadu_pd, _mm_store_pd, _mm_set1_pd, OPERATE, CHECK_DIVISOR, _mm_add_pd, \
+                     _mm_sub_pd, _mm_div_pd, _mm_and_pd, _mm_andnot_pd, _mm_or_pd, _mm_max_pd, _mm_cmpeq_pd,   \
+                     _mm_cmplt_pd, _mm_cmpnlt_pd, _mm_movemask_pd)
+
+static size_t arithmeticSse2(char op, const double* a, size_t aStep, const double* b, size_t bStep,
+                             double* out, size_t count, ErrorCode* code) {
+    size_t i = 0;
+    switch (op) {
+        case '+': SSE2_LANES(_mm_add_pd, 0); break;
+        case '-': SSE2_LANES(_mm_sub_pd, 0); break;
+        case '*': SSE2_LANES(_mm_mul_pd, 0); break;
+        case '/': SSE2_LANES(_mm_div_pd, 1); break;
+        default: break;
+    }
+    return computeElements(op, a, aStep, b, bStep, out, i, count, code);
+}
+
+static void negateSse2(const double* input, double* out, size_t count) {
+    size_t i = 0;
+    NEGATE_LANES(2, __m128d, _mm_loadu_pd, _mm_store_pd, _mm_set1_pd, _mm_xor_pd);
+    for (; i < count; i++) out[i] = -input[i];
+}
+#endif
+
+#ifdef VECTOR_AVX
+#define AVX_EQ(a, b)   _mm256_cmp_pd(a, b, _CMP_EQ_OQ)
+#define AVX_LT(a, b)   _mm256_cmp_pd(a, b, _CMP_LT_OQ)
+#define AVX_NLT(a, b)  _mm256_cmp_pd(a, b, _CMP_NLT_UQ)    // NaN 也算作不小于
+#define AVX_LANES(OPERATE, CHECK_DIVISOR)                                                                     \
+    ARITHMETIC_LANES(4, __m256d, _mm256_loadu_pd, _mm256_store_pd, _mm256_set1_pd, OPERATE, CHECK_DIVISOR,    \
+                     _mm256_add_pd, _mm256_sub_pd, _mm256_div_pd, _mm256_and_pd, _mm256_andnot_pd,             \
+                     _mm256_or_pd, _mm256_max_pd, AVX_EQ, AVX_LT, AVX_NLT, _mm256_movemask_pd)
+
+__attribute__((target("avx")))
+static size_t arithmeticAvx(char op, const double* a, size_t aStep, const double* b, size_t bStep,
+                            double* out, size_t count, ErrorCode* code) {
+    size_t i = 0;
+    switch (op) {
+        case '+': AVX_LANES(_mm256_add_pd, 0); break;
+        case '-': AVX_LANES(_mm256_sub_pd, 0); break;
+        case '*': AVX_LANES(_mm256_mul_pd, 0); break;
+        case '/': AVX_LANES(_mm256_div_pd, 1); break;
+        default: break;
+    }
+    return computeElements(op, a, aStep, b, bStep, out, i, count, code);
+}
+
+__attribute__((target("avx")))
+static void negateAvx(const double* input, double* out, size_t count) {
+    size_t i = 0;
+    NEGATE_LANES(4, __m256d, _mm256_loadu_pd, _mm256_store_pd, _mm256_set1_pd, _mm256_xor_pd);
+    for (; i < count; i++) out[i] = -input[i];
+}
+#endif
+
+#ifndef VECTOR_SSE2
+static size_t arithmeticScalar(char op, const double* a, size_t aStep, const double* b, size_t bStep,
+                               double* out, size_t count, ErrorCode* code) {
+    return computeElements(op, a, aStep, b, bStep, out, 0, count, code);
+}
+
+static void negateScalar(const double* input, double* out, size_t count) {
+    for (size_t i = 0; i < count; i++) out[i] = -input[i];
+}
+#endif
+
+// 选择当前 CPU 可用的最宽实现
+static ArithmeticFunc selectArithmetic(void) {
+#ifdef VECTOR_AVX
+    if (__builtin_cpu_supports("avx")) {
+        return arithmeticAvx;
+    }
+#endif
+#ifdef VECTOR_SSE2
+    return arithmeticSse2;
+#else
+    return arithmeticScalar;
+#endif
+}
+
+static NegateFunc selectNegate(void) {
+#ifdef VECTOR_AVX
+    if (__builtin_cpu_supports("avx")) {
+        return negateAvx;
+    }
+#endif
+#ifdef VECTOR_SSE2
+    return negateSse2;
+#else
+    return negateScalar;
+#endif
+}
+
+/**
+ * 逐元素 a op b（op 为 + - * / ^），结果与逐个调用 performOperationCode 一致
+ * ^ 没有向量实现，逐元素计算
+ */
+size_t vectorArithmetic(char op, const double* a, size_t aStep, const double* b, size_t bStep,
+                        double* out, size_t count, ErrorCode* code) {
+    *code = ERR_SUCCESS;
+    if (count == 0) {
+        return 0;
+    }
+    if (op == '^') {
+        return computeElements(op, a, aStep, b, bStep, out, 0, count, code);
+    }
+    return selectArithmetic()(op, a, aStep, b, bStep, out, count, code);
+}
+
+void vectorNegate(const double* input, double* out, size_t count) {
+    selectNegate()(input, out, count);
+}
+
+// ─── 比较与条件选择 ─────────────────────────────────────────────────────────
+
+static void compareElements(char op, const double* a, size_t aStep, const double* b, size_t bStep,
+                            double* out, size_t start, size_t end) {
+    for (size_t i = start; i < end; i++) {
+        out[i] = compareOperands(op, a[i * aStep], b[i * bStep]);
+    }
+}
+
+/*
+ * 比较得到全 1 / 全 0 的掩码，与 1.0 按位与得到 1 或 0；and / or 先把两侧按
+ * 非 0 即真转成掩码。NaN 参与的比较与 compareOperands 一致（只有 != 为真）。
+ * 批量求值的栈只按 16 字节对齐，读写都不要求对齐。
+ */
+#define COMPARE_LANES(LANES, VEC, LOAD, STORE, SET1, AND, COMPARE)      \
+    do {                                                                \
+        const VEC one = SET1(1.0), zero = SET1(0.0);                    \
+        const VEC aFill = SET1(a[0]), bFill = SET1(b[0]);               \
+        (void)zero;                                                     \
+        for (; i + LANES <= count; i += LANES) {                        \
+            VEC x = aStep ? LOAD(a + i) : aFill;                        \
+            VEC y = bStep ? LOAD(b + i) : bFill;                        \
+            STORE(out + i, AND(COMPARE(x, y), one));                    \
+        }                                                               \
+    } while (0)
+
+// 条件非 0 的元素取 a，否则取 b：掩码混合，不按元素分支
+#define BLEND_LANES(LANES, VEC, LOAD, STORE, SET1, NEQ, BLEND)          \
+    do {                                                                \
+        const VEC zero = SET1(0.0);                                     \
+        for (; i + LANES <= count; i += LANES) {                        \
+            VEC mask = NEQ(LOAD(cond + i), zero);                       \
+            STORE(out + i, BLEND(mask, LOAD(a + i), LOAD(b + i)));      \
+        }                                                               \
+    } while (0)
+
+typedef void (*CompareFunc)(char op, const double* a, size_t aStep, const double* b, size_t bStep,
+                            double* out, size_t count);
+typedef void (*BlendFunc)(const double* cond, const double* a, const double* b, double* out, size_t count);
+
+#ifdef VECTOR_SSE2
+#define SSE2_BOTH(x, y)    _mm_and_pd(_mm_cmpneq_pd(x, zero), _mm_cmpneq_pd(y, zero))
+#define SSE2_EITHER(x, y)  _mm_or_pd(_mm_cmpneq_pd(x, zero), _mm_cmpneq_pd(y, zero))
+#define SSE2_BLEND(m, x, y) _mm_or_pd(_mm_and_pd(m, x), _mm_andnot_pd(m, y))
+#define SSE2_COMPARE(COMPARE) \
+    COMPARE_LANES(2, __m128d, _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd, _mm_and_pd, COMPARE)
+
+static void compareSse2(char op, const double* a, size_t aStep, const double* b, size_t bStep,
+                        double* out, size_t count) {
+    size_t i = 0;
+    switch (op) {
+        case '<':          SSE2_COMPARE(_mm_cmplt_pd); break;
+        case OPERATOR_LE:  SSE2_COMPARE(_mm_cmple_pd); break;
+        case '>':          SSE2_COMPARE(_mm_cmpgt_pd); break;
+        case OPERATOR_GE:  SSE2_COMPARE(_mm_cmpge_pd); break;
+        case OPERATOR_EQ:  SSE2_COMPARE(_mm_cmpeq_pd); break;
+        case OPERATOR_NE:  SSE2_COMPARE(_mm_cmpneq_pd); break;
+        case OPERATOR_AND: SSE2_COMPARE(SSE2_BOTH); break;
+        case OPERATOR_OR:  SSE2_COMPARE(SSE2_EITHER); break;
+        default: break;
+    }
+    compareElements(op, a, aStep, b, bStep, out, i, count);
+}
+
+static void blendSse2(const double* cond, const double* a, const double* b, double* out, size_t count) {
+    size_t i = 0;
+    BLEND_LANES(2, __m128d, _mm_loadu_pd, _mm_storeu_pd, _mm_set1_pd, _mm_cmpneq_pd, SSE2_BLEND);
+    for (; i < count; i++) out[i] = (cond[i] != 0) ? a[i] : b[i];
+}
+#endif
+
+#ifdef VECTOR_AVX
+#define AVX_LE(a, b)   _mm256_cmp_pd(a, b, _CMP_LE_OQ)
+#define AVX_GT(a, b)   _mm256_cmp_pd(a, b, _CMP_GT_OQ)
+#define AVX_GE(a, b)   _mm256_cmp_pd(a, b, _CMP_GE_OQ)
+#define AVX_NE(a, b)   _mm256_cmp_pd(a, b, _CMP_NEQ_UQ)    // NaN 与任何数都不相等
+#define AVX_BOTH(x, y)   _mm256_and_pd(AVX_NE(x, zero), AVX_NE(y, zero))
+#define AVX_EITHER(x, y) _mm256_or_pd(AVX_NE(x, zero), AVX_NE(y, zero))
+#define AVX_BLEND(m, x, y) _mm256_blendv_pd(y, x, m)
+#define AVX_COMPARE(COMPARE) \
+    COMPARE_LANES(4, __m256d, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd, _mm256_and_pd, COMPARE)
+
+__attribute__((target("avx")))
+static void compareAvx(char op, const double* a, size_t aStep, const double* b, size_t bStep,
+                       double* out, size_t count) {
+    size_t i = 0;
+    switch (op) {
+        case '<':          AVX_COMPARE(AVX_LT); break;
+        case OPERATOR_LE:  AVX_COMPARE(AVX_LE); break;
+        case '>':          AVX_COMPARE(AVX_GT); break;
+        case OPERATOR_GE:  AVX_COMPARE(AVX_GE); break;
+        case OPERATOR_EQ:  AVX_COMPARE(AVX_EQ); break;
+        case OPERATOR_NE:  AVX_COMPARE(AVX_NE); break;
+        case OPERATOR_AND: AVX_COMPARE(AVX_BOTH); break;
+        case OPERATOR_OR:  AVX_COMPARE(AVX_EITHER); break;
+        default: break;
+    }
+    compareElements(op, a, aStep, b, bStep, out, i, count);
+}
+
+__attribute__((target("avx")))
+static void blendAvx(const double* cond, const double* a, const double* b, double* out, size_t count) {
+    size_t i = 0;
+    BLEND_LANES(4, __m256d, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_set1_pd, AVX_NE, AVX_BLEND);
+    for (; i < count; i++) out[i] = (cond[i] != 0) ? a[i] : b[i];
+}
+#endif
+
+#ifndef VECTOR_SSE2
+static void compareScalar(char op, const double* a, size_t aStep, const double* b, size_t bStep,
+                          double* out, size_t count) {
+    compareElements(op, a, aStep, b, bStep, out, 0, count);
+}
+
+static void blendScalar(const double* cond, const double* a, const double* b, double* out, size_t count) {
+    for (size_t i = 0; i < count; i++) out[i] = (cond[i] != 0) ? a[i] : b[i];
+}
+#endif
+
+static CompareFunc selectCompare(void) {
+#ifdef VECTOR_AVX
+    if (__builtin_cpu_supports("avx")) {
+        return compareAvx;
+    }
+#endif
+#ifdef VECTOR_SSE2
+    return compareSse2;
+#else
+    return compareScalar;
+#endif
+}
+
+static BlendFunc selectBlend(void) {
+#ifdef VECTOR_AVX
+    if (__builtin_cpu_supports("avx")) {
+        return blendAvx;
+    }
+#endif
+#ifdef VECTOR_SSE2
+    return blendSse2;
+#else
+    return blendScalar;
+#endif
+}
+
+/**
+ * 逐元素比较或逻辑运算（op 为 < > OPERATOR_LE/GE/EQ/NE/AND/OR），结果为 1 或 0，
+ * 与逐个调用 compareOperands 一致；out 可以与 a 或 b 相同
+ */
+void vectorCompare(char op, const double* a, size_t aStep, const double* b, size_t bStep,
+                   double* out, size_t count) {
+    if (count > 0) {
+        selectCompare()(op, a, aStep, b, bStep, out, count);
+    }
+}
+
+/**
+ * 逐元素条件选择 out[i] = cond[i] != 0 ? a[i] : b[i]（out 可以与任一输入相同）
+ */
+void vectorSelect(const double* cond, const double* a, const double* b, double* out, size_t count) {
+    selectBlend()(cond, a, b, out, count);
+}
+
+/**
+ * 按条件选择批量求值的行错误（两个分支的错误相同时直接复制）
+ */
+void selectRowErrors(const double* cond, const unsigned char* a, const unsigned char* b, unsigned char* out,
+                     size_t count) {
+    if (memcmp(a, b, count) == 0) {
+        if (out != a) memcpy(out, a, count);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        out[i] = (cond[i] != 0) ? a[i] : b[i];
+    }
+}
+
+/**
+ * 逐元素调用 calculateFunctionCode（input 与 out 可以相同）
+ */
+size_t vectorFunction(FuncType func, const double* input, double* out, size_t count, AngleMode mode,
+                      ErrorCode* code) {
+    *code = ERR_SUCCESS;
+    for (size_t i = 0; i < count; i++) {
+        *code = calculateFunctionCode(func, input[i], mode, &out[i]);
+        if (*code != ERR_SUCCESS) {
+            return i;
+        }
+    }
+    return count;
+}
@@ -305,6 +305,7 @@ TestCase boundaryTests[] = {
     {"0/100", 0, 0, NULL},
     {"1^1000", 1, 0, NULL},
     {"0^0", 1, 0, NULL},                        // 约定 0^0 = 1
+    {"2^63", 9223372036854775808.0, 0, NULL},   // 超出 int64_t 范围，不能修正为整数
     {NULL, 0, 0, NULL}
 };
 
@@ -320,4 +321,147 @@ TestCase whitespaceTests[] = {
     {"1+   2", 3, 0, NULL},
     {"   3   ", 3, 0, NULL},
     {NULL, 0, 0, NULL}
-};
\ No newline at end of file
+};
+
+// ============================================================================
+// 聚合函数测试用例（数组变量在 setupAggregateTestArrays 中绑定）
+// ============================================================================
+#define LARGE_TEST_ARRAY_SIZE 600000
+
+static double testArrayV[] = {1, 2, 3, 4, 5};
+static double testArrayW[] = {2, -1, 0.5, 4, -3};
+static double testArrayTenths[] = {0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1.0};
+static double testArrayLarge[LARGE_TEST_ARRAY_SIZE];
+
+void setupAggregateTestArrays(void) {
+    for (int i = 0; i < LARGE_TEST_ARRAY_SIZE; i++) {
+        testArrayLarge[i] = 0.1;
+    }
+    bindArrayVariable("v", testArrayV, 5);
+    bindArrayVariable("w", testArrayW, 5);
+    bindArrayVariable("t", testArrayTenths, 10);
+    bindArrayVariable("big", testArrayLarge, LARGE_TEST_ARRAY_SIZE);
+    bindArrayVariable("empty", testArrayV, 0);
+}
+
+TestCase aggregateTests[] = {
+    {"sum(v)", 15, 0, NULL},
+    {"mean(v)", 3, 0, NULL},
+    {"min(w)", -3, 0, NULL},
+    {"max(w)", 4, 0, NULL},
+    {"norm(v)", 7.416198487095663, 0, NULL},
+    {"dot(v, w)", 2.5, 0, NULL},
+    {"sum(t)", 5.5, 0, NULL},         // 补偿求和
+    {"sum(big)", 60000, 0, NULL},     // 并行分块求和
+    {"mean(big)", 0.1, 0, NULL},
+    {"sum(empty)", 0, 0, NULL},
+    {"2*sum(v)+1", 31, 0, NULL},      // 参与运算
+    {"-sum(v)", -15, 0, NULL},        // 负号聚合函数
+    {"sqrt(sum(v)+1)", 4, 0, NULL},   // 嵌套在函数中
+    {"SUM( v )", 15, 0, NULL},        // 大小写与空格
+    {"sum(x)", 0, 1, "未绑定的数组变量"},
+    {"sum(1)", 0, 1, "聚合函数的参数必须是数组变量"},
+    {"dot(v)", 0, 1, "缺少参数"},
+    {"sum(v, w)", 0, 1, "聚合函数参数个数不正确"},
+    {"mean(empty)", 0, 1, "mean的参数不能为空数组"},
+    {"max(empty)", 0, 1, "max的参数不能为空数组"},
+    {"dot(v, t)", 0, 1, "dot的两个数组长度必须相同"},
+    {NULL, 0, 0, NULL}
+};
+
+// ============================================================================
+// 编译求值测试用例（带变量 x、y）
+// ============================================================================
+VariableTestCase variableTests[] = {
+    {"x+1", 2, 0, 3, 0, NULL},
+    {"x*y", 3, 4, 12, 0, NULL},
+    {"2x+3y", 1, 2, 8, 0, NULL},              // 隐式乘法
+    {"x^2+y^2", 3, 4, 25, 0, NULL},
+    {"sqrt(x^2+y^2)", 3, 4, 5, 0, NULL},
+    {"-x^2", 3, 0, 9, 0, NULL},               // 负号只作用于变量（与 -2^2 = 4 一致）
+    {"-(x+y)", 1, 2, -3, 0, NULL},
+    {"x^y^2", 2, 3, 512, 0, NULL},            // 右结合
+    {"x-y-1", 10, 5, 4, 0, NULL},             // 左结合
+    {"sin(x)+cos(y)", 30, 60, 1, 0, NULL},
+    {"2(x+1)(y)", 1, 3, 12, 0, NULL},
+    {"x/y", 1, 0, 0, 1, "除数不能为0"},
+    {"sqrt(x)", -1, 0, 0, 1, "负数不能开平方根"},
+    {"x+", 0, 0, 0, 1, "表达式不能以运算符结尾"},
+    {"(x+1", 0, 0, 0, 1, "括号不匹配：左括号过多"},
+    {"x+1)", 0, 0, 0, 1, "括号不匹配：右括号过多"},
+    {"x++1", 0, 0, 0, 1, "运算符使用不正确"},
+    {"x $ 1", 0, 0, 0, 1, "无效的字符"},
+    {"sum(x)", 0, 0, 0, 1, "编译表达式不支持聚合函数"},
+    {NULL, 0, 0, 0, 0, NULL}
+};
+
+// ============================================================================
+// 整数快速路径测试用例（x = 2^60，超出 double 的精确整数范围）
+// ============================================================================
+IntegerTestCase integerTests[] = {
+    {"x+1", 1152921504606846976.0, 1, 1152921504606846977LL, 0},
+    {"x-1", 1152921504606846976.0, 1, 1152921504606846975LL, 0},
+    {"x*7+3", 1152921504606846976.0, 1, 8070450532247928835LL, 0},
+    {"x/4", 1152921504606846976.0, 1, 288230376151711744LL, 0},
+    {"-x-1", 1152921504606846976.0, 1, -1152921504606846977LL, 0},
+    {"3^39+x", 1152921504606846976.0, 1, 5205476657625823243LL, 0},
+    {"(x+1)/3", 1152921504606846976.0, 0, 0, 384307168202282325.666},     // 除不尽，转为双精度
+    {"x*x", 1152921504606846976.0, 0, 0, 1.329227995784916e36},           // 溢出，转为双精度
+    {"2^63", 0, 0, 0, 9223372036854775808.0},                             // 溢出，转为双精度
+    {"2^62+x", 1152921504606846976.0, 1, 5764607523034234880LL, 0},
+    {"sqrt(16)*x", 1152921504606846976.0, 1, 4611686018427387904LL, 0},   // 函数结果为整数时重新进入整数路径
+    {"x^0", 1152921504606846976.0, 1, 1, 0},
+    {"x+0.5", 1152921504606846976.0, 0, 0, 1152921504606846976.0},       // 非整数运算，结果已舍入
+    {NULL, 0, 0, 0, 0}
+};
+
+// ============================================================================
+// 按需提升精度测试用例（双精度下发生严重相消的表达式应提升到双双精度）
+// ============================================================================
+AdaptiveTestCase adaptiveTests[] = {
+    {"1e16+1-1e16", 0, 1, 1},
+    {"x+1-x", 1e17, 1, 1},
+    {"(x+1)*(x-1)-x*x", 1e8, -1, 1},
+    {"sqrt(x^2+1)-x", 1e8, 5e-9, 1},
+    {"1/(x+1-x)", 1e17, 1, 1},                  // 双精度下除数相消为0
+    {"x*3-x-x-x", 0.1, 0, 1},                   // 结果修正为0，但误差上界非零
+    {"x-x", 0.1, 0, 0},                         // 误差上界为0，无需提升
+    {"0.1+0.2", 0, 0.3, 0},
+    {"sin(x)+cos(x)", 30, 1.3660254037844386, 0},
+    {"x^3-3*x", 1e5, 999999999700000, 0},
+    {NULL, 0, 0, 0}
+};
+
+// ============================================================================
+// 十进制定点模式测试用例
+// ============================================================================
+DecimalTestCase decimalTests[] = {
+    {"0.1+0.2", 2, DEC_ROUND_HALF_EVEN, "0.3", 0},
+    {"0.1+0.2-0.3", 18, DEC_ROUND_HALF_EVEN, "0", 0},
+    {"1/3", 18, DEC_ROUND_HALF_EVEN, "0.333333333333333333", 0},
+    {"2/3", 4, DEC_ROUND_HALF_EVEN, "0.6667", 0},
+    {"2/3", 4, DEC_ROUND_DOWN, "0.6666", 0},
+    {"-2/3", 4, DEC_ROUND_FLOOR, "-0.6667", 0},
+    {"-2/3", 4, DEC_ROUND_CEILING, "-0.6666", 0},
+    {"0.125", 2, DEC_ROUND_HALF_EVEN, "0.12", 0},       // 字面量按舍入方式转换
+    {"0.135", 2, DEC_ROUND_HALF_EVEN, "0.14", 0},
+    {"0.125", 2, DEC_ROUND_HALF_UP, "0.13", 0},
+    {"-0.125", 2, DEC_ROUND_HALF_UP, "-0.13", 0},
+    {"19.99*3", 2, DEC_ROUND_HALF_EVEN, "59.97", 0},
+    {"1.05^10", 6, DEC_ROUND_HALF_EVEN, "1.628895", 0},
+    {"1.05^10", 2, DEC_ROUND_HALF_EVEN, "1.63", 0},
+    {"1000^5", 2, DEC_ROUND_HALF_EVEN, "1000000000000000", 0},  // 额外位数溢出时退回原小数位数
+    {"1.1^-1", 6, DEC_ROUND_HALF_EVEN, "0.909091", 0},
+    {"1.5e3+2.5e-1", 2, DEC_ROUND_HALF_EVEN, "1500.25", 0},
+    {"12345678901234.56+0.01", 2, DEC_ROUND_HALF_EVEN, "12345678901234.57", 0},
+    {"2(3+4)", 0, DEC_ROUND_HALF_EVEN, "14", 0},
+    {"-(1.25-3)", 2, DEC_ROUND_HALF_EVEN, "1.75", 0},
+    {"1/0", 2, DEC_ROUND_HALF_EVEN, "除数不能为0", 1},
+    {"0^-1", 2, DEC_ROUND_HALF_EVEN, "0的负数次幂未定义", 1},
+    {"2^0.5", 2, DEC_ROUND_HALF_EVEN, "十进制模式的指数必须是整数", 1},
+    {"sqrt(4)", 2, DEC_ROUND_HALF_EVEN, "十进制模式不支持函数", 1},
+    {"2pi", 2, DEC_ROUND_HALF_EVEN, "十进制模式不支持常量pi和e", 1},
+    {"100000000000000*100000", 2, DEC_ROUND_HALF_EVEN, "计算结果太大", 1},
+    {"x+1", 2, DEC_ROUND_HALF_EVEN, "无效的字符", 1},
+    {NULL, 0, DEC_ROUND_HALF_EVEN, NULL, 0}
+};
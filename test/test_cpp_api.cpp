@@ -0,0 +1,183 @@
+// C++ 接口测试（calculator.hpp），与 C 测试共用 test_framework 与 test_cases
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "calculator.hpp"
+#include "test_framework.h"
+
+using namespace calc::literals;
+
+extern "C" {
+extern TestCase basicTests[];
+extern TestCase powerTests[];
+extern TestCase implicitMultiplyTests[];
+extern TestCase scientificTests[];
+extern TestCase errorTests[];
+extern TestCase constantTests[];
+extern TestCase boundaryTests[];
+extern TestCase whitespaceTests[];
+}
+
+// 编译期求值：以下断言不成立或表达式出错都是编译错误
+static_assert(calc::literal("1+2*3") == 7);
+static_assert(calc::literal("2^3^2") == 512);
+static_assert(calc::literal("-2^2") == 4);
+static_assert(calc::literal("2(3+4)(5+6)") == 154);
+static_assert(calc::literal("0.1+0.2") == 0.30000000000000004);
+static_assert(calc::literal("10/3*3") == 10);
+static_assert(calc::literal("2^-2") == 0.25);
+static_assert("2pi"_calc == 2 * PI);
+static_assert("1.5e3 - 1e-1"_calc == 1499.9);
+static_assert("-(1 + 2) * -e"_calc == 3 * E);
+
+constexpr double KILO = "2^10"_calc;
+constexpr double TABLE[] = {"1/4"_calc, "3/4"_calc, "1.1^2"_calc};
+
+static bool sameBits(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+/**
+ * 字面量求值与 evaluateExpression 逐位比较（结果与错误代码、消息、位置都相同）
+ * 编译期不支持的用例（函数、非整数次幂）跳过
+ */
+static void runLiteralSuite(const char* name, const TestCase* tests) {
+    int compared = 0, skipped = 0, mismatched = 0;
+    char detail[256] = "";
+    for (size_t i = 0; tests[i].expr != NULL; i++) {
+        double expected = 0;
+        CalcError err = evaluateExpression(tests[i].expr, MODE_DEG, &expected);
+        double actual = 0;
+        int code = 0, position = -1;
+        const char* message = NULL;
+        try {
+            actual = calc::literal(tests[i].expr);
+        } catch (const calc::Error& e) {
+            if (std::strncmp(e.what(), "编译期", std::strlen("编译期")) == 0) {
+                skipped++;
+                continue;
+            }
+            code = e.code();
+            message = e.what();
+            position = e.position();
+        }
+        compared++;
+        bool same = (err.code == 0) ? (code == 0 && sameBits(actual, expected))
+                                    : (code == err.code && position == err.position &&
+                                       std::strcmp(message, err.message) == 0);
+        if (!same && mismatched++ == 0) {
+            std::snprintf(detail, sizeof(detail), "%s: %.17g/%d vs %.17g/%d", tests[i].expr, actual, code,
+                          expected, err.code);
+        }
+    }
+    char description[128];
+    std::snprintf(description, sizeof(description), "%s（比较 %d 个，跳过 %d 个）", name, compared, skipped);
+    recordCheck(description, mismatched == 0 && compared > 0, mismatched ? detail : NULL);
+}
+
+static void runCompileTimeSuite() {
+    printf("\n=== C++：编译期求值 ===\n");
+    runLiteralSuite("基本运算与运行期一致", basicTests);
+    runLiteralSuite("幂运算与运行期一致", powerTests);
+    runLiteralSuite("隐式乘法与运行期一致", implicitMultiplyTests);
+    runLiteralSuite("科学计数法与运行期一致", scientificTests);
+    runLiteralSuite("错误与运行期一致", errorTests);
+    runLiteralSuite("常量与运行期一致", constantTests);
+    runLiteralSuite("边界值与运行期一致", boundaryTests);
+    runLiteralSuite("空格处理与运行期一致", whitespaceTests);
+
+    // 非整数底数的整数次幂（双双精度平方求幂）与 libm 的 pow 逐位比较
+    const char* powers[] = {"1.1^7", "0.3^-5", "(-1.7)^9", "1.0000001^123456", "7.5^300", "0.5^1074",
+                            "2^-1075", "1e-5^3", "3.7e2^-100"};
+    int mismatched = 0;
+    for (const char* expr : powers) {
+        double expected = 0;
+        CalcError err = evaluateExpression(expr, MODE_DEG, &expected);
+        mismatched += (err.code != 0 || !sameBits(calc::literal(expr), expected));
+    }
+    recordCheck("整数次幂与 pow 逐位一致", mismatched == 0, NULL);
+
+    recordCheck("constexpr 变量与数组", KILO == 1024 && TABLE[0] == 0.25 && sameBits(TABLE[2], calc::evaluate("1.1^2")),
+                NULL);
+}
+
+static void runRuntimeSuite() {
+    printf("\n=== C++：string_view 与编译句柄 ===\n");
+
+    // 子串求值：不要求以 '\0' 结尾
+    std::string line = "1+2;3*4;bad(";
+    std::string_view view(line);
+    bool viewOk = calc::evaluate(view.substr(0, 3)) == 3 && calc::evaluate(view.substr(4, 3)) == 12;
+    try {
+        calc::evaluate(view.substr(8));
+        viewOk = false;
+    } catch (const calc::Error& e) {
+        viewOk = viewOk && e.code() == ERR_MISSING_PARENTHESIS;
+    }
+    std::string longExpr(400, ' ');
+    longExpr += "sin(30)";
+    viewOk = viewOk && calc::evaluate(longExpr) == 0.5;
+    recordCheck("string_view 入口（子串、长表达式）", viewOk, NULL);
+
+    // 编译句柄：移动后原句柄为空，析构只释放一次
+    calc::Expression f("x^2 + y");
+    calc::Expression g(std::move(f));
+    double vars[2] = {3, 1};
+    bool moveOk = f.variableCount() == 0 && g.variableCount() == 2 && g.findVariable("y") == 1 &&
+                  g.evaluate(vars) == 10;
+    f = calc::Expression("2*x");
+    moveOk = moveOk && f.evaluate(vars) == 6 && f.variableName(0) == "x";
+    recordCheck("编译句柄只能移动", moveOk, NULL);
+
+    bool errorOk = false;
+    try {
+        calc::Expression bad("1/(x-x)");
+        double zero = 0;
+        bad.evaluate(&zero);
+    } catch (const calc::Error& e) {
+        errorOk = e.code() == ERR_DIV_BY_ZERO && e.position() >= 0;
+    }
+    recordCheck("错误以 calc::Error 抛出", errorOk, NULL);
+
+#if CALC_HAS_SPAN
+    // span 批量求值与逐行结果一致
+    std::vector<double> xs(1000), ys(1000), batch(1000);
+    for (size_t i = 0; i < xs.size(); i++) {
+        xs[i] = i * 0.01 - 5;
+        ys[i] = i % 7;
+    }
+    std::span<const double> columns[2] = {xs, ys};
+    g.evaluateBatch(columns, batch);
+    bool batchOk = true;
+    for (size_t i = 0; i < xs.size(); i++) {
+        double row[2] = {xs[i], ys[i]};
+        batchOk = batchOk && sameBits(batch[i], g.evaluate(std::span<const double>(row)));
+    }
+    calc::Expression inverse("1/x");
+    std::vector<ErrorCode> errors(xs.size());
+    CalcError first = inverse.evaluateBatch(std::span<const std::span<const double>>(columns, 1), batch, errors);
+    batchOk = batchOk && first.code == ERR_DIV_BY_ZERO && errors[500] == ERR_DIV_BY_ZERO && errors[499] == 0;
+    recordCheck("span 批量求值", batchOk, NULL);
+
+    // 向量句柄：结果位于自带的 arena，移动后仍然有效
+    double data[4] = {1, 2, 3, 4};
+    VectorValue v = vectorValue(data, 4);
+    calc::VectorExpression vf("v * 2 + [1, 0, 1, 0]");
+    calc::VectorExpression vg(std::move(vf));
+    std::span<const double> out = calc::elements(vg.evaluate(std::span<const VectorValue>(&v, 1)));
+    bool vectorOk = out.size() == 4 && out[0] == 3 && out[1] == 4 && out[3] == 8;
+    calc::VectorExpression norm("norm(v)");
+    vectorOk = vectorOk && calc::elements(norm.evaluate(&v))[0] == std::sqrt(30.0);
+    recordCheck("向量句柄自带 arena", vectorOk, NULL);
+#endif
+}
+
+int main() {
+    resetTestStats();
+    runCompileTimeSuite();
+    runRuntimeSuite();
+    printTestSummary();
+    return globalStats.failed;
+}
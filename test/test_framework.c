@@ -49,6 +49,73 @@ TestResult runTest(TestCase* testCase, AngleMode mode) {
     return result;
 }
 
+// 根据计算结果判断测试是否通过
+static int checkOutcome(CalcError err, double actual, int expectError, const char* errorMsg,
+                        double expected, EvalPrecision precision) {
+    if (expectError) {
+        return err.code != 0 && (!errorMsg || strcmp(errorMsg, err.message) == 0);
+    }
+    if (err.code != 0) {
+        return 0;
+    }
+    return precision == EVAL_FP32 ? isFloatEqual((float)actual, (float)expected)
+                                  : isDoubleEqual(actual, expected);
+}
+
+// 以编译方式运行单个测试用例
+TestResult runCompiledTest(TestCase* testCase, AngleMode mode, EvalPrecision precision) {
+    TestResult result;
+    CompiledExpr prog;
+    double actualResult = 0;
+    
+    CalcError err = compileExpression(testCase->expr, &prog);
+    if (err.code == 0) {
+        if (precision != EVAL_FP64) {
+            err = evaluateCompiledBatch(&prog, NULL, 1, mode, precision, &actualResult, NULL);
+        } else {
+            err = evaluateCompiled(&prog, NULL, mode, &actualResult);
+        }
+        freeCompiledExpression(&prog);
+    }
+    
+    result.actual_result = actualResult;
+    result.err_code = err.code;
+    result.error_msg = err.message;
+    result.success = checkOutcome(err, actualResult, testCase->expectError, testCase->errorMsg,
+                                  testCase->expected, precision);
+    return result;
+}
+
+// 以编译方式运行带变量的测试用例（display 用于输出）
+TestResult runVariableTest(VariableTestCase* testCase, AngleMode mode, TestCase* display) {
+    TestResult result;
+    CompiledExpr prog;
+    double actualResult = 0;
+    
+    CalcError err = compileExpression(testCase->expr, &prog);
+    if (err.code == 0) {
+        double vars[MAX_COMPILED_VARIABLES] = {0};
+        int xSlot = findCompiledVariable(&prog, "x");
+        int ySlot = findCompiledVariable(&prog, "y");
+        if (xSlot >= 0) vars[xSlot] = testCase->x;
+        if (ySlot >= 0) vars[ySlot] = testCase->y;
+        err = evaluateCompiled(&prog, vars, mode, &actualResult);
+        freeCompiledExpression(&prog);
+    }
+    
+    display->expr = testCase->expr;
+    display->expected = testCase->expected;
+    display->expectError = testCase->expectError;
+    display->errorMsg = testCase->errorMsg;
+    
+    result.actual_result = actualResult;
+    result.err_code = err.code;
+    result.error_msg = err.message;
+    result.success = checkOutcome(err, actualResult, testCase->expectError, testCase->errorMsg,
+                                  testCase->expected, EVAL_FP64);
+    return result;
+}
+
 // 打印测试结果并更新统计
 void printTestResult(TestResult* result, TestCase* testCase, double actual) {
     globalStats.total++;
@@ -86,6 +153,18 @@ void printTestResult(TestResult* result, TestCase* testCase, double actual) {
     }
 }
 
+// 记录一项非表达式检查的结果并更新统计
+void recordCheck(const char* description, int passed, const char* detail) {
+    globalStats.total++;
+    if (passed) {
+        globalStats.passed++;
+    } else {
+        globalStats.failed++;
+    }
+    printf("  [%s] %s%s%s\n", passed ? "PASS" : "FAIL", description,
+           detail ? " => " : "", detail ? detail : "");
+}
+
 // 打印测试摘要
 void printTestSummary(void) {
     printf("\n");
@@ -3,6 +3,10 @@
 
 #include "calculator.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // 测试用例结构
 typedef struct {
     const char* expr;       // 测试表达式
@@ -11,6 +15,42 @@ typedef struct {
     const char* errorMsg;   // 期望的错误消息
 } TestCase;
 
+// 带变量的测试用例结构（编译求值使用，变量名为 x 和 y）
+typedef struct {
+    const char* expr;       // 测试表达式
+    double x;               // 变量 x 的值
+    double y;               // 变量 y 的值
+    double expected;        // 期望结果
+    int expectError;        // 是否期望出错
+    const char* errorMsg;   // 期望的错误消息
+} VariableTestCase;
+
+// 整数快速路径测试用例结构（变量名为 x）
+typedef struct {
+    const char* expr;       // 测试表达式
+    double x;               // 变量 x 的值
+    int expectInteger;      // 是否期望得到精确整数
+    int64_t expectedInt;    // 期望的整数结果
+    double expectedDouble;  // 期望的双精度结果（expectInteger 为假时使用）
+} IntegerTestCase;
+
+// 按需提升精度测试用例结构（变量名为 x）
+typedef struct {
+    const char* expr;       // 测试表达式
+    double x;               // 变量 x 的值
+    double expected;        // 期望结果
+    int expectEscalation;   // 是否期望提升到双双精度
+} AdaptiveTestCase;
+
+// 十进制模式测试用例结构（期望结果为格式化后的字符串）
+typedef struct {
+    const char* expr;           // 测试表达式
+    int scale;                  // 小数位数
+    DecimalRounding rounding;   // 舍入方式
+    const char* expected;       // 期望结果（expectError 为真时为期望的错误消息）
+    int expectError;            // 是否期望出错
+} DecimalTestCase;
+
 // 测试结果结构
 typedef struct {
     int success;            // 测试是否成功
@@ -32,13 +72,26 @@ extern TestStats globalStats;
 // 运行单个测试用例
 TestResult runTest(TestCase* testCase, AngleMode mode);
 
+// 以编译方式运行单个测试用例（EVAL_FP32 按单精度容差比较）
+TestResult runCompiledTest(TestCase* testCase, AngleMode mode, EvalPrecision precision);
+
+// 以编译方式运行带变量的测试用例
+TestResult runVariableTest(VariableTestCase* testCase, AngleMode mode, TestCase* display);
+
 // 打印测试结果并更新统计
 void printTestResult(TestResult* result, TestCase* testCase, double actual);
 
+// 记录一项非表达式检查的结果并更新统计
+void recordCheck(const char* description, int passed, const char* detail);
+
 // 重置测试统计
 void resetTestStats(void);
 
 // 打印测试摘要
 void printTestSummary(void);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif // TEST_FRAMEWORK_H
\ No newline at end of file
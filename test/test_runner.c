@@ -1,6 +1,32 @@
 #include "calculator.h"
 #include "test_framework.h"
+#include "expression_library.h"
+#include "calc_server.h"
+#include "shared_ring.h"
+#include "column_evaluator.h"
+#include "file_mapping.h"
+#include "batch_format.h"
+#include "char_scan.h"
+#include "expression_profile.h"
+#include "trig_reduction.h"
+#include "function_cache.h"
+#include "vector_value.h"
+#include "series_evaluator.h"
+#include "numeric_solver.h"
+#include "polynomial_evaluator.h"
+#include "numeric_policy.h"
+#include "evaluation_budget.h"
 #include <stdio.h>
+#ifdef __linux__
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#endif
 
 // 声明在test_cases.c中定义的测试用例数组
 extern TestCase basicTests[];
@@ -15,6 +41,15 @@ extern TestCase implicitMultiplyTests[];
 extern TestCase powerTests[];
 extern TestCase unitConversionTests[];
 extern TestCase whitespaceTests[];
+extern TestCase aggregateTests[];
+
+extern VariableTestCase variableTests[];
+extern IntegerTestCase integerTests[];
+extern AdaptiveTestCase adaptiveTests[];
+extern DecimalTestCase decimalTests[];
+
+// 在 test_cases.c 中定义，绑定聚合函数测试使用的数组变量
+void setupAggregateTestArrays(void);
 
 // 辅助函数：运行测试数组直到遇到 NULL 终止符
 static int runTestSuite(const char* suiteName, TestCase tests[], AngleMode mode) {
@@ -32,6 +67,2657 @@ static int runTestSuite(const char* suiteName, TestCase tests[], AngleMode mode)
     return suiteTotal - suitePassed;  // 返回失败数
 }
 
+// 以编译方式运行测试数组
+static int runCompiledSuite(const char* suiteName, TestCase tests[], AngleMode mode, EvalPrecision precision) {
+    int suiteTotal = 0, suitePassed = 0;
+    printf("\n=== %s ===\n", suiteName);
+    
+    for (size_t i = 0; tests[i].expr != NULL; i++) {
+        TestResult result = runCompiledTest(&tests[i], mode, precision);
+        printTestResult(&result, &tests[i], result.actual_result);
+        suiteTotal++;
+        if (result.success) suitePassed++;
+    }
+    
+    printf("  --- 小计: %d/%d 通过 ---\n", suitePassed, suiteTotal);
+    return suiteTotal - suitePassed;
+}
+
+// 运行带变量的测试数组
+static int runVariableSuite(const char* suiteName, VariableTestCase tests[], AngleMode mode) {
+    int suiteTotal = 0, suitePassed = 0;
+    printf("\n=== %s ===\n", suiteName);
+    
+    for (size_t i = 0; tests[i].expr != NULL; i++) {
+        TestCase display;
+        TestResult result = runVariableTest(&tests[i], mode, &display);
+        printTestResult(&result, &display, result.actual_result);
+        suiteTotal++;
+        if (result.success) suitePassed++;
+    }
+    
+    printf("  --- 小计: %d/%d 通过 ---\n", suitePassed, suiteTotal);
+    return suiteTotal - suitePassed;
+}
+
+/**
+ * 单精度批量求值精度检查：在参数区间上比较 EVAL_FP32 与 EVAL_FP64 的结果，
+ * 最大误差（结果绝对值小于1时为绝对误差，否则为相对误差）应在 README 精度表给出的范围内。
+ * 单精度路径把绝对值小于 EPSILON_F32 的结果修正为 0，因此零点附近的误差上限为 1e-6
+ */
+static void runPrecisionComparisonSuite(void) {
+    static const struct {
+        const char* expr;
+        AngleMode mode;
+        double lo, hi;
+        double maxError;
+    } checks[] = {
+        {"sin(x)", MODE_DEG, -720, 720, 2e-7},
+        {"cos(x)", MODE_DEG, -720, 720, 2e-7},
+        {"tan(x)", MODE_DEG, -80, 80, 5e-7},
+        {"sin(x)", MODE_RAD, -100, 100, 1e-6},
+        {"asin(x)", MODE_RAD, -1, 1, 5e-7},
+        {"acos(x)", MODE_RAD, -1, 1, 5e-7},
+        {"atan(x)", MODE_RAD, -50, 50, 3e-7},
+        {"ln(x)", MODE_RAD, 0.001, 1000, 3e-7},
+        {"log(x)", MODE_RAD, 0.001, 1000, 1e-6},
+        {"sqrt(x)", MODE_RAD, 0, 1e6, 1e-6},
+        {"x^3-2*x+1", MODE_RAD, -10, 10, 1e-6},
+        {NULL, MODE_RAD, 0, 0, 0}
+    };
+    enum { SAMPLES = 4001 };
+    static double xs[SAMPLES], ref[SAMPLES], single[SAMPLES];
+    
+    printf("\n=== 单精度批量求值精度测试 ===\n");
+    for (int c = 0; checks[c].expr != NULL; c++) {
+        CompiledExpr prog;
+        compileExpression(checks[c].expr, &prog);
+        for (int i = 0; i < SAMPLES; i++) {
+            // 取单精度可表示的参数，使两条路径的输入相同
+            xs[i] = (float)(checks[c].lo + (checks[c].hi - checks[c].lo) * i / (SAMPLES - 1));
+        }
+        const double* columns[1] = {xs};
+        ErrorCode refErrors[SAMPLES], singleErrors[SAMPLES];
+        evaluateCompiledBatch(&prog, columns, SAMPLES, checks[c].mode, EVAL_FP64, ref, refErrors);
+        evaluateCompiledBatch(&prog, columns, SAMPLES, checks[c].mode, EVAL_FP32, single, singleErrors);
+        freeCompiledExpression(&prog);
+        
+        double worst = 0;
+        int mismatched = 0;
+        for (int i = 0; i < SAMPLES; i++) {
+            if (refErrors[i] != ERR_SUCCESS || singleErrors[i] != ERR_SUCCESS) {
+                mismatched += (refErrors[i] == ERR_SUCCESS) != (singleErrors[i] == ERR_SUCCESS);
+                continue;
+            }
+            double scale = fabs(ref[i]) > 1 ? fabs(ref[i]) : 1;
+            double error = fabs(single[i] - ref[i]) / scale;
+            if (error > worst) worst = error;
+        }
+        
+        char description[80], detail[80];
+        snprintf(description, sizeof(description), "%s [%s]", checks[c].expr,
+                 checks[c].mode == MODE_DEG ? "角度" : "弧度");
+        snprintf(detail, sizeof(detail), "最大误差 %.2e（上限 %.0e），错误不一致 %d 处",
+                 worst, checks[c].maxError, mismatched);
+        recordCheck(description, worst <= checks[c].maxError && mismatched == 0, detail);
+    }
+    
+    // 弧度 sin/cos 在修正为 0 与 ±1 的点附近：与 libm 的真值比较（双精度路径按特殊角修正，不能作参考）
+    static const struct {
+        const char* expr;
+        double center;
+    } snapChecks[] = {{"sin(x)", 0}, {"cos(x)", 0}, {"sin(x)", PI / 2}, {"cos(x)", PI}};
+    double worst = 0;
+    for (int c = 0; c < 4; c++) {
+        CompiledExpr prog;
+        compileExpression(snapChecks[c].expr, &prog);
+        for (int i = 0; i < SAMPLES; i++) {
+            xs[i] = (float)(snapChecks[c].center + 0.01 * (2.0 * i / (SAMPLES - 1) - 1));
+        }
+        const double* columns[1] = {xs};
+        ErrorCode errors[SAMPLES];
+        evaluateCompiledBatch(&prog, columns, SAMPLES, MODE_RAD, EVAL_FP32, single, errors);
+        freeCompiledExpression(&prog);
+        for (int i = 0; i < SAMPLES; i++) {
+            double expected = (c & 1) ? cos(xs[i]) : sin(xs[i]);
+            double error = errors[i] == ERR_SUCCESS ? fabs(single[i] - expected) : 1;
+            if (error > worst) worst = error;
+        }
+    }
+    char detail[80];
+    snprintf(detail, sizeof(detail), "最大绝对误差 %.2e（上限 1e-06）", worst);
+    recordCheck("弧度 sin/cos 在 0 与 ±1 附近", worst <= 1e-6, detail);
+}
+
+// 整数快速路径：检查结果是否为精确整数以及整数值
+static void runIntegerSuite(void) {
+    printf("\n=== 整数快速路径测试 ===\n");
+    for (size_t i = 0; integerTests[i].expr != NULL; i++) {
+        IntegerTestCase* tc = &integerTests[i];
+        CompiledExpr prog;
+        CalcNumber number = {0, 0, 0};
+        CalcError err = compileExpression(tc->expr, &prog);
+        if (err.code == 0) {
+            double vars[MAX_COMPILED_VARIABLES] = {tc->x};
+            err = evaluateCompiledNumber(&prog, vars, MODE_DEG, &number);
+            freeCompiledExpression(&prog);
+        }
+        
+        int passed = err.code == 0 && number.isInteger == tc->expectInteger &&
+                     (tc->expectInteger ? number.intValue == tc->expectedInt
+                                        : isDoubleEqual(number.value, tc->expectedDouble));
+        char detail[100];
+        if (err.code != 0) {
+            snprintf(detail, sizeof(detail), "计算失败: %s", err.message);
+        } else if (number.isInteger) {
+            snprintf(detail, sizeof(detail), "整数 %lld", (long long)number.intValue);
+        } else {
+            snprintf(detail, sizeof(detail), "双精度 %.17g", number.value);
+        }
+        recordCheck(tc->expr, passed, detail);
+    }
+    
+    // 超过 2^53 时单行求值跟踪 int64，evaluateExpression 与双精度批量求值不跟踪
+    CompiledExpr prog;
+    double single = -1, batch = -1, direct = -1;
+    ErrorCode batchError = ERR_SUCCESS;
+    CalcError err = compileExpression("x+1-x", &prog);
+    if (err.code == 0) {
+        double x = 1152921504606846976.0;  // 2^60
+        const double* columns[1] = {&x};
+        err = evaluateCompiled(&prog, &x, MODE_DEG, &single);
+        evaluateCompiledBatch(&prog, columns, 1, MODE_DEG, EVAL_FP64, &batch, &batchError);
+        freeCompiledExpression(&prog);
+    }
+    if (err.code == 0) {
+        err = evaluateExpression("2^60+1-2^60", MODE_DEG, &direct);
+    }
+    char detail[100];
+    snprintf(detail, sizeof(detail), "单行 %g，批量 %g，evaluateExpression %g", single, batch, direct);
+    recordCheck("超过 2^53 时单行求值与其他路径的差异", err.code == 0 && batchError == ERR_SUCCESS &&
+                single == 1 && batch == 0 && direct == 0, detail);
+}
+
+// 按需提升精度测试：检查结果与是否提升
+static void runAdaptiveSuite(void) {
+    printf("\n=== 按需提升精度测试 ===\n");
+    for (size_t i = 0; adaptiveTests[i].expr != NULL; i++) {
+        AdaptiveTestCase* tc = &adaptiveTests[i];
+        CompiledExpr prog;
+        double value = 0;
+        int escalated = 0;
+        CalcError err = compileExpression(tc->expr, &prog);
+        if (err.code == 0) {
+            double vars[MAX_COMPILED_VARIABLES] = {tc->x};
+            err = evaluateCompiledAdaptive(&prog, vars, MODE_DEG, DEFAULT_ESCALATION_TOLERANCE, &value, &escalated);
+            freeCompiledExpression(&prog);
+        }
+        
+        int passed = err.code == 0 && escalated == tc->expectEscalation && isDoubleEqual(value, tc->expected);
+        char detail[100];
+        if (err.code != 0) {
+            snprintf(detail, sizeof(detail), "计算失败: %s", err.message);
+        } else {
+            snprintf(detail, sizeof(detail), "%.17g（%s）", value, escalated ? "双双精度" : "双精度");
+        }
+        recordCheck(tc->expr, passed, detail);
+    }
+}
+
+// 十进制定点模式测试：比较格式化后的结果字符串
+static void runDecimalSuite(void) {
+    printf("\n=== 十进制定点模式测试 ===\n");
+    for (size_t i = 0; decimalTests[i].expr != NULL; i++) {
+        DecimalTestCase* tc = &decimalTests[i];
+        DecimalContext context = {tc->scale, tc->rounding};
+        Decimal value;
+        char formatted[64] = "";
+        CalcError err = evaluateDecimalExpression(tc->expr, context, &value);
+        
+        int passed;
+        char detail[100];
+        if (err.code != 0) {
+            passed = tc->expectError && strcmp(err.message, tc->expected) == 0;
+            snprintf(detail, sizeof(detail), "错误: %s", err.message);
+        } else {
+            formatDecimal(value, formatted, sizeof(formatted));
+            passed = !tc->expectError && strcmp(formatted, tc->expected) == 0;
+            snprintf(detail, sizeof(detail), "%s（%d位小数）", formatted, tc->scale);
+        }
+        recordCheck(tc->expr, passed, detail);
+    }
+}
+
+// 字符分类预扫描：位图与逐字节查表一致，括号检查与长表达式编译
+static void runCharScanSuite(void) {
+    printf("\n=== 字符分类测试 ===\n");
+    char detail[200];
+    
+    // 全部 256 个字节值（跨越多个 64 字节块，末尾为不完整的块）
+    static char bytes[300];
+    for (int i = 0; i < 300; i++) bytes[i] = (char)((i * 7) % 256);
+    CharScan scan;
+    CalcError err = scanCharacters(bytes, sizeof(bytes), &scan);
+    int mismatches = 0;
+    for (int cls = 0; cls < CHAR_CLASS_COUNT; cls++) {
+        for (size_t i = 0; i < sizeof(bytes); i++) {
+            if (scanHasClass(&scan, (CharClass)cls, i) != charHasClass(bytes[i], (CharClass)cls)) mismatches++;
+        }
+    }
+    freeCharScan(&scan);
+    snprintf(detail, sizeof(detail), "%d 处不一致", mismatches);
+    recordCheck("位图与查表分类一致（含非 ASCII 字节）", err.code == 0 && mismatches == 0, detail);
+    
+    // 跨块跳过同类字符
+    static char text[400];
+    memset(text, ' ', 150);
+    memcpy(text + 150, "abc_12", 6);
+    memset(text + 156, ' ', 100);
+    size_t length = 256;
+    scanCharacters(text, length, &scan);
+    size_t wordEnd = skipCharClass(&scan, CHAR_WORD, 150);
+    snprintf(detail, sizeof(detail), "空格到 %zu，变量名到 %zu，去掉结尾空格后 %zu",
+             skipCharClass(&scan, CHAR_SPACE, 3), wordEnd, trimTrailingSpaces(&scan));
+    recordCheck("按位图跳到记号边界", skipCharClass(&scan, CHAR_SPACE, 3) == 150 && wordEnd == 156 &&
+                skipCharClass(&scan, CHAR_SPACE, 156) == length && trimTrailingSpaces(&scan) == 156, detail);
+    freeCharScan(&scan);
+    
+    // 括号深度：第 130 个字符处右括号过多
+    memset(text, 0, sizeof(text));
+    for (int i = 0; i < 64; i++) {
+        text[i] = '(';
+        text[64 + i] = ')';
+    }
+    memcpy(text + 128, "+1)", 3);
+    err = checkBracketMatch(text);
+    snprintf(detail, sizeof(detail), "%s，位置 %d", err.message ? err.message : "", err.position);
+    recordCheck("右括号过多（跨块）", err.code != 0 && err.position == 130, detail);
+    text[130] = '(';
+    err = checkBracketMatch(text);
+    recordCheck("左括号过多", err.code == ERR_MISSING_PARENTHESIS, err.message);
+    
+    // 长表达式：大量空格与长数字
+    static char longExpr[20000];
+    size_t used = 0;
+    for (int i = 0; i < 200; i++) {
+        used += (size_t)snprintf(longExpr + used, sizeof(longExpr) - used, "%s(  value_%d   *   1.000000000000000000   )",
+                                 i ? "      +      " : "", i % 3);
+    }
+    CompiledExpr prog;
+    double value = 0;
+    double vars[3] = {1, 2, 3};
+    err = compileExpressionN(longExpr, used, &prog);
+    if (err.code == 0) {
+        err = evaluateCompiled(&prog, vars, MODE_DEG, &value);
+        freeCompiledExpression(&prog);
+    }
+    snprintf(detail, sizeof(detail), "%zu 字节，结果 %.17g", used, value);
+    recordCheck("编译长表达式", err.code == 0 && value == 67 * 1 + 67 * 2 + 66 * 3, detail);
+    
+    used += (size_t)snprintf(longExpr + used, sizeof(longExpr) - used, "  +    ");
+    err = compileExpressionN(longExpr, used, &prog);
+    snprintf(detail, sizeof(detail), "位置 %d", err.position);
+    recordCheck("长表达式结尾运算符的位置", err.code != 0 && err.position == (int)used - 5, detail);
+    longExpr[used - 5] = '#';
+    err = compileExpressionN(longExpr, used, &prog);
+    snprintf(detail, sizeof(detail), "%s，位置 %d", err.message ? err.message : "", err.position);
+    recordCheck("长表达式无效字符的位置", err.code != 0 && err.position == (int)used - 5, detail);
+}
+
+// 两阶段错误：快速求值只返回错误代码，诊断得到与解释求值一致的消息
+static const char* const diagnosticTests[] = {
+    "1/0", "2/(3-3)", "sqrt(-4)", "0^-1", "(-8)^0.5", "asin(2)", "acos(-1.5)",
+    "tan(90)", "log(0)", "ln(-1)", "10^400", "1+2*3", NULL
+};
+
+static void runDiagnosticSuite(void) {
+    printf("\n=== 两阶段错误测试 ===\n");
+    char detail[200];
+    for (int i = 0; diagnosticTests[i] != NULL; i++) {
+        const char* expr = diagnosticTests[i];
+        CompiledExpr prog;
+        double fastValue = 0, value = 0;
+        CalcError expected = evaluateExpression(expr, MODE_DEG, &value);
+        CalcError err = compileExpression(expr, &prog);
+        if (err.code != 0) {
+            recordCheck(expr, 0, err.message);
+            continue;
+        }
+        ErrorCode code = evaluateCompiledFast(&prog, NULL, MODE_DEG, &fastValue);
+        err = diagnoseCompiled(&prog, NULL, MODE_DEG);
+        int passed = (int)code == expected.code && err.code == expected.code &&
+                     (code != ERR_SUCCESS ? strcmp(err.message, expected.message) == 0 : fastValue == value);
+        snprintf(detail, sizeof(detail), "代码 %d，%s（位置 %d）", code, err.message ? err.message : "成功",
+                 err.position);
+        recordCheck(expr, passed, detail);
+        freeCompiledExpression(&prog);
+    }
+    
+    // 诊断给出出错运算的位置
+    CompiledExpr prog;
+    double vars[2] = {1, 0};
+    compileExpression("x + sqrt(x) / y", &prog);
+    double value = 0;
+    ErrorCode code = evaluateCompiledFast(&prog, vars, MODE_DEG, &value);
+    CalcError err = diagnoseCompiled(&prog, vars, MODE_DEG);
+    snprintf(detail, sizeof(detail), "代码 %d，位置 %d", code, err.position);
+    recordCheck("出错运算的位置", code == ERR_DIV_BY_ZERO && err.code == ERR_DIV_BY_ZERO && err.position == 12,
+                detail);
+    freeCompiledExpression(&prog);
+}
+
+// 性能分析：语法树、节点计数、常量折叠与改写建议
+static int profileExpression(const char* expr, const double* vars, int runs, CompiledExpr* prog,
+                             ExpressionProfile* profile) {
+    return compileExpression(expr, prog).code == 0 &&
+           profileCompiled(prog, vars, MODE_DEG, runs, profile).code == 0;
+}
+
+static int findProfileHint(const ExpressionProfile* profile, ProfileHintKind kind, double* value) {
+    for (int h = 0; h < profile->hintCount; h++) {
+        if (profile->hints[h].kind == kind) {
+            *value = profile->hints[h].value;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void runProfileSuite(void) {
+    printf("\n=== 性能分析测试 ===\n");
+    CompiledExpr prog;
+    ExpressionProfile profile;
+    char detail[200];
+    
+    // 由字节码恢复的语法树：sin(x)^2 + 1 的指令为 x sin 2 ^ 1 +
+    double vars[3] = {2, 3, 5};
+    int passed = profileExpression("sin(x)^2 + 1", vars, 10, &prog, &profile);
+    passed = passed && profile.nodes[5].parent == -1 && profile.nodes[5].start == 0 &&
+             profile.nodes[3].parent == 5 && profile.nodes[3].start == 0 && profile.nodes[1].parent == 3 &&
+             profile.nodes[4].start == 4 && profile.nodes[4].parent == 5;
+    for (int i = 0; passed && i < prog.length; i++) {
+        passed = profile.nodes[i].calls == 10;
+    }
+    recordCheck("语法树与执行次数", passed, passed ? "父节点与子树起点正确" : "语法树错误");
+    freeExpressionProfile(&profile);
+    freeCompiledExpression(&prog);
+    
+    // 还原的子表达式重新编译后结果不变
+    const char* formatTests[] = {"x-(y-z)", "2^3^2", "(2^3)^2", "-(x+1)^2", "x/(y*z)", "sqrt(x*y)-z*-2", NULL};
+    passed = 1;
+    for (int i = 0; formatTests[i] != NULL && passed; i++) {
+        char text[160];
+        CompiledExpr again;
+        double expected = 0, actual = 1;
+        passed = profileExpression(formatTests[i], vars, 1, &prog, &profile);
+        if (passed) {
+            formatProfileNode(&profile, prog.length - 1, text, sizeof(text));
+            passed = compileExpression(text, &again).code == 0;
+            if (passed) {
+                evaluateCompiled(&prog, vars, MODE_DEG, &expected);
+                evaluateCompiled(&again, vars, MODE_DEG, &actual);
+                passed = expected == actual && again.length == prog.length;
+                freeCompiledExpression(&again);
+            }
+            snprintf(detail, sizeof(detail), "%s => %s", formatTests[i], text);
+            freeExpressionProfile(&profile);
+        }
+        freeCompiledExpression(&prog);
+    }
+    recordCheck("还原子表达式", passed, detail);
+    
+    // 计数：int64 快速路径、pow、特殊角、接近整数修正
+    struct {
+        const char* expr;
+        double x;
+        int node;
+        size_t counter;
+    } counterTests[] = {
+        {"x*3", 2, 2, offsetof(ProfileNode, integerHits)},
+        {"x^0.5", 2, 2, offsetof(ProfileNode, powCalls)},
+        {"sin(x)", 89.9999, 1, offsetof(ProfileNode, specialHits)},
+        {"x^3", 2.154434690031884, 2, offsetof(ProfileNode, snaps)},
+        {"tan(x)", 30.5, 1, offsetof(ProfileNode, tableHits)},
+    };
+    for (size_t i = 0; i < sizeof(counterTests) / sizeof(counterTests[0]); i++) {
+        passed = profileExpression(counterTests[i].expr, &counterTests[i].x, 20, &prog, &profile);
+        uint64_t count = passed ? *(const uint64_t*)((const char*)&profile.nodes[counterTests[i].node] +
+                                                     counterTests[i].counter) : 0;
+        snprintf(detail, sizeof(detail), "x = %g，计数 %llu", counterTests[i].x, (unsigned long long)count);
+        recordCheck(counterTests[i].expr, passed && count == 20, detail);
+        if (passed) freeExpressionProfile(&profile);
+        freeCompiledExpression(&prog);
+    }
+    
+    // 常量折叠与改写建议
+    struct {
+        const char* expr;
+        ProfileHintKind kind;
+        double value;
+    } hintTests[] = {
+        {"2*pi*x + 1", HINT_FOLD, 2 * PI},
+        {"x + sin(30)*4", HINT_FOLD, 2},
+        {"(x+1)^2", HINT_SQUARE, 2},
+        {"x^0.5 + 1", HINT_SQRT, 0.5},
+        {"sin(x)*y + sin(x)*z", HINT_REPEATED, 2},
+    };
+    for (size_t i = 0; i < sizeof(hintTests) / sizeof(hintTests[0]); i++) {
+        double value = 0;
+        passed = profileExpression(hintTests[i].expr, vars, 1, &prog, &profile) &&
+                 findProfileHint(&profile, hintTests[i].kind, &value) && isDoubleEqual(value, hintTests[i].value);
+        snprintf(detail, sizeof(detail), "%d 条结论", passed ? profile.hintCount : 0);
+        recordCheck(hintTests[i].expr, passed, detail);
+        freeExpressionProfile(&profile);
+        freeCompiledExpression(&prog);
+    }
+    
+    // 没有可改写之处
+    passed = profileExpression("x*y + z", vars, 1, &prog, &profile) && profile.hintCount == 0;
+    recordCheck("无改写建议", passed, passed ? "x*y + z" : "出现了多余的结论");
+    freeExpressionProfile(&profile);
+    freeCompiledExpression(&prog);
+    
+    // 求值出错时记录错误，只统计到出错的节点
+    double zero = 0;
+    passed = profileExpression("1/x + 2", &zero, 100, &prog, &profile);
+    passed = passed && profile.error.code == ERR_DIV_BY_ZERO && profile.error.position == 1 && profile.runs == 1 &&
+             profile.nodes[2].calls == 1 && profile.nodes[3].calls == 0;
+    recordCheck("求值出错", passed, profile.error.message ? profile.error.message : "没有记录错误");
+    freeExpressionProfile(&profile);
+    freeCompiledExpression(&prog);
+}
+
+// 角度模式查表：与长双精度参考值比较、对称性与无定义点
+static void runTrigTableSuite(void) {
+    printf("\n=== 角度查表测试 ===\n");
+    const FuncType funcs[3] = {FUNC_SIN, FUNC_COS, FUNC_TAN};
+    const char* names[3] = {"sin", "cos", "tan"};
+    char detail[200];
+    
+    // 每 0.5° 的结果与长双精度参考值的误差不超过 0.5 ulp（再留一点参考值自身的误差）
+    for (int f = 0; f < 3; f++) {
+        double worst = 0;
+        int missing = 0;
+        for (int k = -720; k < 1440; k++) {
+            double value;
+            if (calculateFunctionCode(funcs[f], k * 0.5, MODE_DEG, &value) != ERR_SUCCESS) {
+                missing += !(funcs[f] == FUNC_TAN && (k % 360 == 180 || k % 360 == -180));
+                continue;
+            }
+            // 参考值：先用整数运算把角度精确地归约到 [-90°, 90°]，再用长双精度计算
+            int r = ((funcs[f] == FUNC_COS ? k + 180 : k) % 720 + 720) % 720;
+            if (funcs[f] == FUNC_TAN) {
+                r = r % 360 > 180 ? r % 360 - 360 : r % 360;
+            } else {
+                r = r > 540 ? r - 720 : r > 180 ? 360 - r : r;
+            }
+            long double x = (long double)r * 3.14159265358979323846264338327950288L / 360.0L;
+            long double expected = funcs[f] == FUNC_TAN ? tanl(x) : sinl(x);
+            if (fabsl(expected) < 1e-15L) {
+                missing += value != 0;
+                continue;
+            }
+            double ulp = nextafter(fabs(value), INFINITY) - fabs(value);
+            double ulps = (double)(fabsl((long double)value - expected) / ulp);
+            if (ulps > worst) worst = ulps;
+        }
+        snprintf(detail, sizeof(detail), "最大误差 %.3f ulp，异常 %d 个", worst, missing);
+        char name[40];
+        snprintf(name, sizeof(name), "%s 每 0.5°", names[f]);
+        recordCheck(name, worst <= 0.51 && missing == 0, detail);
+    }
+    
+    // 常见角度的精确值
+    struct {
+        FuncType func;
+        double degrees;
+        double expected;
+    } exactTests[] = {
+        {FUNC_SIN, 30, 0.5}, {FUNC_SIN, 150, 0.5}, {FUNC_SIN, -30, -0.5}, {FUNC_SIN, 390, 0.5},
+        {FUNC_COS, 60, 0.5}, {FUNC_COS, 120, -0.5}, {FUNC_TAN, 45, 1}, {FUNC_TAN, 135, -1},
+        {FUNC_TAN, -45, -1}, {FUNC_COS, 360.0 * 1099511627776.0 + 60, 0.5},
+    };
+    int passed = 1;
+    for (size_t i = 0; i < sizeof(exactTests) / sizeof(exactTests[0]) && passed; i++) {
+        double value = 0;
+        passed = calculateFunctionCode(exactTests[i].func, exactTests[i].degrees, MODE_DEG, &value) == ERR_SUCCESS &&
+                 value == exactTests[i].expected;
+        snprintf(detail, sizeof(detail), "%s(%g) = %.17g", getFunctionName(exactTests[i].func),
+                 exactTests[i].degrees, value);
+    }
+    recordCheck("常见角度的精确值", passed, detail);
+    
+    // tan 在 90° + 180°·n 处无定义
+    double value;
+    passed = calculateFunctionCode(FUNC_TAN, 270, MODE_DEG, &value) == ERR_UNDEFINED &&
+             calculateFunctionCode(FUNC_TAN, -90, MODE_DEG, &value) == ERR_UNDEFINED &&
+             calculateFunctionCode(FUNC_TAN, 450, MODE_DEG, &value) == ERR_UNDEFINED;
+    recordCheck("tan 的无定义点", passed, "270、-90、450");
+    
+    // 不在表中的角度仍按原来的方式计算（含特殊角容差）
+    double expected = sin(degreeToRadian(30.25));
+    passed = calculateFunctionCode(FUNC_SIN, 30.25, MODE_DEG, &value) == ERR_SUCCESS && value == expected &&
+             calculateFunctionCode(FUNC_SIN, 89.9999, MODE_DEG, &value) == ERR_SUCCESS && value == 1 &&
+             calculateFunctionCode(FUNC_SIN, 30, MODE_RAD, &value) == ERR_SUCCESS && value == sin(30.0);
+    recordCheck("表外角度与弧度模式", passed, "sin(30.25)、sin(89.9999)、弧度 sin(30)");
+}
+
+// 高精度参考值（400 位十进制的 π 精确归约后求和，再舍入到双精度）
+typedef struct {
+    double x;
+    double sinValue;
+    double cosValue;
+    double tanValue;
+} TrigReference;
+
+static const TrigReference radianReferences[] = {
+    {1e22, -0.8522008497671888, 0.523214785395139, -1.6287782256068988},
+    {-1e22, 0.8522008497671888, 0.523214785395139, 1.6287782256068988},
+    {1e300, -0.8178819121159085, -0.5753861119575491, 1.4214488238747245},
+    {1.0715086071862673e+301, -0.15920170308624243, 0.9872460775989135, -0.16125837995065806},   // 2^1000
+    {1.7976931348623157e+308, 0.004961954789184062, -0.9999876894265599, -0.004962015874444895},
+    {5.319372648326541e+255, 1.0, -4.687165924254628e-19, -2.133485385753704e+18},  // 最接近 π/2 倍数的双精度数
+    {8000000000000003.0, 0.8562826244266216, 0.5165075673260338, 1.6578317116622467},
+    {3000000000.5, 0.7891392707502624, -0.6142143040989393, -1.2847946807555066},
+    {123456789.0, 0.9901147518020355, 0.14025968153390964, 7.059154426802703},
+    {5419351.0, -3.8200475070896605e-08, -0.9999999999999992, 3.820047507089663e-08},
+    {1647100.25, 0.7961070296692312, 0.6051558454739026, 1.31554051014048},     // Cody-Waite 范围之外
+    {1647098.5, -0.7373677855283095, 0.6754914868931192, -1.091601892600877},    // Cody-Waite 范围之内
+    {1000000.0, -0.34999350217129294, 0.9367521275331447, -0.373624453987599},
+    {355.0, -3.014435335948845e-05, -0.999999999545659, 3.0144353373184265e-05},
+};
+
+static const TrigReference degreeReferences[] = {
+    {10000000030.25, -0.7632324697825289, 0.6461239796429639, -1.1812477076060186},
+    {1000000000000000.5, -0.9832549075639546, 0.18223552549214744, -5.395517174319138},
+    {395824185999405.125, 0.7086477648609169, 0.7055624319347131, 1.0043728701905845},  // 360·2^40 + 45.125
+    {123456789.75, -0.1693495038490246, -0.9855560590580777, 0.17183142683012517},
+    {-749999999999984.75, -0.9670459389139431, -0.2546019482055276, 3.798266060923048},
+    {1.152921504606847e+18, 0.6946583704589973, -0.7193398003386512, -0.965688774807074},  // 2^60
+};
+
+// 归约后计算的结果与参考值的最大误差（ulp）
+static double worstReferenceError(const TrigReference* refs, size_t count, AngleMode mode, char* detail, size_t size) {
+    double worst = 0;
+    for (size_t i = 0; i < count; i++) {
+        TrigReduction reduction;
+        reduceAngle(refs[i].x, mode, &reduction);
+        const FuncType funcs[3] = {FUNC_SIN, FUNC_COS, FUNC_TAN};
+        const double expected[3] = {refs[i].sinValue, refs[i].cosValue, refs[i].tanValue};
+        for (int f = 0; f < 3; f++) {
+            double value = trigFromReduction(funcs[f], &reduction);
+            double ulp = nextafter(fabs(expected[f]), INFINITY) - fabs(expected[f]);
+            double ulps = fabs(value - expected[f]) / ulp;
+            if (!(ulps <= worst)) {
+                worst = ulps;
+                snprintf(detail, size, "最大误差 %.2f ulp（%s(%.17g) = %.17g）", worst,
+                         getFunctionName(funcs[f]), refs[i].x, value);
+            }
+        }
+    }
+    return worst;
+}
+
+// 参数归约测试：大参数的精度、Cody-Waite 与 Payne-Hanek 的衔接、单精度内核
+static void runTrigReductionSuite(void) {
+    printf("\n=== 三角函数参数归约测试 ===\n");
+    char detail[200] = "";
+    
+    double worst = worstReferenceError(radianReferences, sizeof(radianReferences) / sizeof(radianReferences[0]),
+                                       MODE_RAD, detail, sizeof(detail));
+    recordCheck("弧度大参数与高精度参考值", worst <= 1.0, detail);
+    
+    worst = worstReferenceError(degreeReferences, sizeof(degreeReferences) / sizeof(degreeReferences[0]),
+                                MODE_DEG, detail, sizeof(detail));
+    recordCheck("角度大参数与高精度参考值", worst <= 1.0, detail);
+    
+    // Cody-Waite 范围两侧：归约结果应与 libm 一致（libm 自身误差不超过 1 ulp）
+    worst = 0;
+    for (int i = -2000; i <= 2000; i++) {
+        double x = CODY_WAITE_LIMIT + i * 0.37;
+        TrigReduction reduction;
+        reduceAngle(x, MODE_RAD, &reduction);
+        double value = trigFromReduction(FUNC_SIN, &reduction);
+        double expected = sin(x);
+        double ulps = fabs(value - expected) / (nextafter(fabs(expected), INFINITY) - fabs(expected));
+        if (ulps > worst) worst = ulps;
+    }
+    snprintf(detail, sizeof(detail), "最大误差 %.2f ulp", worst);
+    recordCheck("Cody-Waite 与 Payne-Hanek 的衔接", worst <= 1.0, detail);
+    
+    // 特殊角按归约后的余数判断，正负对称
+    double value;
+    int passed = calculateFunctionCode(FUNC_SIN, -0.0005, MODE_DEG, &value) == ERR_SUCCESS && value == 0 &&
+                 calculateFunctionCode(FUNC_SIN, 0.0005, MODE_DEG, &value) == ERR_SUCCESS && value == 0 &&
+                 calculateFunctionCode(FUNC_COS, 3.6e9 + 90.0005, MODE_DEG, &value) == ERR_SUCCESS && value == 0 &&
+                 calculateFunctionCode(FUNC_SIN, 1e22, MODE_RAD, &value) == ERR_SUCCESS &&
+                 value == radianReferences[0].sinValue;
+    recordCheck("特殊角判断与大参数求值", passed, "sin(±0.0005°)、cos(3.6e9+90.0005°)、弧度 sin(1e22)");
+    
+    // 单精度内核：Cody-Waite 范围内向量化计算，范围外回退到标量路径
+    float input[8] = {0.5f, -3.0f, 1000.0f, 1.0e5f, 1.6e6f, -1.7e6f, 1.0e10f, 1.0e20f};
+    float output[8];
+    unsigned char errors[8] = {0};
+    worst = 0;
+    calculateFunctionBlockF32(FUNC_SIN, input, output, 8, MODE_RAD, errors);
+    for (int i = 0; i < 8; i++) {
+        double diff = fabs(output[i] - sin((double)input[i]));
+        if (diff > worst) worst = diff;
+    }
+    snprintf(detail, sizeof(detail), "最大绝对误差 %.2e", worst);
+    recordCheck("单精度内核的大参数", worst <= 2e-7, detail);
+}
+
+#ifdef __linux__
+// 在另一个线程中查询缓存，返回该线程的查询次数
+static void* functionCacheThreadMain(void* arg) {
+    FunctionCacheStats* stats = (FunctionCacheStats*)arg;
+    double value;
+    for (int i = 0; i < 100; i++) {
+        calculateFunctionCode(FUNC_COS, 60, MODE_RAD, &value);
+    }
+    getFunctionCacheStats(stats);
+    return NULL;
+}
+#endif
+
+// 函数缓存测试：命中结果与直接计算一致、统计、自动关闭与重新开启、线程隔离
+static void runFunctionCacheSuite(void) {
+    printf("\n=== 函数缓存测试 ===\n");
+    char detail[200] = "";
+    struct {
+        FuncType func;
+        double value;
+        AngleMode mode;
+    } cases[] = {
+        {FUNC_SIN, 30.25, MODE_DEG}, {FUNC_SIN, 30.25, MODE_RAD}, {FUNC_COS, 30.25, MODE_DEG},
+        {FUNC_TAN, 90, MODE_DEG}, {FUNC_TAN, 89.9999, MODE_DEG}, {FUNC_LN, -1, MODE_DEG},
+        {FUNC_LN, 0.0, MODE_DEG}, {FUNC_LN, -0.0, MODE_DEG}, {FUNC_LOG, 1000, MODE_DEG},
+        {FUNC_ASIN, 0.5, MODE_DEG}, {FUNC_ASIN, 0.5, MODE_RAD}, {FUNC_ATAN, 1e300, MODE_RAD},
+    };
+    const int caseCount = (int)(sizeof(cases) / sizeof(cases[0]));
+    
+    // 第二轮全部命中，结果、错误代码都与关闭缓存时相同
+    double expected[16];
+    ErrorCode expectedCodes[16];
+    for (int i = 0; i < caseCount; i++) {
+        expected[i] = 0;
+        expectedCodes[i] = calculateFunctionCode(cases[i].func, cases[i].value, cases[i].mode, &expected[i]);
+    }
+    setFunctionCacheEnabled(1);
+    resetFunctionCache();
+    int passed = 1;
+    for (int round = 0; round < 2 && passed; round++) {
+        for (int i = 0; i < caseCount && passed; i++) {
+            double value = 0;
+            ErrorCode code = calculateFunctionCode(cases[i].func, cases[i].value, cases[i].mode, &value);
+            passed = code == expectedCodes[i] && (code != ERR_SUCCESS || value == expected[i]);
+            snprintf(detail, sizeof(detail), "第 %d 轮 %s(%g)：%.17g，错误代码 %d", round + 1,
+                     getFunctionName(cases[i].func), cases[i].value, value, code);
+        }
+    }
+    FunctionCacheStats stats;
+    getFunctionCacheStats(&stats);
+    recordCheck("命中结果与直接计算一致", passed && stats.hits == (uint64_t)caseCount, detail);
+    
+    // 不缓存的函数不计入查询；重复参数的命中率
+    resetFunctionCache();
+    double value;
+    for (int i = 0; i < 1000; i++) {
+        calculateFunctionCode(FUNC_SQRT, i % 4, MODE_DEG, &value);
+        calculateFunctionCode(FUNC_SIN, (i % 4) * 7.25, MODE_DEG, &value);
+    }
+    getFunctionCacheStats(&stats);
+    snprintf(detail, sizeof(detail), "查询 %llu 次，命中 %llu 次", (unsigned long long)stats.lookups,
+             (unsigned long long)stats.hits);
+    recordCheck("命中统计", stats.lookups == 1000 && stats.hits == 996 && stats.active, detail);
+    
+    // 参数各不相同时在第一个窗口结束后自动关闭，跳过 FUNCTION_CACHE_RETRY 次后重新开启
+    resetFunctionCache();
+    for (int i = 0; i < FUNCTION_CACHE_WINDOW; i++) {
+        calculateFunctionCode(FUNC_SIN, i * 0.01 + 0.003, MODE_RAD, &value);
+    }
+    getFunctionCacheStats(&stats);
+    passed = !stats.active && stats.disables == 1;
+    for (int i = 0; i < FUNCTION_CACHE_RETRY; i++) {
+        calculateFunctionCode(FUNC_SIN, 1.5, MODE_RAD, &value);
+    }
+    getFunctionCacheStats(&stats);
+    passed = passed && stats.active && stats.bypassed == FUNCTION_CACHE_RETRY &&
+             stats.lookups == FUNCTION_CACHE_WINDOW && value == sin(1.5);
+    snprintf(detail, sizeof(detail), "关闭 %u 次，直接计算 %llu 次", stats.disables,
+             (unsigned long long)stats.bypassed);
+    recordCheck("命中率低时自动关闭", passed, detail);
+    
+#ifdef __linux__
+    // 每个线程有自己的缓存与统计
+    resetFunctionCache();
+    FunctionCacheStats threadStats;
+    memset(&threadStats, 0, sizeof(threadStats));
+    pthread_t thread;
+    pthread_create(&thread, NULL, functionCacheThreadMain, &threadStats);
+    pthread_join(thread, NULL);
+    getFunctionCacheStats(&stats);
+    passed = threadStats.lookups == 100 && threadStats.hits == 99 && stats.lookups == 0;
+    recordCheck("线程隔离", passed, "另一线程查询 100 次、命中 99 次，本线程不受影响");
+#endif
+    
+    // 编译求值与批量求值经过同一缓存
+    resetFunctionCache();
+    CompiledExpr prog;
+    passed = compileExpression("sin(x)+cos(x)", &prog).code == 0;
+    if (passed) {
+        double xs[64], results[64];
+        for (int i = 0; i < 64; i++) {
+            xs[i] = (i % 2) * 33.5 + 0.125;
+        }
+        double single = 0;
+        double vars[1] = {xs[1]};
+        passed = evaluateCompiled(&prog, vars, MODE_DEG, &single).code == 0;
+        const double* columns[1] = {xs};
+        CalcError err = evaluateCompiledBatch(&prog, columns, 64, MODE_DEG, EVAL_FP64, results, NULL);
+        getFunctionCacheStats(&stats);
+        passed = passed && err.code == 0 && results[1] == single && stats.hits >= 2 * 64 - 2;
+        snprintf(detail, sizeof(detail), "查询 %llu 次，命中 %llu 次", (unsigned long long)stats.lookups,
+                 (unsigned long long)stats.hits);
+        freeCompiledExpression(&prog);
+    }
+    recordCheck("编译求值与批量求值", passed, detail);
+    
+    setFunctionCacheEnabled(0);
+    resetFunctionCache();
+}
+
+// 向量表达式求值，结果写入 detail；返回错误代码
+static int evaluateVectorTest(const char* expr, VectorArena* arena, VectorValue* result, char* detail,
+                              size_t detailSize) {
+    CalcError err = evaluateVectorExpression(expr, MODE_DEG, arena, result);
+    if (err.code != 0) {
+        snprintf(detail, detailSize, "%s：%s（位置 %d）", expr, err.message, err.position);
+    } else {
+        char text[200];
+        snprintf(detail, detailSize, "%s = %s", expr, formatVector(result, text, sizeof(text)));
+    }
+    return err.code;
+}
+
+static int vectorEquals(const VectorValue* value, const double* expected, size_t count) {
+    if (!value->isVector || value->count != count) return 0;
+    for (size_t i = 0; i < count; i++) {
+        if (value->data[i] != expected[i]) return 0;
+    }
+    return 1;
+}
+
+static void runVectorSuite(void) {
+    printf("\n=== 向量求值测试 ===\n");
+    char detail[300] = "";
+    VectorArena arena;
+    initVectorArena(&arena);
+    VectorValue result;
+    
+    // 字面量、标量广播、取负与拼接
+    struct {
+        const char* expr;
+        double expected[4];
+        size_t count;
+    } literalCases[] = {
+        {"[1, 2, 3] * 2 + 1", {3, 5, 7}, 3},
+        {"2^[1,2,3]", {2, 4, 8}, 3},
+        {"-[1, 2.5] - 1", {-2, -3.5}, 2},
+        {"[1,2,3] / [4,5,6] * [4,5,6]", {1, 2, 3}, 3},
+        {"[[1,2], 3, [4]]", {1, 2, 3, 4}, 4},
+        {"sqrt([4, 9]) + [0.1*3, 0.7*10]", {2.3, 10}, 2},
+        {"sin([0, 30, 90, 180])", {0, 0.5, 1, 0}, 4},
+    };
+    int passed = 1;
+    for (size_t i = 0; passed && i < sizeof(literalCases) / sizeof(literalCases[0]); i++) {
+        passed = evaluateVectorTest(literalCases[i].expr, &arena, &result, detail, sizeof(detail)) == 0 &&
+                 vectorEquals(&result, literalCases[i].expected, literalCases[i].count);
+    }
+    recordCheck("字面量与标量广播", passed, detail);
+    
+    // 聚合函数把向量归约为标量
+    passed = evaluateVectorTest("sum([1,2,3]^2) + norm([3,4])", &arena, &result, detail, sizeof(detail)) == 0 &&
+             !result.isVector && result.scalar == 19;
+    recordCheck("聚合函数", passed, detail);
+    
+    // 逐元素结果与批量求值逐位一致（包括接近整数修正与超过 2^51 的大数）
+    enum { VECTOR_TEST_COUNT = 1001 };
+    static double aData[VECTOR_TEST_COUNT + 1], bData[VECTOR_TEST_COUNT];
+    double* aValues = aData + 1;   // 故意不对齐
+    for (int i = 0; i < VECTOR_TEST_COUNT; i++) {
+        switch (i % 5) {
+            case 0: aValues[i] = i * 0.1; break;
+            case 1: aValues[i] = i - 500; break;
+            case 2: aValues[i] = (i + 1) * 1e13 + 0.5; break;
+            case 3: aValues[i] = 1.0 / (i + 3); break;
+            default: aValues[i] = -0.7 * i; break;
+        }
+        bData[i] = (i % 3 == 0) ? 10 : (i % 3 == 1) ? 0.3 - i * 1e-3 : 3 + i;
+    }
+    bindArrayVariable("a", aValues, VECTOR_TEST_COUNT);
+    bindArrayVariable("b", bData, VECTOR_TEST_COUNT);
+    const char* elementwise[] = {
+        "a+b", "a-b", "a*b", "a/b", "(a*b - a/b + 3) / (b + 1)", "a^2 - b", "-a*b + 1e16",
+        "sin(a) + ln(abs(b) + 1)", "a*3 - b/7",
+    };
+    static double expected[VECTOR_TEST_COUNT];
+    passed = 1;
+    for (size_t e = 0; passed && e < sizeof(elementwise) / sizeof(elementwise[0]); e++) {
+        CompiledExpr prog;
+        passed = compileExpression(elementwise[e], &prog).code == 0;
+        const double* columns[MAX_COMPILED_VARIABLES];
+        for (int v = 0; passed && v < prog.varCount; v++) {
+            columns[v] = prog.varNames[v][0] == 'a' ? aValues : bData;
+        }
+        passed = passed &&
+                 evaluateCompiledBatch(&prog, columns, VECTOR_TEST_COUNT, MODE_DEG, EVAL_FP64, expected, NULL).code == 0 &&
+                 evaluateVectorTest(elementwise[e], &arena, &result, detail, sizeof(detail)) == 0 &&
+                 result.isVector && result.count == VECTOR_TEST_COUNT;
+        for (int i = 0; passed && i < VECTOR_TEST_COUNT; i++) {
+            passed = memcmp(&expected[i], &result.data[i], sizeof(double)) == 0;
+            snprintf(detail, sizeof(detail), "%s 第 %d 个元素：%.17g，批量求值 %.17g", elementwise[e], i,
+                     result.data[i], expected[i]);
+        }
+        freeCompiledExpression(&prog);
+        resetVectorArena(&arena);
+    }
+    recordCheck("逐元素结果与批量求值一致", passed, detail);
+    
+    // 出错元素：错误代码、消息与标量求值相同，位置为出错的运算
+    bData[700] = 0;
+    CalcError err = evaluateVectorExpression("a / b", MODE_DEG, &arena, &result);
+    passed = err.code == ERR_DIV_BY_ZERO && err.position == 2 && strcmp(err.message, "除数不能为0") == 0;
+    err = evaluateVectorExpression("sqrt([4, -1])", MODE_DEG, &arena, &result);
+    passed = passed && err.code != 0 && strcmp(err.message, "负数不能开平方根") == 0;
+    snprintf(detail, sizeof(detail), "%s（位置 %d）", err.message ? err.message : "", err.position);
+    recordCheck("出错元素", passed, detail);
+    
+    err = evaluateVectorExpression("[1,2] + [1,2,3]", MODE_DEG, &arena, &result);
+    passed = err.code == ERR_INVALID_ARGUMENT && err.position == 6;
+    err = evaluateVectorExpression("a + c", MODE_DEG, &arena, &result);
+    passed = passed && err.code == ERR_INVALID_ARGUMENT && err.position == 4;
+    err = evaluateVectorExpression("[1,,2]", MODE_DEG, &arena, &result);
+    passed = passed && err.code != 0;
+    recordCheck("长度不一致与未绑定变量", passed, err.message ? err.message : "");
+    
+    // 结果按 VECTOR_ALIGNMENT 对齐；超过一个块的向量单独分配
+    resetVectorArena(&arena);
+    static double large[100000];
+    for (int i = 0; i < 100000; i++) large[i] = i;
+    bindArrayVariable("big", large, 100000);
+    passed = evaluateVectorTest("big * 2 + 1", &arena, &result, detail, sizeof(detail)) == 0 &&
+             result.count == 100000 && result.data[99999] == 199999 &&
+             (uintptr_t)result.data % VECTOR_ALIGNMENT == 0;
+    VectorValue small;
+    passed = passed && evaluateVectorTest("[1,2,3] + 1", &arena, &small, detail, sizeof(detail)) == 0 &&
+             (uintptr_t)small.data % VECTOR_ALIGNMENT == 0 && result.data[0] == 1;
+    recordCheck("arena 对齐与分块", passed, detail);
+    
+    // 标量路径不接受向量语法，标量求值拒绝向量模式编译的表达式
+    CompiledExpr prog;
+    passed = compileExpression("[1,2]", &prog).code != 0;
+    passed = passed && compileVectorExpression("x + 1", &prog).code == 0;
+    double value;
+    double vars[1] = {1};
+    passed = passed && evaluateCompiled(&prog, vars, MODE_DEG, &value).code == ERR_INVALID_ARGUMENT;
+    freeCompiledExpression(&prog);
+    recordCheck("标量求值不接受向量表达式", passed, "");
+    
+    clearArrayVariables();
+    freeVectorArena(&arena);
+}
+
+static void runSeriesSuite(void) {
+    printf("\n=== 求和与连乘测试 ===\n");
+    char detail[200] = "";
+    double value;
+    CalcError err;
+    
+    struct {
+        const char* expr;
+        double expected;
+    } cases[] = {
+        {"sum(i, 1, 100, i)", 5050},
+        {"prod(k, 1, 10, k)", 3628800},
+        {"2sum(i,1,3,i^2) + 1", 29},
+        {"-prod(i, 1, 5, 2)", -32},
+        {"sum(i, 5, 1, i) + prod(i, 5, 1, i)", 1},
+        {"sum(i, -3, 3, i^3)", 0},
+        {"sum(n, 1, 2+2, 3)", 12},
+        {"sum(i, 0, 3, sin(90*i))", 0},
+    };
+    int passed = 1;
+    for (size_t i = 0; passed && i < sizeof(cases) / sizeof(cases[0]); i++) {
+        err = evaluateExpression(cases[i].expr, MODE_DEG, &value);
+        passed = err.code == 0 && value == cases[i].expected;
+        snprintf(detail, sizeof(detail), "%s = %.17g", cases[i].expr, value);
+    }
+    recordCheck("求和与连乘", passed, detail);
+    
+    // 整块求值与逐项调用 evaluateExpression 一致（跨多个块）
+    long double reference = 0;
+    for (int i = 1; i <= 3 * SERIES_BLOCK_SIZE + 7; i++) {
+        char term[80];
+        snprintf(term, sizeof(term), "sin(%d)/%d + 1/(%d+0.5)", i, i, i);
+        evaluateExpression(term, MODE_RAD, &value);
+        reference += value;
+    }
+    char expr[80];
+    snprintf(expr, sizeof(expr), "sum(i, 1, %d, sin(i)/i + 1/(i+0.5))", 3 * SERIES_BLOCK_SIZE + 7);
+    err = evaluateExpression(expr, MODE_RAD, &value);
+    passed = err.code == 0 && fabsl(value - reference) <= 1e-14L * fabsl(reference);
+    snprintf(detail, sizeof(detail), "%.17g，逐项 %.17Lg", value, reference);
+    recordCheck("与逐项求值一致", passed, detail);
+    
+    // 含聚合函数的项逐个下标求值
+    double weights[3] = {1, 2, 3};
+    bindArrayVariable("w", weights, 3);
+    passed = evaluateExpression("sum(i, 1, 3, sum(w)*i)", MODE_DEG, &value).code == 0 && value == 36;
+    err = evaluateExpression("sum(i, 1, 3, w*i)", MODE_DEG, &value);
+    passed = passed && err.code == ERR_INVALID_ARGUMENT;
+    clearArrayVariables();
+    recordCheck("数组变量与聚合函数", passed, err.message ? err.message : "");
+    
+    // 补偿求和：直接累加 10^6 个 0.1 误差约 1e-6（超过并行阈值）
+    err = evaluateExpression("sum(i, 1, 1000000, 0.1)", MODE_DEG, &value);
+    passed = err.code == 0 && value == 100000;
+    snprintf(detail, sizeof(detail), "%.17g", value);
+    recordCheck("补偿求和", passed, detail);
+    
+    // 连乘的指数单独累加：前 50 项 1e9（直接连乘会溢出），后 50 项 1e-9
+    err = evaluateExpression("prod(i, 1, 100, 10^(9*(50.5-i)/abs(50.5-i)))", MODE_DEG, &value);
+    passed = err.code == 0 && value == 1;
+    snprintf(detail, sizeof(detail), "%.17g", value);
+    passed = passed && evaluateExpression("prod(i, 1, 400, i)", MODE_DEG, &value).code == ERR_OVERFLOW;
+    recordCheck("连乘不提前溢出", passed, detail);
+    
+    // 错误：第一个出错项的位置、上下限、项数与变量名
+    err = evaluateExpression("sum(i, 1, 10, 1/(i-5))", MODE_DEG, &value);
+    passed = err.code == ERR_DIV_BY_ZERO && err.position == 15;
+    passed = passed && evaluateExpression("sum(i, 1.5, 3, i)", MODE_DEG, &value).code == ERR_INVALID_ARGUMENT;
+    passed = passed && evaluateExpression("sum(i, 0, 1e9, i)", MODE_DEG, &value).code == ERR_INVALID_ARGUMENT;
+    passed = passed && evaluateExpression("sum(pi, 1, 3, pi)", MODE_DEG, &value).code == ERR_INVALID_ARGUMENT;
+    passed = passed && evaluateExpression("sum(i, 1, 3, )", MODE_DEG, &value).code == ERR_SYNTAX;
+    snprintf(detail, sizeof(detail), "%s（位置 %d）", err.message ? err.message : "", err.position);
+    recordCheck("错误处理", passed, detail);
+    
+    // 嵌套的求和与连乘：报告内层调用的位置
+    err = evaluateExpression("sum(i,1,3,sum(j,1,i,j))", MODE_DEG, &value);
+    passed = err.code == ERR_INVALID_ARGUMENT && err.position == 10 && strcmp(err.message, "求和与连乘不能嵌套") == 0;
+    CalcError inner = evaluateExpression("2 + prod(i, 1, 3, 1 + sum(k, 1, i, k))", MODE_DEG, &value);
+    passed = passed && inner.code == ERR_INVALID_ARGUMENT && inner.position == 22;
+    CalcError unbound = evaluateExpression("sum(i, 1, 3, summary + i)", MODE_DEG, &value);
+    passed = passed && unbound.code == ERR_INVALID_ARGUMENT && strcmp(unbound.message, "未绑定的数组变量") == 0;
+    snprintf(detail, sizeof(detail), "%s（位置 %d、%d）", err.message ? err.message : "", err.position, inner.position);
+    recordCheck("不支持嵌套", passed, detail);
+}
+
+static void runSolverSuite(void) {
+    printf("\n=== 求根与积分测试 ===\n");
+    char detail[200] = "";
+    double value;
+    CalcError err;
+    
+    // Brent 求根（端点恰好是根时直接返回）
+    struct {
+        const char* expr;
+        double expected;
+    } roots[] = {
+        {"solve(x^2 - 2, x, 0, 2)", 1.4142135623730951},
+        {"solve(x^3 - x - 1, x, 1, 2)", 1.324717957244746},
+        {"solve(cos(x) - x, x, 0, 1)", 0.7390851332151607},
+        {"-solve(x - 3, x, 0, 10)", -3},
+        {"solve(x - 1, x, 1, 2)", 1},
+    };
+    int passed = 1;
+    for (size_t i = 0; passed && i < sizeof(roots) / sizeof(roots[0]); i++) {
+        err = evaluateExpression(roots[i].expr, MODE_RAD, &value);
+        passed = err.code == 0 && fabs(value - roots[i].expected) < 1e-12;
+        snprintf(detail, sizeof(detail), "%s = %.17g", roots[i].expr, value);
+    }
+    recordCheck("求根", passed, detail);
+    
+    // 自适应 Gauss-Kronrod 积分
+    struct {
+        const char* expr;
+        double expected;
+    } integrals[] = {
+        {"integrate(x^2, x, 0, 3)", 9},
+        {"integrate(sin(x), x, 0, pi)", 2},
+        {"integrate(x, x, 3, 0)", -4.5},
+        {"integrate(sqrt(x), x, 0, 1)", 2.0 / 3},
+        {"2integrate(1/(1+x^2), x, 0, 1)", PI / 2},
+    };
+    passed = 1;
+    for (size_t i = 0; passed && i < sizeof(integrals) / sizeof(integrals[0]); i++) {
+        err = evaluateExpression(integrals[i].expr, MODE_RAD, &value);
+        passed = err.code == 0 && fabs(value - integrals[i].expected) < 1e-10;
+        snprintf(detail, sizeof(detail), "%s = %.17g", integrals[i].expr, value);
+    }
+    recordCheck("积分", passed, detail);
+    
+    // 含聚合函数的函数逐点求值，结果与整体求值一致
+    double weights[3] = {1, 2, 3};
+    bindArrayVariable("w", weights, 3);
+    double pointwise, vectorized;
+    passed = evaluateExpression("integrate(sum(w)*sin(x), x, 0, 2)", MODE_RAD, &pointwise).code == 0 &&
+             evaluateExpression("integrate(6*sin(x), x, 0, 2)", MODE_RAD, &vectorized).code == 0 &&
+             pointwise == vectorized;
+    clearArrayVariables();
+    snprintf(detail, sizeof(detail), "%.17g / %.17g", pointwise, vectorized);
+    recordCheck("逐点与整体求值一致", passed, detail);
+    
+    // 容差与迭代预算
+    VectorFunction fn;
+    const char* body = "x^3 - x - 1";
+    passed = compileVectorFunction(body, strlen(body), "x", 1, &fn).code == 0;
+    SolverOptions options = {1e-12, 4};
+    passed = passed && solveFunction(&fn, 1, 2, MODE_RAD, &options, &value).code == ERR_UNDEFINED;
+    options.tolerance = 1e-3;
+    options.maxIterations = 100;
+    passed = passed && solveFunction(&fn, 1, 2, MODE_RAD, &options, &value).code == 0 && fabs(value - 1.3247) < 1e-3;
+    options.maxIterations = 1;
+    passed = passed && integrateFunction(&fn, 0, 2, MODE_RAD, &options, &value).code == 0;
+    freeVectorFunction(&fn);
+    body = "sin(1/x)";
+    passed = passed && compileVectorFunction(body, strlen(body), "x", 1, &fn).code == 0;
+    options = defaultSolverOptions(SOLVER_INTEGRATE);
+    options.maxIterations = 9;
+    passed = passed && integrateFunction(&fn, 0.01, 1, MODE_RAD, &options, &value).code == ERR_UNDEFINED;
+    freeVectorFunction(&fn);
+    recordCheck("容差与迭代预算", passed, "");
+    
+    // 错误：区间两端同号、变量名无效、节点上的运算错误
+    err = evaluateExpression("integrate(1/x, x, -1, 1)", MODE_RAD, &value);
+    passed = err.code == ERR_DIV_BY_ZERO && err.position == 11;
+    snprintf(detail, sizeof(detail), "%s（位置 %d）", err.message ? err.message : "", err.position);
+    passed = passed && evaluateExpression("solve(x^2 + 1, x, 0, 2)", MODE_RAD, &value).code == ERR_INVALID_ARGUMENT;
+    passed = passed && evaluateExpression("solve(x, pi, 0, 1)", MODE_RAD, &value).code == ERR_INVALID_ARGUMENT;
+    passed = passed && evaluateExpression("integrate(x, x, 0, )", MODE_RAD, &value).code == ERR_SYNTAX;
+    recordCheck("错误处理", passed, detail);
+}
+
+// 去掉多项式子树后的原指令（用于比较）
+static CompiledExpr withoutPolynomials(const CompiledExpr* prog) {
+    CompiledExpr view = *prog;
+    view.storage = NULL;
+    view.polynomials = NULL;
+    view.polynomialCount = 0;
+    return view;
+}
+
+static void runPolynomialSuite(void) {
+    printf("\n=== 多项式改写测试 ===\n");
+    char detail[200] = "";
+    CompiledExpr prog;
+    double value;
+    
+    // 识别：整个表达式是 4 次多项式；多项式的乘方不展开；两个子树各自记录
+    int passed = compileExpression("3*x^4 + 2*x^3 - x + 7", &prog).code == 0 &&
+                 prog.polynomialCount == 1 && prog.polynomials[0].start == 0 &&
+                 prog.polynomials[0].end == prog.length && prog.polynomials[0].degree == 4 &&
+                 prog.polynomials[0].numerator[0] == 7 && prog.polynomials[0].numerator[1] == -1 &&
+                 prog.polynomials[0].numerator[4] == 3;
+    freeCompiledExpression(&prog);
+    passed = passed && compileExpression("(x+1)^2 + 2*x", &prog).code == 0 && prog.polynomialCount == 0;
+    freeCompiledExpression(&prog);
+    passed = passed && compileExpression("sin(x^3 - 2*x) + 3*y^2 + 1", &prog).code == 0 &&
+             prog.polynomialCount == 2 && prog.polynomials[0].slot == 0 && prog.polynomials[1].slot == 1;
+    snprintf(detail, sizeof(detail), "%d 个子树", prog.polynomialCount);
+    freeCompiledExpression(&prog);
+    recordCheck("识别多项式子树", passed, detail);
+    
+    // 默认只用精确形式：随机的整数、小数与接近根的自变量上，结果与原指令逐位相同
+    const char* exprs[] = {"3*x^4 + 2*x^3 - x + 7", "-x^2 + x/2", "(x^2+1)/(x-2)", "x*x*x - 0.1*x",
+                           "1/(x^2 - 4) + cos(x)", "2^x + x^5/120 - x^3/6", "x^2 - 2*x + 1",
+                           "(3*x^2 + x^3) - x^3", "x^4*6/2 - x"};
+    passed = 1;
+    int exactHits = 0;
+    unsigned seed = 12345;
+    for (size_t e = 0; passed && e < sizeof(exprs) / sizeof(exprs[0]); e++) {
+        passed = compileExpression(exprs[e], &prog).code == 0 && prog.polynomialCount > 0;
+        CompiledExpr original = withoutPolynomials(&prog);
+        for (int k = 0; passed && k < 20000; k++) {
+            seed = seed * 1103515245u + 12345u;
+            double u = (seed >> 8) / 16777216.0;
+            double x = k % 3 == 0 ? floor((u - 0.5) * 2e6) : k % 3 == 1 ? (u - 0.5) * 10 : 1 + (u - 0.5) * 1e-4;
+            double expected;
+            ErrorCode code = evaluateCompiledFast(&prog, &x, MODE_RAD, &value);
+            ErrorCode reference = evaluateCompiledFast(&original, &x, MODE_RAD, &expected);
+            CalcNumber number;
+            exactHits += evaluatePolynomialNumber(&prog.polynomials[0], x, &number);
+            passed = code == reference && (code != 0 || memcmp(&value, &expected, sizeof(double)) == 0);
+            snprintf(detail, sizeof(detail), "%s, x = %.17g: %.17g / %.17g", exprs[e], x, value, expected);
+        }
+        freeCompiledExpression(&prog);
+    }
+    if (passed) snprintf(detail, sizeof(detail), "精确形式求值 %d 次", exactHits);
+    recordCheck("默认与原指令逐位一致", passed && exactHits > 0, detail);
+    
+    // POLYNOMIAL_FAST：Estrin 形式与原指令的结果一致（相对误差在 1e-14 以内），错误与位置相同
+    const double points[] = {-3.5, -2, -0.7, 0, 0.3, 1, 2, 2.5, 1e3};
+    for (size_t e = 0; passed && e < sizeof(exprs) / sizeof(exprs[0]); e++) {
+        passed = compileExpression(exprs[e], &prog).code == 0 && prog.polynomialCount > 0;
+        CompiledExpr original = withoutPolynomials(&prog);
+        setPolynomialMode(&prog, POLYNOMIAL_FAST);
+        for (size_t k = 0; passed && k < sizeof(points) / sizeof(points[0]); k++) {
+            double expected;
+            CalcError err = evaluateCompiled(&prog, &points[k], MODE_RAD, &value);
+            CalcError reference = evaluateCompiled(&original, &points[k], MODE_RAD, &expected);
+            passed = err.code == reference.code && err.position == reference.position &&
+                     (err.code != 0 || fabs(value - expected) <= 1e-14 * fmax(1, fabs(expected)));
+            snprintf(detail, sizeof(detail), "%s, x = %g: %.17g / %.17g", exprs[e], points[k], value, expected);
+        }
+        freeCompiledExpression(&prog);
+    }
+    recordCheck("Estrin 形式与原指令相差不超过 1e-14", passed, detail);
+    
+    // 整数系数与整数自变量在 int64_t 上精确计算（结果超过 2^53 时由原指令计算，同样精确）
+    CalcNumber number;
+    double x = 6000;
+    passed = compileExpression("x^5 - 3*x^2 + 1", &prog).code == 0 &&
+             evaluateCompiledNumber(&prog, &x, MODE_RAD, &number).code == 0 && number.isInteger &&
+             number.intValue == 7776000000000000000LL - 108000000LL + 1;
+    snprintf(detail, sizeof(detail), "%lld", (long long)number.intValue);
+    x = 7000;   // 7000^5 超出 int64_t，回到原指令按双精度计算
+    passed = passed && evaluateCompiledNumber(&prog, &x, MODE_RAD, &number).code == 0 && !number.isInteger &&
+             fabs(number.value - (1.6807e19 - 147000000.0)) < 1e4;
+    freeCompiledExpression(&prog);
+    recordCheck("整数系数精确计算", passed, detail);
+    
+    // Estrin 形式：批量求值与逐行求值逐位一致（单精度在误差范围内），极点所在的行报告除零
+    enum { ROWS = 1000 };
+    static double column[ROWS], batch[ROWS], single[ROWS];
+    ErrorCode errors[ROWS];
+    for (int r = 0; r < ROWS; r++) column[r] = -5 + r * 0.01;
+    const double* columns[1] = {column};
+    passed = compileExpression("(x^3 - 2*x + 1)/(x^2 - 4)", &prog).code == 0 && prog.polynomialCount == 1;
+    setPolynomialMode(&prog, POLYNOMIAL_FAST);
+    passed = passed &&
+             evaluateCompiledBatch(&prog, columns, ROWS, MODE_RAD, EVAL_FP64, batch, errors).code == ERR_DIV_BY_ZERO;
+    int poles = 0;
+    for (int r = 0; passed && r < ROWS; r++) {
+        double expected;
+        ErrorCode code = evaluateCompiledFast(&prog, &column[r], MODE_RAD, &expected);
+        poles += code != 0;
+        passed = errors[r] == code && (code != 0 || memcmp(&batch[r], &expected, sizeof(double)) == 0);
+    }
+    passed = passed && poles == 2 &&
+             evaluateCompiledBatch(&prog, columns, ROWS, MODE_RAD, EVAL_FP32, single, errors).code == ERR_DIV_BY_ZERO;
+    for (int r = 0; passed && r < ROWS; r++) {
+        passed = errors[r] != 0 || fabs(single[r] - batch[r]) <= 1e-4 * fmax(1, fabs(batch[r]));
+    }
+    freeCompiledExpression(&prog);
+    snprintf(detail, sizeof(detail), "%d 个极点", poles);
+    recordCheck("Estrin 形式批量求值", passed, detail);
+    
+    // 向量求值：sum/integrate 的项整块走 Estrin 形式
+    double sum, integral;
+    passed = evaluateExpression("sum(i, 1, 1000, 2*i^3 - i^2 + 1)", MODE_RAD, &sum).code == 0 &&
+             sum == 2 * 250500250000.0 - 333833500.0 + 1000 &&
+             evaluateExpression("integrate(4*x^3 - 3*x^2 + 1, x, 0, 2)", MODE_RAD, &integral).code == 0 &&
+             fabs(integral - 10) < 1e-12;
+    snprintf(detail, sizeof(detail), "%.17g / %.17g", sum, integral);
+    recordCheck("向量求值", passed, detail);
+}
+
+static void runPolicySuite(void) {
+    printf("\n=== 数值策略测试 ===\n");
+    char detail[200] = "";
+    double value, expected;
+    
+    // 默认策略的运算与函数就是现有实现（结果与错误代码逐位一致）
+    const double operands[] = {0, -0.0, 1, -2, 0.1, 0.2, 1e-16, 3.5, -8, 1e200, 1e308, 9007199254740993.0};
+    const char ops[] = "+-*/^";
+    int passed = 1;
+    for (size_t i = 0; passed && i < sizeof(operands) / sizeof(operands[0]); i++) {
+        for (size_t j = 0; passed && j < sizeof(operands) / sizeof(operands[0]); j++) {
+            for (int k = 0; passed && ops[k]; k++) {
+                value = expected = 0;
+                ErrorCode code = performPolicyOperation(POLICY_CHECKED, ops[k], operands[i], operands[j], &value);
+                ErrorCode reference = performOperationCode(ops[k], operands[i], operands[j], &expected);
+                passed = code == reference && (code != 0 || memcmp(&value, &expected, sizeof(double)) == 0);
+                snprintf(detail, sizeof(detail), "%g %c %g", operands[i], ops[k], operands[j]);
+            }
+        }
+    }
+    for (int f = FUNC_SIN; passed && f <= FUNC_DEG; f++) {
+        for (size_t i = 0; passed && i < sizeof(operands) / sizeof(operands[0]); i++) {
+            value = expected = 0;
+            ErrorCode code = calculatePolicyFunction(POLICY_CHECKED, (FuncType)f, operands[i] * 90, MODE_DEG, &value);
+            ErrorCode reference = calculateFunctionCode((FuncType)f, operands[i] * 90, MODE_DEG, &expected);
+            passed = code == reference && (code != 0 || memcmp(&value, &expected, sizeof(double)) == 0);
+            snprintf(detail, sizeof(detail), "%s(%g)", getFunctionName((FuncType)f), operands[i] * 90);
+        }
+    }
+    recordCheck("默认策略与现有实现一致", passed, detail);
+    
+    // 默认策略的单行求值与 evaluateCompiledFast 逐位一致，包括超过 2^53 的整数中间结果
+    const char* bigExprs[] = {"(x*x+1)-x*x", "x*x*8 - (x*x*8 - 3)", "(x^2 + x) / x", "x*x*x / (x*x)"};
+    const double bigValues[] = {1073741824.0, 3037000499.0, 123456789.0, -1073741825.0};
+    passed = 1;
+    for (size_t e = 0; passed && e < sizeof(bigExprs) / sizeof(bigExprs[0]); e++) {
+        CompiledExpr big;
+        passed = compileExpression(bigExprs[e], &big).code == 0;
+        for (size_t k = 0; passed && k < sizeof(bigValues) / sizeof(bigValues[0]); k++) {
+            value = expected = 0;
+            ErrorCode code = evaluateCompiledPolicy(&big, &bigValues[k], MODE_DEG, POLICY_CHECKED, &value);
+            ErrorCode reference = evaluateCompiledFast(&big, &bigValues[k], MODE_DEG, &expected);
+            passed = code == reference && memcmp(&value, &expected, sizeof(double)) == 0;
+            snprintf(detail, sizeof(detail), "%s，x = %.17g：%.17g（应为 %.17g）", bigExprs[e], bigValues[k], value,
+                     expected);
+        }
+        freeCompiledExpression(&big);
+    }
+    CompiledExpr big;
+    if (compileExpression(bigExprs[0], &big).code == 0) {
+        passed = passed && evaluateCompiledPolicy(&big, &bigValues[0], MODE_DEG, POLICY_CHECKED, &value) == 0 &&
+                 value == 1;
+        freeCompiledExpression(&big);
+    }
+    recordCheck("默认策略单行求值跟踪大整数", passed, detail);
+    
+    // 默认策略的批量求值与 evaluateCompiledBatch（EVAL_FP64）逐位一致，出错的行相同
+    enum { ROWS = 600 };
+    static double xs[ROWS], policyResults[ROWS], batchResults[ROWS];
+    ErrorCode policyErrors[ROWS], batchErrors[ROWS];
+    for (int r = 0; r < ROWS; r++) xs[r] = (r - 300) * 0.75;
+    const double* columns[1] = {xs};
+    CompiledExpr prog;
+    passed = compileExpression("sin(x)/x + sqrt(x) - 2^x + ln(x + 100)", &prog).code == 0;
+    CalcError policyErr = evaluateCompiledBatchPolicy(&prog, columns, ROWS, MODE_DEG, POLICY_CHECKED,
+                                                      policyResults, policyErrors);
+    CalcError batchErr = evaluateCompiledBatch(&prog, columns, ROWS, MODE_DEG, EVAL_FP64, batchResults, batchErrors);
+    passed = passed && policyErr.code == batchErr.code && policyErr.position == batchErr.position;
+    for (int r = 0; passed && r < ROWS; r++) {
+        passed = policyErrors[r] == batchErrors[r] &&
+                 memcmp(&policyResults[r], &batchResults[r], sizeof(double)) == 0;
+    }
+    freeCompiledExpression(&prog);
+    snprintf(detail, sizeof(detail), "%s（位置 %d）", policyErr.message ? policyErr.message : "", policyErr.position);
+    recordCheck("默认策略批量求值", passed, detail);
+    
+    // IEEE 语义：不修正、不识别特殊角，NaN 与 Inf 照常传播
+    passed = performPolicyOperation(POLICY_IEEE, '+', 0.1, 0.2, &value) == 0 && value == 0.1 + 0.2 &&
+             performPolicyOperation(POLICY_IEEE, '/', 1, 0, &value) == 0 && isinf(value) &&
+             performPolicyOperation(POLICY_IEEE, '^', -8, 1.0 / 3, &value) == 0 && isnan(value) &&
+             performPolicyOperation(POLICY_IEEE, '*', 1e200, 1e200, &value) == 0 && isinf(value) &&
+             calculatePolicyFunction(POLICY_IEEE, FUNC_SIN, 180, MODE_DEG, &value) == 0 &&
+             value == sin(PI) && value != 0 &&
+             calculatePolicyFunction(POLICY_IEEE, FUNC_SQRT, -1, MODE_RAD, &value) == 0 && isnan(value) &&
+             calculatePolicyFunction(POLICY_IEEE, FUNC_LN, 0, MODE_RAD, &value) == 0 && isinf(value) && value < 0;
+    snprintf(detail, sizeof(detail), "sin(180°) = %.17g", sin(PI));
+    recordCheck("IEEE 语义", passed, detail);
+    
+    // IEEE 批量求值与单行求值逐位一致，不报告错误
+    passed = compileExpression("x/(x - 3) + sqrt(x) * 2^x", &prog).code == 0 &&
+             evaluateCompiledBatchPolicy(&prog, columns, ROWS, MODE_RAD, POLICY_IEEE, policyResults, policyErrors).code == 0;
+    int nans = 0;
+    for (int r = 0; passed && r < ROWS; r++) {
+        passed = policyErrors[r] == 0 &&
+                 evaluateCompiledPolicy(&prog, &xs[r], MODE_RAD, POLICY_IEEE, &value) == 0 &&
+                 memcmp(&value, &policyResults[r], sizeof(double)) == 0;
+        nans += isnan(policyResults[r]);
+    }
+    passed = passed && nans == 300;
+    freeCompiledExpression(&prog);
+    snprintf(detail, sizeof(detail), "%d 行 NaN", nans);
+    recordCheck("IEEE 批量求值", passed, detail);
+    
+    // 十进制与向量模式的表达式不能按策略求值
+    passed = compileVectorExpression("[1, 2] * 2", &prog).code == 0 &&
+             evaluateCompiledPolicy(&prog, NULL, MODE_RAD, POLICY_IEEE, &value) == ERR_INVALID_ARGUMENT &&
+             evaluateCompiledBatchPolicy(&prog, NULL, 1, MODE_RAD, POLICY_IEEE, &value, NULL).code == ERR_INVALID_ARGUMENT;
+    freeCompiledExpression(&prog);
+    DecimalContext context = {2, DEC_ROUND_HALF_UP};
+    passed = passed && compileDecimalExpression("1.25 * 2", context, &prog).code == 0 &&
+             evaluateCompiledPolicy(&prog, NULL, MODE_RAD, POLICY_CHECKED, &value) == ERR_INVALID_ARGUMENT;
+    freeCompiledExpression(&prog);
+    recordCheck("错误处理", passed, "");
+}
+
+// 求值预算测试
+static void runBudgetSuite(void) {
+    printf("\n=== 求值预算测试 ===\n");
+    char detail[200] = "";
+    EvaluationBudget budget = {0, 0, 0};
+    BudgetUsage usage;
+    double value, expected;
+    CalcError err;
+    
+    // 不限制时结果不变；计入的步数与深度等于编译时的估计
+    const char* exprs[] = {"1+2*3", "2(3+4)(5+6)", "2^3^2", "-(1+2)^2", "((1+2)*(3-4))/5",
+                           "sin(30)+cos(60)*2", "abs(-3)-sqrt(16)", "2pi(1+e)", "-sin(-(30))"};
+    int passed = 1;
+    for (size_t i = 0; passed && i < sizeof(exprs) / sizeof(exprs[0]); i++) {
+        CompiledExpr prog;
+        passed = evaluateExpression(exprs[i], MODE_DEG, &expected).code == 0 &&
+                 evaluateExpressionBudget(exprs[i], MODE_DEG, &budget, &value, &usage).code == 0 &&
+                 memcmp(&value, &expected, sizeof(double)) == 0 &&
+                 compileExpression(exprs[i], &prog).code == 0 &&
+                 usage.steps == prog.cost.steps && usage.depth == (int)prog.cost.depth;
+        snprintf(detail, sizeof(detail), "%s：%llu 步 %d 层，估计 %u 步 %u 层", exprs[i],
+                 (unsigned long long)usage.steps, usage.depth, prog.cost.steps, prog.cost.depth);
+        freeCompiledExpression(&prog);
+    }
+    recordCheck("步数与深度和编译估计一致", passed, detail);
+    
+    // 步数上限：恰好用完时成功，少一步时失败
+    budget.maxSteps = 5;
+    passed = evaluateExpressionBudget("1+2+3+4+5+6", MODE_DEG, &budget, &value, &usage).code == 0 && value == 21;
+    budget.maxSteps = 4;
+    err = evaluateExpressionBudget("1+2+3+4+5+6", MODE_DEG, &budget, &value, &usage);
+    passed = passed && err.code == ERR_BUDGET_EXCEEDED && strcmp(err.message, "超出运算步数上限") == 0 &&
+             usage.steps == 5;
+    recordCheck("步数上限", passed, err.message);
+    
+    // 嵌套深度上限：错误位置为超出的左括号
+    budget.maxSteps = 0;
+    budget.maxDepth = 4;
+    passed = evaluateExpressionBudget("1+(2*(3-(4)))", MODE_DEG, &budget, &value, NULL).code == 0 &&
+             evaluateExpressionBudget("sin(cos(abs(0)))", MODE_DEG, &budget, &value, NULL).code == 0;
+    err = evaluateExpressionBudget("1+(2*(3-(4+(5))))", MODE_DEG, &budget, &value, NULL);
+    passed = passed && err.code == ERR_BUDGET_EXCEEDED && err.position == 11 &&
+             strcmp(err.message, "超出嵌套深度上限") == 0;
+    err = evaluateExpressionBudget("1+sin(cos(abs(tan(0))))", MODE_DEG, &budget, &value, NULL);
+    passed = passed && err.code == ERR_BUDGET_EXCEEDED;
+    snprintf(detail, sizeof(detail), "%s（位置 %d）", err.message, err.position);
+    recordCheck("嵌套深度上限", passed, detail);
+    
+    // 出错后不影响之后的求值与其他调用的预算
+    passed = evaluateExpression("((((((1+1))))))", MODE_DEG, &value).code == 0 && value == 2 &&
+             evaluateExpressionBudget("((((1))))", MODE_DEG, NULL, &value, &usage).code == 0 && usage.depth == 5;
+    recordCheck("预算只作用于本次调用", passed, "");
+    
+    // 时限：截止时间已过时直接失败；sum 在计算之前按项数计入步数
+    budget.maxDepth = 0;
+    budget.deadlineNs = budgetClockNs();
+    err = evaluateExpressionBudget("1+1", MODE_DEG, &budget, &value, NULL);
+    passed = err.code == ERR_BUDGET_EXCEEDED && strcmp(err.message, "超出求值时限") == 0;
+    budget.deadlineNs = budgetClockNs() + 2000000;  // 2 毫秒
+    err = evaluateExpressionBudget("sum(i, 1, 10^8, sin(i)^2 + cos(i)^2)", MODE_RAD, &budget, &value, &usage);
+    passed = passed && err.code == ERR_BUDGET_EXCEEDED && strcmp(err.message, "超出求值时限") == 0 &&
+             usage.elapsedNs < 500000000;
+    snprintf(detail, sizeof(detail), "sum 在 %.1f 毫秒后停止", usage.elapsedNs / 1e6);
+    budget.deadlineNs = 0;
+    budget.maxSteps = 1000;
+    err = evaluateExpressionBudget("1 + sum(i, 1, 10^6, i^2)", MODE_DEG, &budget, &value, &usage);
+    passed = passed && err.code == ERR_BUDGET_EXCEEDED && err.position == 8 && usage.elapsedNs < 100000000;
+    passed = passed && evaluateExpressionBudget("sum(i, 1, 100, i^2)", MODE_DEG, &budget, &value, NULL).code == 0 &&
+             value == 338350;
+    budget.maxSteps = 20;  // 积分的第一轮是 15 个点、每点 1 步
+    err = evaluateExpressionBudget("integrate(2x, x, 0, 3) + 1", MODE_DEG, &budget, &value, &usage);
+    passed = passed && err.code == 0 && value == 10 && usage.steps == 16;
+    err = evaluateExpressionBudget("integrate(sqrt(x), x, 0, 1)", MODE_DEG, &budget, &value, NULL);
+    passed = passed && err.code == ERR_BUDGET_EXCEEDED;
+    recordCheck("时限与 sum/integrate 的步数", passed, detail);
+    
+    // 编译表达式：按估计代价检查，库文件保存嵌套深度
+    CompiledExpr prog;
+    passed = compileExpression("x^2 + sin(x) / (1 - x)", &prog).code == 0 &&
+             prog.cost.steps == 5 && prog.cost.weight == 20 + 1 + 20 + 4 + 1 && prog.cost.depth == 2;
+    snprintf(detail, sizeof(detail), "%u 步，代价 %u，深度 %u", prog.cost.steps, prog.cost.weight, prog.cost.depth);
+    EvaluationBudget rows = {5000, 2, 0};
+    passed = passed && checkCompiledBudget(&prog, 1000, &rows).code == 0 &&
+             checkCompiledBudget(&prog, 1001, &rows).code == ERR_BUDGET_EXCEEDED;
+    rows.maxDepth = 1;
+    passed = passed && checkCompiledBudget(&prog, 1, &rows).code == ERR_BUDGET_EXCEEDED;
+    LibraryWriter writer;
+    ExpressionLibrary lib;
+    CompiledExpr loaded;
+    passed = passed && openLibraryWriter("build/test_budget.lib", &writer).code == 0 &&
+             appendLibraryExpression(&writer, &prog, MODE_RAD).code == 0 && closeLibraryWriter(&writer).code == 0 &&
+             openExpressionLibrary("build/test_budget.lib", &lib).code == 0;
+    if (passed) {
+        passed = getLibraryExpression(&lib, 0, &loaded, NULL).code == 0 &&
+                 memcmp(&loaded.cost, &prog.cost, sizeof(ExpressionCost)) == 0;
+        closeExpressionLibrary(&lib);
+    }
+    remove("build/test_budget.lib");
+    freeCompiledExpression(&prog);
+    recordCheck("编译代价估计", passed, detail);
+}
+
+// 把表达式中的变量 x 替换为数值（交给解释器求值作对照）
+static void substituteVariable(const char* expr, double x, char* out, size_t size) {
+    size_t n = 0;
+    for (const char* p = expr; *p && n + 32 < size; p++) {
+        if (*p == 'x') {
+            n += snprintf(out + n, size - n, "(%.17g)", x);
+        } else {
+            out[n++] = *p;
+        }
+    }
+    out[n] = '\0';
+}
+
+// 比较、逻辑与条件运算测试
+static void runConditionalSuite(void) {
+    printf("\n=== 条件运算测试 ===\n");
+    char detail[300] = "";
+    double value, expected;
+    CalcError err;
+    
+    // 优先级：算术 > 比较 > not > and > or > ?:，条件运算右结合；比较的是修正精度后的结果
+    struct {
+        const char* expr;
+        double expected;
+    } cases[] = {
+        {"1 + 2 > 2", 1},               {"3 <= 2 * 1.5", 1},        {"0.1 + 0.2 == 0.3", 1},
+        {"2 != 2", 0},                  {"not 1 < 0", 1},           {"1 or 0 and 0", 1},
+        {"not 0 and 0", 0},             {"1 ? 2 : 3 ? 4 : 5", 2},   {"0 ? 2 : 0 ? 4 : 5", 5},
+        {"if(2 >= 3, 10, 20) + 1", 21}, {"2if(1, 3, 4)", 6},        {"(1 < 2) + (2 < 1) * 10", 1},
+        {"-1 < 0 ? -1 : 1", -1},        {"1 > 0 ? 2 : 3 + 4", 2},   {"2 and 3", 1},
+    };
+    int passed = 1;
+    for (size_t i = 0; passed && i < sizeof(cases) / sizeof(cases[0]); i++) {
+        err = evaluateExpression(cases[i].expr, MODE_DEG, &value);
+        passed = err.code == 0 && value == cases[i].expected;
+        snprintf(detail, sizeof(detail), "%s = %g（%s）", cases[i].expr, value, err.message ? err.message : "");
+    }
+    recordCheck("优先级与结合性", passed, detail);
+    
+    // 短路：未选中的分支与不需要的右操作数不求值，其中的错误不报告
+    const char* shortCircuits[] = {"0 and 1/0", "1 or sqrt(-1)", "1 ? 5 : ln(0)", "0 ? 1/0 : 5",
+                                   "if(1, 5, asin(2))", "0 and (1/0 or ln(0))"};
+    for (size_t i = 0; passed && i < sizeof(shortCircuits) / sizeof(shortCircuits[0]); i++) {
+        err = evaluateExpression(shortCircuits[i], MODE_DEG, &value);
+        passed = err.code == 0;
+        snprintf(detail, sizeof(detail), "%s：%s", shortCircuits[i], err.message ? err.message : "");
+    }
+    passed = passed && evaluateExpression("1 ? 1/0 : 5", MODE_DEG, &value).code == ERR_DIV_BY_ZERO &&
+             evaluateExpression("1 and ln(0)", MODE_DEG, &value).code != 0;
+    recordCheck("短路求值", passed, detail);
+    
+    // 编译求值（含多项式改写的分支）与代入数值后的解释器逐位一致（取能精确解析的 x）
+    const char* exprs[] = {"x > 0 ? sqrt(x) : -x", "if(x == 0, 1, sin(x)/x)", "x < -1 or x > 1",
+                           "not (x >= 0 and x <= 2) ? x^2 + 2x : 2x", "x > 0 ? x > 2 ? 3 : 2 : x^3 - x"};
+    CompiledExpr prog;
+    for (size_t e = 0; passed && e < sizeof(exprs) / sizeof(exprs[0]); e++) {
+        passed = compileExpression(exprs[e], &prog).code == 0;
+        for (double x = -3; passed && x <= 3; x += 0.5) {
+            char substituted[200];
+            substituteVariable(exprs[e], x, substituted, sizeof(substituted));
+            err = evaluateCompiled(&prog, &x, MODE_RAD, &value);
+            passed = err.code == 0 && evaluateExpression(substituted, MODE_RAD, &expected).code == 0 &&
+                     memcmp(&value, &expected, sizeof(double)) == 0;
+            snprintf(detail, sizeof(detail), "%s：%.17g / %.17g", substituted, value, expected);
+        }
+        freeCompiledExpression(&prog);
+    }
+    recordCheck("编译求值与解释器一致", passed, detail);
+    
+    // 批量求值：正负交替的行走不同分支，未选中分支的错误（负数开方）不报告
+    enum { ROWS = 1000 };
+    static double xs[ROWS], batch[ROWS];
+    ErrorCode errors[ROWS];
+    for (int r = 0; r < ROWS; r++) xs[r] = (r % 2 ? -0.37 : 0.37) * r;
+    const double* columns[1] = {xs};
+    passed = compileExpression("x > 0 ? sqrt(x) : -x", &prog).code == 0;
+    EvalPrecision precisions[] = {EVAL_FP64, EVAL_FP32, EVAL_ADAPTIVE};
+    for (size_t p = 0; passed && p < 4; p++) {
+        err = p < 3 ? evaluateCompiledBatch(&prog, columns, ROWS, MODE_RAD, precisions[p], batch, errors)
+                    : evaluateCompiledBatchPolicy(&prog, columns, ROWS, MODE_RAD, POLICY_CHECKED, batch, errors);
+        passed = err.code == 0;
+        for (int r = 0; passed && r < ROWS; r++) {
+            expected = xs[r] > 0 ? sqrt(xs[r]) : -xs[r];
+            passed = errors[r] == 0 && (p == 1 ? fabs(batch[r] - expected) <= 1e-6 * fmax(1, expected)
+                                               : memcmp(&batch[r], &expected, sizeof(double)) == 0);
+            snprintf(detail, sizeof(detail), "模式 %zu，第 %d 行：%.17g / %.17g", p, r, batch[r], expected);
+        }
+    }
+    freeCompiledExpression(&prog);
+    recordCheck("批量求值按掩码选择分支", passed, detail);
+    
+    // 选中分支的错误照常报告；and/or 右侧只在需要时计入错误
+    for (int r = 0; r < ROWS; r++) xs[r] = r - 500;
+    passed = compileExpression("x >= 0 ? 1/(x - 4) : ln(-x)", &prog).code == 0 &&
+             evaluateCompiledBatch(&prog, columns, ROWS, MODE_RAD, EVAL_FP64, batch, errors).code == ERR_DIV_BY_ZERO;
+    for (int r = 0; passed && r < ROWS; r++) {
+        passed = errors[r] == (r == 504 ? ERR_DIV_BY_ZERO : 0);
+    }
+    freeCompiledExpression(&prog);
+    const char* logical[] = {"x > 0 and 1/x > 0.01", "x == 0 or 1/x < 0", "not (x != 0 and ln(x^2) > 1)"};
+    for (size_t e = 0; passed && e < sizeof(logical) / sizeof(logical[0]); e++) {
+        passed = compileExpression(logical[e], &prog).code == 0 &&
+                 evaluateCompiledBatch(&prog, columns, ROWS, MODE_RAD, EVAL_FP64, batch, errors).code == 0;
+        for (int r = 0; passed && r < ROWS; r++) {
+            passed = errors[r] == 0 && evaluateCompiled(&prog, &xs[r], MODE_RAD, &value).code == 0 &&
+                     value == batch[r];
+            snprintf(detail, sizeof(detail), "%s，x = %g：%g / %g", logical[e], xs[r], batch[r], value);
+        }
+        freeCompiledExpression(&prog);
+    }
+    recordCheck("批量求值的错误与短路", passed, detail);
+    
+    // 十进制模式按精确的十进制值比较；向量模式的条件必须是标量，比较逐元素进行
+    DecimalContext context = {2, DEC_ROUND_HALF_UP};
+    Decimal decimal;
+    char text[64] = "";
+    passed = evaluateDecimalExpression("0.1 + 0.2 == 0.3 ? 1.5 : 2", context, &decimal).code == 0 &&
+             strcmp(formatDecimal(decimal, text, sizeof(text)), "1.5") == 0 &&
+             evaluateDecimalExpression("0 and 1/0", context, &decimal).code == 0 && decimal.mantissa == 0;
+    VectorArena arena;
+    initVectorArena(&arena);
+    VectorValue result;
+    const double selected[] = {1, 2}, compared[] = {1, 0, 1};
+    passed = passed &&
+             evaluateVectorTest("2 > 1 ? [1, 2] : [3]", &arena, &result, detail, sizeof(detail)) == 0 &&
+             vectorEquals(&result, selected, 2) &&
+             evaluateVectorTest("[1, 3, 2] <= [2, 2, 2]", &arena, &result, detail, sizeof(detail)) == 0 &&
+             vectorEquals(&result, compared, 3);
+    err = evaluateVectorExpression("[1, 2] > 0 ? 1 : 2", MODE_DEG, &arena, &result);
+    passed = passed && err.code == ERR_INVALID_ARGUMENT && strcmp(err.message, "条件必须是标量") == 0;
+    freeVectorArena(&arena);
+    passed = passed && evaluateExpression("sum(i, 1, 100, i > 50 ? i : 0)", MODE_DEG, &value).code == 0 &&
+             value == 3775 &&
+             evaluateExpression("sum(i, 1, 10, i <= 5 or i == 10)", MODE_DEG, &value).code == 0 && value == 6;
+    recordCheck("十进制、向量与 sum", passed, text);
+    
+    // 表达式库：分支指令原样保存，加载后结果不变
+    LibraryWriter writer;
+    ExpressionLibrary lib;
+    CompiledExpr loaded;
+    double x = -2.5;
+    passed = compileExpression("x < 0 ? if(x < -2, -x, 0) : sqrt(x)", &prog).code == 0 &&
+             openLibraryWriter("build/test_conditional.lib", &writer).code == 0 &&
+             appendLibraryExpression(&writer, &prog, MODE_RAD).code == 0 && closeLibraryWriter(&writer).code == 0 &&
+             openExpressionLibrary("build/test_conditional.lib", &lib).code == 0;
+    if (passed) {
+        passed = getLibraryExpression(&lib, 0, &loaded, NULL).code == 0 &&
+                 evaluateCompiled(&loaded, &x, MODE_RAD, &value).code == 0 && value == 2.5;
+        closeExpressionLibrary(&lib);
+    }
+    remove("build/test_conditional.lib");
+    freeCompiledExpression(&prog);
+    recordCheck("表达式库保存分支", passed, "");
+    
+    // 错误：缺少冒号、参数个数、运算符位置；插桩分析不支持分支
+    struct {
+        const char* expr;
+        const char* message;
+        int position;
+    } errorCases[] = {
+        {"1 ? 2", "条件运算缺少冒号", 2},
+        {"if(1, 2)", "参数个数不正确", 3},
+        {"1 = 2", "运算符使用不正确", 2},
+        {"1 : 2", "运算符使用不正确", 2},
+    };
+    passed = 1;
+    for (size_t i = 0; passed && i < sizeof(errorCases) / sizeof(errorCases[0]); i++) {
+        err = evaluateExpression(errorCases[i].expr, MODE_DEG, &value);
+        passed = err.code == ERR_SYNTAX && strcmp(err.message, errorCases[i].message) == 0 &&
+                 err.position == errorCases[i].position;
+        snprintf(detail, sizeof(detail), "%s：%s（位置 %d）", errorCases[i].expr, err.message, err.position);
+        if (passed) {
+            err = compileExpression(errorCases[i].expr, &prog);
+            passed = err.code == ERR_SYNTAX;
+            if (err.code == 0) freeCompiledExpression(&prog);
+        }
+    }
+    passed = passed && evaluateExpression("1 <", MODE_DEG, &value).code != 0 &&
+             evaluateExpression("1 and", MODE_DEG, &value).code != 0 &&
+             evaluateExpression("2 not 1", MODE_DEG, &value).code != 0;
+    ExpressionProfile profile;
+    x = 1;
+    passed = passed && compileExpression("x > 0 ? x : -x", &prog).code == 0 &&
+             profileCompiled(&prog, &x, MODE_RAD, 1, &profile).code == ERR_INVALID_ARGUMENT;
+    freeCompiledExpression(&prog);
+    recordCheck("错误处理", passed, detail);
+}
+
+#define TEST_LIBRARY_PATH "build/test_expressions.lib"
+
+// 写入库文件时记录的测试用例
+typedef struct {
+    TestCase* test;
+    AngleMode mode;
+} LibraryEntry;
+
+// 将测试数组中不期望出错的用例编译写入库文件
+static void appendLibraryTests(LibraryWriter* writer, TestCase tests[], AngleMode mode,
+                               LibraryEntry* entries, size_t* count) {
+    for (size_t i = 0; tests[i].expr != NULL; i++) {
+        CompiledExpr prog;
+        if (tests[i].expectError || compileExpression(tests[i].expr, &prog).code != 0) {
+            continue;
+        }
+        if (appendLibraryExpression(writer, &prog, mode).code == 0) {
+            entries[*count].test = &tests[i];
+            entries[*count].mode = mode;
+            (*count)++;
+        }
+        freeCompiledExpression(&prog);
+    }
+}
+
+// 表达式库测试：写入后通过 mmap 加载，结果应与直接求值一致
+static void runLibrarySuite(void) {
+    printf("\n=== 表达式库测试 ===\n");
+    LibraryEntry entries[64];
+    size_t count = 0;
+    LibraryWriter writer;
+    CompiledExpr prog;
+    char detail[100];
+    
+    CalcError err = openLibraryWriter(TEST_LIBRARY_PATH, &writer);
+    if (err.code == 0) {
+        appendLibraryTests(&writer, complexTests, MODE_DEG, entries, &count);
+        appendLibraryTests(&writer, radianTests, MODE_RAD, entries, &count);
+        
+        // 带变量的表达式与十进制模式的表达式
+        compileExpression("rate*x^2+y", &prog);
+        appendLibraryExpression(&writer, &prog, MODE_DEG);
+        freeCompiledExpression(&prog);
+        DecimalContext context = {2, DEC_ROUND_HALF_UP};
+        compileDecimalExpression("0.1+0.2+0.125", context, &prog);
+        appendLibraryExpression(&writer, &prog, MODE_DEG);
+        freeCompiledExpression(&prog);
+        err = closeLibraryWriter(&writer);
+    }
+    recordCheck("写入库文件", err.code == 0, err.message);
+    
+    ExpressionLibrary lib;
+    err = openExpressionLibrary(TEST_LIBRARY_PATH, &lib);
+    snprintf(detail, sizeof(detail), "%u 个表达式", lib.count);
+    recordCheck("映射库文件", err.code == 0 && lib.count == count + 2, detail);
+    if (err.code != 0) {
+        return;
+    }
+    
+    for (uint32_t i = 0; i < count; i++) {
+        AngleMode mode;
+        double value = 0;
+        err = getLibraryExpression(&lib, i, &prog, &mode);
+        if (err.code == 0) {
+            err = evaluateCompiled(&prog, NULL, mode, &value);
+        }
+        int passed = err.code == 0 && prog.storage == NULL && mode == entries[i].mode &&
+                     isDoubleEqual(value, entries[i].test->expected);
+        snprintf(detail, sizeof(detail), "%.10g（%s）", value, mode == MODE_DEG ? "角度" : "弧度");
+        recordCheck(entries[i].test->expr, passed, err.code == 0 ? detail : err.message);
+    }
+    
+    // 变量槽位表
+    double vars[MAX_COMPILED_VARIABLES] = {0};
+    double value = 0;
+    err = getLibraryExpression(&lib, (uint32_t)count, &prog, NULL);
+    if (err.code == 0) {
+        vars[findCompiledVariable(&prog, "rate")] = 0.5;
+        vars[findCompiledVariable(&prog, "x")] = 4;
+        vars[findCompiledVariable(&prog, "y")] = 1;
+        err = evaluateCompiled(&prog, vars, MODE_DEG, &value);
+    }
+    snprintf(detail, sizeof(detail), "%g", value);
+    recordCheck("rate*x^2+y（rate=0.5, x=4, y=1）", err.code == 0 && prog.varCount == 3 && value == 9, detail);
+    
+    // 十进制模式
+    Decimal decimal = {0, 0};
+    err = getLibraryExpression(&lib, (uint32_t)count + 1, &prog, NULL);
+    if (err.code == 0) {
+        err = evaluateCompiledDecimal(&prog, NULL, &decimal);
+    }
+    formatDecimal(decimal, detail, sizeof(detail));
+    recordCheck("0.1+0.2+0.125（十进制，2位小数）", err.code == 0 && strcmp(detail, "0.43") == 0, detail);
+    
+    err = getLibraryExpression(&lib, lib.count, &prog, NULL);
+    recordCheck("序号超出范围", err.code != 0, err.message);
+    closeExpressionLibrary(&lib);
+    
+    // 损坏的文件：修改字节序标记后应拒绝加载
+    FILE* file = fopen(TEST_LIBRARY_PATH, "r+b");
+    if (file != NULL) {
+        uint32_t badTag = 0x04030201u;
+        fseek(file, offsetof(LibraryFileHeader, endianTag), SEEK_SET);
+        fwrite(&badTag, sizeof(badTag), 1, file);
+        fclose(file);
+    }
+    err = openExpressionLibrary(TEST_LIBRARY_PATH, &lib);
+    recordCheck("拒绝字节序不同的库文件", err.code != 0, err.message);
+    remove(TEST_LIBRARY_PATH);
+    
+    err = openExpressionLibrary(TEST_LIBRARY_PATH, &lib);
+    recordCheck("库文件不存在", err.code != 0, err.message);
+}
+
+#define TEST_CSV_INPUT "build/test_columns.csv"
+#define TEST_CSV_OUTPUT "build/test_columns_out.csv"
+#define TEST_COLUMNAR_INPUT "build/test_columns.col"
+#define TEST_COLUMNAR_OUTPUT "build/test_columns_out.col"
+
+// 快速数值字段解析：expectValid 为 0 表示应拒绝
+static const struct {
+    const char* text;
+    int expectValid;
+} numberFieldTests[] = {
+    {"1.5", 1}, {" -2e3 ", 1}, {"0.1", 1}, {"+.5", 1}, {"5.", 1}, {"3.14159265358979", 1},
+    {"1234567890123456789012", 1}, {"4.9e-324", 1}, {"1.7976931348623157e308", 1},
+    {"1e400", 0}, {"abc", 0}, {"1.2.3", 0}, {"", 0}, {"1e", 0}, {"--1", 0}, {"12a", 0}
+};
+
+static int readWholeFile(const char* path, char* buffer, size_t size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return 0;
+    size_t length = fread(buffer, 1, size - 1, file);
+    buffer[length] = '\0';
+    fclose(file);
+    return 1;
+}
+
+// 按列计算测试：CSV 流式处理与列式文件
+static void runColumnSuite(void) {
+    printf("\n=== 按列计算测试 ===\n");
+    char detail[200];
+    
+    // 与 strtod 的结果逐位一致
+    for (size_t i = 0; i < sizeof(numberFieldTests) / sizeof(numberFieldTests[0]); i++) {
+        const char* text = numberFieldTests[i].text;
+        double value = 0;
+        int valid = parseNumberField(text, text + strlen(text), &value);
+        int passed = valid == numberFieldTests[i].expectValid && (!valid || value == strtod(text, NULL));
+        snprintf(detail, sizeof(detail), "%s（%.17g）", valid ? "有效" : "无效", value);
+        recordCheck(text[0] ? text : "（空字段）", passed, detail);
+    }
+    
+    FormulaSet set;
+    memset(&set, 0, sizeof(set));
+    set.mode = MODE_DEG;
+    CalcError err = addFormulaColumn(&set, "c=sqrt(a^2+b^2)");
+    if (err.code == 0) err = addFormulaColumn(&set, "ratio = a/b");
+    if (err.code == 0) err = addFormulaColumn(&set, "d=c*2");
+    recordCheck("定义公式列", err.code == 0 && set.count == 3, err.message);
+    
+    FILE* input = fopen(TEST_CSV_INPUT, "wb");
+    if (input != NULL) {
+        fputs("a,b,label\n3,4,\"x, \"\"y\"\"\"\n5,0,z\r\n\n1e1,abc,w\n0.1,0.2,last", input);
+        fclose(input);
+    }
+    input = fopen(TEST_CSV_INPUT, "rb");
+    FILE* output = fopen(TEST_CSV_OUTPUT, "wb");
+    ColumnStats stats = {0, 0, 0};
+    err = (input && output) ? evaluateCsvStream(input, output, &set, &stats)
+                            : CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法创建测试文件");
+    if (input) fclose(input);
+    if (output) fclose(output);
+    
+    static char content[4096];
+    const char* expected =
+        "a,b,label,c,ratio,d\n"
+        "3,4,\"x, \"\"y\"\"\",5,0.75,10\n"
+        "5,0,z,5,,10\n"
+        "1e1,abc,w,,,\n"
+        "0.1,0.2,last,0.223606797749979,0.5,0.447213595499958\n";
+    int matched = err.code == 0 && readWholeFile(TEST_CSV_OUTPUT, content, sizeof(content)) &&
+                  strcmp(content, expected) == 0;
+    recordCheck("CSV 追加结果列（引号字段、CRLF、空行、出错留空）", matched,
+                err.code != 0 ? err.message : (matched ? "输出一致" : content));
+    snprintf(detail, sizeof(detail), "%llu 行，%llu 个结果出错，第一个在第 %llu 行",
+             (unsigned long long)stats.rows, (unsigned long long)stats.errors,
+             (unsigned long long)stats.firstErrorRow);
+    recordCheck("CSV 统计", stats.rows == 4 && stats.errors == 4 && stats.firstErrorRow == 2, detail);
+    
+    // 列名与公式不匹配
+    FormulaSet unknown;
+    memset(&unknown, 0, sizeof(unknown));
+    addFormulaColumn(&unknown, "out=a+missing");
+    input = fopen(TEST_CSV_INPUT, "rb");
+    output = fopen(TEST_CSV_OUTPUT, "wb");
+    err = (input && output) ? evaluateCsvStream(input, output, &unknown, &stats)
+                            : CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法创建测试文件");
+    if (input) fclose(input);
+    if (output) fclose(output);
+    recordCheck("拒绝未知的列", err.code == ERR_INVALID_ARGUMENT, err.message);
+    freeFormulaSet(&unknown);
+    err = addFormulaColumn(&unknown, "1x=a");
+    recordCheck("拒绝无效的结果列名", err.code != 0, err.message);
+    
+    // 列式文件：5000 行（跨越计算块边界）
+    enum { COLUMNAR_ROWS = 5000 };
+    static double a[COLUMNAR_ROWS], b[COLUMNAR_ROWS];
+    for (int i = 0; i < COLUMNAR_ROWS; i++) {
+        a[i] = i * 3;
+        b[i] = i * 4;
+    }
+    const char names[2][MAX_VARIABLE_NAME] = {"a", "b"};
+    const double* columns[2] = {a, b};
+    err = writeColumnarFile(TEST_COLUMNAR_INPUT, names, columns, 2, COLUMNAR_ROWS);
+    if (err.code == 0) {
+        err = evaluateColumnarFile(TEST_COLUMNAR_INPUT, TEST_COLUMNAR_OUTPUT, &set, &stats);
+    }
+    recordCheck("列式文件计算", err.code == 0, err.message);
+    
+    MappedFile file;
+    int valid = 0;
+    if (err.code == 0 && mapReadOnlyFile(TEST_COLUMNAR_OUTPUT, &file).code == 0) {
+        const ColumnarFileHeader* header = (const ColumnarFileHeader*)file.base;
+        const char* storedNames = (const char*)(header + 1);
+        const double* data = (const double*)(storedNames + header->columnCount * MAX_VARIABLE_NAME);
+        valid = header->columnCount == 5 && header->rowCount == COLUMNAR_ROWS &&
+                strcmp(storedNames + 3 * MAX_VARIABLE_NAME, "ratio") == 0 &&
+                isnan(data[3 * COLUMNAR_ROWS]) &&   // 第一行 0/0
+                data[2 * COLUMNAR_ROWS + 4999] == 5 * 4999.0 &&
+                data[3 * COLUMNAR_ROWS + 4999] == 0.75 &&
+                data[4 * COLUMNAR_ROWS + 4097] == 10 * 4097.0;
+        unmapFile(&file);
+    }
+    snprintf(detail, sizeof(detail), "%llu 行，%llu 个结果出错", (unsigned long long)stats.rows,
+             (unsigned long long)stats.errors);
+    recordCheck("列式输出：输入列 + 结果列，出错为 NaN", valid && stats.errors == 1, detail);
+    
+    err = evaluateColumnarFile(TEST_CSV_INPUT, TEST_COLUMNAR_OUTPUT, &set, &stats);
+    recordCheck("拒绝非列式文件", err.code != 0, err.message);
+    
+    // 输出路径的写法不同但指向输入文件：拒绝，输入不被截断
+    err = evaluateColumnarFile(TEST_COLUMNAR_INPUT, "build/./test_columns.col", &set, &stats);
+    valid = 0;
+    if (mapReadOnlyFile(TEST_COLUMNAR_INPUT, &file).code == 0) {
+        valid = ((const ColumnarFileHeader*)file.base)->rowCount == COLUMNAR_ROWS;
+        unmapFile(&file);
+    }
+    recordCheck("拒绝指向输入文件的输出路径", err.code == ERR_INVALID_ARGUMENT && valid, err.message);
+    
+    freeFormulaSet(&set);
+    remove(TEST_CSV_INPUT);
+    remove(TEST_CSV_OUTPUT);
+    remove(TEST_COLUMNAR_INPUT);
+    remove(TEST_COLUMNAR_OUTPUT);
+}
+
+#define TEST_BATCH_LIBRARY "build/test_batch.lib"
+#define TEST_BATCH_REQUESTS "build/test_batch.req"
+#define TEST_BATCH_RESULTS "build/test_batch.res"
+#define TEST_BATCH_STREAM "build/test_batch_stream.res"
+
+// 批量请求：kind 为 BATCH_LIBRARY 时 expr 为库序号
+typedef struct {
+    int kind;
+    const char* expr;
+    uint32_t index;
+    AngleMode mode;
+    double values[3];
+    int count;
+    double expected;
+    int expectedCode;
+} BatchTestCase;
+
+static const BatchTestCase batchTests[] = {
+    {BATCH_INLINE, "a+b*2", 0, MODE_DEG, {1, 2}, 2, 5, ERR_SUCCESS},
+    {BATCH_INLINE, "a+b*2", 0, MODE_DEG, {3, 4}, 2, 11, ERR_SUCCESS},       // 复用编译结果
+    {BATCH_LIBRARY, "库 0：rate*x^2+y", 0, MODE_DEG, {2, 3, 1}, 3, 19, ERR_SUCCESS},
+    {BATCH_LIBRARY, "库 1：sin(x)（角度）", 1, MODE_DEG, {30}, 1, 0.5, ERR_SUCCESS},
+    {BATCH_INLINE, "sin(x)", 0, MODE_RAD, {M_PI / 2}, 1, 1, ERR_SUCCESS},
+    {BATCH_INLINE, "1/x", 0, MODE_DEG, {0}, 1, 0, ERR_DIV_BY_ZERO},
+    {BATCH_INLINE, "2+", 0, MODE_DEG, {0}, 0, 0, ERR_SYNTAX},
+    {BATCH_LIBRARY, "库 7（不存在）", 7, MODE_DEG, {0}, 0, 0, ERR_INVALID_ARGUMENT},
+    {BATCH_INLINE, "a+b", 0, MODE_DEG, {1}, 1, 0, ERR_INVALID_ARGUMENT},   // 变量值个数不符
+};
+
+static void runBatchFormatSuite(void) {
+    printf("\n=== 二进制批量请求测试 ===\n");
+    enum { BATCH_TEST_COUNT = sizeof(batchTests) / sizeof(batchTests[0]) };
+    char detail[200];
+    
+    LibraryWriter writer;
+    CompiledExpr prog;
+    CalcError err = openLibraryWriter(TEST_BATCH_LIBRARY, &writer);
+    if (err.code == 0) {
+        compileExpression("rate*x^2+y", &prog);
+        appendLibraryExpression(&writer, &prog, MODE_DEG);
+        freeCompiledExpression(&prog);
+        compileExpression("sin(x)", &prog);
+        appendLibraryExpression(&writer, &prog, MODE_DEG);
+        freeCompiledExpression(&prog);
+        err = closeLibraryWriter(&writer);
+    }
+    ExpressionLibrary lib;
+    if (err.code == 0) {
+        err = openExpressionLibrary(TEST_BATCH_LIBRARY, &lib);
+    }
+    
+    FILE* file = err.code == 0 ? fopen(TEST_BATCH_REQUESTS, "wb") : NULL;
+    if (file != NULL) {
+        err = writeBatchHeader(file, BATCH_REQUEST_MAGIC);
+        for (int i = 0; i < BATCH_TEST_COUNT && err.code == 0; i++) {
+            const BatchTestCase* test = &batchTests[i];
+            err = test->kind == BATCH_LIBRARY
+                      ? appendLibraryRequest(file, test->index, test->values, test->count)
+                      : appendInlineRequest(file, test->expr, strlen(test->expr), test->mode,
+                                            test->values, test->count);
+        }
+        fclose(file);
+    }
+    recordCheck("写入批量请求", err.code == 0 && file != NULL, err.message);
+    if (err.code != 0 || file == NULL) {
+        return;
+    }
+    
+    // 映射处理
+    BatchStats stats;
+    memset(&stats, 0, sizeof(stats));
+    err = processBatchFile(TEST_BATCH_REQUESTS, TEST_BATCH_RESULTS, &lib, &stats);
+    snprintf(detail, sizeof(detail), "%llu 条，%llu 条出错", (unsigned long long)stats.records,
+             (unsigned long long)stats.errors);
+    recordCheck("处理请求文件（mmap）", err.code == 0 && stats.records == BATCH_TEST_COUNT && stats.errors == 4,
+                err.code != 0 ? err.message : detail);
+    
+    MappedFile results;
+    if (err.code == 0 && mapReadOnlyFile(TEST_BATCH_RESULTS, &results).code == 0) {
+        const BatchFileHeader* header = (const BatchFileHeader*)results.base;
+        const BatchResult* records = (const BatchResult*)(header + 1);
+        recordCheck("结果文件头记录总条数",
+                    results.size == sizeof(*header) + BATCH_TEST_COUNT * sizeof(BatchResult) &&
+                    memcmp(header->magic, BATCH_RESULT_MAGIC, sizeof(BATCH_RESULT_MAGIC)) == 0 &&
+                    header->recordCount == BATCH_TEST_COUNT, NULL);
+        for (int i = 0; i < BATCH_TEST_COUNT && results.size >= sizeof(*header) + (i + 1) * sizeof(BatchResult); i++) {
+            const BatchTestCase* test = &batchTests[i];
+            int passed = records[i].errorCode == test->expectedCode &&
+                         (test->expectedCode != 0 || isDoubleEqual(records[i].value, test->expected));
+            snprintf(detail, sizeof(detail), "值 %.17g，错误代码 %d，位置 %d", records[i].value,
+                     records[i].errorCode, records[i].errorPosition);
+            recordCheck(test->expr, passed, detail);
+        }
+        recordCheck("错误位置写入结果", records[5].errorPosition == 1 && records[0].errorPosition == -1, NULL);
+        unmapFile(&results);
+    }
+    
+    // 流式处理的结果与映射处理一致（文件头条数除外）
+    FILE* input = fopen(TEST_BATCH_REQUESTS, "rb");
+    FILE* output = fopen(TEST_BATCH_STREAM, "wb");
+    err = (input && output) ? processBatchStream(input, output, &lib, &stats)
+                            : CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法创建测试文件");
+    if (input) fclose(input);
+    if (output) fclose(output);
+    static unsigned char mapped[1024], streamed[1024];
+    FILE* a = fopen(TEST_BATCH_RESULTS, "rb");
+    FILE* b = fopen(TEST_BATCH_STREAM, "rb");
+    size_t mappedSize = a ? fread(mapped, 1, sizeof(mapped), a) : 0;
+    size_t streamedSize = b ? fread(streamed, 1, sizeof(streamed), b) : 0;
+    if (a) fclose(a);
+    if (b) fclose(b);
+    size_t headerSize = sizeof(BatchFileHeader);
+    recordCheck("流式处理结果与映射处理一致", err.code == 0 && mappedSize == streamedSize &&
+                mappedSize > headerSize &&
+                memcmp(mapped + headerSize, streamed + headerSize, mappedSize - headerSize) == 0,
+                err.message);
+    
+    // 截断的请求文件：已处理的记录照常输出，然后报告错误
+    input = fopen(TEST_BATCH_REQUESTS, "rb");
+    file = fopen(TEST_BATCH_RESULTS, "wb");
+    if (input && file) {
+        static unsigned char truncated[1024];
+        size_t size = fread(truncated, 1, sizeof(truncated), input);
+        fwrite(truncated, 1, size - 4, file);
+    }
+    if (input) fclose(input);
+    if (file) fclose(file);
+    err = processBatchFile(TEST_BATCH_RESULTS, TEST_BATCH_REQUESTS ".out", &lib, &stats);
+    snprintf(detail, sizeof(detail), "%s（已处理 %llu 条）", err.message ? err.message : "",
+             (unsigned long long)stats.records);
+    recordCheck("拒绝截断的请求文件", err.code == ERR_INVALID_ARGUMENT && stats.records == BATCH_TEST_COUNT - 1,
+                detail);
+    err = processBatchFile(TEST_BATCH_LIBRARY, TEST_BATCH_RESULTS, &lib, &stats);
+    recordCheck("拒绝非请求文件", err.code == ERR_INVALID_ARGUMENT, err.message);
+    
+    // 输出路径的写法不同但指向请求文件：拒绝，请求文件不被截断
+    err = processBatchFile(TEST_BATCH_REQUESTS, "build/./test_batch.req", &lib, &stats);
+    MappedFile requestFile;
+    int intact = mapReadOnlyFile(TEST_BATCH_REQUESTS, &requestFile).code == 0;
+    unmapFile(&requestFile);
+    recordCheck("拒绝指向请求文件的输出路径", err.code == ERR_INVALID_ARGUMENT && intact, err.message);
+    
+    closeExpressionLibrary(&lib);
+    remove(TEST_BATCH_LIBRARY);
+    remove(TEST_BATCH_REQUESTS);
+    remove(TEST_BATCH_REQUESTS ".out");
+    remove(TEST_BATCH_RESULTS);
+    remove(TEST_BATCH_STREAM);
+}
+
+#define TEST_BATCH_PLAN "build/test_batch_plan.req"
+#define TEST_BATCH_PLAN_RESULTS "build/test_batch_plan.res"
+#define BATCH_PLAN_TEST_COUNT 10000
+
+// 批量计划测试的第 i 条请求：常量表达式、重复的变量值、交错的表达式、
+// 超过 BATCH_PLAN_PROGRAMS 个不同表达式与重复出错的记录
+static void planTestRequest(int i, BatchTestCase* test, char* text, size_t size) {
+    memset(test, 0, sizeof(*test));
+    test->kind = BATCH_INLINE;
+    test->mode = MODE_DEG;
+    test->expr = text;
+    switch (i % 5) {
+        case 0:
+            snprintf(text, size, "2^10+1");
+            break;
+        case 1:
+            snprintf(text, size, "a*b");
+            test->values[0] = i % 7;
+            test->values[1] = 3;
+            test->count = 2;
+            break;
+        case 2:
+            snprintf(text, size, "sin(x)");
+            test->mode = (i / 5) % 2 ? MODE_RAD : MODE_DEG;
+            test->values[0] = (i % 4) * 30;
+            test->count = 1;
+            break;
+        case 3:
+            test->kind = BATCH_LIBRARY;
+            snprintf(text, size, "库 0");
+            test->values[0] = 1;
+            test->values[1] = i % 3;
+            test->count = 3;
+            break;
+        default:
+            if (i % 50 == 4) {
+                snprintf(text, size, "2*(1/x)");
+            } else {
+                snprintf(text, size, "x+%d", (i / 5) % 300);
+            }
+            test->count = 1;
+            break;
+    }
+}
+
+// 在管道的另一端运行流式处理
+typedef struct {
+    FILE* input;
+    FILE* output;
+    CalcError err;
+    BatchStats stats;
+} StreamJob;
+
+static void* batchStreamThreadMain(void* arg) {
+    StreamJob* job = (StreamJob*)arg;
+    job->err = processBatchStream(job->input, job->output, NULL, &job->stats);
+    fclose(job->input);
+    fclose(job->output);
+    return NULL;
+}
+
+// 从 fd 读满 size 字节，5 秒内没有数据时返回 0
+static int readWithTimeout(int fd, void* buffer, size_t size) {
+    size_t got = 0;
+    while (got < size) {
+        struct pollfd ready = {.fd = fd, .events = POLLIN};
+        ssize_t n = poll(&ready, 1, 5000) == 1 ? read(fd, (char*)buffer + got, size - got) : -1;
+        if (n <= 0) {
+            return 0;
+        }
+        got += (size_t)n;
+    }
+    return 1;
+}
+
+// 批量计划测试：去重与分组后的结果与逐条直接求值一致，且按原顺序写出
+static void runBatchPlanSuite(void) {
+    printf("\n=== 批量计划测试 ===\n");
+    char detail[200];
+    char text[32];
+    BatchTestCase test;
+    
+    LibraryWriter writer;
+    CompiledExpr prog;
+    CalcError err = openLibraryWriter(TEST_BATCH_LIBRARY, &writer);
+    if (err.code == 0) {
+        compileExpression("rate*x^2+y", &prog);
+        appendLibraryExpression(&writer, &prog, MODE_DEG);
+        freeCompiledExpression(&prog);
+        err = closeLibraryWriter(&writer);
+    }
+    ExpressionLibrary lib;
+    if (err.code == 0) {
+        err = openExpressionLibrary(TEST_BATCH_LIBRARY, &lib);
+    }
+    FILE* file = err.code == 0 ? fopen(TEST_BATCH_PLAN, "wb") : NULL;
+    if (file != NULL) {
+        err = writeBatchHeader(file, BATCH_REQUEST_MAGIC);
+        for (int i = 0; i < BATCH_PLAN_TEST_COUNT && err.code == 0; i++) {
+            planTestRequest(i, &test, text, sizeof(text));
+            err = test.kind == BATCH_LIBRARY
+                      ? appendLibraryRequest(file, 0, test.values, test.count)
+                      : appendInlineRequest(file, text, strlen(text), test.mode, test.values, test.count);
+        }
+        fclose(file);
+    }
+    if (err.code != 0 || file == NULL) {
+        recordCheck("写入批量请求", 0, err.message);
+        return;
+    }
+    
+    BatchStats stats;
+    err = processBatchFile(TEST_BATCH_PLAN, TEST_BATCH_PLAN_RESULTS, &lib, &stats);
+    snprintf(detail, sizeof(detail), "%llu 条，实际求值 %llu 条，编译 %llu 次，出错 %llu 条",
+             (unsigned long long)stats.records, (unsigned long long)stats.evaluated,
+             (unsigned long long)stats.programs, (unsigned long long)stats.errors);
+    recordCheck("去重后的求值次数", err.code == 0 && stats.records == BATCH_PLAN_TEST_COUNT &&
+                stats.evaluated < BATCH_PLAN_TEST_COUNT / 2 && stats.errors == BATCH_PLAN_TEST_COUNT / 50,
+                err.code != 0 ? err.message : detail);
+    
+    // 逐条直接求值（值的位模式、错误代码与位置都相同）
+    MappedFile results;
+    int passed = 0;
+    if (err.code == 0 && mapReadOnlyFile(TEST_BATCH_PLAN_RESULTS, &results).code == 0) {
+        const BatchResult* records = (const BatchResult*)((const BatchFileHeader*)results.base + 1);
+        passed = results.size == sizeof(BatchFileHeader) + BATCH_PLAN_TEST_COUNT * sizeof(BatchResult);
+        for (int i = 0; i < BATCH_PLAN_TEST_COUNT && passed; i++) {
+            planTestRequest(i, &test, text, sizeof(text));
+            AngleMode mode = test.mode;
+            if (test.kind == BATCH_LIBRARY) {
+                getLibraryExpression(&lib, 0, &prog, &mode);
+            } else {
+                compileExpression(text, &prog);
+            }
+            double value = 0;
+            CalcError expected = evaluateCompiled(&prog, test.values, mode, &value);
+            passed = records[i].errorCode == expected.code &&
+                     (expected.code != 0 ? records[i].errorPosition == expected.position
+                                         : memcmp(&records[i].value, &value, sizeof(value)) == 0);
+            snprintf(detail, sizeof(detail), "第 %d 条 %s：%.17g（应为 %.17g），错误代码 %d", i, text,
+                     records[i].value, value, records[i].errorCode);
+            freeCompiledExpression(&prog);
+        }
+        unmapFile(&results);
+    }
+    recordCheck("结果与逐条求值一致且顺序不变", passed, detail);
+    
+    // 流式处理使用同样的计划
+    BatchStats streamStats;
+    FILE* input = fopen(TEST_BATCH_PLAN, "rb");
+    FILE* output = fopen(TEST_BATCH_STREAM, "wb");
+    err = (input && output) ? processBatchStream(input, output, &lib, &streamStats)
+                            : CALC_ERROR_CODE(ERR_INVALID_ARGUMENT, "无法创建测试文件");
+    if (input) fclose(input);
+    if (output) fclose(output);
+    MappedFile mapped, streamed;
+    passed = 0;
+    if (err.code == 0 && mapReadOnlyFile(TEST_BATCH_PLAN_RESULTS, &mapped).code == 0) {
+        if (mapReadOnlyFile(TEST_BATCH_STREAM, &streamed).code == 0) {
+            size_t headerSize = sizeof(BatchFileHeader);
+            passed = mapped.size == streamed.size &&
+                     memcmp(mapped.base + headerSize, streamed.base + headerSize, mapped.size - headerSize) == 0 &&
+                     streamStats.evaluated == stats.evaluated && streamStats.programs == stats.programs;
+            unmapFile(&streamed);
+        }
+        unmapFile(&mapped);
+    }
+    recordCheck("流式处理结果与映射处理一致", passed, err.message);
+    
+    // 管道中逐条发送请求：每条的结果在下一条请求之前写出，不等窗口填满或输入结束
+    int requestPipe[2], resultPipe[2];
+    passed = pipe(requestPipe) == 0;
+    if (passed && pipe(resultPipe) != 0) {
+        close(requestPipe[0]);
+        close(requestPipe[1]);
+        passed = 0;
+    }
+    if (passed) {
+        StreamJob job = {fdopen(requestPipe[0], "rb"), fdopen(resultPipe[1], "wb"), CALC_SUCCESS, {0, 0, 0, 0}};
+        FILE* requests = fdopen(requestPipe[1], "wb");
+        pthread_t thread;
+        int started = job.input && job.output && requests &&
+                      pthread_create(&thread, NULL, batchStreamThreadMain, &job) == 0;
+        BatchFileHeader resultHeader;
+        passed = started && writeBatchHeader(requests, BATCH_REQUEST_MAGIC).code == 0 && fflush(requests) == 0 &&
+                 readWithTimeout(resultPipe[0], &resultHeader, sizeof(resultHeader));
+        snprintf(detail, sizeof(detail), "没有收到结果文件头");
+        for (int i = 0; passed && i < 3; i++) {
+            double x = i;
+            BatchResult result;
+            passed = appendInlineRequest(requests, "x*2+1", 5, MODE_DEG, &x, 1).code == 0 && fflush(requests) == 0 &&
+                     readWithTimeout(resultPipe[0], &result, sizeof(result)) && result.errorCode == 0 &&
+                     result.value == 2 * i + 1;
+            snprintf(detail, sizeof(detail), "第 %d 条请求没有及时收到结果", i);
+        }
+        // 一次写入的多条记录：读入后仍在同一个窗口中执行计划
+        for (int i = 0; passed && i < 50; i++) {
+            double x = i;
+            passed = appendInlineRequest(requests, "x*2+1", 5, MODE_DEG, &x, 1).code == 0;
+        }
+        passed = passed && fflush(requests) == 0;
+        for (int i = 0; passed && i < 50; i++) {
+            BatchResult result;
+            passed = readWithTimeout(resultPipe[0], &result, sizeof(result)) && result.errorCode == 0 &&
+                     result.value == 2 * i + 1;
+            snprintf(detail, sizeof(detail), "一次写入的第 %d 条请求没有收到结果", i);
+        }
+        if (requests) fclose(requests);
+        if (started) {
+            pthread_join(thread, NULL);
+            if (passed && job.stats.programs != 4) {
+                snprintf(detail, sizeof(detail), "执行计划 %llu 次（应为 4 次）", (unsigned long long)job.stats.programs);
+                passed = 0;
+            }
+            passed = passed && job.err.code == 0 && job.stats.records == 53;
+        } else {
+            if (job.input) fclose(job.input);
+            if (job.output) fclose(job.output);
+        }
+        close(resultPipe[0]);
+    }
+    recordCheck("管道中逐条请求及时得到结果", passed, passed ? NULL : detail);
+    
+    closeExpressionLibrary(&lib);
+    remove(TEST_BATCH_LIBRARY);
+    remove(TEST_BATCH_PLAN);
+    remove(TEST_BATCH_PLAN_RESULTS);
+    remove(TEST_BATCH_STREAM);
+}
+
+#ifdef __linux__
+#define TEST_SERVER_SOCKET "build/test_server.sock"
+
+static void* serverThreadMain(void* arg) {
+    runServer((CalcServer*)arg);
+    return NULL;
+}
+
+/**
+ * 一次性发送全部请求（流水线），关闭写端后读取全部响应
+ */
+static size_t exchangeRequests(int fd, const char* requests, char* responses, size_t size) {
+    size_t length = strlen(requests);
+    size_t sent = 0;
+    while (fd >= 0 && sent < length) {
+        ssize_t n = send(fd, requests + sent, length - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += (size_t)n;
+    }
+    size_t received = 0;
+    if (fd >= 0) {
+        shutdown(fd, SHUT_WR);
+        ssize_t n;
+        while (received + 1 < size && (n = recv(fd, responses + received, size - received - 1, 0)) > 0) {
+            received += (size_t)n;
+        }
+        close(fd);
+    }
+    responses[received] = '\0';
+    return received;
+}
+
+static int connectTcp(int port) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((uint16_t)port);
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+static int connectUnix(const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+}
+
+// 取出第 index 行（从 0 开始）
+static const char* responseLine(const char* responses, int index, char* line, size_t size) {
+    const char* p = responses;
+    for (int i = 0; i < index && p; i++) {
+        p = strchr(p, '\n');
+        if (p) p++;
+    }
+    line[0] = '\0';
+    if (p) {
+        size_t length = strcspn(p, "\n");
+        if (length >= size) length = size - 1;
+        memcpy(line, p, length);
+        line[length] = '\0';
+    }
+    return line;
+}
+
+// 多客户端压力测试：每个线程打开多个连接，同时流水线发送请求
+#define STRESS_CLIENTS 8
+#define STRESS_CONNECTIONS 4
+#define STRESS_REQUESTS 500
+
+typedef struct {
+    int index;
+    int ordered;                // 每个连接的响应是否完整且按顺序
+} StressClient;
+
+static void* stressClientMain(void* arg) {
+    StressClient* client = (StressClient*)arg;
+    char requests[STRESS_REQUESTS * 32];
+    char responses[STRESS_REQUESTS * 32];
+    int fds[STRESS_CONNECTIONS];
+    client->ordered = 1;
+    for (int c = 0; c < STRESS_CONNECTIONS; c++) {
+        fds[c] = connectUnix(TEST_SERVER_SOCKET);
+        size_t length = 0;
+        for (int i = 0; i < STRESS_REQUESTS; i++) {
+            length += (size_t)snprintf(requests + length, sizeof(requests) - length, "EVAL %d+%d\n", client->index, i);
+        }
+        size_t sent = 0;
+        while (fds[c] >= 0 && sent < length) {
+            ssize_t n = send(fds[c], requests + sent, length - sent, MSG_NOSIGNAL);
+            if (n <= 0) break;
+            sent += (size_t)n;
+        }
+        if (fds[c] < 0 || sent < length) client->ordered = 0;
+    }
+    // 所有连接的请求都已发出后再依次读取响应
+    for (int c = 0; c < STRESS_CONNECTIONS; c++) {
+        exchangeRequests(fds[c], "", responses, sizeof(responses));
+        const char* p = responses;
+        for (int i = 0; i < STRESS_REQUESTS && client->ordered; i++) {
+            char expectedLine[32];
+            int n = snprintf(expectedLine, sizeof(expectedLine), "OK %d\n", client->index + i);
+            client->ordered = strncmp(p, expectedLine, (size_t)n) == 0;
+            p += n;
+        }
+        if (*p != '\0') client->ordered = 0;
+    }
+    return NULL;
+}
+
+// 服务模式测试：在回环地址上启动服务，验证流水线请求按顺序得到响应
+static void runServerSuite(void) {
+    printf("\n=== 服务模式测试 ===\n");
+    ServerConfig config = {NULL, 0, 2, 0, 0, 0};
+    CalcServer* server;
+    CalcError err = createServer(&config, &server);
+    recordCheck("启动 TCP 服务", err.code == 0 && getServerPort(server) > 0, err.message);
+    if (err.code != 0) {
+        return;
+    }
+    pthread_t thread;
+    pthread_create(&thread, NULL, serverThreadMain, server);
+    
+    static char responses[65536];
+    char line[256];
+    exchangeRequests(connectTcp(getServerPort(server)),
+                     "EVAL 1+2\r\n"
+                     "EVAL RAD sin(x) | x=0\n"
+                     "EVAL x*y+z | x=3, y=4 z=0.5\n"
+                     "EVAL 1/0\n"
+                     "EVAL x+1\n"
+                     "\n"
+                     "PING\n"
+                     "HELLO\n"
+                     "STATS\n"
+                     "QUIT\n"
+                     "EVAL 5\n",
+                     responses, sizeof(responses));
+    static const char* expected[] = {
+        "OK 3", "OK 0", "OK 12.5", "ERR 2 ", "ERR 7 -1 未绑定的变量: x", "PONG", "ERR 1 ", "STATS requests=", "BYE"
+    };
+    for (int i = 0; i < 9; i++) {
+        responseLine(responses, i, line, sizeof(line));
+        recordCheck(expected[i], strncmp(line, expected[i], strlen(expected[i])) == 0, line);
+    }
+    responseLine(responses, 9, line, sizeof(line));
+    recordCheck("QUIT 后不再处理请求", line[0] == '\0', line);
+    
+    // 大量流水线请求：响应顺序与请求顺序一致
+    static char requests[65536];
+    size_t length = 0;
+    for (int i = 0; i < 2000; i++) {
+        length += (size_t)snprintf(requests + length, sizeof(requests) - length, "EVAL %d*2\n", i);
+    }
+    exchangeRequests(connectTcp(getServerPort(server)), requests, responses, sizeof(responses));
+    int ordered = 1;
+    const char* p = responses;
+    for (int i = 0; i < 2000 && ordered; i++) {
+        char expectedLine[32];
+        int n = snprintf(expectedLine, sizeof(expectedLine), "OK %d\n", i * 2);
+        ordered = strncmp(p, expectedLine, (size_t)n) == 0;
+        p += n;
+    }
+    recordCheck("2000 条流水线请求按顺序返回", ordered && *p == '\0', ordered ? "" : p);
+    
+    ServerStats stats;
+    getServerStats(server, &stats);
+    snprintf(line, sizeof(line), "requests=%llu p50=%.1fus p99=%.1fus",
+             (unsigned long long)stats.requests, stats.p50Micros, stats.p99Micros);
+    recordCheck("延迟统计", stats.requests == 2009 && stats.errors == 3 &&
+                stats.p50Micros <= stats.p99Micros && stats.p99Micros <= stats.maxMicros + 1e-9, line);
+    
+    // 没有换行的超长请求：不关闭写端也能收到错误响应，之后服务关闭连接
+    int fd = connectTcp(getServerPort(server));
+    struct timeval timeout = {5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    length = MAX_REQUEST_LINE + 2000;
+    memset(requests, '7', length);
+    size_t sent = 0, received = 0;
+    while (fd >= 0 && sent < length) {
+        ssize_t n = send(fd, requests + sent, length - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += (size_t)n;
+    }
+    ssize_t n;
+    while (fd >= 0 && received + 1 < sizeof(responses) &&
+           (n = recv(fd, responses + received, sizeof(responses) - received - 1, 0)) > 0) {
+        received += (size_t)n;
+    }
+    responses[received] = '\0';
+    if (fd >= 0) close(fd);
+    responseLine(responses, 0, line, sizeof(line));
+    p = strchr(responses, '\n');
+    recordCheck("超长请求返回错误并关闭连接", strncmp(line, "ERR 7 ", 6) == 0 && strstr(line, "请求过长") != NULL &&
+                p != NULL && p[1] == '\0', responses);
+    
+    // 带换行的超长请求同样被拒绝，之前的请求照常返回
+    length = (size_t)snprintf(requests, sizeof(requests), "EVAL 1+1\nEVAL ");
+    memset(requests + length, '7', MAX_REQUEST_LINE);
+    length += MAX_REQUEST_LINE;
+    snprintf(requests + length, sizeof(requests) - length, "\nEVAL 2+2\n");
+    exchangeRequests(connectTcp(getServerPort(server)), requests, responses, sizeof(responses));
+    responseLine(responses, 1, line, sizeof(line));
+    p = strchr(responses + 5, '\n');
+    recordCheck("带换行的超长请求返回错误并关闭连接", strncmp(responses, "OK 2\n", 5) == 0 &&
+                strncmp(line, "ERR 7 ", 6) == 0 && strstr(line, "请求过长") != NULL &&
+                p != NULL && p[1] == '\0', responses);
+    
+    stopServer(server);
+    pthread_join(thread, NULL);
+    destroyServer(server);
+    
+    // Unix 域套接字
+    config.unixPath = TEST_SERVER_SOCKET;
+    config.threads = 4;
+    err = createServer(&config, &server);
+    recordCheck("启动 Unix 域套接字服务", err.code == 0, err.message);
+    if (err.code != 0) {
+        return;
+    }
+    pthread_create(&thread, NULL, serverThreadMain, server);
+    exchangeRequests(connectUnix(TEST_SERVER_SOCKET), "EVAL 2^10\n", responses, sizeof(responses));
+    recordCheck("EVAL 2^10（Unix 域套接字）", strcmp(responses, "OK 1024\n") == 0, responses);
+    
+    StressClient clients[STRESS_CLIENTS];
+    pthread_t clientThreads[STRESS_CLIENTS];
+    for (int i = 0; i < STRESS_CLIENTS; i++) {
+        clients[i].index = i * 1000;
+        pthread_create(&clientThreads[i], NULL, stressClientMain, &clients[i]);
+    }
+    int allOrdered = 1;
+    for (int i = 0; i < STRESS_CLIENTS; i++) {
+        pthread_join(clientThreads[i], NULL);
+        allOrdered = allOrdered && clients[i].ordered;
+    }
+    snprintf(line, sizeof(line), "%d 个线程 × %d 个连接 × %d 条请求",
+             STRESS_CLIENTS, STRESS_CONNECTIONS, STRESS_REQUESTS);
+    recordCheck("多客户端流水线请求全部按顺序返回", allOrdered, line);
+    stopServer(server);
+    pthread_join(thread, NULL);
+    destroyServer(server);
+    recordCheck("停止后删除套接字文件", access(TEST_SERVER_SOCKET, F_OK) != 0, "");
+    
+    // 求值预算：按估计步数与嵌套深度拒绝
+    ServerConfig limited = {NULL, 0, 1, 3, 3, 1000000};
+    err = createServer(&limited, &server);
+    if (err.code != 0) {
+        recordCheck("启动带预算的服务", 0, err.message);
+        return;
+    }
+    pthread_create(&thread, NULL, serverThreadMain, server);
+    exchangeRequests(connectTcp(getServerPort(server)), "EVAL 1+2*3-4/2\nEVAL sin(cos(abs(x))) | x=0\nEVAL 1+2*3\n",
+                     responses, sizeof(responses));
+    static const char* limitedExpected[] = {"ERR 11 -1 超出运算步数上限", "ERR 11 -1 超出嵌套深度上限", "OK 7"};
+    int limitedOk = 1;
+    for (int i = 0; i < 3; i++) {
+        responseLine(responses, i, line, sizeof(line));
+        limitedOk = limitedOk && strcmp(line, limitedExpected[i]) == 0;
+    }
+    recordCheck("按估计代价拒绝请求", limitedOk, responses);
+    stopServer(server);
+    pthread_join(thread, NULL);
+    destroyServer(server);
+}
+static void* ringServiceMain(void* arg) {
+    serveSharedRing((SharedRing*)arg);
+    return NULL;
+}
+
+typedef struct {
+    const char* name;
+    int producer;
+    int mismatches;
+} RingProducer;
+
+#define RING_REQUESTS_PER_PRODUCER 5000
+#define RING_PIPELINE_DEPTH 8
+
+// 每个生产者独立映射共享内存，每次连续提交若干条请求后再依次取回结果
+static void* ringProducerMain(void* arg) {
+    RingProducer* producer = (RingProducer*)arg;
+    SharedRing ring;
+    if (openSharedRing(producer->name, &ring).code != 0) {
+        producer->mismatches = -1;
+        return NULL;
+    }
+    const char* expr = "x*2+k";
+    RingBinding bindings[2] = {{"x", 0}, {"k", (double)producer->producer}};
+    int next = 0;
+    while (next < RING_REQUESTS_PER_PRODUCER && producer->mismatches == 0) {
+        uint64_t tickets[RING_PIPELINE_DEPTH];
+        int inputs[RING_PIPELINE_DEPTH];
+        int count = 0;
+        while (count < RING_PIPELINE_DEPTH && next < RING_REQUESTS_PER_PRODUCER) {
+            bindings[0].value = next;
+            CalcError err = submitRingRequest(&ring, expr, strlen(expr), MODE_DEG, bindings, 2, &tickets[count]);
+            if (err.code == ERR_STACK_OVERFLOW) {
+                break;  // 队列已满：先取回已提交的结果
+            }
+            if (err.code != 0) {
+                producer->mismatches++;
+                break;
+            }
+            inputs[count++] = next++;
+        }
+        for (int j = 0; j < count; j++) {
+            double value = 0;
+            CalcError err = waitRingResult(&ring, tickets[j], &value);
+            if (err.code != 0 || value != inputs[j] * 2.0 + producer->producer) {
+                producer->mismatches++;
+            }
+        }
+    }
+    closeSharedRing(&ring);
+    return NULL;
+}
+
+// 共享内存队列测试：服务线程与生产者各自映射同一块共享内存
+static void runSharedRingSuite(void) {
+    printf("\n=== 共享内存队列测试 ===\n");
+    char name[64];
+    char detail[100];
+    snprintf(name, sizeof(name), "/calc_test_ring_%d", (int)getpid());
+    
+    SharedRing service;
+    CalcError err = createSharedRing(name, 64, &service);
+    recordCheck("创建共享内存队列", err.code == 0, err.message);
+    if (err.code != 0) {
+        return;
+    }
+    pthread_t thread;
+    pthread_create(&thread, NULL, ringServiceMain, &service);
+    
+    SharedRing ring;
+    err = openSharedRing(name, &ring);
+    recordCheck("生产者映射共享内存", err.code == 0, err.message);
+    if (err.code == 0) {
+        double value = 0;
+        err = evaluateOverRing(&ring, "1+2", 3, MODE_DEG, NULL, 0, &value);
+        snprintf(detail, sizeof(detail), "%g", value);
+        recordCheck("1+2", err.code == 0 && value == 3, err.code == 0 ? detail : err.message);
+        
+        // 表达式按长度传递，不要求以 '\0' 结尾
+        err = evaluateOverRing(&ring, "2*3+1)))", 5, MODE_DEG, NULL, 0, &value);
+        snprintf(detail, sizeof(detail), "%g", value);
+        recordCheck("按长度截取 \"2*3+1\"", err.code == 0 && value == 7, err.code == 0 ? detail : err.message);
+        
+        RingBinding binding = {"x", 3.14159265358979323846 / 2};
+        err = evaluateOverRing(&ring, "sin(x)", 6, MODE_RAD, &binding, 1, &value);
+        snprintf(detail, sizeof(detail), "%g", value);
+        recordCheck("sin(x)（弧度，x=pi/2）", err.code == 0 && isDoubleEqual(value, 1), err.code == 0 ? detail : err.message);
+        
+        err = evaluateOverRing(&ring, "1/0", 3, MODE_DEG, NULL, 0, &value);
+        snprintf(detail, sizeof(detail), "错误代码 %d，位置 %d", err.code, err.position);
+        recordCheck("1/0 返回错误代码与位置", err.code == ERR_DIV_BY_ZERO && err.position >= 0, detail);
+        
+        err = evaluateOverRing(&ring, "x+1", 3, MODE_DEG, NULL, 0, &value);
+        recordCheck("未绑定的变量", err.code == ERR_INVALID_ARGUMENT, err.message);
+        
+        char longExpr[MAX_RING_EXPRESSION + 8];
+        memset(longExpr, '1', sizeof(longExpr));
+        err = evaluateOverRing(&ring, longExpr, sizeof(longExpr), MODE_DEG, NULL, 0, &value);
+        recordCheck("拒绝过长的表达式", err.code != 0, err.message);
+        
+        // 往返延迟
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int roundTrips = 20000;
+        int ok = 1;
+        for (int i = 0; i < roundTrips && ok; i++) {
+            ok = evaluateOverRing(&ring, "1+2", 3, MODE_DEG, NULL, 0, &value).code == 0 && value == 3;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double micros = ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / 1e3 / roundTrips;
+        snprintf(detail, sizeof(detail), "平均往返 %.2f us", micros);
+        recordCheck("连续 20000 次往返", ok, detail);
+        closeSharedRing(&ring);
+    }
+    
+    // 多个生产者同时提交，槽位反复复用
+    RingProducer producers[4];
+    pthread_t producerThreads[4];
+    for (int i = 0; i < 4; i++) {
+        producers[i] = (RingProducer){name, i, 0};
+        pthread_create(&producerThreads[i], NULL, ringProducerMain, &producers[i]);
+    }
+    int mismatches = 0;
+    for (int i = 0; i < 4; i++) {
+        pthread_join(producerThreads[i], NULL);
+        mismatches += producers[i].mismatches != 0;
+    }
+    snprintf(detail, sizeof(detail), "4 个生产者 × %d 条，%d 个生产者结果不符", RING_REQUESTS_PER_PRODUCER, mismatches);
+    recordCheck("多生产者流水线提交", mismatches == 0, detail);
+    
+    stopSharedRing(&service);
+    pthread_join(thread, NULL);
+    closeSharedRing(&service);
+    err = openSharedRing(name, &ring);
+    recordCheck("关闭后删除共享内存", err.code != 0, err.message);
+}
+#endif
+
 int main() {
     // 设置控制台代码页（仅Windows）
 #ifdef _WIN32
@@ -60,6 +2746,57 @@ int main() {
     runTestSuite("常量测试", constantTests, MODE_DEG);
     runTestSuite("空格处理测试", whitespaceTests, MODE_DEG);
     
+    setupAggregateTestArrays();
+    runTestSuite("聚合函数测试", aggregateTests, MODE_DEG);
+    clearArrayVariables();
+    
+    // 编译求值（双精度结果应与直接求值一致）
+    runCompiledSuite("编译求值：基本运算", basicTests, MODE_DEG, EVAL_FP64);
+    runCompiledSuite("编译求值：幂运算", powerTests, MODE_DEG, EVAL_FP64);
+    runCompiledSuite("编译求值：隐式乘法", implicitMultiplyTests, MODE_DEG, EVAL_FP64);
+    runCompiledSuite("编译求值：科学计数法", scientificTests, MODE_DEG, EVAL_FP64);
+    runCompiledSuite("编译求值：函数（角度）", functionTests, MODE_DEG, EVAL_FP64);
+    runCompiledSuite("编译求值：函数（弧度）", radianTests, MODE_RAD, EVAL_FP64);
+    runCompiledSuite("编译求值：复杂表达式", complexTests, MODE_DEG, EVAL_FP64);
+    runCompiledSuite("编译求值：边界值", boundaryTests, MODE_DEG, EVAL_FP64);
+    runCompiledSuite("编译求值：常量", constantTests, MODE_DEG, EVAL_FP64);
+    runVariableSuite("编译求值：变量", variableTests, MODE_DEG);
+    runIntegerSuite();
+    runAdaptiveSuite();
+    runDecimalSuite();
+    runCharScanSuite();
+    runDiagnosticSuite();
+    runProfileSuite();
+    runTrigTableSuite();
+    runTrigReductionSuite();
+    runFunctionCacheSuite();
+    runVectorSuite();
+    runSeriesSuite();
+    runSolverSuite();
+    runPolynomialSuite();
+    runPolicySuite();
+    runBudgetSuite();
+    runConditionalSuite();
+    runLibrarySuite();
+    runColumnSuite();
+    runBatchFormatSuite();
+    runBatchPlanSuite();
+#ifdef __linux__
+    runServerSuite();
+    runSharedRingSuite();
+#endif
+    runCompiledSuite("按需提升精度：基本运算", basicTests, MODE_DEG, EVAL_ADAPTIVE);
+    runCompiledSuite("按需提升精度：复杂表达式", complexTests, MODE_DEG, EVAL_ADAPTIVE);
+    
+    // 单精度批量求值
+    runCompiledSuite("单精度：基本运算", basicTests, MODE_DEG, EVAL_FP32);
+    runCompiledSuite("单精度：幂运算", powerTests, MODE_DEG, EVAL_FP32);
+    runCompiledSuite("单精度：函数（角度）", functionTests, MODE_DEG, EVAL_FP32);
+    runCompiledSuite("单精度：函数（弧度）", radianTests, MODE_RAD, EVAL_FP32);
+    runCompiledSuite("单精度：单位转换", unitConversionTests, MODE_DEG, EVAL_FP32);
+    runCompiledSuite("单精度：复杂表达式", complexTests, MODE_DEG, EVAL_FP32);
+    runPrecisionComparisonSuite();
+    
     // 打印测试摘要
     printTestSummary();
     